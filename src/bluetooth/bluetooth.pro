@@ -30,6 +30,8 @@ PUBLIC_HEADERS += \
     qlowenergyadvertisingdata.h \
     qlowenergyadvertisingparameters.h \
     qlowenergyconnectionparameters.h \
+    qlowenergyconnectionparameterpolicy.h \
+    qlowenergyconnectionmetrics.h \
     qlowenergycontroller.h
 
 PRIVATE_HEADERS += \
@@ -48,6 +50,7 @@ PRIVATE_HEADERS += \
     qbluetoothlocaldevice_p.h \
     qlowenergycontroller_p.h \
     qlowenergyserviceprivate_p.h \
+    qlowenergyconnectionmetrics_p.h \
     qleadvertiser_p.h \
     lecmaccalculator_p.h
 
@@ -69,6 +72,8 @@ SOURCES += \
     qlowenergyadvertisingdata.cpp \
     qlowenergyadvertisingparameters.cpp \
     qlowenergyconnectionparameters.cpp \
+    qlowenergyconnectionparameterpolicy.cpp \
+    qlowenergyconnectionmetrics.cpp \
     qlowenergyservice.cpp \
     qlowenergyservicedata.cpp \
     qlowenergycharacteristic.cpp \
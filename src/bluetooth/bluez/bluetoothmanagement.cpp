@@ -37,9 +37,11 @@
 **
 ****************************************************************************/
 
+#include <QtCore/qelapsedtimer.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qsocketnotifier.h>
 #include <QtCore/qtimer.h>
+#include <QtBluetooth/qbluetoothuuid.h>
 
 #include "bluetoothmanagement_p.h"
 #include "bluez_data_p.h"
@@ -56,8 +58,16 @@ QT_BEGIN_NAMESPACE
 
 // Packet data structures for Mgmt API bluez.git/doc/mgmt-api.txt
 
+enum class CommandCode {
+    StartDiscovery =    0x0023,
+    StopDiscovery =     0x0024,
+};
+
 enum class EventCode {
+    CommandComplete =   0x0001,
+    CommandStatus =     0x0002,
     DeviceFound =       0x0012,
+    Discovering =       0x0013,
 };
 
 struct MgmtHdr {
@@ -75,6 +85,33 @@ struct MgmtEventDeviceFound {
     quint8 eirData[0];
 }  __attribute__((packed));
 
+struct MgmtEventCommandStatus {
+    quint16 opcode;
+    quint8 status;
+}  __attribute__((packed));
+
+struct MgmtEventDiscovering {
+    quint8 addressType;
+    quint8 discovering;
+}  __attribute__((packed));
+
+// EIR and AD data types, Bluetooth Assigned Numbers - Generic Access Profile
+enum class EirType : quint8 {
+    Incomplete16BitUuids =  0x02,
+    Complete16BitUuids =    0x03,
+    Incomplete32BitUuids =  0x04,
+    Complete32BitUuids =    0x05,
+    Incomplete128BitUuids = 0x06,
+    Complete128BitUuids =   0x07,
+    ShortenedName =         0x08,
+    CompleteName =          0x09,
+    ClassOfDevice =         0x0d,
+    ServiceData16BitUuid =  0x16,
+    ServiceData32BitUuid =  0x20,
+    ServiceData128BitUuid = 0x21,
+    ManufacturerData =      0xff,
+};
+
 
 /*
  * This class encapsulates access to the Bluetooth Management API as introduced by
@@ -130,6 +167,129 @@ inline uint qHash(const QBluetoothAddress& address)
     return qHash(address.toUInt64());
 }
 
+// as reported by QBluetoothDeviceInfo::lastSeenTimestamp()
+static qint64 monotonicTimestamp()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer.msecsSinceReference();
+}
+
+// 128 bit UUIDs are transmitted in little endian order, quint128 is big endian
+static QBluetoothUuid uuid128FromLittleEndian(const quint8 *data)
+{
+    quint128 uuid;
+    for (int i = 0; i < 16; ++i)
+        uuid.data[i] = data[15 - i];
+    return QBluetoothUuid(uuid);
+}
+
+/*
+ * Decodes a Device Found event into a QBluetoothDeviceInfo. The EIR data of
+ * BR/EDR devices and the advertising data of LE devices share the same format,
+ * a sequence of length, type, data structures (Core Specification Vol 3, Part C, 8 and 11).
+ * Returns an invalid info if the event is malformed.
+ */
+static QBluetoothDeviceInfo decodeDeviceFound(const char *data, int length)
+{
+    if (length < int(sizeof(MgmtEventDeviceFound)))
+        return QBluetoothDeviceInfo();
+
+    const MgmtEventDeviceFound *event = reinterpret_cast<const MgmtEventDeviceFound *>(data);
+    const int eirLength = qFromLittleEndian(event->eirLength);
+    if (length < int(sizeof(MgmtEventDeviceFound)) + eirLength)
+        return QBluetoothDeviceInfo();
+
+    QString name;
+    quint32 classOfDevice = 0;
+    QList<QBluetoothUuid> uuids;
+    QHash<quint16, QByteArray> manufacturerData;
+    QHash<QBluetoothUuid, QByteArray> serviceData;
+
+    const quint8 *eir = event->eirData;
+    for (int offset = 0; offset < eirLength; ) {
+        const int fieldLength = eir[offset];
+        if (fieldLength == 0)
+            break; // significant part ends, the rest is padding
+        if (offset + 1 + fieldLength > eirLength)
+            break; // truncated field
+
+        const quint8 *field = eir + offset + 2;
+        const int size = fieldLength - 1;
+
+        switch (static_cast<EirType>(eir[offset + 1])) {
+        case EirType::Incomplete16BitUuids:
+        case EirType::Complete16BitUuids:
+            for (int i = 0; i + 2 <= size; i += 2)
+                uuids.append(QBluetoothUuid(qFromLittleEndian<quint16>(field + i)));
+            break;
+        case EirType::Incomplete32BitUuids:
+        case EirType::Complete32BitUuids:
+            for (int i = 0; i + 4 <= size; i += 4)
+                uuids.append(QBluetoothUuid(qFromLittleEndian<quint32>(field + i)));
+            break;
+        case EirType::Incomplete128BitUuids:
+        case EirType::Complete128BitUuids:
+            for (int i = 0; i + 16 <= size; i += 16)
+                uuids.append(uuid128FromLittleEndian(field + i));
+            break;
+        case EirType::ShortenedName:
+            if (name.isEmpty())
+                name = QString::fromUtf8(reinterpret_cast<const char *>(field), size);
+            break;
+        case EirType::CompleteName:
+            name = QString::fromUtf8(reinterpret_cast<const char *>(field), size);
+            break;
+        case EirType::ClassOfDevice:
+            if (size >= 3)
+                classOfDevice = field[0] | (field[1] << 8) | (field[2] << 16);
+            break;
+        case EirType::ServiceData16BitUuid:
+            if (size >= 2) {
+                serviceData.insert(QBluetoothUuid(qFromLittleEndian<quint16>(field)),
+                                   QByteArray(reinterpret_cast<const char *>(field + 2), size - 2));
+            }
+            break;
+        case EirType::ServiceData32BitUuid:
+            if (size >= 4) {
+                serviceData.insert(QBluetoothUuid(qFromLittleEndian<quint32>(field)),
+                                   QByteArray(reinterpret_cast<const char *>(field + 4), size - 4));
+            }
+            break;
+        case EirType::ServiceData128BitUuid:
+            if (size >= 16) {
+                serviceData.insert(uuid128FromLittleEndian(field),
+                                   QByteArray(reinterpret_cast<const char *>(field + 16), size - 16));
+            }
+            break;
+        case EirType::ManufacturerData:
+            if (size >= 2) {
+                manufacturerData.insert(qFromLittleEndian<quint16>(field),
+                                        QByteArray(reinterpret_cast<const char *>(field + 2), size - 2));
+            }
+            break;
+        default:
+            break;
+        }
+
+        offset += fieldLength + 1;
+    }
+
+    const bdaddr_t address = event->bdaddr;
+    QBluetoothDeviceInfo info(QBluetoothAddress(convertAddress(address.b)), name, classOfDevice);
+    info.setRssi(qint8(event->rssi));
+    info.setServiceUuids(uuids, QBluetoothDeviceInfo::DataIncomplete);
+    info.setCoreConfigurations(event->type == BDADDR_BREDR
+                               ? QBluetoothDeviceInfo::BaseRateCoreConfiguration
+                               : QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+    for (auto it = manufacturerData.constBegin(); it != manufacturerData.constEnd(); ++it)
+        info.setManufacturerData(it.key(), it.value());
+    for (auto it = serviceData.constBegin(); it != serviceData.constEnd(); ++it)
+        info.setServiceData(it.key(), it.value());
+
+    return info;
+}
+
 static int sysCallCapGet(capHdr *header, capData *data)
 {
     return syscall(__NR_capget, header, data);
@@ -188,6 +348,29 @@ BluetoothManagement::BluetoothManagement(QObject *parent) : QObject(parent)
         return;
     }
 
+    setupNotifier();
+}
+
+/*
+ * Uses the already connected \a socketDescriptor instead of opening a
+ * Bluetooth Management socket. This is meant for feeding recorded
+ * event streams through a socketpair.
+ */
+BluetoothManagement::BluetoothManagement(int socketDescriptor, QObject *parent)
+    : QObject(parent), fd(socketDescriptor)
+{
+    if (fd >= 0)
+        setupNotifier();
+}
+
+BluetoothManagement::~BluetoothManagement()
+{
+    if (fd >= 0)
+        ::close(fd);
+}
+
+void BluetoothManagement::setupNotifier()
+{
     notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
     connect(notifier, &QSocketNotifier::activated, this, &BluetoothManagement::_q_readNotifier);
 
@@ -220,55 +403,125 @@ void BluetoothManagement::_q_readNotifier()
     if ((uint)buffer.size() < sizeof(MgmtHdr))
         return;
 
-    QByteArray data = buffer.readAll();
+    const qint64 timestamp = monotonicTimestamp();
+    const QByteArray data = buffer.readAll();
+    int offset = 0;
 
-    while (true) {
-        if ((uint)data.size() < sizeof(MgmtHdr))
-            break;
+    while (data.size() - offset >= int(sizeof(MgmtHdr))) {
+        const MgmtHdr *hdr = reinterpret_cast<const MgmtHdr*>(data.constData() + offset);
+        const int packageLength = qFromLittleEndian(hdr->length);
+        const int nextPackageSize = packageLength + sizeof(MgmtHdr);
 
-        const MgmtHdr *hdr = reinterpret_cast<const MgmtHdr*>(data.constData());
-        const int nextPackageSize = qFromLittleEndian(hdr->length) + sizeof(MgmtHdr);
-        const int remainingPackageSize = data.length() - nextPackageSize;
+        if (data.size() - offset < nextPackageSize)
+            break; // not a complete event -> wait for next notifier
 
-        if (data.length() < nextPackageSize)
-            break; // not a complete event header -> wait for next notifier
+        const char *package = data.constData() + offset + sizeof(MgmtHdr);
+        const quint16 controllerIndex = qFromLittleEndian(hdr->controllerIndex);
 
         switch (static_cast<EventCode>(qFromLittleEndian(hdr->cmdCode))) {
         case EventCode::DeviceFound:
-        {
-            const MgmtEventDeviceFound *event = reinterpret_cast<const MgmtEventDeviceFound*>
-                                                   (data.constData() + sizeof(MgmtHdr));
-
-            if (event->type == BDADDR_LE_RANDOM) {
-                const bdaddr_t address = event->bdaddr;
-                quint64 bdaddr;
-
-                convertAddress(address.b, &bdaddr);
-                const QBluetoothAddress qtAddress(bdaddr);
-                qCDebug(QT_BT_BLUEZ) << "BluetoothManagement: found random device"
-                                     << qtAddress;
-                processRandomAddressFlagInformation(qtAddress);
+            processDeviceFound(controllerIndex, package, packageLength, timestamp);
+            break;
+        case EventCode::Discovering:
+            if (packageLength >= int(sizeof(MgmtEventDiscovering))) {
+                const MgmtEventDiscovering *event =
+                        reinterpret_cast<const MgmtEventDiscovering *>(package);
+                emit discoveringChanged(controllerIndex, event->discovering);
+            }
+            break;
+        case EventCode::CommandComplete:
+        case EventCode::CommandStatus:
+            if (packageLength >= int(sizeof(MgmtEventCommandStatus))) {
+                const MgmtEventCommandStatus *event =
+                        reinterpret_cast<const MgmtEventCommandStatus *>(package);
+                if (event->status != 0) {
+                    const quint16 opcode = qFromLittleEndian(event->opcode);
+                    qCDebug(QT_BT_BLUEZ) << "BluetoothManagement: command" << hex << opcode
+                                         << "failed with status" << event->status;
+                    emit commandFailed(controllerIndex, opcode, event->status);
+                }
             }
-
             break;
-        }
         default:
             qCDebug(QT_BT_BLUEZ) << "BluetoothManagement: Ignored event:"
                                  << hex << qFromLittleEndian(hdr->cmdCode);
             break;
         }
 
-        if (data.length() > nextPackageSize)
-            data = data.right(remainingPackageSize);
-        else
-            data.clear();
+        offset += nextPackageSize;
+    }
 
-        if (data.isEmpty())
-            break;
+    if (offset < data.size())
+        buffer.ungetBlock(data.constData() + offset, data.size() - offset);
+}
+
+void BluetoothManagement::processDeviceFound(quint16 controllerIndex, const char *data,
+                                             int length, qint64 timestamp)
+{
+    if (length < int(sizeof(MgmtEventDeviceFound)))
+        return;
+
+    const MgmtEventDeviceFound *event = reinterpret_cast<const MgmtEventDeviceFound*>(data);
+
+    if (event->type == BDADDR_LE_RANDOM) {
+        const bdaddr_t address = event->bdaddr;
+        quint64 bdaddr;
+
+        convertAddress(address.b, &bdaddr);
+        const QBluetoothAddress qtAddress(bdaddr);
+        qCDebug(QT_BT_BLUEZ) << "BluetoothManagement: found random device"
+                             << qtAddress;
+        processRandomAddressFlagInformation(qtAddress);
+    }
+
+    // decoding is only worth it if somebody listens
+    if (!isSignalConnected(QMetaMethod::fromSignal(&BluetoothManagement::deviceFound)))
+        return;
+
+    const QBluetoothDeviceInfo info = decodeDeviceFound(data, length);
+    if (info.isValid())
+        emit deviceFound(controllerIndex, info, timestamp);
+}
+
+/*
+ * Starts a discovery cycle on the controller with \a controllerIndex for the
+ * \l AddressType combination \a addressTypes. The kernel emits Device Found
+ * events and stops discovery on its own at the end of the cycle, which is
+ * announced by \l discoveringChanged(). Errors are reported by \l commandFailed().
+ */
+bool BluetoothManagement::startDiscovery(quint16 controllerIndex, quint8 addressTypes)
+{
+    return sendCommand(quint16(CommandCode::StartDiscovery), controllerIndex,
+                       QByteArray(1, char(addressTypes)));
+}
+
+bool BluetoothManagement::stopDiscovery(quint16 controllerIndex, quint8 addressTypes)
+{
+    return sendCommand(quint16(CommandCode::StopDiscovery), controllerIndex,
+                       QByteArray(1, char(addressTypes)));
+}
+
+bool BluetoothManagement::sendCommand(quint16 command, quint16 controllerIndex,
+                                      const QByteArray &parameters)
+{
+    if (fd == -1)
+        return false;
+
+    MgmtHdr hdr;
+    hdr.cmdCode = qToLittleEndian(command);
+    hdr.controllerIndex = qToLittleEndian(controllerIndex);
+    hdr.length = qToLittleEndian(quint16(parameters.size()));
+
+    QByteArray package(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+    package.append(parameters);
+
+    if (::write(fd, package.constData(), package.size()) != package.size()) {
+        qCWarning(QT_BT_BLUEZ, "Management Control write error %s",
+                  qPrintable(qt_error_string(errno)));
+        return false;
     }
 
-    if (!data.isEmpty())
-        buffer.ungetBlock(data.constData(), data.size());
+    return true;
 }
 
 void BluetoothManagement::processRandomAddressFlagInformation(const QBluetoothAddress &address)
@@ -56,6 +56,7 @@
 #include <QtCore/qobject.h>
 
 #include <QtBluetooth/qbluetoothaddress.h>
+#include <QtBluetooth/qbluetoothdeviceinfo.h>
 
 #ifndef QPRIVATELINEARBUFFER_BUFFERSIZE
 #define QPRIVATELINEARBUFFER_BUFFERSIZE Q_INT64_C(16384)
@@ -66,33 +67,52 @@ QT_BEGIN_NAMESPACE
 
 class QSocketNotifier;
 
-class BluetoothManagement : public QObject
+class Q_AUTOTEST_EXPORT BluetoothManagement : public QObject
 {
     Q_OBJECT
 
 public:
+    // Address_Type bits of the Start/Stop Discovery commands
+    enum AddressType {
+        BrEdrAddress = 0x01,
+        LePublicAddress = 0x02,
+        LeRandomAddress = 0x04
+    };
+
     explicit BluetoothManagement(QObject *parent = nullptr);
+    explicit BluetoothManagement(int socketDescriptor, QObject *parent = nullptr);
+    ~BluetoothManagement();
     static BluetoothManagement *instance();
 
     bool isAddressRandom(const QBluetoothAddress &address) const;
     bool isMonitoringEnabled() const;
 
+    bool startDiscovery(quint16 controllerIndex, quint8 addressTypes);
+    bool stopDiscovery(quint16 controllerIndex, quint8 addressTypes);
+
+signals:
+    void deviceFound(quint16 controllerIndex, const QBluetoothDeviceInfo &info, qint64 timestamp);
+    void discoveringChanged(quint16 controllerIndex, bool discovering);
+    void commandFailed(quint16 controllerIndex, quint16 command, quint8 status);
+
 private slots:
     void _q_readNotifier();
     void processRandomAddressFlagInformation(const QBluetoothAddress &address);
     void cleanupOldAddressFlags();
 
 private:
-    void readyRead();
+    void setupNotifier();
+    bool sendCommand(quint16 command, quint16 controllerIndex, const QByteArray &parameters);
+    void processDeviceFound(quint16 controllerIndex, const char *data, int length,
+                            qint64 timestamp);
 
     int fd = -1;
-    QSocketNotifier* notifier;
+    QSocketNotifier* notifier = nullptr;
     QPrivateLinearBuffer buffer;
     QHash<QBluetoothAddress, QDateTime> privateFlagAddresses;
     mutable QMutex accessLock;
 };
 
-
 QT_END_NAMESPACE
 
 #endif // BLUETOOTHMANAGEMENT_P_H
@@ -20,7 +20,14 @@ HEADERS += bluez/manager_p.h \
            bluez/bluez_data_p.h \
            bluez/hcimanager_p.h \
            bluez/remotedevicemanager_p.h \
-           bluez/bluetoothmanagement_p.h
+           bluez/bluetoothmanagement_p.h \
+           bluez/sdpdataelement_p.h \
+           bluez/sdpclient_p.h \
+           bluez/servicediscoveryscheduler_p.h \
+           bluez/signcounterstore_p.h \
+           bluez/btsnooptracer_p.h \
+           bluez/roundtriptimeestimator_p.h \
+           bluez/connectionparametertuner_p.h
 
 SOURCES += bluez/manager.cpp \
            bluez/adapter.cpp \
@@ -43,4 +50,11 @@ SOURCES += bluez/manager.cpp \
            bluez/obex_transfer1_bluez5.cpp \
            bluez/hcimanager.cpp \
            bluez/remotedevicemanager.cpp \
-           bluez/bluetoothmanagement.cpp
+           bluez/bluetoothmanagement.cpp \
+           bluez/sdpdataelement.cpp \
+           bluez/sdpclient.cpp \
+           bluez/servicediscoveryscheduler.cpp \
+           bluez/signcounterstore.cpp \
+           bluez/btsnooptracer.cpp \
+           bluez/roundtriptimeestimator.cpp \
+           bluez/connectionparametertuner.cpp
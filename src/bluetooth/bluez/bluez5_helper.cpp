@@ -40,6 +40,7 @@
 #include <QtCore/QGlobalStatic>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMap>
+#include <QtCore/QReadWriteLock>
 #include "bluez5_helper_p.h"
 #include "objectmanager_p.h"
 #include "properties_p.h"
@@ -63,17 +64,8 @@ Q_GLOBAL_STATIC_WITH_ARGS(Bluez5TestResult, bluezVersion, (BluezVersionUnknown))
 bool isBluez5()
 {
     if (*bluezVersion() == BluezVersionUnknown) {
-        OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
-                                                         QStringLiteral("/"),
-                                                         QDBusConnection::systemBus());
-
-        qDBusRegisterMetaType<InterfaceList>();
-        qDBusRegisterMetaType<ManagedObjectList>();
-        qDBusRegisterMetaType<ManufacturerDataList>();
-
-        QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
-        reply.waitForFinished();
-        if (reply.isError()) {
+        // the object mirror is populated with GetManagedObjects() which is BlueZ 5 only
+        if (!QtBluezObjectMirror::instance()->isValid()) {
             // not Bluez 5.x
             OrgBluezManagerInterface manager_bluez4(QStringLiteral("org.bluez"),
                                              QStringLiteral("/"),
@@ -97,6 +89,431 @@ bool isBluez5()
     return (*bluezVersion() == BluezVersion5);
 }
 
+static QString objectAdapterPath(const QString &objectPath, const QVariantMap &deviceProperties)
+{
+    const QVariant adapter = deviceProperties.value(QStringLiteral("Adapter"));
+    if (adapter.canConvert<QDBusObjectPath>())
+        return qvariant_cast<QDBusObjectPath>(adapter).path();
+
+    // e.g. /org/bluez/hci0/dev_XX_XX_XX_XX_XX_XX
+    return objectPath.left(objectPath.lastIndexOf(QLatin1Char('/')));
+}
+
+class QtBluezObjectMirrorPrivate
+{
+public:
+    QtBluezObjectMirrorPrivate(const QDBusConnection &connection)
+        : connection(connection), manager(0), valid(false)
+    {
+    }
+
+    void index(const QString &objectPath, const InterfaceList &interfaces);
+    void unindex(const QString &objectPath, const InterfaceList &interfaces);
+
+    QDBusConnection connection;
+    OrgFreedesktopDBusObjectManagerInterface *manager;
+
+    // guards everything below, the mirror may be queried from any thread
+    mutable QReadWriteLock lock;
+    bool valid;
+    QDBusError error;
+    ManagedObjectList objects;
+    QHash<quint64, QString> adapters;                   // address -> adapter path
+    QHash<QString, QHash<quint64, QString> > devices;   // adapter path -> address -> device path
+};
+
+void QtBluezObjectMirrorPrivate::index(const QString &objectPath, const InterfaceList &interfaces)
+{
+    InterfaceList::const_iterator it = interfaces.constFind(QStringLiteral("org.bluez.Adapter1"));
+    if (it != interfaces.constEnd()) {
+        const QBluetoothAddress address(it->value(QStringLiteral("Address")).toString());
+        if (!address.isNull())
+            adapters.insert(address.toUInt64(), objectPath);
+    }
+
+    it = interfaces.constFind(QStringLiteral("org.bluez.Device1"));
+    if (it != interfaces.constEnd()) {
+        const QBluetoothAddress address(it->value(QStringLiteral("Address")).toString());
+        if (!address.isNull())
+            devices[objectAdapterPath(objectPath, *it)].insert(address.toUInt64(), objectPath);
+    }
+}
+
+void QtBluezObjectMirrorPrivate::unindex(const QString &objectPath, const InterfaceList &interfaces)
+{
+    InterfaceList::const_iterator it = interfaces.constFind(QStringLiteral("org.bluez.Adapter1"));
+    if (it != interfaces.constEnd()) {
+        const QBluetoothAddress address(it->value(QStringLiteral("Address")).toString());
+        if (adapters.value(address.toUInt64()) == objectPath)
+            adapters.remove(address.toUInt64());
+    }
+
+    it = interfaces.constFind(QStringLiteral("org.bluez.Device1"));
+    if (it != interfaces.constEnd()) {
+        const QBluetoothAddress address(it->value(QStringLiteral("Address")).toString());
+        const QString adapterPath = objectAdapterPath(objectPath, *it);
+
+        QHash<QString, QHash<quint64, QString> >::iterator adapter = devices.find(adapterPath);
+        if (adapter != devices.end() && adapter->value(address.toUInt64()) == objectPath) {
+            adapter->remove(address.toUInt64());
+            if (adapter->isEmpty())
+                devices.erase(adapter);
+        }
+    }
+}
+
+// BlueZ derives the Alias of a device from its Name until the alias is set explicitly
+static bool containsDeviceName(const QVariantMap &properties)
+{
+    return properties.contains(QStringLiteral("Alias"))
+            || properties.contains(QStringLiteral("Name"));
+}
+
+Q_GLOBAL_STATIC(QtBluezObjectMirror, objectMirror)
+
+/*!
+    \internal
+    \class QtBluezObjectMirror
+
+    This class keeps a process wide copy of all objects, interfaces and properties
+    that BlueZ 5 exports via org.freedesktop.DBus.ObjectManager.
+
+    The copy is populated with a single GetManagedObjects() call and afterwards kept
+    current by InterfacesAdded, InterfacesRemoved and PropertiesChanged. Qt classes
+    should query the mirror instead of calling GetManagedObjects() themselves, which
+    serializes the entire BlueZ object tree and becomes slow once BlueZ has seen many
+    remote devices. Adapters can be looked up by address and devices by adapter and address.
+
+    The mirror lives in the main thread but can be queried from any thread.
+    Changes are re-emitted by \l interfacesAdded(), \l interfacesRemoved() and
+    \l propertiesChanged() after the mirror was updated. \l deviceNameChanged()
+    singles out the changes of a device's name or alias. \l validChanged() is
+    emitted when BlueZ goes away or the mirror was populated again.
+*/
+
+QtBluezObjectMirror::QtBluezObjectMirror(QObject *parent)
+    : QObject(parent), d(new QtBluezObjectMirrorPrivate(QDBusConnection::systemBus()))
+{
+    initialize();
+}
+
+/*!
+    Constructs a mirror of the BlueZ objects on \a connection. This is meant
+    for testing against a mock BlueZ on a private bus.
+*/
+QtBluezObjectMirror::QtBluezObjectMirror(const QDBusConnection &connection, QObject *parent)
+    : QObject(parent), d(new QtBluezObjectMirrorPrivate(connection))
+{
+    initialize();
+}
+
+QtBluezObjectMirror::~QtBluezObjectMirror()
+{
+    delete d;
+}
+
+QtBluezObjectMirror *QtBluezObjectMirror::instance()
+{
+    return objectMirror();
+}
+
+void QtBluezObjectMirror::initialize()
+{
+    qDBusRegisterMetaType<InterfaceList>();
+    qDBusRegisterMetaType<ManagedObjectList>();
+    qDBusRegisterMetaType<ManufacturerDataList>();
+
+    // subscribe before fetching the initial state, nothing must be missed in between
+    d->manager = new OrgFreedesktopDBusObjectManagerInterface(
+                QStringLiteral("org.bluez"), QStringLiteral("/"), d->connection, this);
+    connect(d->manager, SIGNAL(InterfacesAdded(QDBusObjectPath,InterfaceList)),
+            SLOT(InterfacesAdded(QDBusObjectPath,InterfaceList)));
+    connect(d->manager, SIGNAL(InterfacesRemoved(QDBusObjectPath,QStringList)),
+            SLOT(InterfacesRemoved(QDBusObjectPath,QStringList)));
+
+    // a single match rule covers the properties of every BlueZ object
+    d->connection.connect(QStringLiteral("org.bluez"), QString(),
+                          QStringLiteral("org.freedesktop.DBus.Properties"),
+                          QStringLiteral("PropertiesChanged"),
+                          this, SLOT(PropertiesChanged(QDBusMessage)));
+
+    QDBusServiceWatcher *watcher = new QDBusServiceWatcher(
+                QStringLiteral("org.bluez"), d->connection,
+                QDBusServiceWatcher::WatchForRegistration
+                | QDBusServiceWatcher::WatchForUnregistration, this);
+    connect(watcher, SIGNAL(serviceRegistered(QString)), SLOT(serviceRegistered()));
+    connect(watcher, SIGNAL(serviceUnregistered(QString)), SLOT(serviceUnregistered()));
+
+    // The first user may run in a short lived thread, updates must keep flowing.
+    // Moving the mirror moves the children created above along with it.
+    if (!parent() && QCoreApplication::instance())
+        moveToThread(QCoreApplication::instance()->thread());
+
+    QDBusPendingReply<ManagedObjectList> reply = d->manager->GetManagedObjects();
+    reply.waitForFinished();
+    if (reply.isError()) {
+        QWriteLocker locker(&d->lock);
+        d->error = reply.error();
+        qCDebug(QT_BT_BLUEZ) << "Cannot mirror BlueZ objects:" << d->error.message();
+        return;
+    }
+
+    populate(reply.value());
+}
+
+void QtBluezObjectMirror::populate(const ManagedObjectList &objects)
+{
+    bool wasValid;
+    {
+        QWriteLocker locker(&d->lock);
+
+        wasValid = d->valid;
+        d->valid = true;
+        d->error = QDBusError();
+        d->objects = objects;
+        d->adapters.clear();
+        d->devices.clear();
+
+        for (ManagedObjectList::const_iterator it = objects.constBegin(); it != objects.constEnd(); ++it)
+            d->index(it.key().path(), it.value());
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Mirrored" << objects.count() << "BlueZ objects";
+
+    if (!wasValid)
+        emit validChanged(true);
+}
+
+/*!
+    Returns \c true if the mirror was populated and BlueZ 5 is still running.
+*/
+bool QtBluezObjectMirror::isValid() const
+{
+    QReadLocker locker(&d->lock);
+    return d->valid;
+}
+
+/*!
+    Returns the error of the last attempt to populate the mirror.
+*/
+QDBusError QtBluezObjectMirror::lastError() const
+{
+    QReadLocker locker(&d->lock);
+    return d->error;
+}
+
+/*!
+    Returns all mirrored objects. Prefer the indexed lookups, this copies
+    the whole object tree.
+*/
+ManagedObjectList QtBluezObjectMirror::managedObjects() const
+{
+    QReadLocker locker(&d->lock);
+    return d->objects;
+}
+
+InterfaceList QtBluezObjectMirror::interfaces(const QString &objectPath) const
+{
+    QReadLocker locker(&d->lock);
+    return d->objects.value(QDBusObjectPath(objectPath));
+}
+
+QVariantMap QtBluezObjectMirror::properties(const QString &objectPath,
+                                            const QString &interface) const
+{
+    QReadLocker locker(&d->lock);
+
+    ManagedObjectList::const_iterator it = d->objects.constFind(QDBusObjectPath(objectPath));
+    if (it == d->objects.constEnd())
+        return QVariantMap();
+
+    return it->value(interface);
+}
+
+/*!
+    Returns the paths of all local adapters ordered by path.
+*/
+QStringList QtBluezObjectMirror::adapterPaths() const
+{
+    QReadLocker locker(&d->lock);
+
+    QStringList paths;
+    for (ManagedObjectList::const_iterator it = d->objects.constBegin(); it != d->objects.constEnd(); ++it) {
+        if (it->contains(QStringLiteral("org.bluez.Adapter1")))
+            paths.append(it.key().path());
+    }
+
+    return paths;
+}
+
+/*!
+    Returns the path of the local adapter with \a address or an empty string.
+*/
+QString QtBluezObjectMirror::adapterPath(const QBluetoothAddress &address) const
+{
+    QReadLocker locker(&d->lock);
+    return d->adapters.value(address.toUInt64());
+}
+
+/*!
+    Returns the paths of all remote devices known to the adapter at \a adapterPath.
+*/
+QStringList QtBluezObjectMirror::devicePaths(const QString &adapterPath) const
+{
+    QReadLocker locker(&d->lock);
+    return d->devices.value(adapterPath).values();
+}
+
+/*!
+    Returns the path of the remote device with \a address known to the adapter at
+    \a adapterPath or an empty string.
+*/
+QString QtBluezObjectMirror::devicePath(const QString &adapterPath,
+                                        const QBluetoothAddress &address) const
+{
+    QReadLocker locker(&d->lock);
+
+    QHash<QString, QHash<quint64, QString> >::const_iterator it = d->devices.constFind(adapterPath);
+    if (it == d->devices.constEnd())
+        return QString();
+
+    return it->value(address.toUInt64());
+}
+
+void QtBluezObjectMirror::InterfacesAdded(const QDBusObjectPath &object_path,
+                                          InterfaceList interfaces_and_properties)
+{
+    {
+        QWriteLocker locker(&d->lock);
+
+        InterfaceList &interfaces = d->objects[object_path];
+        for (InterfaceList::const_iterator it = interfaces_and_properties.constBegin();
+             it != interfaces_and_properties.constEnd(); ++it) {
+            interfaces.insert(it.key(), it.value());
+        }
+        d->index(object_path.path(), interfaces);
+    }
+
+    emit interfacesAdded(object_path, interfaces_and_properties);
+
+    InterfaceList::const_iterator device =
+            interfaces_and_properties.constFind(QStringLiteral("org.bluez.Device1"));
+    if (device != interfaces_and_properties.constEnd() && containsDeviceName(*device))
+        emit deviceNameChanged(object_path.path());
+}
+
+void QtBluezObjectMirror::InterfacesRemoved(const QDBusObjectPath &object_path,
+                                            const QStringList &interfaces)
+{
+    {
+        QWriteLocker locker(&d->lock);
+
+        ManagedObjectList::iterator it = d->objects.find(object_path);
+        if (it != d->objects.end()) {
+            InterfaceList removed;
+            foreach (const QString &interface, interfaces) {
+                if (it->contains(interface))
+                    removed.insert(interface, it->take(interface));
+            }
+            d->unindex(object_path.path(), removed);
+
+            if (it->isEmpty())
+                d->objects.erase(it);
+        }
+    }
+
+    emit interfacesRemoved(object_path, interfaces);
+}
+
+void QtBluezObjectMirror::PropertiesChanged(const QDBusMessage &message)
+{
+    const QList<QVariant> arguments = message.arguments();
+    if (arguments.count() != 3)
+        return;
+
+    const QString interface = arguments.at(0).toString();
+    const QVariantMap changed = qdbus_cast<QVariantMap>(arguments.at(1));
+    const QStringList invalidated = qdbus_cast<QStringList>(arguments.at(2));
+
+    {
+        QWriteLocker locker(&d->lock);
+
+        ManagedObjectList::iterator it = d->objects.find(QDBusObjectPath(message.path()));
+        if (it != d->objects.end() && it->contains(interface)) {
+            // the address is part of the index
+            const bool reindex = changed.contains(QStringLiteral("Address"));
+            if (reindex)
+                d->unindex(message.path(), *it);
+
+            QVariantMap &properties = (*it)[interface];
+            for (QVariantMap::const_iterator jt = changed.constBegin(); jt != changed.constEnd(); ++jt)
+                properties.insert(jt.key(), jt.value());
+            foreach (const QString &name, invalidated)
+                properties.remove(name);
+
+            if (reindex)
+                d->index(message.path(), *it);
+        }
+    }
+
+    emit propertiesChanged(message.path(), interface, changed, invalidated);
+
+    if (interface == QStringLiteral("org.bluez.Device1") && containsDeviceName(changed))
+        emit deviceNameChanged(message.path());
+}
+
+void QtBluezObjectMirror::serviceRegistered()
+{
+    // BlueZ was (re)started, nothing is known about its objects yet
+    QDBusPendingCallWatcher *watcher =
+            new QDBusPendingCallWatcher(d->manager->GetManagedObjects(), this);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            SLOT(managedObjectsReceived(QDBusPendingCallWatcher*)));
+}
+
+void QtBluezObjectMirror::serviceUnregistered()
+{
+    ManagedObjectList objects;
+    bool wasValid;
+    {
+        QWriteLocker locker(&d->lock);
+        wasValid = d->valid;
+        d->valid = false;
+        objects.swap(d->objects);
+        d->adapters.clear();
+        d->devices.clear();
+    }
+
+    for (ManagedObjectList::const_iterator it = objects.constBegin(); it != objects.constEnd(); ++it)
+        emit interfacesRemoved(it.key(), it->keys());
+
+    if (wasValid)
+        emit validChanged(false);
+}
+
+void QtBluezObjectMirror::managedObjectsReceived(QDBusPendingCallWatcher *watcher)
+{
+    watcher->deleteLater();
+
+    QDBusPendingReply<ManagedObjectList> reply = *watcher;
+    if (reply.isError()) {
+        QWriteLocker locker(&d->lock);
+        d->error = reply.error();
+        return;
+    }
+
+    const ManagedObjectList objects = reply.value();
+    populate(objects);
+
+    for (ManagedObjectList::const_iterator it = objects.constBegin(); it != objects.constEnd(); ++it) {
+        emit interfacesAdded(it.key(), it.value());
+
+        InterfaceList::const_iterator device = it->constFind(QStringLiteral("org.bluez.Device1"));
+        if (device != it->constEnd() && containsDeviceName(*device))
+            emit deviceNameChanged(it.key().path());
+    }
+}
+
 struct AdapterData
 {
 public:
@@ -309,57 +726,29 @@ void QtBluezDiscoveryManager::removeAdapterFromMonitoring(const QString &dbusPat
  */
 QString findAdapterForAddress(const QBluetoothAddress &wantedAddress, bool *ok = 0)
 {
-    OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
-                                                     QStringLiteral("/"),
-                                                     QDBusConnection::systemBus());
-
-    QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
+    QtBluezObjectMirror *mirror = QtBluezObjectMirror::instance();
+    if (!mirror->isValid()) {
         if (ok)
             *ok = false;
 
         return QString();
     }
 
-    typedef QPair<QString, QBluetoothAddress> AddressForPathType;
-    QList<AddressForPathType> localAdapters;
-
-    ManagedObjectList managedObjectList = reply.value();
-    for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-        const QDBusObjectPath &path = it.key();
-        const InterfaceList &ifaceList = it.value();
-
-        for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-            const QString &iface = jt.key();
-
-            if (iface == QStringLiteral("org.bluez.Adapter1")) {
-                AddressForPathType pair;
-                pair.first = path.path();
-                pair.second = QBluetoothAddress(ifaceList.value(iface).value(
-                                          QStringLiteral("Address")).toString());
-                if (!pair.second.isNull())
-                    localAdapters.append(pair);
-                break;
-            }
-        }
-    }
-
     if (ok)
         *ok = true;
 
-    if (localAdapters.isEmpty())
-        return QString(); // -> no local adapter found
-
-    if (wantedAddress.isNull())
-        return localAdapters.front().first; // -> return first found adapter
+    if (!wantedAddress.isNull())
+        return mirror->adapterPath(wantedAddress);
 
-    foreach (const AddressForPathType &pair, localAdapters) {
-        if (pair.second == wantedAddress)
-            return pair.first; // -> found local adapter with wanted address
+    // -> return first found adapter
+    foreach (const QString &path, mirror->adapterPaths()) {
+        const QBluetoothAddress address(mirror->properties(path, QStringLiteral("org.bluez.Adapter1"))
+                                            .value(QStringLiteral("Address")).toString());
+        if (!address.isNull())
+            return path;
     }
 
-    return QString(); // nothing matching found
+    return QString(); // -> no local adapter found
 }
 
 /*
@@ -71,6 +71,54 @@ QString sanitizeNameForDBus(const QString& text);
 
 QString findAdapterForAddress(const QBluetoothAddress &wantedAddress, bool *ok);
 
+class QtBluezObjectMirrorPrivate;
+class Q_AUTOTEST_EXPORT QtBluezObjectMirror : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QtBluezObjectMirror(QObject *parent = 0);
+    explicit QtBluezObjectMirror(const QDBusConnection &connection, QObject *parent = 0);
+    ~QtBluezObjectMirror();
+    static QtBluezObjectMirror *instance();
+
+    bool isValid() const;
+    QDBusError lastError() const;
+
+    ManagedObjectList managedObjects() const;
+    InterfaceList interfaces(const QString &objectPath) const;
+    QVariantMap properties(const QString &objectPath, const QString &interface) const;
+
+    QStringList adapterPaths() const;
+    QString adapterPath(const QBluetoothAddress &address) const;
+    QStringList devicePaths(const QString &adapterPath) const;
+    QString devicePath(const QString &adapterPath, const QBluetoothAddress &address) const;
+
+signals:
+    void interfacesAdded(const QDBusObjectPath &objectPath, const InterfaceList &interfaces);
+    void interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces);
+    void propertiesChanged(const QString &objectPath, const QString &interface,
+                           const QVariantMap &changedProperties,
+                           const QStringList &invalidatedProperties);
+    void validChanged(bool valid);
+    void deviceNameChanged(const QString &devicePath);
+
+private slots:
+    void InterfacesAdded(const QDBusObjectPath &object_path,
+                         InterfaceList interfaces_and_properties);
+    void InterfacesRemoved(const QDBusObjectPath &object_path,
+                           const QStringList &interfaces);
+    void PropertiesChanged(const QDBusMessage &message);
+    void serviceRegistered();
+    void serviceUnregistered();
+    void managedObjectsReceived(QDBusPendingCallWatcher *watcher);
+
+private:
+    void initialize();
+    void populate(const ManagedObjectList &objects);
+
+    QtBluezObjectMirrorPrivate *d;
+};
+
 class QtBluezDiscoveryManagerPrivate;
 class QtBluezDiscoveryManager : public QObject
 {
@@ -86,6 +86,14 @@ QT_BEGIN_NAMESPACE
 #define L2CAP_LM_TRUSTED    0x0008
 #define L2CAP_LM_SECURE     0x0020
 
+#define L2CAP_CONNINFO      0x02
+#define RFCOMM_CONNINFO     0x02
+// same layout for l2cap_conninfo and rfcomm_conninfo
+struct bt_conninfo {
+    quint16 hci_handle;
+    quint8 dev_class[3];
+};
+
 #define BT_SECURITY 4
 struct bt_security {
     quint8 level;
@@ -96,6 +104,7 @@ struct bt_security {
 #define BT_SECURITY_MEDIUM  2
 #define BT_SECURITY_HIGH    3
 
+#define BDADDR_BREDR        0x00
 #define BDADDR_LE_PUBLIC    0x01
 #define BDADDR_LE_RANDOM    0x02
 
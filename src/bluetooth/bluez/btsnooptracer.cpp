@@ -0,0 +1,291 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "btsnooptracer_p.h"
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+// btsnoop format, see RFC 1761 and the btsnoop documentation in BlueZ
+static const char btsnoopMagic[8] = { 'b', 't', 's', 'n', 'o', 'o', 'p', '\0' };
+static const quint32 btsnoopVersion = 1;
+static const quint32 btsnoopDatalinkH4 = 1001;
+static const quint32 btsnoopFlagReceived = 0x01;
+// microseconds between 0000-01-01 and 1970-01-01
+static const qint64 btsnoopEpochOffset = Q_INT64_C(0x00dcddb30f2f8000);
+
+static const quint8 h4AclData = 0x02;
+// ACL packet boundary flag: first automatically flushable packet
+static const quint16 aclStartFlag = 0x2000;
+static const int hciHeaderLength = 1 + 4 + 4; // H4 packet type, ACL header, L2CAP header
+
+QBasicAtomicPointer<BtSnoopTracer> BtSnoopTracer::current = Q_BASIC_ATOMIC_INITIALIZER(0);
+QBasicAtomicInt BtSnoopTracer::environmentChecked = Q_BASIC_ATOMIC_INITIALIZER(0);
+QBasicAtomicInt BtSnoopTracer::users = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+Q_GLOBAL_STATIC(QMutex, tracerMutex)
+
+BtSnoopTracer::BtSnoopTracer(const QString &fileName)
+    : ring(new Slot[SlotCount]), file(fileName)
+{
+    for (int i = 0; i < SlotCount; ++i)
+        ring[i].sequence.store(i);
+}
+
+BtSnoopTracer::~BtSnoopTracer()
+{
+}
+
+BtSnoopTracer *BtSnoopTracer::startFromEnvironment()
+{
+    QMutexLocker locker(tracerMutex());
+
+    if (!environmentChecked.loadAcquire()) {
+        if (!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_BTSNOOP_FILE"))
+            startLocked(QFile::decodeName(qgetenv("QT_BLUETOOTH_BTSNOOP_FILE")));
+        environmentChecked.storeRelease(1);
+    }
+
+    return current.loadAcquire();
+}
+
+/*
+ * Starts tracing into \a fileName, which is overwritten. Returns false if a trace
+ * is already running or the file cannot be created.
+ */
+bool BtSnoopTracer::start(const QString &fileName)
+{
+    QMutexLocker locker(tracerMutex());
+
+    // an explicit start takes precedence over the environment
+    environmentChecked.storeRelease(1);
+    return startLocked(fileName);
+}
+
+bool BtSnoopTracer::startLocked(const QString &fileName)
+{
+    if (current.loadAcquire())
+        return false;
+
+    QScopedPointer<BtSnoopTracer> tracer(new BtSnoopTracer(fileName));
+    if (!tracer->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot open btsnoop file" << fileName
+                               << tracer->file.errorString();
+        return false;
+    }
+
+    char header[16];
+    memcpy(header, btsnoopMagic, sizeof(btsnoopMagic));
+    qToBigEndian<quint32>(btsnoopVersion, header + 8);
+    qToBigEndian<quint32>(btsnoopDatalinkH4, header + 12);
+    if (tracer->file.write(header, sizeof(header)) != sizeof(header)) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot write btsnoop file" << fileName
+                               << tracer->file.errorString();
+        return false;
+    }
+
+    tracer->startTime = QDateTime::currentMSecsSinceEpoch() * 1000;
+    tracer->clock.start();
+    tracer->setObjectName(QStringLiteral("BtSnoopTracer"));
+    tracer->start(QThread::LowPriority);
+
+    static bool postRoutineAdded = false;
+    if (!postRoutineAdded) {
+        qAddPostRoutine(BtSnoopTracer::stop);
+        postRoutineAdded = true;
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Tracing Bluetooth traffic into" << fileName;
+    current.storeRelease(tracer.take());
+    return true;
+}
+
+/*
+ * Stops the active trace and writes all buffered packets. Packets which are
+ * traced concurrently are either written or silently discarded.
+ */
+void BtSnoopTracer::stop()
+{
+    QMutexLocker locker(tracerMutex());
+
+    BtSnoopTracer *tracer = current.fetchAndStoreOrdered(0);
+    if (!tracer)
+        return;
+
+    // New references see the cleared pointer; wait for the ones taken before.
+    // They only copy a packet into the ring, so this never spins for long.
+    while (users.fetchAndAddOrdered(0) != 0)
+        QThread::yieldCurrentThread();
+
+    tracer->stopRequested.storeRelease(1);
+    tracer->wakeWriter();
+    tracer->wait();
+
+    if (tracer->dropped.load())
+        qCWarning(QT_BT_BLUEZ) << "btsnoop trace dropped" << tracer->dropped.load() << "packets";
+
+    delete tracer;
+}
+
+/*
+ * Records a PDU of \a size bytes which was sent or received on the L2CAP channel
+ * \a channelId of the ACL connection \a connectionHandle.
+ *
+ * Called from the data path; it never blocks and drops the packet if the
+ * writer thread is behind.
+ */
+void BtSnoopTracer::trace(Direction direction, quint16 connectionHandle, quint16 channelId,
+                          const char *data, int size)
+{
+    if (size < 0)
+        return;
+
+    // reserve a slot, see Vyukov's bounded MPMC queue
+    Slot *slot = 0;
+    quint32 position = enqueuePosition.load();
+    forever {
+        slot = &ring[position % SlotCount];
+        const qint32 difference = qint32(slot->sequence.loadAcquire() - position);
+        if (difference == 0) {
+            if (enqueuePosition.testAndSetRelaxed(position, position + 1, position))
+                break;
+        } else if (difference < 0) {
+            dropped.ref();
+            return;
+        } else {
+            position = enqueuePosition.load();
+        }
+    }
+
+    slot->timestamp = startTime + clock.nsecsElapsed() / 1000;
+    slot->connectionHandle = connectionHandle;
+    slot->channelId = channelId;
+    slot->direction = direction;
+    slot->originalLength = size;
+    slot->includedLength = qMin<int>(size, SnapLength);
+    memcpy(slot->data, data, slot->includedLength);
+
+    slot->sequence.storeRelease(position + 1);
+    wakeWriter();
+}
+
+void BtSnoopTracer::wakeWriter()
+{
+    // only the thread which clears the flag posts, so the data path rarely touches the semaphore
+    if (writerWaiting.loadAcquire() && writerWaiting.testAndSetOrdered(1, 0))
+        wakeup.release();
+}
+
+bool BtSnoopTracer::hasPendingRecords()
+{
+    Slot &slot = ring[dequeuePosition % SlotCount];
+    return slot.sequence.fetchAndAddOrdered(0) == dequeuePosition + 1;
+}
+
+int BtSnoopTracer::writePendingRecords()
+{
+    char header[24 + hciHeaderLength];
+    int written = 0;
+
+    forever {
+        Slot &slot = ring[dequeuePosition % SlotCount];
+        if (slot.sequence.loadAcquire() != dequeuePosition + 1)
+            break;
+
+        const quint32 originalLength = hciHeaderLength + slot.originalLength;
+        const quint32 includedLength = hciHeaderLength + slot.includedLength;
+
+        qToBigEndian<quint32>(originalLength, header);
+        qToBigEndian<quint32>(includedLength, header + 4);
+        qToBigEndian<quint32>(slot.direction == Received ? btsnoopFlagReceived : 0, header + 8);
+        qToBigEndian<quint32>(dropped.load(), header + 12);
+        qToBigEndian<qint64>(slot.timestamp + btsnoopEpochOffset, header + 16);
+
+        // HCI ACL and L2CAP headers are little endian
+        header[24] = char(h4AclData);
+        qToLittleEndian<quint16>((slot.connectionHandle & 0x0fff) | aclStartFlag, header + 25);
+        qToLittleEndian<quint16>(quint16(slot.originalLength + 4), header + 27);
+        qToLittleEndian<quint16>(quint16(slot.originalLength), header + 29);
+        qToLittleEndian<quint16>(slot.channelId, header + 31);
+
+        file.write(header, sizeof(header));
+        file.write(slot.data, slot.includedLength);
+
+        slot.sequence.storeRelease(dequeuePosition + SlotCount);
+        ++dequeuePosition;
+        ++written;
+    }
+
+    return written;
+}
+
+void BtSnoopTracer::run()
+{
+    forever {
+        const bool stopping = stopRequested.loadAcquire();
+
+        if (writePendingRecords() > 0) {
+            file.flush();
+            continue;
+        }
+        if (stopping)
+            break;
+
+        // announce the sleep before checking the ring again, so that a packet
+        // published in between either is seen here or posts the semaphore
+        writerWaiting.fetchAndStoreOrdered(1);
+        if (hasPendingRecords() || stopRequested.loadAcquire()) {
+            // a wakeup posted in the meantime is consumed by the next sleep
+            writerWaiting.testAndSetOrdered(1, 0);
+            continue;
+        }
+        wakeup.acquire();
+    }
+
+    file.close();
+}
+
+QT_END_NAMESPACE
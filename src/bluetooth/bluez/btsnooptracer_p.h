@@ -0,0 +1,184 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef BTSNOOPTRACER_P_H
+#define BTSNOOPTRACER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qscopedpointer.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthread.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * Writes the traffic of Bluetooth sockets into a btsnoop file, which Wireshark can open.
+ *
+ * Tracing is enabled by the QT_BLUETOOTH_BTSNOOP_FILE environment variable or by start().
+ * The data path only reserves a slot in a lock-free ring buffer and copies the packet into
+ * it; a writer thread adds the HCI framing and writes the records to the file. Packets are
+ * dropped rather than blocking the data path if the writer thread falls behind.
+ *
+ * The data path holds a Reference while it traces, which keeps stop() from deleting the
+ * tracer under its feet.
+ */
+class Q_AUTOTEST_EXPORT BtSnoopTracer : public QThread
+{
+public:
+    enum Direction { Sent, Received };
+
+    // the L2CAP channel used for the payload of sockets which are not ATT sockets
+    enum { DynamicChannelId = 0x0040 };
+
+    enum { SlotCount = 1024, SnapLength = 1024 };
+
+    class Reference
+    {
+    public:
+        Reference() : tracer(BtSnoopTracer::acquire()) {}
+        ~Reference()
+        {
+            if (tracer)
+                users.deref();
+        }
+
+        BtSnoopTracer *operator->() const { return tracer; }
+        bool isNull() const { return !tracer; }
+
+    private:
+        Q_DISABLE_COPY(Reference)
+        BtSnoopTracer *tracer;
+    };
+
+    // Only safe to dereference on threads which do not race with stop(); use Reference otherwise.
+    static BtSnoopTracer *active()
+    {
+        BtSnoopTracer *tracer = current.loadAcquire();
+        if (Q_LIKELY(tracer) || Q_LIKELY(environmentChecked.loadAcquire()))
+            return tracer;
+        return startFromEnvironment();
+    }
+
+    static bool start(const QString &fileName);
+    static void stop();
+
+    void trace(Direction direction, quint16 connectionHandle, quint16 channelId,
+               const char *data, int size);
+
+    QString fileName() const { return file.fileName(); }
+    quint32 droppedPackets() const { return dropped.load(); }
+
+protected:
+    void run() override;
+
+private:
+    explicit BtSnoopTracer(const QString &fileName);
+    ~BtSnoopTracer();
+
+    static BtSnoopTracer *acquire()
+    {
+        if (Q_LIKELY(!current.loadAcquire()) && Q_LIKELY(environmentChecked.loadAcquire()))
+            return 0;
+        if (!environmentChecked.loadAcquire())
+            startFromEnvironment();
+
+        // pairs with stop(), which clears current before it waits for users to drop to 0
+        users.ref();
+        BtSnoopTracer *tracer = current.fetchAndAddOrdered(0);
+        if (!tracer)
+            users.deref();
+        return tracer;
+    }
+
+    static BtSnoopTracer *startFromEnvironment();
+    static bool startLocked(const QString &fileName);
+
+    bool hasPendingRecords();
+    int writePendingRecords();
+    void wakeWriter();
+
+    struct Slot {
+        QAtomicInteger<quint32> sequence;
+        qint64 timestamp;
+        quint16 connectionHandle;
+        quint16 channelId;
+        Direction direction;
+        int originalLength;
+        int includedLength;
+        char data[SnapLength];
+    };
+
+    QScopedArrayPointer<Slot> ring;
+    QAtomicInteger<quint32> enqueuePosition;
+    quint32 dequeuePosition = 0;
+    QAtomicInteger<quint32> dropped;
+    QAtomicInt stopRequested;
+
+    // the writer thread sleeps on wakeup while writerWaiting is set
+    QAtomicInt writerWaiting;
+    QSemaphore wakeup;
+
+    // timestamps are taken from a monotonic clock relative to the start time
+    QElapsedTimer clock;
+    qint64 startTime = 0;
+
+    QFile file;
+
+    static QBasicAtomicPointer<BtSnoopTracer> current;
+    static QBasicAtomicInt environmentChecked;
+    // the number of threads holding a Reference
+    static QBasicAtomicInt users;
+};
+
+QT_END_NAMESPACE
+
+#endif // BTSNOOPTRACER_P_H
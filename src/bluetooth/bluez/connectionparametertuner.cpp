@@ -0,0 +1,205 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "connectionparametertuner_p.h"
+
+#include <QtCore/qloggingcategory.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+// a peer rejecting the parameters is asked again, but not indefinitely
+static const int MaxRetries = 3;
+
+ConnectionParameterTuner::ConnectionParameterTuner(
+        const QLowEnergyConnectionParameterPolicy &policy, QObject *parent)
+    : QObject(parent), currentPolicy(policy)
+{
+    idleTimer.setSingleShot(true);
+    connect(&idleTimer, &QTimer::timeout, this, &ConnectionParameterTuner::checkIdle);
+    retryTimer.setSingleShot(true);
+    connect(&retryTimer, &QTimer::timeout, this, &ConnectionParameterTuner::requestUpdate);
+}
+
+void ConnectionParameterTuner::setPolicy(const QLowEnergyConnectionParameterPolicy &policy)
+{
+    currentPolicy = policy;
+
+    // apply the new parameters of the current mode right away
+    if (isActive() && currentMode != UnknownMode) {
+        const Mode mode = currentMode;
+        currentMode = UnknownMode;
+        setMode(mode);
+    }
+}
+
+/*
+ * Starts watching a new connection. Unless a burst starts, the connection
+ * falls back to the idle parameters after the idle timeout.
+ */
+void ConnectionParameterTuner::start()
+{
+    currentMode = UnknownMode;
+    lastTraffic.start();
+    window.start();
+    windowBytes = 0;
+    idleTimer.start(currentPolicy.idleTimeout());
+    retryTimer.stop();
+    updatePending = false;
+    retries = 0;
+}
+
+void ConnectionParameterTuner::stop()
+{
+    idleTimer.stop();
+    retryTimer.stop();
+    lastTraffic.invalidate();
+    currentMode = UnknownMode;
+    updatePending = false;
+}
+
+/*
+ * Called for every connection update of the controller. Only an update following
+ * a request of the tuner is checked, parameters the application requested itself
+ * remain until the next change of the mode.
+ */
+void ConnectionParameterTuner::updateApplied(const QLowEnergyConnectionParameters &parameters)
+{
+    if (!updatePending)
+        return;
+    updatePending = false;
+
+    // the controller may pick any interval of the requested range, reported in units of 1.25ms
+    const QLowEnergyConnectionParameters requested = currentMode == BurstMode
+            ? currentPolicy.burstParameters() : currentPolicy.idleParameters();
+    if (parameters.minimumInterval() >= requested.minimumInterval() - 1.25
+            && parameters.maximumInterval() <= requested.maximumInterval() + 1.25) {
+        retries = 0;
+        return;
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Connection interval" << parameters.minimumInterval()
+                         << "differs from the requested one";
+    scheduleRetry();
+}
+
+/*
+ * Called if the controller or the remote device rejected a connection update.
+ */
+void ConnectionParameterTuner::updateFailed()
+{
+    if (!updatePending)
+        return;
+    updatePending = false;
+    scheduleRetry();
+}
+
+void ConnectionParameterTuner::scheduleRetry()
+{
+    if (retries >= MaxRetries) {
+        qCWarning(QT_BT_BLUEZ) << "Giving up requesting the connection parameters after"
+                               << retries << "retries";
+        return;
+    }
+
+    // back off, the peer may accept the parameters once its own traffic calmed down
+    retryTimer.start(retryInterval << retries);
+    ++retries;
+}
+
+void ConnectionParameterTuner::checkBurst(int queueDepth)
+{
+    // bytes are counted in windows of one second
+    if (window.elapsed() >= 1000) {
+        window.restart();
+        windowBytes = 0;
+    }
+
+    if (queueDepth >= currentPolicy.burstQueueDepth()
+            || windowBytes >= currentPolicy.burstThroughput()) {
+        setMode(BurstMode);
+    }
+}
+
+void ConnectionParameterTuner::checkIdle()
+{
+    if (!lastTraffic.isValid())
+        return;
+
+    // the timer is not restarted for every PDU, it only fires to check the time of the last one
+    const qint64 remaining = currentPolicy.idleTimeout() - lastTraffic.elapsed();
+    if (remaining > 0) {
+        idleTimer.start(int(remaining));
+        return;
+    }
+
+    window.restart();
+    windowBytes = 0;
+    setMode(IdleMode);
+}
+
+void ConnectionParameterTuner::setMode(Mode mode)
+{
+    if (currentMode == mode)
+        return;
+
+    currentMode = mode;
+    retries = 0;
+    if (mode == BurstMode) {
+        qCDebug(QT_BT_BLUEZ) << "Connection burst, requesting short connection interval";
+        idleTimer.start(currentPolicy.idleTimeout());
+    } else if (mode == IdleMode) {
+        qCDebug(QT_BT_BLUEZ) << "Connection idle, requesting long connection interval";
+    }
+    requestUpdate();
+}
+
+void ConnectionParameterTuner::requestUpdate()
+{
+    retryTimer.stop();
+    if (!isActive() || currentMode == UnknownMode)
+        return;
+
+    updatePending = true;
+    emit updateRequested(currentMode == BurstMode
+                         ? currentPolicy.burstParameters() : currentPolicy.idleParameters());
+}
+
+QT_END_NAMESPACE
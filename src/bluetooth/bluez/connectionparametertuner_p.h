@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef CONNECTIONPARAMETERTUNER_P_H
+#define CONNECTIONPARAMETERTUNER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qtimer.h>
+
+#include <QtBluetooth/qlowenergyconnectionparameterpolicy.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * Applies a QLowEnergyConnectionParameterPolicy to a connection. The controller
+ * reports every PDU via observeTraffic(); the tuner emits updateRequested()
+ * whenever the connection enters a burst or becomes idle. The outcome of a request
+ * is reported back via updateApplied() or updateFailed(), requests which were
+ * rejected or not applied as asked for are repeated a few times.
+ */
+class Q_AUTOTEST_EXPORT ConnectionParameterTuner : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode { UnknownMode, IdleMode, BurstMode };
+
+    explicit ConnectionParameterTuner(const QLowEnergyConnectionParameterPolicy &policy,
+                                      QObject *parent = nullptr);
+
+    void setPolicy(const QLowEnergyConnectionParameterPolicy &policy);
+    QLowEnergyConnectionParameterPolicy policy() const { return currentPolicy; }
+
+    void start();
+    void stop();
+    bool isActive() const { return lastTraffic.isValid(); }
+    Mode mode() const { return currentMode; }
+    bool isUpdatePending() const { return updatePending; }
+
+    void updateApplied(const QLowEnergyConnectionParameters &parameters);
+    void updateFailed();
+    void setRetryInterval(int msecs) { retryInterval = msecs; }
+
+    void observeTraffic(int queueDepth, int bytes)
+    {
+        if (!lastTraffic.isValid())
+            return;
+        lastTraffic.restart();
+        windowBytes += bytes;
+        if (currentMode != BurstMode)
+            checkBurst(queueDepth);
+    }
+
+signals:
+    void updateRequested(const QLowEnergyConnectionParameters &parameters);
+
+private slots:
+    void checkIdle();
+    void requestUpdate();
+
+private:
+    void checkBurst(int queueDepth);
+    void setMode(Mode mode);
+    void scheduleRetry();
+
+    QLowEnergyConnectionParameterPolicy currentPolicy;
+    Mode currentMode = UnknownMode;
+    QElapsedTimer lastTraffic;
+    QElapsedTimer window;
+    qint64 windowBytes = 0;
+    QTimer idleTimer;
+    bool updatePending = false;
+    int retries = 0;
+    int retryInterval = 500;
+    QTimer retryTimer;
+};
+
+QT_END_NAMESPACE
+
+#endif // CONNECTIONPARAMETERTUNER_P_H
@@ -551,6 +551,15 @@ void HciManager::handleHciAclPacket(const quint8 *data, int size)
     }
 //    qCDebug(QT_BT_BLUEZ) << "l2cap channel id:" << l2CapHeader.channelId
 //                         << "payload length:" << l2CapHeader.length;
+    if (l2CapHeader.channelId == SIGNALING_CHANNEL_ID) {
+        // Connection Parameter Update Response, the result follows code, identifier and length.
+        // Spec v4.2, Vol 3, Part A, 4.21
+        if (l2CapHeader.length >= 6 && data[0] == 0x13 && bt_get_le16(data + 4) != 0) {
+            qCDebug(QT_BT_BLUEZ) << "remote device rejected connection parameter update";
+            emit connectionUpdateFailed(aclData->handle);
+        }
+        return;
+    }
     if (l2CapHeader.channelId != SECURITY_CHANNEL_ID)
         return;
     if (*data != 0xa) // "Signing Information". Spec v4.2, Vol 3, Part H, 3.6.6
@@ -592,6 +601,9 @@ void HciManager::handleLeMetaEvent(const quint8 *data)
             params.setLatency(qFromLittleEndian(updateData->latency));
             params.setSupervisionTimeout(qFromLittleEndian(updateData->timeout) * 10);
             emit connectionUpdate(qFromLittleEndian(updateData->handle), params);
+        } else {
+            qCDebug(QT_BT_BLUEZ) << "connection update failed with status" << updateData->status;
+            emit connectionUpdateFailed(qFromLittleEndian(updateData->handle));
         }
         break;
     }
@@ -41,8 +41,9 @@
 
 #include "remotedevicemanager_p.h"
 #include "bluez5_helper_p.h"
-#include "device1_bluez5_p.h"
-#include "objectmanager_p.h"
+
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusPendingCallWatcher>
 
 QT_BEGIN_NAMESPACE
 
@@ -51,12 +52,17 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 /*!
  * Convenience wrapper around org.bluez.Device1 management
  *
- * Very simple and not thread safe.
+ * Jobs are run concurrently, at most maximumParallelJobs() at a time.
+ * Each job reports its outcome via jobFinished(), finished() is emitted
+ * once the queue is drained.
+ *
+ * Not thread safe.
  */
 
 RemoteDeviceManager::RemoteDeviceManager(
         const QBluetoothAddress &address, QObject *parent)
-    : QObject(parent), localAddress(address)
+    : QObject(parent), localAddress(address), connection(QDBusConnection::systemBus()),
+      mirror(QtBluezObjectMirror::instance())
 {
     if (!isBluez5())
         return;
@@ -68,106 +74,105 @@ RemoteDeviceManager::RemoteDeviceManager(
     }
 }
 
+/*!
+ * Constructs a manager for the adapter at \a adapterPath which resolves devices
+ * via \a mirror and calls BlueZ on \a connection. This is meant for testing
+ * against a mock BlueZ on a private bus.
+ */
+RemoteDeviceManager::RemoteDeviceManager(const QDBusConnection &connection,
+                                         QtBluezObjectMirror *mirror,
+                                         const QString &adapterPath, QObject *parent)
+    : QObject(parent), adapterPath(adapterPath), connection(connection), mirror(mirror)
+{
+}
+
+/*!
+ * Limits the number of concurrently running jobs to \a jobs.
+ * Values smaller than 1 are treated as 1.
+ */
+void RemoteDeviceManager::setMaximumParallelJobs(int jobs)
+{
+    maxParallelJobs = qMax(1, jobs);
+    runQueue();
+}
+
 bool RemoteDeviceManager::scheduleJob(
         JobType job, const QVector<QBluetoothAddress> &remoteDevices)
 {
     if (adapterPath.isEmpty())
         return false;
 
+    // resolve the whole batch in one go, paths stay valid while the job is queued
     for (const auto& remote : remoteDevices)
-        jobQueue.push_back(std::make_pair(job, remote));
-
-    QTimer::singleShot(0, this, [this](){ runQueue(); });
+        jobQueue.push_back(Job{job, remote, mirror->devicePath(adapterPath, remote)});
+
+    if (!runPending) {
+        runPending = true;
+        QTimer::singleShot(0, this, [this](){
+            runPending = false;
+            runQueue();
+        });
+    }
     return true;
 }
 
 void RemoteDeviceManager::runQueue()
 {
-    if (jobInProgress || adapterPath.isEmpty())
+    if (adapterPath.isEmpty())
         return;
 
-    if (jobQueue.empty())
-        return;
+    while (activeJobs < maxParallelJobs && !jobQueue.empty()) {
+        const Job job = jobQueue.front();
+        jobQueue.pop_front();
 
-    jobInProgress = true;
-    switch (jobQueue.front().first) {
-    case JobType::JobDisconnectDevice:
-        disconnectDevice(jobQueue.front().second);
-        break;
-    default:
-        break;
+        ++activeJobs;
+        switch (job.type) {
+        case JobType::JobDisconnectDevice:
+            disconnectDevice(job);
+            break;
+        default:
+            jobDone(job, false);
+            break;
+        }
     }
 }
 
-void RemoteDeviceManager::prepareNextJob()
+void RemoteDeviceManager::jobDone(const Job &job, bool success)
 {
-    Q_ASSERT(!jobQueue.empty());
+    --activeJobs;
+    emit jobFinished(job.type, job.remote, success);
 
-    jobQueue.pop_front();
-    jobInProgress = false;
+    qCDebug(QT_BT_BLUEZ) << "RemoteDeviceManager job queue status:"
+                         << activeJobs << "active" << jobQueue.size() << "queued";
 
-    qDebug(QT_BT_BLUEZ) << "RemoteDeviceManager job queue status:" << jobQueue.empty();
-    if (jobQueue.empty())
-        emit finished();
-    else
+    if (!jobQueue.empty())
         runQueue();
+    else if (activeJobs == 0)
+        emit finished();
 }
 
-void RemoteDeviceManager::disconnectDevice(const QBluetoothAddress &remote)
+void RemoteDeviceManager::disconnectDevice(const Job &job)
 {
-    // collect initial set of information
-    OrgFreedesktopDBusObjectManagerInterface managerBluez5(
-                                               QStringLiteral("org.bluez"),
-                                               QStringLiteral("/"),
-                                               QDBusConnection::systemBus(), this);
-    QDBusPendingReply<ManagedObjectList> reply = managerBluez5.GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
-        QTimer::singleShot(0, this, [this](){ prepareNextJob(); });
+    if (job.devicePath.isEmpty()) {
+        qCDebug(QT_BT_BLUEZ) << "RemoteDeviceManager JobDisconnectDevice failed for" << job.remote;
+        QTimer::singleShot(0, this, [this, job](){ jobDone(job, false); });
         return;
     }
 
-    bool jobStarted = false;
-    ManagedObjectList managedObjectList = reply.value();
-    for (auto it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-        const QDBusObjectPath &path = it.key();
-        const InterfaceList &ifaceList = it.value();
-
-        for (auto jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-            const QString &iface = jt.key();
-
-            if (path.path().indexOf(adapterPath) != 0)
-                continue; //devices whose path doesn't start with same path we skip
-
-            if (iface != QStringLiteral("org.bluez.Device1"))
-                continue;
-
-            const QBluetoothAddress foundAddress(ifaceList.value(iface).value(QStringLiteral("Address")).toString());
-            if (foundAddress != remote)
-                continue;
-
-            // found the correct Device1 path
-            OrgBluezDevice1Interface* device1 = new OrgBluezDevice1Interface(QStringLiteral("org.bluez"),
-                                                                             path.path(),
-                                                                             QDBusConnection::systemBus(),
-                                                                             this);
-            QDBusPendingReply<> asyncReply = device1->Disconnect();
-            QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(asyncReply, this);
-            const auto watcherFinished = [this, device1](QDBusPendingCallWatcher* call) {
-                call->deleteLater();
-                device1->deleteLater();
-                prepareNextJob();
-            };
-            connect(watcher, &QDBusPendingCallWatcher::finished, this, watcherFinished);
-            jobStarted = true;
-            break;
-        }
-    }
-
-    if (!jobStarted) {
-        qDebug(QT_BT_BLUEZ) << "RemoteDeviceManager JobDisconnectDevice failed";
-        QTimer::singleShot(0, this, [this](){ prepareNextJob(); });
-    }
+    // the proxy object per device is not needed for a single call
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.bluez"),
+                                                          job.devicePath,
+                                                          QStringLiteral("org.bluez.Device1"),
+                                                          QStringLiteral("Disconnect"));
+    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(
+                connection.asyncCall(message), this);
+    const auto watcherFinished = [this, job](QDBusPendingCallWatcher* call) {
+        call->deleteLater();
+        if (call->isError())
+            qCDebug(QT_BT_BLUEZ) << "Cannot disconnect" << job.remote << call->error().message();
+        jobDone(job, !call->isError());
+    };
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, watcherFinished);
 }
 
 QT_END_NAMESPACE
@@ -58,13 +58,16 @@
 #include <QVector>
 
 #include <QtBluetooth/qbluetoothaddress.h>
+#include <QtDBus/qdbusconnection.h>
 
 
 QT_BEGIN_NAMESPACE
 
+class QtBluezObjectMirror;
+
 // This API is kept a bit more generic in anticipation of further changes in the future.
 
-class RemoteDeviceManager : public QObject
+class Q_AUTOTEST_EXPORT RemoteDeviceManager : public QObject
 {
     Q_OBJECT
 public:
@@ -74,24 +77,42 @@ public:
     };
 
     explicit RemoteDeviceManager(const QBluetoothAddress& localAddress, QObject *parent = 0);
+    RemoteDeviceManager(const QDBusConnection &connection, QtBluezObjectMirror *mirror,
+                        const QString &adapterPath, QObject *parent = 0);
 
-    bool isJobInProgress() const { return jobInProgress; }
+    bool isJobInProgress() const { return activeJobs > 0 || !jobQueue.empty(); }
     bool scheduleJob(JobType job, const QVector<QBluetoothAddress>& remoteDevices);
 
+    int maximumParallelJobs() const { return maxParallelJobs; }
+    void setMaximumParallelJobs(int jobs);
+
 signals:
+    void jobFinished(RemoteDeviceManager::JobType job, const QBluetoothAddress &remote,
+                     bool success);
     void finished();
 
 private slots:
     void runQueue();
-    void prepareNextJob();
 
 private:
-    void disconnectDevice(const QBluetoothAddress& remote);
+    struct Job
+    {
+        JobType type;
+        QBluetoothAddress remote;
+        QString devicePath;
+    };
+
+    void disconnectDevice(const Job &job);
+    void jobDone(const Job &job, bool success);
 
-    bool jobInProgress = false;
+    int activeJobs = 0;
+    int maxParallelJobs = 8;
+    bool runPending = false;
     QBluetoothAddress localAddress;
-    std::deque<std::pair<JobType, QBluetoothAddress>> jobQueue;
+    std::deque<Job> jobQueue;
     QString adapterPath;
+    QDBusConnection connection;
+    QtBluezObjectMirror *mirror;
 };
 
 QT_END_NAMESPACE
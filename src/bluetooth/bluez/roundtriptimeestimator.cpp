@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "roundtriptimeestimator_p.h"
+
+QT_BEGIN_NAMESPACE
+
+// lower bound of the variation term, covers the granularity of the request timer
+static const qint64 clockGranularity = 10000;
+
+RoundTripTimeEstimator::RoundTripTimeEstimator(int minimumMsecs, int maximumMsecs)
+{
+    setTimeoutRange(minimumMsecs, maximumMsecs);
+}
+
+/*
+ * Sets the range of the timeout. A \a minimumMsecs which is not smaller than
+ * \a maximumMsecs disables the estimation, the timeout is always \a maximumMsecs.
+ */
+void RoundTripTimeEstimator::setTimeoutRange(int minimumMsecs, int maximumMsecs)
+{
+    this->maximumMsecs = maximumMsecs;
+    this->minimumMsecs = qMin(minimumMsecs, maximumMsecs);
+    reset();
+}
+
+/*
+ * Adds the round trip time of a request which was answered, in microseconds.
+ * Requests which timed out or were sent more than once must not be sampled.
+ */
+void RoundTripTimeEstimator::addSample(qint64 usecs)
+{
+    if (usecs < 0)
+        return;
+
+    if (srtt < 0) {
+        srtt = usecs;
+        rttvar = usecs / 2;
+    } else {
+        const qint64 delta = srtt > usecs ? srtt - usecs : usecs - srtt;
+        rttvar = (3 * rttvar + delta) / 4;
+        srtt = (7 * srtt + usecs) / 8;
+    }
+
+    updateTimeout(srtt + qMax(clockGranularity, 4 * rttvar));
+}
+
+/*
+ * Doubles the timeout after a request timed out. The next sample recomputes it.
+ */
+void RoundTripTimeEstimator::backOff()
+{
+    updateTimeout(qint64(timeoutMsecs) * 2000);
+}
+
+void RoundTripTimeEstimator::reset()
+{
+    srtt = -1;
+    rttvar = 0;
+    timeoutMsecs = maximumMsecs;
+}
+
+void RoundTripTimeEstimator::updateTimeout(qint64 usecs)
+{
+    // round up, the timer must not fire before the estimated time
+    const qint64 msecs = (usecs + 999) / 1000;
+    timeoutMsecs = int(qBound<qint64>(minimumMsecs, msecs, maximumMsecs));
+}
+
+QT_END_NAMESPACE
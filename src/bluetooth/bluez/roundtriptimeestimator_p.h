@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef ROUNDTRIPTIMEESTIMATOR_P_H
+#define ROUNDTRIPTIMEESTIMATOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * Derives the timeout of ATT requests from the measured round trip times,
+ * following the SRTT/RTTVAR estimator of RFC 6298. The timeout is kept
+ * between minimumTimeout() and maximumTimeout(). Until the first sample
+ * arrives it equals maximumTimeout().
+ */
+class Q_AUTOTEST_EXPORT RoundTripTimeEstimator
+{
+public:
+    explicit RoundTripTimeEstimator(int minimumMsecs = 1000, int maximumMsecs = 20000);
+
+    void setTimeoutRange(int minimumMsecs, int maximumMsecs);
+    int minimumTimeout() const { return minimumMsecs; }
+    int maximumTimeout() const { return maximumMsecs; }
+
+    void addSample(qint64 usecs);
+    void backOff();
+    void reset();
+
+    int timeout() const { return timeoutMsecs; }
+    qint64 smoothedRoundTripTime() const { return srtt; }
+    qint64 roundTripTimeVariation() const { return rttvar; }
+
+private:
+    void updateTimeout(qint64 usecs);
+
+    int minimumMsecs;
+    int maximumMsecs;
+    int timeoutMsecs;
+    qint64 srtt = -1;       // usecs, negative until the first sample
+    qint64 rttvar = 0;      // usecs
+};
+
+QT_END_NAMESPACE
+
+#endif // ROUNDTRIPTIMEESTIMATOR_P_H
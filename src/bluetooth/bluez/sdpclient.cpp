@@ -0,0 +1,440 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "sdpclient_p.h"
+#include "sdpdataelement_p.h"
+#include "bluez_data_p.h"
+#include "../qbluetoothsocket_p.h"
+
+#include <QtBluetooth/qbluetoothsocket.h>
+
+#include <QtCore/qendian.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qtimer.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+static const quint16 sdpPsm = 0x0001;
+static const int sdpHeaderSize = 5;
+static const int queryTimeout = 10000; // ms without response
+// upper bound for the attribute lists of one transaction, which the remote
+// device can extend with any number of continuation responses
+static const int maximumAttributeListsSize = 256 * 1024;
+
+enum SdpPduId {
+    ErrorResponse = 0x01,
+    ServiceSearchAttributeRequest = 0x06,
+    ServiceSearchAttributeResponse = 0x07
+};
+
+/*!
+    \internal
+    \class SdpClient
+
+    Performs SDP_ServiceSearchAttributeRequest transactions against remote
+    devices over an L2CAP connection on PSM 1. The returned data elements are
+    decoded directly into QBluetoothServiceInfo attributes.
+
+    Queries for several devices run concurrently, at most
+    maximumParallelQueries() at a time. Every service record is reported by
+    serviceFound() as soon as its transaction completes, queryFinished() is
+    emitted once all records of a device were received.
+*/
+
+SdpClient::SdpClient(const QBluetoothAddress &address, QObject *parent)
+    : QObject(parent), localAddress(address)
+{
+}
+
+SdpClient::~SdpClient()
+{
+    cancel();
+}
+
+/*!
+    Limits the number of devices queried at the same time to \a queries.
+    Values smaller than 1 are treated as 1.
+*/
+void SdpClient::setMaximumParallelQueries(int queries)
+{
+    maxParallelQueries = qMax(1, queries);
+    startQueries();
+}
+
+/*!
+    Queries all service records of \a remote which contain at least one of
+    \a uuids. If \a uuids is empty, the records of the public browse group are
+    returned.
+*/
+void SdpClient::query(const QBluetoothAddress &remote, const QList<QBluetoothUuid> &uuids)
+{
+    Query *query = new Query;
+    query->remote = remote;
+    query->uuids = uuids;
+
+    // a service search pattern matches records containing all of its UUIDs,
+    // hence one transaction per UUID
+    if (query->uuids.isEmpty())
+        query->uuids.append(QBluetoothUuid(QBluetoothUuid::PublicBrowseGroup));
+
+    pending.append(query);
+    startQueries();
+}
+
+/*!
+    Aborts all running and pending queries without emitting queryFinished().
+*/
+void SdpClient::cancel()
+{
+    qDeleteAll(pending);
+    pending.clear();
+
+    const QList<Query *> queries = running;
+    running.clear();
+    foreach (Query *query, queries)
+        releaseQuery(query);
+}
+
+void SdpClient::startQueries()
+{
+    while (running.count() < maxParallelQueries && !pending.isEmpty()) {
+        Query *query = pending.takeFirst();
+        running.append(query);
+
+        query->timer = new QTimer(this);
+        query->timer->setSingleShot(true);
+        query->timer->setInterval(queryTimeout);
+        connect(query->timer, &QTimer::timeout, this, [this, query]() {
+            finishQuery(query, tr("Timeout during SDP query"));
+        });
+
+        connectSocket(query);
+    }
+}
+
+void SdpClient::connectSocket(Query *query)
+{
+    QBluetoothSocket *socket = new QBluetoothSocket(QBluetoothServiceInfo::L2capProtocol, this);
+    query->socket = socket;
+    query->rxBuffer.clear();
+    query->attributeLists.clear();
+
+    connect(socket, &QBluetoothSocket::connected, this, [this, query]() {
+        sendRequest(query, QByteArray());
+    });
+    connect(socket, &QBluetoothSocket::readyRead, this, [this, query]() {
+        readResponses(query);
+    });
+    connect(socket, static_cast<void (QBluetoothSocket::*)(QBluetoothSocket::SocketError)>(&QBluetoothSocket::error),
+            this, [this, query]() {
+        socketError(query);
+    });
+
+    // SDP does not require any security, it is needed to pair in the first place
+    socket->setPreferredSecurityFlags(QBluetooth::NoSecurity);
+
+    if (!localAddress.isNull()) {
+        sockaddr_l2 addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.l2_family = AF_BLUETOOTH;
+        convertAddress(localAddress.toUInt64(), addr.l2_bdaddr.b);
+
+        // bind the socket to the local device
+        if (::bind(socket->socketDescriptor(), (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            qCWarning(QT_BT_BLUEZ) << "Cannot bind SDP socket:" << qt_error_string(errno);
+            // the timer is deleted together with the query, which cancels the call
+            QTimer::singleShot(0, query->timer, [this, query]() {
+                finishQuery(query, tr("Cannot bind SDP socket"));
+            });
+            return;
+        }
+    }
+
+    query->timer->start();
+    socket->connectToService(query->remote, sdpPsm, QIODevice::ReadWrite | QIODevice::Unbuffered);
+}
+
+/*!
+    Returns the SDP_ServiceSearchAttributeRequest PDU with \a transactionId for all
+    attributes of the records matching \a uuid. \a continuationState is empty
+    for the first request of a transaction.
+*/
+QByteArray SdpClient::serviceSearchAttributeRequest(quint16 transactionId,
+                                                    const QBluetoothUuid &uuid,
+                                                    const QByteArray &continuationState)
+{
+    QByteArray pdu;
+    pdu.reserve(sdpHeaderSize + 30);
+
+    pdu.append(char(ServiceSearchAttributeRequest));
+    pdu.append(char(transactionId >> 8));
+    pdu.append(char(transactionId & 0xff));
+    pdu.append(2, 0); // parameter length, set below
+
+    // ServiceSearchPattern, the smallest UUID representation is used
+    bool ok;
+    switch (uuid.minimumSize()) {
+    case 2: {
+        const quint16 value = uuid.toUInt16(&ok);
+        pdu.append("\x35\x03\x19", 3);
+        pdu.append(char(value >> 8));
+        pdu.append(char(value & 0xff));
+        break;
+    }
+    case 4: {
+        const quint32 value = uuid.toUInt32(&ok);
+        pdu.append("\x35\x05\x1a", 3);
+        for (int shift = 24; shift >= 0; shift -= 8)
+            pdu.append(char(value >> shift));
+        break;
+    }
+    default: {
+        const quint128 value = uuid.toUInt128();
+        pdu.append("\x35\x11\x1c", 3);
+        pdu.append(reinterpret_cast<const char *>(value.data), 16);
+        break;
+    }
+    }
+
+    // MaximumAttributeByteCount
+    pdu.append("\xff\xff", 2);
+
+    // AttributeIDList, the range 0x0000 - 0xffff
+    pdu.append("\x35\x05\x0a\x00\x00\xff\xff", 7);
+
+    pdu.append(char(continuationState.size()));
+    pdu.append(continuationState);
+
+    const quint16 parameterLength = pdu.size() - sdpHeaderSize;
+    pdu[3] = char(parameterLength >> 8);
+    pdu[4] = char(parameterLength & 0xff);
+
+    return pdu;
+}
+
+/*!
+    Parses the complete response \a pdu to the request with \a transactionId.
+    The AttributeLists bytes of the response are appended to \a attributeLists,
+    \a continuationState is set to the state for the next request. Returns
+    \c false if the PDU is malformed or an error response. In the latter case
+    \a errorCode is set.
+*/
+bool SdpClient::parseServiceSearchAttributeResponse(const QByteArray &pdu, quint16 transactionId,
+                                                    QByteArray *attributeLists,
+                                                    QByteArray *continuationState,
+                                                    quint16 *errorCode)
+{
+    *errorCode = 0;
+    if (pdu.size() < sdpHeaderSize)
+        return false;
+
+    const char *data = pdu.constData();
+    const int parameterLength = qFromBigEndian<quint16>(data + 3);
+    if (qFromBigEndian<quint16>(data + 1) != transactionId
+            || pdu.size() != sdpHeaderSize + parameterLength) {
+        return false;
+    }
+
+    data += sdpHeaderSize;
+    switch (quint8(pdu.at(0))) {
+    case ErrorResponse:
+        if (parameterLength >= 2)
+            *errorCode = qFromBigEndian<quint16>(data);
+        return false;
+    case ServiceSearchAttributeResponse: {
+        if (parameterLength < 3)
+            return false;
+
+        const int byteCount = qFromBigEndian<quint16>(data);
+        if (parameterLength < 2 + byteCount + 1)
+            return false;
+
+        const int continuationLength = quint8(data[2 + byteCount]);
+        if (continuationLength > 16 || parameterLength != 2 + byteCount + 1 + continuationLength)
+            return false;
+
+        attributeLists->append(data + 2, byteCount);
+        *continuationState = QByteArray(data + 2 + byteCount + 1, continuationLength);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void SdpClient::sendRequest(Query *query, const QByteArray &continuationState)
+{
+    if (continuationState.isEmpty())
+        ++query->transactionId;
+
+    query->timer->start();
+    query->socket->write(serviceSearchAttributeRequest(query->transactionId,
+                                                       query->uuids.first(),
+                                                       continuationState));
+}
+
+void SdpClient::readResponses(Query *query)
+{
+    // serviceFound() and queryFinished() may cancel the query
+    ++query->processing;
+    processResponses(query);
+    --query->processing;
+
+    if (query->released && query->processing == 0)
+        delete query;
+}
+
+void SdpClient::processResponses(Query *query)
+{
+    query->rxBuffer.append(query->socket->readAll());
+
+    while (query->rxBuffer.size() >= sdpHeaderSize) {
+        const int pduSize = sdpHeaderSize
+                + qFromBigEndian<quint16>(query->rxBuffer.constData() + 3);
+        if (query->rxBuffer.size() < pduSize)
+            return;
+
+        const QByteArray pdu = query->rxBuffer.left(pduSize);
+        query->rxBuffer.remove(0, pduSize);
+
+        QByteArray continuationState;
+        quint16 errorCode;
+        if (!parseServiceSearchAttributeResponse(pdu, query->transactionId,
+                                                 &query->attributeLists,
+                                                 &continuationState, &errorCode)) {
+            qCWarning(QT_BT_BLUEZ) << "SDP query failed for" << query->remote
+                                   << "error code" << errorCode;
+            finishQuery(query, tr("Invalid SDP response"));
+            return;
+        }
+
+        if (query->attributeLists.size() > maximumAttributeListsSize) {
+            qCWarning(QT_BT_BLUEZ) << "SDP response of" << query->remote << "is too large";
+            finishQuery(query, tr("Invalid SDP response"));
+            return;
+        }
+
+        if (!continuationState.isEmpty()) {
+            sendRequest(query, continuationState);
+            continue;
+        }
+
+        // transaction complete
+        QList<QMap<quint16, QVariant> > records;
+        if (!SdpDataElement::decodeAttributeLists(query->attributeLists, &records)) {
+            finishQuery(query, tr("Invalid SDP response"));
+            return;
+        }
+        query->attributeLists.clear();
+
+        for (int i = 0; i < records.count(); ++i) {
+            QBluetoothServiceInfo info;
+            const QMap<quint16, QVariant> &attributes = records.at(i);
+            for (QMap<quint16, QVariant>::const_iterator it = attributes.constBegin();
+                 it != attributes.constEnd(); ++it) {
+                info.setAttribute(it.key(), it.value());
+            }
+            emit serviceFound(query->remote, info);
+            if (query->released)
+                return;
+        }
+
+        query->uuids.removeFirst();
+        if (query->uuids.isEmpty()) {
+            finishQuery(query, QString());
+            return;
+        }
+
+        sendRequest(query, QByteArray());
+    }
+}
+
+void SdpClient::socketError(Query *query)
+{
+    const QString errorString = query->socket->errorString();
+
+    // the remote may still be busy with a previous connection, try once more
+    if (query->socket->state() != QBluetoothSocket::ConnectedState && !query->retried
+            && query->transactionId == 0) {
+        qCDebug(QT_BT_BLUEZ) << "Retrying SDP connection to" << query->remote << errorString;
+        query->retried = true;
+        query->socket->disconnect(this);
+        query->socket->deleteLater();
+        connectSocket(query);
+        return;
+    }
+
+    finishQuery(query, errorString);
+}
+
+void SdpClient::finishQuery(Query *query, const QString &errorString)
+{
+    if (!running.removeOne(query))
+        return;
+
+    const QBluetoothAddress remote = query->remote;
+    releaseQuery(query);
+
+    emit queryFinished(remote, errorString);
+    startQueries();
+}
+
+/*!
+    Stops all activity of the running \a query and frees it. A query which is
+    being processed by readResponses() is freed once it returns.
+*/
+void SdpClient::releaseQuery(Query *query)
+{
+    query->timer->stop();
+    query->timer->disconnect(this);
+    query->timer->deleteLater();
+
+    query->socket->disconnect(this);
+    query->socket->abort();
+    query->socket->deleteLater();
+
+    if (query->processing > 0)
+        query->released = true;
+    else
+        delete query;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SDPCLIENT_P_H
+#define SDPCLIENT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+
+#include <QtBluetooth/qbluetoothaddress.h>
+#include <QtBluetooth/qbluetoothserviceinfo.h>
+#include <QtBluetooth/qbluetoothuuid.h>
+
+QT_BEGIN_NAMESPACE
+
+class QBluetoothSocket;
+class QTimer;
+
+class Q_AUTOTEST_EXPORT SdpClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SdpClient(const QBluetoothAddress &localAddress, QObject *parent = nullptr);
+    ~SdpClient();
+
+    int maximumParallelQueries() const { return maxParallelQueries; }
+    void setMaximumParallelQueries(int queries);
+
+    void query(const QBluetoothAddress &remote, const QList<QBluetoothUuid> &uuids);
+    void cancel();
+    bool isActive() const { return !running.isEmpty() || !pending.isEmpty(); }
+
+    static QByteArray serviceSearchAttributeRequest(quint16 transactionId,
+                                                    const QBluetoothUuid &uuid,
+                                                    const QByteArray &continuationState);
+    static bool parseServiceSearchAttributeResponse(const QByteArray &pdu, quint16 transactionId,
+                                                    QByteArray *attributeLists,
+                                                    QByteArray *continuationState,
+                                                    quint16 *errorCode);
+
+signals:
+    void serviceFound(const QBluetoothAddress &remote, const QBluetoothServiceInfo &info);
+    void queryFinished(const QBluetoothAddress &remote, const QString &errorString);
+
+private:
+    struct Query
+    {
+        QBluetoothAddress remote;
+        QList<QBluetoothUuid> uuids;
+        QBluetoothSocket *socket = nullptr;
+        QTimer *timer = nullptr;
+        quint16 transactionId = 0;
+        bool retried = false;
+        // set while readResponses() uses the query, which then frees it once released
+        int processing = 0;
+        bool released = false;
+        QByteArray rxBuffer;
+        QByteArray attributeLists;
+    };
+
+    void startQueries();
+    void connectSocket(Query *query);
+    void sendRequest(Query *query, const QByteArray &continuationState);
+    void readResponses(Query *query);
+    void processResponses(Query *query);
+    void socketError(Query *query);
+    void finishQuery(Query *query, const QString &errorString);
+    void releaseQuery(Query *query);
+
+    QBluetoothAddress localAddress;
+    int maxParallelQueries = 4;
+    QList<Query *> pending;
+    QList<Query *> running;
+};
+
+QT_END_NAMESPACE
+
+#endif // SDPCLIENT_P_H
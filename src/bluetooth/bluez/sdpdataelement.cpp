@@ -0,0 +1,572 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "sdpdataelement_p.h"
+
+#include <QtCore/qendian.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qurl.h>
+#include <QtBluetooth/qbluetoothserviceinfo.h>
+#include <QtBluetooth/qbluetoothuuid.h>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+/*!
+    \internal
+    \class SdpDataElement
+
+    Converts SDP data elements from and to the QVariant representation used by
+    QBluetoothServiceInfo::attribute(). All multi byte values are big endian.
+*/
+
+template <typename T>
+static void appendBigEndian(QByteArray *data, T value)
+{
+    const int pos = data->size();
+    data->resize(pos + int(sizeof(T)));
+    qToBigEndian(value, reinterpret_cast<uchar *>(data->data() + pos));
+}
+
+static void appendFixedSize(QByteArray *data, SdpDataElement::Type type, const char *value,
+                            int size)
+{
+    int sizeIndex = 0;
+    while ((1 << sizeIndex) < size)
+        ++sizeIndex;
+
+    data->append(char((type << 3) | sizeIndex));
+    data->append(value, size);
+}
+
+template <typename T>
+static void appendFixedSize(QByteArray *data, SdpDataElement::Type type, T value)
+{
+    data->append(char((type << 3) | (sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1
+                                     : sizeof(T) == 4 ? 2 : 3)));
+    appendBigEndian(data, value);
+}
+
+// Inserts the header of a variable sized element whose data starts at pos.
+static void insertVariableSizeHeader(QByteArray *data, SdpDataElement::Type type, int pos)
+{
+    const quint32 size = data->size() - pos;
+
+    char header[5];
+    int headerSize;
+    if (size <= 0xff) {
+        header[0] = char((type << 3) | 5);
+        header[1] = char(size);
+        headerSize = 2;
+    } else if (size <= 0xffff) {
+        header[0] = char((type << 3) | 6);
+        qToBigEndian(quint16(size), reinterpret_cast<uchar *>(header + 1));
+        headerSize = 3;
+    } else {
+        header[0] = char((type << 3) | 7);
+        qToBigEndian(size, reinterpret_cast<uchar *>(header + 1));
+        headerSize = 5;
+    }
+
+    data->insert(pos, header, headerSize);
+}
+
+static void appendVariableSize(QByteArray *data, SdpDataElement::Type type,
+                               const QByteArray &value)
+{
+    const int pos = data->size();
+    data->append(value);
+    insertVariableSizeHeader(data, type, pos);
+}
+
+/*!
+    Reads the data element header at \a data and advances \a data past it.
+    \a size is the number of data bytes following the header.
+    Returns \c false if the header is truncated or the data exceeds \a end.
+*/
+bool SdpDataElement::readHeader(const char *&data, const char *end, Type *type, quint32 *size)
+{
+    if (data >= end)
+        return false;
+
+    const quint8 header = quint8(*data++);
+    *type = static_cast<Type>(header >> 3);
+
+    const quint8 sizeIndex = header & 0x07;
+    switch (sizeIndex) {
+    case 0:
+        *size = (*type == Nil) ? 0 : 1;
+        break;
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+        *size = 1 << sizeIndex;
+        break;
+    case 5:
+        if (end - data < 1)
+            return false;
+        *size = quint8(*data);
+        data += 1;
+        break;
+    case 6:
+        if (end - data < 2)
+            return false;
+        *size = qFromBigEndian<quint16>(data);
+        data += 2;
+        break;
+    case 7:
+        if (end - data < 4)
+            return false;
+        *size = qFromBigEndian<quint32>(data);
+        data += 4;
+        break;
+    }
+
+    return quint32(end - data) >= *size;
+}
+
+/*!
+    Decodes the data element at \a data and advances \a data past it. \a ok is
+    set to \c false if the element is malformed or sequences and alternatives are
+    nested deeper than MaximumNestingDepth. \a depth is the nesting depth of the
+    element. Elements without a Qt representation, such as 128 bit integers, are
+    returned as invalid QVariant.
+*/
+QVariant SdpDataElement::decode(const char *&data, const char *end, bool *ok, int depth)
+{
+    Type type;
+    quint32 size;
+    if (!readHeader(data, end, &type, &size)) {
+        *ok = false;
+        return QVariant();
+    }
+
+    const char *element = data;
+    data += size;
+    *ok = true;
+
+    switch (type) {
+    case Nil:
+        return QVariant();
+    case UnsignedInteger:
+        switch (size) {
+        case 1: return QVariant::fromValue(quint8(*element));
+        case 2: return QVariant::fromValue(qFromBigEndian<quint16>(element));
+        case 4: return QVariant::fromValue(qFromBigEndian<quint32>(element));
+        case 8: return QVariant::fromValue(qFromBigEndian<quint64>(element));
+        }
+        break;
+    case SignedInteger:
+        switch (size) {
+        case 1: return QVariant::fromValue(qint8(*element));
+        case 2: return QVariant::fromValue(qFromBigEndian<qint16>(element));
+        case 4: return QVariant::fromValue(qFromBigEndian<qint32>(element));
+        case 8: return QVariant::fromValue(qFromBigEndian<qint64>(element));
+        }
+        break;
+    case Uuid:
+        switch (size) {
+        case 2:
+            return QVariant::fromValue(QBluetoothUuid(qFromBigEndian<quint16>(element)));
+        case 4:
+            return QVariant::fromValue(QBluetoothUuid(qFromBigEndian<quint32>(element)));
+        case 16: {
+            quint128 uuid;
+            memcpy(uuid.data, element, 16);
+            return QVariant::fromValue(QBluetoothUuid(uuid));
+        }
+        }
+        *ok = false;
+        return QVariant();
+    case Text:
+    case Url: {
+        // some stacks include the terminating zero
+        const int length = qstrnlen(element, size);
+        return QString::fromUtf8(element, length);
+    }
+    case Boolean:
+        if (size != 1)
+            break;
+        return bool(*element);
+    case Sequence:
+    case Alternative: {
+        if (depth >= MaximumNestingDepth) {
+            qCWarning(QT_BT_BLUEZ) << "SDP data elements nested too deeply";
+            *ok = false;
+            return QVariant();
+        }
+
+        QList<QVariant> values;
+        const char *elementEnd = element + size;
+        while (element < elementEnd) {
+            const QVariant value = decode(element, elementEnd, ok, depth + 1);
+            if (!*ok)
+                return QVariant();
+            values.append(value);
+        }
+
+        if (type == Sequence) {
+            QBluetoothServiceInfo::Sequence sequence;
+            sequence.append(values);
+            return QVariant::fromValue(sequence);
+        }
+
+        QBluetoothServiceInfo::Alternative alternative;
+        alternative.append(values);
+        return QVariant::fromValue(alternative);
+    }
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Skipping SDP data element of type" << int(type) << "size" << size;
+    return QVariant();
+}
+
+/*!
+    Decodes the attribute list at \a data, a sequence of attribute id and value
+    pairs, into \a attributes and advances \a data past it.
+*/
+bool SdpDataElement::decodeAttributeList(const char *&data, const char *end,
+                                         QMap<quint16, QVariant> *attributes)
+{
+    Type type;
+    quint32 size;
+    if (!readHeader(data, end, &type, &size) || type != Sequence)
+        return false;
+
+    const char *listEnd = data + size;
+    while (data < listEnd) {
+        bool ok;
+        const QVariant id = decode(data, listEnd, &ok);
+        if (!ok || id.userType() != QMetaType::UShort)
+            return false;
+
+        const QVariant value = decode(data, listEnd, &ok);
+        if (!ok)
+            return false;
+
+        attributes->insert(id.value<quint16>(), value);
+    }
+
+    return true;
+}
+
+/*!
+    Decodes the AttributeLists parameter of an SDP_ServiceSearchAttributeResponse,
+    a sequence of attribute lists, into one attribute map per service record.
+*/
+bool SdpDataElement::decodeAttributeLists(const QByteArray &data,
+                                          QList<QMap<quint16, QVariant> > *records)
+{
+    const char *begin = data.constData();
+    const char *end = begin + data.size();
+
+    Type type;
+    quint32 size;
+    if (!readHeader(begin, end, &type, &size) || type != Sequence)
+        return false;
+
+    const char *listsEnd = begin + size;
+    while (begin < listsEnd) {
+        QMap<quint16, QVariant> attributes;
+        if (!decodeAttributeList(begin, listsEnd, &attributes))
+            return false;
+        records->append(attributes);
+    }
+
+    return true;
+}
+
+/*!
+    Appends the data element encoding of \a value to \a data. Integers keep the
+    width of their QVariant type, UUIDs use their minimum size.
+    Returns \c false, leaving \a data unchanged, if \a value or one of its
+    members has no SDP representation.
+*/
+bool SdpDataElement::encode(const QVariant &value, QByteArray *data)
+{
+    const int pos = data->size();
+
+    switch (value.userType()) {
+    case QMetaType::UnknownType:
+    case QMetaType::Void:
+        data->append(char(Nil));
+        return true;
+    case QMetaType::UChar:
+        appendFixedSize(data, UnsignedInteger, value.value<quint8>());
+        return true;
+    case QMetaType::UShort:
+        appendFixedSize(data, UnsignedInteger, value.value<quint16>());
+        return true;
+    case QMetaType::UInt:
+        appendFixedSize(data, UnsignedInteger, value.value<quint32>());
+        return true;
+    case QMetaType::ULongLong:
+        appendFixedSize(data, UnsignedInteger, value.value<quint64>());
+        return true;
+    case QMetaType::Char:
+    case QMetaType::SChar:
+        appendFixedSize(data, SignedInteger, value.value<qint8>());
+        return true;
+    case QMetaType::Short:
+        appendFixedSize(data, SignedInteger, value.value<qint16>());
+        return true;
+    case QMetaType::Int:
+        appendFixedSize(data, SignedInteger, value.value<qint32>());
+        return true;
+    case QMetaType::LongLong:
+        appendFixedSize(data, SignedInteger, value.value<qint64>());
+        return true;
+    case QMetaType::Bool:
+        appendFixedSize(data, Boolean, quint8(value.toBool()));
+        return true;
+    case QMetaType::QString:
+        appendVariableSize(data, Text, value.toString().toUtf8());
+        return true;
+    case QMetaType::QUrl:
+        appendVariableSize(data, Url, value.toUrl().toEncoded());
+        return true;
+    default:
+        break;
+    }
+
+    if (value.userType() == qMetaTypeId<QBluetoothUuid>()) {
+        const QBluetoothUuid uuid = value.value<QBluetoothUuid>();
+        switch (uuid.minimumSize()) {
+        case 0:
+            appendFixedSize(data, Uuid, quint16(0));
+            break;
+        case 2:
+            appendFixedSize(data, Uuid, uuid.toUInt16());
+            break;
+        case 4:
+            appendFixedSize(data, Uuid, uuid.toUInt32());
+            break;
+        default: {
+            const quint128 uuid128 = uuid.toUInt128();
+            appendFixedSize(data, Uuid, reinterpret_cast<const char *>(uuid128.data), 16);
+            break;
+        }
+        }
+        return true;
+    }
+
+    Type type;
+    QList<QVariant> values;
+    if (value.userType() == qMetaTypeId<QBluetoothServiceInfo::Sequence>()) {
+        type = Sequence;
+        values = value.value<QBluetoothServiceInfo::Sequence>();
+    } else if (value.userType() == qMetaTypeId<QBluetoothServiceInfo::Alternative>()) {
+        type = Alternative;
+        values = value.value<QBluetoothServiceInfo::Alternative>();
+    } else {
+        qCWarning(QT_BT_BLUEZ) << "Cannot encode SDP attribute of type" << value.typeName();
+        return false;
+    }
+
+    for (int i = 0; i < values.count(); ++i) {
+        if (!encode(values.at(i), data)) {
+            data->truncate(pos);
+            return false;
+        }
+    }
+
+    insertVariableSizeHeader(data, type, pos);
+    return true;
+}
+
+/*!
+    Appends \a attributes as a single attribute list to \a data. Attributes
+    which cannot be encoded are skipped.
+*/
+void SdpDataElement::encodeAttributeList(const QMap<quint16, QVariant> &attributes,
+                                         QByteArray *data)
+{
+    const int pos = data->size();
+
+    for (QMap<quint16, QVariant>::const_iterator it = attributes.constBegin();
+         it != attributes.constEnd(); ++it) {
+        const int attributePos = data->size();
+        appendFixedSize(data, UnsignedInteger, it.key());
+        if (!encode(it.value(), data)) {
+            qCWarning(QT_BT_BLUEZ) << "Skipping SDP attribute" << hex << it.key();
+            data->truncate(attributePos);
+        }
+    }
+
+    insertVariableSizeHeader(data, Sequence, pos);
+}
+
+static void appendHex(QString *xml, const char *data, int size)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    xml->append(QLatin1String("0x"));
+    for (int i = 0; i < size; ++i) {
+        const quint8 byte = quint8(data[i]);
+        xml->append(QLatin1Char(digits[byte >> 4]));
+        xml->append(QLatin1Char(digits[byte & 0x0f]));
+    }
+}
+
+static void appendIntegerElement(QString *xml, const char *name, int size)
+{
+    xml->append(QLatin1Char('<'));
+    xml->append(QLatin1String(name));
+    xml->append(QString::number(size * 8));
+    xml->append(QLatin1String(" value=\""));
+}
+
+static bool appendXmlElement(const char *&data, const char *end, QString *xml, int depth = 0)
+{
+    SdpDataElement::Type type;
+    quint32 size;
+    if (!SdpDataElement::readHeader(data, end, &type, &size))
+        return false;
+
+    const char *element = data;
+    data += size;
+
+    switch (type) {
+    case SdpDataElement::Nil:
+        xml->append(QLatin1String("<nil/>"));
+        return true;
+    case SdpDataElement::UnsignedInteger:
+        if (size > 8)
+            return false;
+        appendIntegerElement(xml, "uint", size);
+        appendHex(xml, element, size);
+        break;
+    case SdpDataElement::SignedInteger:
+        appendIntegerElement(xml, "int", size);
+        switch (size) {
+        case 1: xml->append(QString::number(qint8(*element))); break;
+        case 2: xml->append(QString::number(qFromBigEndian<qint16>(element))); break;
+        case 4: xml->append(QString::number(qFromBigEndian<qint32>(element))); break;
+        case 8: xml->append(QString::number(qFromBigEndian<qint64>(element))); break;
+        default: return false;
+        }
+        break;
+    case SdpDataElement::Uuid:
+        xml->append(QLatin1String("<uuid value=\""));
+        if (size == 2 || size == 4) {
+            appendHex(xml, element, size);
+        } else if (size == 16) {
+            quint128 uuid;
+            memcpy(uuid.data, element, 16);
+            xml->append(QBluetoothUuid(uuid).toString().midRef(1, 36));
+        } else {
+            return false;
+        }
+        break;
+    case SdpDataElement::Text:
+    case SdpDataElement::Url:
+        xml->append(QLatin1String(type == SdpDataElement::Text ? "<text value=\"" : "<url value=\""));
+        xml->append(QString::fromUtf8(element, qstrnlen(element, size)).toHtmlEscaped());
+        break;
+    case SdpDataElement::Boolean:
+        if (size != 1)
+            return false;
+        xml->append(QLatin1String(*element ? "<boolean value=\"true" : "<boolean value=\"false"));
+        break;
+    case SdpDataElement::Sequence:
+    case SdpDataElement::Alternative: {
+        if (depth >= SdpDataElement::MaximumNestingDepth)
+            return false;
+
+        const bool sequence = type == SdpDataElement::Sequence;
+        xml->append(QLatin1String(sequence ? "<sequence>" : "<alternate>"));
+        const char *elementEnd = data;
+        while (element < elementEnd) {
+            if (!appendXmlElement(element, elementEnd, xml, depth + 1))
+                return false;
+        }
+        xml->append(QLatin1String(sequence ? "</sequence>" : "</alternate>"));
+        return true;
+    }
+    default:
+        return false;
+    }
+
+    xml->append(QLatin1String("\"/>"));
+    return true;
+}
+
+/*!
+    Converts the attribute list \a data created by encodeAttributeList() into the
+    XML record format accepted by BlueZ and stores it in \a xml.
+*/
+bool SdpDataElement::attributeListToXml(const QByteArray &data, QString *xml)
+{
+    const char *begin = data.constData();
+    const char *end = begin + data.size();
+
+    Type type;
+    quint32 size;
+    if (!readHeader(begin, end, &type, &size) || type != Sequence)
+        return false;
+
+    xml->clear();
+    xml->reserve(data.size() * 4);
+    xml->append(QLatin1String("<?xml version=\"1.0\" encoding=\"UTF-8\"?><record>"));
+
+    const char *listEnd = begin + size;
+    while (begin < listEnd) {
+        if (!readHeader(begin, listEnd, &type, &size) || type != UnsignedInteger || size != 2)
+            return false;
+
+        xml->append(QLatin1String("<attribute id=\""));
+        appendHex(xml, begin, 2);
+        xml->append(QLatin1String("\">"));
+        begin += 2;
+
+        if (!appendXmlElement(begin, listEnd, xml))
+            return false;
+
+        xml->append(QLatin1String("</attribute>"));
+    }
+
+    xml->append(QLatin1String("</record>"));
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,100 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SDPDATAELEMENT_P_H
+#define SDPDATAELEMENT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qvariant.h>
+
+#include <QtBluetooth/qbluetoothglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+// Binary representation of SDP attribute values,
+// Bluetooth Core Specification Vol 3, Part B, 3.
+// Shared by service discovery and service registration.
+class Q_AUTOTEST_EXPORT SdpDataElement
+{
+public:
+    enum Type {
+        Nil = 0,
+        UnsignedInteger = 1,
+        SignedInteger = 2,
+        Uuid = 3,
+        Text = 4,
+        Boolean = 5,
+        Sequence = 6,
+        Alternative = 7,
+        Url = 8
+    };
+
+    // remote devices control the nesting of sequences and alternatives
+    enum { MaximumNestingDepth = 32 };
+
+    static QVariant decode(const char *&data, const char *end, bool *ok, int depth = 0);
+    static bool decodeAttributeList(const char *&data, const char *end,
+                                    QMap<quint16, QVariant> *attributes);
+    static bool decodeAttributeLists(const QByteArray &data,
+                                     QList<QMap<quint16, QVariant> > *records);
+
+    static bool encode(const QVariant &value, QByteArray *data);
+    static void encodeAttributeList(const QMap<quint16, QVariant> &attributes, QByteArray *data);
+
+    static bool attributeListToXml(const QByteArray &data, QString *xml);
+
+    static bool readHeader(const char *&data, const char *end, Type *type, quint32 *size);
+};
+
+QT_END_NAMESPACE
+
+#endif // SDPDATAELEMENT_P_H
@@ -0,0 +1,167 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "servicediscoveryscheduler_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \internal
+    \class ServiceDiscoveryScheduler
+
+    Decides in which order and how many remote devices are scanned for services
+    at the same time. discoveryStarted() is emitted for a device once it may be
+    scanned, the scan is expected to report its end with deviceFinished().
+    finished() is emitted after the last device.
+
+    Devices whose UUIDs are already cached by BlueZ are started first. They
+    were seen recently and usually answer quickly, whereas unknown devices tend
+    to run into connection timeouts.
+*/
+
+ServiceDiscoveryScheduler::ServiceDiscoveryScheduler(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/*!
+    Limits the number of devices scanned at the same time to \a count.
+    Values smaller than 1 are treated as 1.
+*/
+void ServiceDiscoveryScheduler::setMaximumParallelDiscoveries(int count)
+{
+    maxParallelDiscoveries = qMax(1, count);
+    if (started)
+        startDiscoveries();
+}
+
+/*!
+    Adds \a device to the queue. Devices with \a hasCachedUuids are queued
+    ahead of all devices without, otherwise the order of the calls is kept.
+*/
+void ServiceDiscoveryScheduler::enqueue(const QBluetoothDeviceInfo &device, bool hasCachedUuids)
+{
+    if (hasCachedUuids)
+        pending.insert(cachedCount++, device);
+    else
+        pending.append(device);
+
+    if (started)
+        startDiscoveries();
+}
+
+/*!
+    Starts the queued devices. finished() is emitted right away if the queue
+    is empty.
+*/
+void ServiceDiscoveryScheduler::start()
+{
+    started = true;
+    startDiscoveries();
+}
+
+/*!
+    Marks the scan of \a address as done and starts the next queued device.
+    May be called from a slot connected to discoveryStarted().
+*/
+void ServiceDiscoveryScheduler::deviceFinished(const QBluetoothAddress &address)
+{
+    for (int i = 0; i < running.count(); ++i) {
+        if (running.at(i).address() == address) {
+            running.removeAt(i);
+            startDiscoveries();
+            return;
+        }
+    }
+}
+
+/*!
+    Drops all running and queued devices without emitting finished().
+*/
+void ServiceDiscoveryScheduler::clear()
+{
+    pending.clear();
+    running.clear();
+    cachedCount = 0;
+    started = false;
+}
+
+bool ServiceDiscoveryScheduler::isRunning(const QBluetoothAddress &address) const
+{
+    return !runningDevice(address).address().isNull();
+}
+
+/*!
+    Returns the device info of \a address while it is being scanned, otherwise
+    an invalid device info.
+*/
+QBluetoothDeviceInfo ServiceDiscoveryScheduler::runningDevice(const QBluetoothAddress &address) const
+{
+    for (int i = 0; i < running.count(); ++i) {
+        if (running.at(i).address() == address)
+            return running.at(i);
+    }
+
+    return QBluetoothDeviceInfo();
+}
+
+void ServiceDiscoveryScheduler::startDiscoveries()
+{
+    // scans may finish synchronously, the outermost call starts the next ones
+    if (starting || !started)
+        return;
+
+    starting = true;
+    while (started && running.count() < maxParallelDiscoveries && !pending.isEmpty()) {
+        const QBluetoothDeviceInfo device = pending.takeFirst();
+        if (cachedCount > 0)
+            --cachedCount;
+
+        running.append(device);
+        emit discoveryStarted(device);
+    }
+    starting = false;
+
+    if (started && running.isEmpty() && pending.isEmpty()) {
+        started = false;
+        emit finished();
+    }
+}
+
+QT_END_NAMESPACE
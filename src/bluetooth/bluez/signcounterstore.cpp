@@ -0,0 +1,193 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "signcounterstore_p.h"
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QSettings>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+static QString settingsGroup(SignCounterStore::KeyType keyType)
+{
+    return QLatin1String(keyType == SignCounterStore::LocalSigningKey
+                         ? "LocalSignatureKey" : "RemoteSignatureKey");
+}
+
+/*!
+    \internal
+    \class SignCounterStore
+
+    Keeps the sign counters of a bonded peer in memory and writes them back to
+    the BlueZ settings file of the peer.
+
+    The Counter entry of the file holds the next counter to be used. Both
+    counters are persisted ahead of their use: once a counter reaches the
+    persisted value, the next reservedCounterCount() counters are reserved with
+    a single synchronous write. Even after a crash, no local counter is ever used
+    twice. For the counter of the peer the persisted value is a high-water mark:
+    after a crash, signed writes below it are rejected, so a write that was
+    accepted before cannot be replayed. This also rejects up to
+    reservedCounterCount() genuine writes of the peer until its counter passes
+    the mark. flush() releases both reservations, so only a crash costs them.
+*/
+
+SignCounterStore::SignCounterStore(const QString &settingsFilePath, QObject *parent)
+    : QObject(parent), filePath(settingsFilePath)
+{
+}
+
+/*!
+    Releases the reservations of both counters.
+*/
+SignCounterStore::~SignCounterStore()
+{
+    flush();
+}
+
+/*!
+    Reads the signing key of type \a keyType into \a key and the next counter
+    to be used into \a counter. Returns \c false if the settings file has no
+    valid key of that type.
+*/
+bool SignCounterStore::readKey(KeyType keyType, quint128 *key, quint32 *counter)
+{
+    if (!QFileInfo(filePath).exists()) {
+        qCDebug(QT_BT_BLUEZ) << "No settings found for peer device.";
+        return false;
+    }
+
+    QSettings settings(filePath, QSettings::IniFormat);
+    const QString group = settingsGroup(keyType);
+    settings.beginGroup(group);
+    const QByteArray keyString = settings.value(QLatin1String("Key")).toByteArray();
+    if (keyString.isEmpty()) {
+        qCDebug(QT_BT_BLUEZ) << "Group" << group << "not found in settings file";
+        return false;
+    }
+    const QByteArray keyData = QByteArray::fromHex(keyString);
+    if (keyData.count() != int(sizeof(quint128))) {
+        qCWarning(QT_BT_BLUEZ) << "Signing key in settings file has invalid size"
+                               << keyString.count();
+        return false;
+    }
+    qCDebug(QT_BT_BLUEZ) << "CSRK of peer device is" << keyString;
+
+    using namespace std;
+    memcpy(key->data, keyData.constData(), keyData.count());
+    *counter = settings.value(QLatin1String("Counter"), 0).toUInt();
+
+    Counter &c = counters[keyType];
+    c.pending = c.persisted = *counter;
+    return true;
+}
+
+/*!
+    Forgets what is known about the persisted counter of type \a keyType. This
+    is required when a new key has been distributed, since BlueZ starts its
+    counter from zero again.
+*/
+void SignCounterStore::resetCounter(KeyType keyType)
+{
+    counters[keyType] = Counter();
+}
+
+/*!
+    Records that \a lastUsedCounter was the last counter used with the key of
+    type \a keyType. When this function returns, the settings file holds a
+    counter above \a lastUsedCounter.
+*/
+void SignCounterStore::setCounter(KeyType keyType, quint32 lastUsedCounter)
+{
+    Counter &c = counters[keyType];
+    c.pending = lastUsedCounter + 1;
+    if (lastUsedCounter < c.persisted)
+        return; // covered by the reservation
+
+    const quint32 reservation = qMin(reservedCounters, quint32(-1) - c.pending);
+    writeCounter(keyType, c.pending + reservation);
+}
+
+/*!
+    Releases the reservations of both counters, which is only safe if no
+    further counters are used until the next call to setCounter().
+*/
+void SignCounterStore::flush()
+{
+    for (KeyType keyType : {LocalSigningKey, RemoteSigningKey}) {
+        const Counter &c = counters[keyType];
+        if (c.persisted > c.pending)
+            writeCounter(keyType, c.pending);
+    }
+}
+
+/*!
+    Stores \a value as the Counter entry of the \a keyType group. The entry is
+    only updated if it already exists, as BlueZ owns the file. The value is
+    considered persisted even if the write fails, so that a missing or
+    read-only file is not rewritten for every packet.
+*/
+bool SignCounterStore::writeCounter(KeyType keyType, quint32 value)
+{
+    counters[keyType].persisted = value;
+
+    if (!QFileInfo(filePath).exists())
+        return false;
+    QSettings settings(filePath, QSettings::IniFormat);
+    if (!settings.isWritable())
+        return false;
+    settings.beginGroup(settingsGroup(keyType));
+    const QString counterKey = QLatin1String("Counter");
+    if (!settings.contains(counterKey) || settings.value(counterKey).toUInt() == value)
+        return false;
+    settings.setValue(counterKey, value);
+    settings.sync();
+    if (settings.status() != QSettings::NoError) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot store sign counter in" << filePath;
+        return false;
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
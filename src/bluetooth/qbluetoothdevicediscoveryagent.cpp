@@ -154,6 +154,28 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
     \sa QBluetoothDeviceInfo::rssi(), lowEnergyDiscoveryTimeout()
 */
 
+/*!
+    \fn void QBluetoothDeviceDiscoveryAgent::deviceUpdated(const QBluetoothDeviceInfo &info, QBluetoothDeviceInfo::Fields updatedFields)
+
+    This signal is emitted when the agent receives additional information about
+    the Bluetooth device described by \a info. The \a updatedFields flags tell
+    which information has been updated. Only fields whose value actually changed
+    are reported.
+
+    During discovery, some information can change dynamically, such as
+    \l {QBluetoothDeviceInfo::rssi()}{signal strength}, advertised
+    \l {QBluetoothDeviceInfo::manufacturerData()}{manufacturer data} and
+    \l {QBluetoothDeviceInfo::serviceData()}{service data}. The name and the service
+    UUIDs of a Bluetooth Low Energy device may only be part of a later scan response.
+    This signal informs you that if your application is displaying this data, it
+    can be updated, rather than waiting until the discovery has finished.
+
+    \note This signal is only emitted on BlueZ 5.
+
+    \sa QBluetoothDeviceInfo::rssi(), lowEnergyDiscoveryTimeout()
+    \since 5.11
+*/
+
 /*!
     \fn void QBluetoothDeviceDiscoveryAgent::finished()
 
@@ -112,6 +112,7 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     void deviceDiscovered(const QBluetoothDeviceInfo &info);
+    void deviceUpdated(const QBluetoothDeviceInfo &info, QBluetoothDeviceInfo::Fields updatedFields);
     void finished();
     void error(QBluetoothDeviceDiscoveryAgent::Error error);
     void canceled();
@@ -126,8 +127,11 @@ private:
     Q_PRIVATE_SLOT(d_func(), void _q_InterfacesAdded(const QDBusObjectPath &path, InterfaceList interfaceList))
     Q_PRIVATE_SLOT(d_func(), void _q_discoveryFinished())
     Q_PRIVATE_SLOT(d_func(), void _q_discoveryInterrupted(const QString &path))
-    Q_PRIVATE_SLOT(d_func(), void _q_PropertiesChanged(const QString &interface, const QVariantMap &changed_properties, const QStringList &invalidated_properties))
+    Q_PRIVATE_SLOT(d_func(), void _q_PropertiesChanged(const QString &path, const QString &interface, const QVariantMap &changed_properties, const QStringList &invalidated_properties))
     Q_PRIVATE_SLOT(d_func(), void _q_extendedDeviceDiscoveryTimeout())
+    Q_PRIVATE_SLOT(d_func(), void _q_mgmtDeviceFound(quint16 controllerIndex, const QBluetoothDeviceInfo &info, qint64 timestamp))
+    Q_PRIVATE_SLOT(d_func(), void _q_mgmtDiscoveringChanged(quint16 controllerIndex, bool discovering))
+    Q_PRIVATE_SLOT(d_func(), void _q_mgmtCommandFailed(quint16 controllerIndex, quint16 command, quint8 status))
 #endif
 };
 
@@ -40,6 +40,7 @@
 #include <QtCore/QLoggingCategory>
 #include "qbluetoothdevicediscoveryagent.h"
 #include "qbluetoothdevicediscoveryagent_p.h"
+#include "qbluetoothdeviceinfo_p.h"
 #include "qbluetoothaddress.h"
 #include "qbluetoothuuid.h"
 
@@ -57,6 +58,58 @@ QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 
+/*
+    Applies the RSSI, ManufacturerData and ServiceData entries of the org.bluez.Device1
+    \a properties to \a info and returns the fields whose value changed.
+ */
+static QBluetoothDeviceInfo::Fields updateAdvertisementData(QBluetoothDeviceInfo &info,
+                                                            const QVariantMap &properties)
+{
+    QBluetoothDeviceInfo::Fields fields = QBluetoothDeviceInfo::Field::None;
+
+    QVariantMap::const_iterator it = properties.constFind(QStringLiteral("RSSI"));
+    if (it != properties.constEnd() && info.rssi() != qint16(it->toInt())) {
+        info.setRssi(it->toInt());
+        fields |= QBluetoothDeviceInfo::Field::RSSI;
+    }
+
+    it = properties.constFind(QStringLiteral("ManufacturerData"));
+    if (it != properties.constEnd()) {
+        const ManufacturerDataList data = qdbus_cast<ManufacturerDataList>(*it);
+        for (ManufacturerDataList::const_iterator jt = data.constBegin(); jt != data.constEnd(); ++jt) {
+            if (info.setManufacturerData(jt.key(), jt.value().variant().toByteArray()))
+                fields |= QBluetoothDeviceInfo::Field::ManufacturerData;
+        }
+    }
+
+    it = properties.constFind(QStringLiteral("ServiceData"));
+    if (it != properties.constEnd()) {
+        const QVariantMap data = qdbus_cast<QVariantMap>(*it);
+        for (QVariantMap::const_iterator jt = data.constBegin(); jt != data.constEnd(); ++jt) {
+            if (info.setServiceData(QBluetoothUuid(jt.key()), jt.value().toByteArray()))
+                fields |= QBluetoothDeviceInfo::Field::ServiceData;
+        }
+    }
+
+    return fields;
+}
+
+/*
+    Returns the Bluetooth Management controller index of the adapter with the
+    D-Bus object \a adapterPath or -1 if the path does not follow the
+    /org/bluez/hciN naming of BlueZ.
+ */
+static int controllerIndexForAdapterPath(const QString &adapterPath)
+{
+    const int hciIndex = adapterPath.lastIndexOf(QStringLiteral("/hci"));
+    if (hciIndex == -1)
+        return -1;
+
+    bool ok = false;
+    const int index = adapterPath.midRef(hciIndex + 4).toInt(&ok);
+    return ok ? index : -1;
+}
+
 QBluetoothDeviceDiscoveryAgentPrivate::QBluetoothDeviceDiscoveryAgentPrivate(
     const QBluetoothAddress &deviceAdapter, QBluetoothDeviceDiscoveryAgent *parent) :
     lastError(QBluetoothDeviceDiscoveryAgent::NoError),
@@ -68,6 +121,8 @@ QBluetoothDeviceDiscoveryAgentPrivate::QBluetoothDeviceDiscoveryAgentPrivate(
     managerBluez5(0),
     adapterBluez5(0),
     discoveryTimer(0),
+    mgmtControllerIndex(-1),
+    mgmtAddressTypes(0),
     useExtendedDiscovery(false),
     lowEnergySearchTimeout(-1), // remains -1 on BlueZ 4 -> timeout not supported
     q_ptr(parent)
@@ -75,12 +130,9 @@ QBluetoothDeviceDiscoveryAgentPrivate::QBluetoothDeviceDiscoveryAgentPrivate(
     Q_Q(QBluetoothDeviceDiscoveryAgent);
     if (isBluez5()) {
         lowEnergySearchTimeout = 20000;
-        managerBluez5 = new OrgFreedesktopDBusObjectManagerInterface(
-                                           QStringLiteral("org.bluez"),
-                                           QStringLiteral("/"),
-                                           QDBusConnection::systemBus(), parent);
+        managerBluez5 = QtBluezObjectMirror::instance();
         QObject::connect(managerBluez5,
-                         SIGNAL(InterfacesAdded(QDBusObjectPath,InterfaceList)),
+                         SIGNAL(interfacesAdded(QDBusObjectPath,InterfaceList)),
                          q, SLOT(_q_InterfacesAdded(QDBusObjectPath,InterfaceList)));
 
         // start private address monitoring
@@ -246,7 +298,8 @@ void QBluetoothDeviceDiscoveryAgentPrivate::startBluez5(QBluetoothDeviceDiscover
                                                   adapterPath,
                                                   QDBusConnection::systemBus());
 
-    if (!adapterBluez5->powered()) {
+    if (!managerBluez5->properties(adapterPath, QStringLiteral("org.bluez.Adapter1"))
+            .value(QStringLiteral("Powered")).toBool()) {
         qCDebug(QT_BT_BLUEZ) << "Aborting device discovery due to offline Bluetooth Adapter";
         lastError = QBluetoothDeviceDiscoveryAgent::PoweredOffError;
         errorString = QBluetoothDeviceDiscoveryAgent::tr("Device is powered off");
@@ -256,6 +309,41 @@ void QBluetoothDeviceDiscoveryAgentPrivate::startBluez5(QBluetoothDeviceDiscover
         return;
     }
 
+    // Opt-in: drive the discovery via the kernel's Bluetooth Management interface.
+    // This avoids the D-Bus round trips of BlueZ and provides the raw
+    // advertisement data of every received packet.
+    mgmtControllerIndex = -1;
+    if (!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_MGMT_DISCOVERY")
+            && BluetoothManagement::instance()->isMonitoringEnabled()) {
+        const int controllerIndex = controllerIndexForAdapterPath(adapterPath);
+
+        mgmtAddressTypes = 0;
+        if (methods & QBluetoothDeviceDiscoveryAgent::ClassicMethod)
+            mgmtAddressTypes |= BluetoothManagement::BrEdrAddress;
+        if (methods & QBluetoothDeviceDiscoveryAgent::LowEnergyMethod)
+            mgmtAddressTypes |= BluetoothManagement::LePublicAddress
+                                | BluetoothManagement::LeRandomAddress;
+
+        BluetoothManagement *management = BluetoothManagement::instance();
+        QObject::connect(management, SIGNAL(deviceFound(quint16,QBluetoothDeviceInfo,qint64)),
+                         q, SLOT(_q_mgmtDeviceFound(quint16,QBluetoothDeviceInfo,qint64)));
+        QObject::connect(management, SIGNAL(discoveringChanged(quint16,bool)),
+                         q, SLOT(_q_mgmtDiscoveringChanged(quint16,bool)));
+        QObject::connect(management, SIGNAL(commandFailed(quint16,quint16,quint8)),
+                         q, SLOT(_q_mgmtCommandFailed(quint16,quint16,quint8)));
+
+        if (controllerIndex >= 0 && management->startDiscovery(controllerIndex, mgmtAddressTypes)) {
+            qCDebug(QT_BT_BLUEZ) << "Using Bluetooth Management discovery on controller"
+                                 << controllerIndex;
+            mgmtControllerIndex = controllerIndex;
+            startDiscoveryTimer();
+            return;
+        }
+
+        qCDebug(QT_BT_BLUEZ) << "Bluetooth Management discovery not available, using D-Bus";
+        management->disconnect(q);
+    }
+
     QVariantMap map;
     if (methods == (QBluetoothDeviceDiscoveryAgent::LowEnergyMethod|QBluetoothDeviceDiscoveryAgent::ClassicMethod))
         map.insert(QStringLiteral("Transport"), QStringLiteral("auto"));
@@ -288,30 +376,23 @@ void QBluetoothDeviceDiscoveryAgentPrivate::startBluez5(QBluetoothDeviceDiscover
     QObject::connect(QtBluezDiscoveryManager::instance(), SIGNAL(discoveryInterrupted(QString)),
             q, SLOT(_q_discoveryInterrupted(QString)));
 
-    // collect initial set of information
-    QDBusPendingReply<ManagedObjectList> reply = managerBluez5->GetManagedObjects();
-    reply.waitForFinished();
-    if (!reply.isError()) {
-        ManagedObjectList managedObjectList = reply.value();
-        for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-            const QDBusObjectPath &path = it.key();
-            const InterfaceList &ifaceList = it.value();
-
-            for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-                const QString &iface = jt.key();
+    QObject::connect(managerBluez5,
+                     SIGNAL(propertiesChanged(QString,QString,QVariantMap,QStringList)),
+                     q, SLOT(_q_PropertiesChanged(QString,QString,QVariantMap,QStringList)));
 
-                if (iface == QStringLiteral("org.bluez.Device1")) {
+    // collect initial set of information
+    foreach (const QString &devicePath, managerBluez5->devicePaths(adapterBluez5->path())) {
+        deviceFoundBluez5(devicePath);
+        if (!isActive()) // Can happen if stop() was called from a slot in user code.
+          return;
+    }
 
-                    if (path.path().indexOf(adapterBluez5->path()) != 0)
-                        continue; //devices whose path doesn't start with same path we skip
+    startDiscoveryTimer();
+}
 
-                    deviceFoundBluez5(path.path());
-                    if (!isActive()) // Can happen if stop() was called from a slot in user code.
-                      return;
-                }
-            }
-        }
-    }
+void QBluetoothDeviceDiscoveryAgentPrivate::startDiscoveryTimer()
+{
+    Q_Q(QBluetoothDeviceDiscoveryAgent);
 
     // wait interval and sum up what was found
     if (!discoveryTimer) {
@@ -402,38 +483,35 @@ void QBluetoothDeviceDiscoveryAgentPrivate::deviceFoundBluez5(const QString& dev
     if (!q->isActive())
         return;
 
-    OrgBluezDevice1Interface device(QStringLiteral("org.bluez"), devicePath,
-                                    QDBusConnection::systemBus());
+    const QVariantMap device = managerBluez5->properties(devicePath,
+                                                         QStringLiteral("org.bluez.Device1"));
 
-    if (device.adapter().path() != adapterBluez5->path())
+    const QBluetoothAddress btAddress(device.value(QStringLiteral("Address")).toString());
+    if (btAddress.isNull()) // no point reporting an empty address
         return;
 
-    const QBluetoothAddress btAddress(device.address());
-    if (btAddress.isNull()) // no point reporting an empty address
+    // device belongs to a different adapter
+    if (managerBluez5->devicePath(adapterBluez5->path(), btAddress) != devicePath)
         return;
 
-    const QString btName = device.alias();
-    quint32 btClass = device.classProperty();
+    const QString btName = device.value(QStringLiteral("Alias")).toString();
+    quint32 btClass = device.value(QStringLiteral("Class")).toUInt();
+    const QStringList btUuids = device.value(QStringLiteral("UUIDs")).toStringList();
+    const qint16 btRssi = device.value(QStringLiteral("RSSI")).toInt();
 
     qCDebug(QT_BT_BLUEZ) << "Discovered: " << btAddress.toString() << btName
-                         << "Num UUIDs" << device.uUIDs().count()
+                         << "Num UUIDs" << btUuids.count()
                          << "total device" << discoveredDevices.count() << "cached"
-                         << "RSSI" << device.rSSI() << "Class" << btClass;
-
-    OrgFreedesktopDBusPropertiesInterface *prop = new OrgFreedesktopDBusPropertiesInterface(
-                QStringLiteral("org.bluez"), devicePath, QDBusConnection::systemBus(), q);
-    QObject::connect(prop, SIGNAL(PropertiesChanged(QString,QVariantMap,QStringList)),
-                     q, SLOT(_q_PropertiesChanged(QString,QVariantMap,QStringList)));
-    // remember what we have to cleanup
-    propertyMonitors.append(prop);
+                         << "RSSI" << btRssi << "Class" << btClass;
 
     // read information
     QBluetoothDeviceInfo deviceInfo(btAddress, btName, btClass);
-    deviceInfo.setRssi(device.rSSI());
+    deviceInfo.setRssi(btRssi);
+    updateAdvertisementData(deviceInfo, device);
 
     QList<QBluetoothUuid> uuids;
     bool foundLikelyLowEnergyUuid = false;
-    for (const auto &u: device.uUIDs()) {
+    for (const auto &u: btUuids) {
         const QBluetoothUuid id(u);
         if (id.isNull())
             continue;
@@ -559,11 +637,18 @@ void QBluetoothDeviceDiscoveryAgentPrivate::_q_discoveryFinished()
     if (discoveryTimer)
         discoveryTimer->stop();
 
-    QtBluezDiscoveryManager::instance()->disconnect(q);
-    QtBluezDiscoveryManager::instance()->unregisterDiscoveryInterest(adapterBluez5->path());
+    if (mgmtControllerIndex >= 0) {
+        BluetoothManagement::instance()->disconnect(q);
+        BluetoothManagement::instance()->stopDiscovery(mgmtControllerIndex, mgmtAddressTypes);
+        mgmtControllerIndex = -1;
+    } else {
+        QtBluezDiscoveryManager::instance()->disconnect(q);
+        QtBluezDiscoveryManager::instance()->unregisterDiscoveryInterest(adapterBluez5->path());
 
-    qDeleteAll(propertyMonitors);
-    propertyMonitors.clear();
+        QObject::disconnect(managerBluez5,
+                            SIGNAL(propertiesChanged(QString,QString,QVariantMap,QStringList)),
+                            q, SLOT(_q_PropertiesChanged(QString,QString,QVariantMap,QStringList)));
+    }
 
     delete adapterBluez5;
     adapterBluez5 = 0;
@@ -598,6 +683,10 @@ void QBluetoothDeviceDiscoveryAgentPrivate::_q_discoveryInterrupted(const QStrin
         // no need to call unregisterDiscoveryInterest since QtBluezDiscoveryManager
         // does this automatically when emitting discoveryInterrupted(QString) signal
 
+        QObject::disconnect(managerBluez5,
+                            SIGNAL(propertiesChanged(QString,QString,QVariantMap,QStringList)),
+                            q, SLOT(_q_PropertiesChanged(QString,QString,QVariantMap,QStringList)));
+
         delete adapterBluez5;
         adapterBluez5 = 0;
 
@@ -607,30 +696,162 @@ void QBluetoothDeviceDiscoveryAgentPrivate::_q_discoveryInterrupted(const QStrin
     }
 }
 
-void QBluetoothDeviceDiscoveryAgentPrivate::_q_PropertiesChanged(const QString &interface,
+void QBluetoothDeviceDiscoveryAgentPrivate::_q_PropertiesChanged(const QString &path,
+                                                                 const QString &interface,
                                                                  const QVariantMap &changed_properties,
                                                                  const QStringList &)
 {
     Q_Q(QBluetoothDeviceDiscoveryAgent);
-    if (interface == QStringLiteral("org.bluez.Device1")
-            && changed_properties.contains(QStringLiteral("RSSI"))) {
-        OrgFreedesktopDBusPropertiesInterface *props =
-                qobject_cast<OrgFreedesktopDBusPropertiesInterface *>(q->sender());
-        if (!props)
-            return;
 
-        OrgBluezDevice1Interface device(QStringLiteral("org.bluez"), props->path(),
-                                            QDBusConnection::systemBus());
-        for (int i = 0; i < discoveredDevices.size(); i++) {
-            if (discoveredDevices[i].address().toString() == device.address()) {
-                qCDebug(QT_BT_BLUEZ) << "Updating RSSI for" << device.address()
-                         << changed_properties.value(QStringLiteral("RSSI"));
-                discoveredDevices[i].setRssi(
-                            changed_properties.value(QStringLiteral("RSSI")).toInt());
-                return;
+    if (interface != QStringLiteral("org.bluez.Device1"))
+        return;
+
+    if (!changed_properties.contains(QStringLiteral("RSSI"))
+            && !changed_properties.contains(QStringLiteral("ManufacturerData"))
+            && !changed_properties.contains(QStringLiteral("ServiceData"))) {
+        return;
+    }
+
+    const QBluetoothAddress address(managerBluez5->properties(path, interface)
+                                        .value(QStringLiteral("Address")).toString());
+    if (managerBluez5->devicePath(adapterBluez5->path(), address) != path)
+        return;
+
+    for (int i = 0; i < discoveredDevices.size(); i++) {
+        if (discoveredDevices[i].address() == address) {
+            const QBluetoothDeviceInfo::Fields updatedFields =
+                    updateAdvertisementData(discoveredDevices[i], changed_properties);
+            if (updatedFields) {
+                qCDebug(QT_BT_BLUEZ) << "Updating" << address << "fields" << int(updatedFields);
+                emit q->deviceUpdated(discoveredDevices[i], updatedFields);
             }
+            return;
         }
     }
 }
 
+void QBluetoothDeviceDiscoveryAgentPrivate::_q_mgmtDeviceFound(quint16 controllerIndex,
+                                                               const QBluetoothDeviceInfo &info,
+                                                               qint64 timestamp)
+{
+    Q_Q(QBluetoothDeviceDiscoveryAgent);
+
+    if (int(controllerIndex) != mgmtControllerIndex)
+        return;
+
+    for (int i = 0; i < discoveredDevices.size(); i++) {
+        QBluetoothDeviceInfo &known = discoveredDevices[i];
+        if (known.address() != info.address())
+            continue;
+
+        known.setLastSeenTimestamp(timestamp);
+
+        QBluetoothDeviceInfo::Fields updatedFields = QBluetoothDeviceInfo::Field::None;
+        if (known.rssi() != info.rssi()) {
+            known.setRssi(info.rssi());
+            updatedFields |= QBluetoothDeviceInfo::Field::RSSI;
+        }
+        foreach (quint16 id, info.manufacturerIds()) {
+            if (known.setManufacturerData(id, info.manufacturerData(id)))
+                updatedFields |= QBluetoothDeviceInfo::Field::ManufacturerData;
+        }
+        foreach (const QBluetoothUuid &uuid, info.serviceIds()) {
+            if (known.setServiceData(uuid, info.serviceData(uuid)))
+                updatedFields |= QBluetoothDeviceInfo::Field::ServiceData;
+        }
+
+        // the scan response of an LE device may carry the name and UUIDs its advertisement lacked
+        QBluetoothDeviceInfoPrivate *knownData = known.d_ptr;
+        if (!info.name().isEmpty() && info.name() != knownData->name) {
+            knownData->name = info.name();
+            updatedFields |= QBluetoothDeviceInfo::Field::Name;
+        }
+
+        QList<QBluetoothUuid> uuids = knownData->serviceUuids;
+        foreach (const QBluetoothUuid &uuid, info.serviceUuids()) {
+            if (!uuids.contains(uuid))
+                uuids.append(uuid);
+        }
+        if (uuids.count() != knownData->serviceUuids.count()) {
+            const bool complete =
+                    knownData->serviceUuidsCompleteness == QBluetoothDeviceInfo::DataComplete
+                    || info.serviceUuidsCompleteness() == QBluetoothDeviceInfo::DataComplete;
+            known.setServiceUuids(uuids, complete ? QBluetoothDeviceInfo::DataComplete
+                                                  : QBluetoothDeviceInfo::DataIncomplete);
+            updatedFields |= QBluetoothDeviceInfo::Field::ServiceUuids;
+        }
+
+        // LE advertisements carry no class of device
+        const QBluetoothDeviceInfoPrivate *foundData = info.d_ptr;
+        const bool hasClass = foundData->majorDeviceClass != QBluetoothDeviceInfo::MiscellaneousDevice
+                || foundData->minorDeviceClass != 0
+                || foundData->serviceClasses != QBluetoothDeviceInfo::NoService;
+        if (hasClass && (foundData->majorDeviceClass != knownData->majorDeviceClass
+                         || foundData->minorDeviceClass != knownData->minorDeviceClass
+                         || foundData->serviceClasses != knownData->serviceClasses)) {
+            knownData->majorDeviceClass = foundData->majorDeviceClass;
+            knownData->minorDeviceClass = foundData->minorDeviceClass;
+            knownData->serviceClasses = foundData->serviceClasses;
+            updatedFields |= QBluetoothDeviceInfo::Field::DeviceClass;
+        }
+
+        // dual mode devices are found via both transports
+        if (known.coreConfigurations() != info.coreConfigurations())
+            known.setCoreConfigurations(QBluetoothDeviceInfo::BaseRateAndLowEnergyCoreConfiguration);
+
+        if (updatedFields) {
+            qCDebug(QT_BT_BLUEZ) << "Updating" << info.address() << "fields" << int(updatedFields);
+            emit q->deviceUpdated(known, updatedFields);
+        }
+        return;
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Discovered:" << info.address().toString() << info.name()
+                         << "RSSI" << info.rssi();
+    discoveredDevices.append(info);
+    discoveredDevices.last().setLastSeenTimestamp(timestamp);
+    emit q->deviceDiscovered(discoveredDevices.last());
+}
+
+void QBluetoothDeviceDiscoveryAgentPrivate::_q_mgmtDiscoveringChanged(quint16 controllerIndex,
+                                                                      bool discovering)
+{
+    if (int(controllerIndex) != mgmtControllerIndex || discovering)
+        return;
+
+    // The kernel ends every discovery cycle after a few seconds.
+    // Keep discovering until the search timeout or stop().
+    if (!pendingCancel)
+        BluetoothManagement::instance()->startDiscovery(mgmtControllerIndex, mgmtAddressTypes);
+}
+
+void QBluetoothDeviceDiscoveryAgentPrivate::_q_mgmtCommandFailed(quint16 controllerIndex,
+                                                                 quint16 command, quint8 status)
+{
+    Q_Q(QBluetoothDeviceDiscoveryAgent);
+
+    if (int(controllerIndex) != mgmtControllerIndex)
+        return;
+
+    // another process is discovering already, its results are reported to us as well
+    if (status == 0x0a) // Busy
+        return;
+
+    qCWarning(QT_BT_BLUEZ) << "Bluetooth Management command" << hex << command
+                           << "failed with status" << status;
+
+    if (discoveryTimer)
+        discoveryTimer->stop();
+
+    BluetoothManagement::instance()->disconnect(q);
+    mgmtControllerIndex = -1;
+
+    delete adapterBluez5;
+    adapterBluez5 = 0;
+
+    errorString = QBluetoothDeviceDiscoveryAgent::tr("Bluetooth adapter error");
+    lastError = QBluetoothDeviceDiscoveryAgent::InputOutputError;
+    emit q->error(lastError);
+}
+
 QT_END_NAMESPACE
@@ -115,10 +115,15 @@ public:
                             InterfaceList interfaces_and_properties);
     void _q_discoveryFinished();
     void _q_discoveryInterrupted(const QString &path);
-    void _q_PropertiesChanged(const QString &interface,
+    void _q_PropertiesChanged(const QString &path,
+                              const QString &interface,
                               const QVariantMap &changed_properties,
                               const QStringList &invalidated_properties);
     void _q_extendedDeviceDiscoveryTimeout();
+    void _q_mgmtDeviceFound(quint16 controllerIndex, const QBluetoothDeviceInfo &info,
+                            qint64 timestamp);
+    void _q_mgmtDiscoveringChanged(quint16 controllerIndex, bool discovering);
+    void _q_mgmtCommandFailed(quint16 controllerIndex, quint16 command, quint8 status);
 #endif
 
 private:
@@ -152,13 +157,16 @@ private:
     bool pendingStart;
     OrgBluezManagerInterface *manager;
     OrgBluezAdapterInterface *adapter;
-    OrgFreedesktopDBusObjectManagerInterface *managerBluez5;
+    QtBluezObjectMirror *managerBluez5;
     OrgBluezAdapter1Interface *adapterBluez5;
     QTimer *discoveryTimer;
-    QList<OrgFreedesktopDBusPropertiesInterface *> propertyMonitors;
 
     void deviceFoundBluez5(const QString& devicePath);
     void startBluez5(QBluetoothDeviceDiscoveryAgent::DiscoveryMethods methods);
+    void startDiscoveryTimer();
+
+    int mgmtControllerIndex;
+    quint8 mgmtAddressTypes;
 
     bool useExtendedDiscovery;
     QTimer extendedDiscoveryTimer;
@@ -258,10 +258,29 @@ QT_BEGIN_NAMESPACE
                                                 for standard and Low Energy device.
     \value LowEnergyCoreConfiguration           The device is a Bluetooth Low Energy device.
 */
+
+/*!
+    \enum QBluetoothDeviceInfo::Field
+    \since 5.11
+
+    This enum is used in conjunction with the \l QBluetoothDeviceDiscoveryAgent::deviceUpdated()
+    signal and indicates the field that changed.
+
+    \value None                 None of the values changed.
+    \value RSSI                 The \l rssi() value of the device changed.
+    \value ManufacturerData     The \l manufacturerData() field changed.
+    \value ServiceData          The \l serviceData() field changed.
+    \value Name                 The \l name() of the device became known or changed.
+    \value ServiceUuids         Further \l serviceUuids() became known.
+    \value DeviceClass          The \l majorDeviceClass(), \l minorDeviceClass() or
+                                \l serviceClasses() changed.
+    \value All                  Matches every possible field.
+*/
 QBluetoothDeviceInfoPrivate::QBluetoothDeviceInfoPrivate() :
     valid(false),
     cached(false),
     rssi(1),
+    lastSeenTimestamp(-1),
     serviceClasses(QBluetoothDeviceInfo::NoService),
     majorDeviceClass(QBluetoothDeviceInfo::MiscellaneousDevice),
     minorDeviceClass(0),
@@ -389,6 +408,35 @@ void QBluetoothDeviceInfo::setRssi(qint16 signal)
     d->rssi = signal;
 }
 
+/*!
+    Returns the time at which the device was last seen during a device discovery,
+    or -1 if it is unknown. The time is given in milliseconds since the reference
+    time of QElapsedTimer, so that it can be compared with
+    QElapsedTimer::msecsSinceReference().
+
+    Only the BlueZ backend reports this time, and only if the discovery runs through
+    the kernel's Bluetooth management interface.
+
+    \since 5.11
+*/
+qint64 QBluetoothDeviceInfo::lastSeenTimestamp() const
+{
+    Q_D(const QBluetoothDeviceInfo);
+
+    return d->lastSeenTimestamp;
+}
+
+/*!
+    \internal
+
+    Sets the time at which the device was last seen to \a timestamp.
+*/
+void QBluetoothDeviceInfo::setLastSeenTimestamp(qint64 timestamp)
+{
+    Q_D(QBluetoothDeviceInfo);
+    d->lastSeenTimestamp = timestamp;
+}
+
 /*!
     Makes a copy of the \a other and assigns it to this QBluetoothDeviceInfo object.
 */
@@ -406,8 +454,11 @@ QBluetoothDeviceInfo &QBluetoothDeviceInfo::operator=(const QBluetoothDeviceInfo
     d->serviceUuidsCompleteness = other.d_func()->serviceUuidsCompleteness;
     d->serviceUuids = other.d_func()->serviceUuids;
     d->rssi = other.d_func()->rssi;
+    d->lastSeenTimestamp = other.d_func()->lastSeenTimestamp;
     d->deviceCoreConfiguration = other.d_func()->deviceCoreConfiguration;
     d->deviceUuid = other.d_func()->deviceUuid;
+    d->manufacturerData = other.d_func()->manufacturerData;
+    d->serviceData = other.d_func()->serviceData;
 
     return *this;
 }
@@ -443,6 +494,10 @@ bool QBluetoothDeviceInfo::operator==(const QBluetoothDeviceInfo &other) const
         return false;
     if (d->deviceUuid != other.d_func()->deviceUuid)
         return false;
+    if (d->manufacturerData != other.d_func()->manufacturerData)
+        return false;
+    if (d->serviceData != other.d_func()->serviceData)
+        return false;
 
     return true;
 }
@@ -518,6 +573,136 @@ quint8 QBluetoothDeviceInfo::minorDeviceClass() const
     return d->minorDeviceClass;
 }
 
+/*!
+    Returns all manufacturer ids attached to this device information.
+
+    \sa manufacturerData(), setManufacturerData()
+
+    \since 5.11
+*/
+QVector<quint16> QBluetoothDeviceInfo::manufacturerIds() const
+{
+    Q_D(const QBluetoothDeviceInfo);
+
+    return d->manufacturerData.keys().toVector();
+}
+
+/*!
+    Returns the data associated with the given \a manufacturerId.
+
+    Manufacturer data is defined by
+    the Supplement to the Bluetooth Core Specification and consists of two segments:
+
+    \list
+    \li Manufacturer specific identifier code from the
+    \l {https://www.bluetooth.com/specifications/assigned-numbers} {Assigned Numbers}
+    Company Identifiers document
+    \li Sequence of arbitrary data octets
+    \endlist
+
+    The interpretation of the data octets is defined by the manufacturer
+    specified by the company identifier.
+
+    \sa manufacturerIds(), setManufacturerData()
+    \since 5.11
+*/
+QByteArray QBluetoothDeviceInfo::manufacturerData(quint16 manufacturerId) const
+{
+    Q_D(const QBluetoothDeviceInfo);
+
+    return d->manufacturerData.value(manufacturerId);
+}
+
+/*!
+    Sets the advertised manufacturer \a data for the given \a manufacturerId.
+    Returns \c true if it was inserted or changed, \c false if it was already known.
+
+    \sa manufacturerData
+    \since 5.11
+*/
+bool QBluetoothDeviceInfo::setManufacturerData(quint16 manufacturerId, const QByteArray &data)
+{
+    Q_D(QBluetoothDeviceInfo);
+
+    QHash<quint16, QByteArray>::const_iterator it = d->manufacturerData.constFind(manufacturerId);
+    if (it != d->manufacturerData.constEnd() && *it == data)
+        return false;
+
+    d->manufacturerData.insert(manufacturerId, data);
+    return true;
+}
+
+/*!
+    Returns the complete set of all manufacturer data.
+
+    \sa setManufacturerData
+    \since 5.11
+*/
+QHash<quint16, QByteArray> QBluetoothDeviceInfo::manufacturerData() const
+{
+    Q_D(const QBluetoothDeviceInfo);
+
+    return d->manufacturerData;
+}
+
+/*!
+    Returns the UUIDs of all services with advertised service data.
+
+    \sa serviceData(), setServiceData()
+    \since 5.11
+*/
+QVector<QBluetoothUuid> QBluetoothDeviceInfo::serviceIds() const
+{
+    Q_D(const QBluetoothDeviceInfo);
+
+    return d->serviceData.keys().toVector();
+}
+
+/*!
+    Returns the data advertised for the service \a serviceId.
+
+    \sa serviceIds(), setServiceData()
+    \since 5.11
+*/
+QByteArray QBluetoothDeviceInfo::serviceData(const QBluetoothUuid &serviceId) const
+{
+    Q_D(const QBluetoothDeviceInfo);
+
+    return d->serviceData.value(serviceId);
+}
+
+/*!
+    Sets the advertised service \a data for the service \a serviceId.
+    Returns \c true if it was inserted or changed, \c false if it was already known.
+
+    \sa serviceData()
+    \since 5.11
+*/
+bool QBluetoothDeviceInfo::setServiceData(const QBluetoothUuid &serviceId, const QByteArray &data)
+{
+    Q_D(QBluetoothDeviceInfo);
+
+    QHash<QBluetoothUuid, QByteArray>::const_iterator it = d->serviceData.constFind(serviceId);
+    if (it != d->serviceData.constEnd() && *it == data)
+        return false;
+
+    d->serviceData.insert(serviceId, data);
+    return true;
+}
+
+/*!
+    Returns the complete set of all advertised service data.
+
+    \sa setServiceData()
+    \since 5.11
+*/
+QHash<QBluetoothUuid, QByteArray> QBluetoothDeviceInfo::serviceData() const
+{
+    Q_D(const QBluetoothDeviceInfo);
+
+    return d->serviceData;
+}
+
 /*!
     Sets the list of service UUIDs to \a uuids and the completeness of the data to \a completeness.
 */
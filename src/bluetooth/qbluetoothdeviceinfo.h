@@ -44,6 +44,9 @@
 
 #include <QtCore/qstring.h>
 #include <QtCore/qmetatype.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qvector.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -204,6 +207,18 @@ public:
     };
     Q_DECLARE_FLAGS(CoreConfigurations, CoreConfiguration)
 
+    enum class Field {
+        None = 0x0000,
+        RSSI = 0x0001,
+        ManufacturerData = 0x0002,
+        ServiceData = 0x0004,
+        Name = 0x0008,
+        ServiceUuids = 0x0010,
+        DeviceClass = 0x0020,
+        All = 0x7fff
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
     QBluetoothDeviceInfo();
     QBluetoothDeviceInfo(const QBluetoothAddress &address, const QString &name,
                          quint32 classOfDevice);
@@ -231,6 +246,18 @@ public:
     qint16 rssi() const;
     void setRssi(qint16 signal);
 
+    qint64 lastSeenTimestamp() const;
+
+    QVector<quint16> manufacturerIds() const;
+    QByteArray manufacturerData(quint16 manufacturerId) const;
+    bool setManufacturerData(quint16 manufacturerId, const QByteArray &data);
+    QHash<quint16, QByteArray> manufacturerData() const;
+
+    QVector<QBluetoothUuid> serviceIds() const;
+    QByteArray serviceData(const QBluetoothUuid &serviceId) const;
+    bool setServiceData(const QBluetoothUuid &serviceId, const QByteArray &data);
+    QHash<QBluetoothUuid, QByteArray> serviceData() const;
+
     void setServiceUuids(const QList<QBluetoothUuid> &uuids, DataCompleteness completeness);
     QList<QBluetoothUuid> serviceUuids(DataCompleteness *completeness = Q_NULLPTR) const;
     DataCompleteness serviceUuidsCompleteness() const;
@@ -245,11 +272,15 @@ protected:
     QBluetoothDeviceInfoPrivate *d_ptr;
 
 private:
+    void setLastSeenTimestamp(qint64 timestamp);
+
     Q_DECLARE_PRIVATE(QBluetoothDeviceInfo)
+    friend class QBluetoothDeviceDiscoveryAgentPrivate;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QBluetoothDeviceInfo::CoreConfigurations)
 Q_DECLARE_OPERATORS_FOR_FLAGS(QBluetoothDeviceInfo::ServiceClasses)
+Q_DECLARE_OPERATORS_FOR_FLAGS(QBluetoothDeviceInfo::Fields)
 
 QT_END_NAMESPACE
 
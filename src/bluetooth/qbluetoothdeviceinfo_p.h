@@ -56,6 +56,8 @@
 #include "qbluetoothuuid.h"
 
 #include <QString>
+#include <QtCore/QHash>
+#include <QtCore/QByteArray>
 
 QT_BEGIN_NAMESPACE
 
@@ -71,6 +73,7 @@ public:
     QString name;
 
     qint16 rssi;
+    qint64 lastSeenTimestamp;
 
     QBluetoothDeviceInfo::ServiceClasses serviceClasses;
     QBluetoothDeviceInfo::MajorDeviceClass majorDeviceClass;
@@ -81,6 +84,9 @@ public:
     QBluetoothDeviceInfo::CoreConfigurations deviceCoreConfiguration;
 
     QBluetoothUuid deviceUuid;
+
+    QHash<quint16, QByteArray> manufacturerData;
+    QHash<QBluetoothUuid, QByteArray> serviceData;
 };
 
 QT_END_NAMESPACE
@@ -212,33 +212,19 @@ QList<QBluetoothHostInfo> QBluetoothLocalDevice::allDevices()
     QList<QBluetoothHostInfo> localDevices;
 
     if (isBluez5()) {
-        OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
-                                                         QStringLiteral("/"),
-                                                         QDBusConnection::systemBus());
-        QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
-        reply.waitForFinished();
-        if (reply.isError())
-            return localDevices;
+        QtBluezObjectMirror *mirror = QtBluezObjectMirror::instance();
+        foreach (const QString &path, mirror->adapterPaths()) {
+            const QVariantMap ifaceValues = mirror->properties(path,
+                                                               QStringLiteral("org.bluez.Adapter1"));
 
-        ManagedObjectList managedObjectList = reply.value();
-        for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-            const InterfaceList &ifaceList = it.value();
+            QBluetoothHostInfo hostInfo;
+            const QString temp = ifaceValues.value(QStringLiteral("Address")).toString();
 
-            for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-                const QString &iface = jt.key();
-                const QVariantMap &ifaceValues = jt.value();
-
-                if (iface == QStringLiteral("org.bluez.Adapter1")) {
-                    QBluetoothHostInfo hostInfo;
-                    const QString temp = ifaceValues.value(QStringLiteral("Address")).toString();
-
-                    hostInfo.setAddress(QBluetoothAddress(temp));
-                    if (hostInfo.address().isNull())
-                        continue;
-                    hostInfo.setName(ifaceValues.value(QStringLiteral("Name")).toString());
-                    localDevices.append(hostInfo);
-                }
-            }
+            hostInfo.setAddress(QBluetoothAddress(temp));
+            if (hostInfo.address().isNull())
+                continue;
+            hostInfo.setName(ifaceValues.value(QStringLiteral("Name")).toString());
+            localDevices.append(hostInfo);
         }
    } else {
         OrgBluezManagerInterface manager(QStringLiteral("org.bluez"), QStringLiteral("/"),
@@ -452,36 +438,15 @@ void QBluetoothLocalDevicePrivate::requestPairingBluez5(const QBluetoothAddress
     // if we cannot find it we may have to turn on Discovery mode for a limited amount of time
 
     // check device doesn't already exist
-    QDBusPendingReply<ManagedObjectList> reply = managerBluez5->GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
-        emit q_ptr->error(QBluetoothLocalDevice::PairingError);
+    const QString devicePath = QtBluezObjectMirror::instance()->devicePath(adapterBluez5->path(),
+                                                                            targetAddress);
+    if (!devicePath.isEmpty()) {
+        qCDebug(QT_BT_BLUEZ) << "Initiating direct pair to" << targetAddress.toString();
+        //device exist -> directly work with it
+        processPairingBluez5(devicePath, targetPairing);
         return;
     }
 
-    ManagedObjectList managedObjectList = reply.value();
-    for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-        const QDBusObjectPath &path = it.key();
-        const InterfaceList &ifaceList = it.value();
-
-        for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-            const QString &iface = jt.key();
-
-            if (iface == QStringLiteral("org.bluez.Device1")) {
-
-                OrgBluezDevice1Interface device(QStringLiteral("org.bluez"),
-                                                path.path(),
-                                                QDBusConnection::systemBus());
-                if (targetAddress == QBluetoothAddress(device.address())) {
-                    qCDebug(QT_BT_BLUEZ) << "Initiating direct pair to" << targetAddress.toString();
-                    //device exist -> directly work with it
-                    processPairingBluez5(path.path(), targetPairing);
-                    return;
-                }
-            }
-        }
-    }
-
     //no device matching -> turn on discovery
     QtBluezDiscoveryManager::instance()->registerDiscoveryInterest(adapterBluez5->path());
 
@@ -613,36 +578,20 @@ QBluetoothLocalDevice::Pairing QBluetoothLocalDevice::pairingStatus(
         delete device;
     } else if (d_ptr->adapterBluez5) {
 
-        QDBusPendingReply<ManagedObjectList> reply = d_ptr->managerBluez5->GetManagedObjects();
-        reply.waitForFinished();
-        if (reply.isError())
+        QtBluezObjectMirror *mirror = QtBluezObjectMirror::instance();
+        const QString devicePath = mirror->devicePath(d_ptr->adapterBluez5->path(), address);
+        if (devicePath.isEmpty())
             return Unpaired;
 
-        ManagedObjectList managedObjectList = reply.value();
-        for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-            const QDBusObjectPath &path = it.key();
-            const InterfaceList &ifaceList = it.value();
-
-            for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-                const QString &iface = jt.key();
-
-                if (iface == QStringLiteral("org.bluez.Device1")) {
-
-                    OrgBluezDevice1Interface device(QStringLiteral("org.bluez"),
-                                                    path.path(),
-                                                    QDBusConnection::systemBus());
-
-                    if (address == QBluetoothAddress(device.address())) {
-                        if (device.trusted() && device.paired())
-                            return AuthorizedPaired;
-                        else if (device.paired())
-                            return Paired;
-                        else
-                            return Unpaired;
-                    }
-                }
-            }
-        }
+        const QVariantMap device = mirror->properties(devicePath,
+                                                      QStringLiteral("org.bluez.Device1"));
+        const bool paired = device.value(QStringLiteral("Paired")).toBool();
+        if (device.value(QStringLiteral("Trusted")).toBool() && paired)
+            return AuthorizedPaired;
+        else if (paired)
+            return Paired;
+        else
+            return Unpaired;
     }
 
     return Unpaired;
@@ -690,39 +639,24 @@ void QBluetoothLocalDevicePrivate::connectDeviceChanges()
                 SLOT(_q_deviceRemoved(QDBusObjectPath)));
     } else if (adapterBluez5 && managerBluez5) {
         //setup property change notifications for all existing devices
-        QDBusPendingReply<ManagedObjectList> reply = managerBluez5->GetManagedObjects();
-        reply.waitForFinished();
-        if (reply.isError())
-            return;
-
+        QtBluezObjectMirror *mirror = QtBluezObjectMirror::instance();
         OrgFreedesktopDBusPropertiesInterface *monitor = 0;
 
-        ManagedObjectList managedObjectList = reply.value();
-        for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-            const QDBusObjectPath &path = it.key();
-            const InterfaceList &ifaceList = it.value();
+        // don't track connected devices from other adapters but the current
+        foreach (const QString &path, mirror->devicePaths(deviceAdapterPath)) {
+            const QVariantMap ifaceValues = mirror->properties(path,
+                                                               QStringLiteral("org.bluez.Device1"));
 
-            // don't track connected devices from other adapters but the current
-            if (!objectPathIsForThisDevice(deviceAdapterPath, path.path()))
-                continue;
+            monitor = new OrgFreedesktopDBusPropertiesInterface(QStringLiteral("org.bluez"),
+                                                                path,
+                                                                QDBusConnection::systemBus(), this);
+            connect(monitor, SIGNAL(PropertiesChanged(QString,QVariantMap,QStringList)),
+                    SLOT(PropertiesChanged(QString,QVariantMap,QStringList)));
+            deviceChangeMonitors.insert(path, monitor);
 
-            for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-                const QString &iface = jt.key();
-                const QVariantMap &ifaceValues = jt.value();
-
-                if (iface == QStringLiteral("org.bluez.Device1")) {
-                    monitor = new OrgFreedesktopDBusPropertiesInterface(QStringLiteral("org.bluez"),
-                                                                        path.path(),
-                                                                        QDBusConnection::systemBus(), this);
-                    connect(monitor, SIGNAL(PropertiesChanged(QString,QVariantMap,QStringList)),
-                            SLOT(PropertiesChanged(QString,QVariantMap,QStringList)));
-                    deviceChangeMonitors.insert(path.path(), monitor);
-
-                    if (ifaceValues.value(QStringLiteral("Connected"), false).toBool()) {
-                        QBluetoothAddress address(ifaceValues.value(QStringLiteral("Address")).toString());
-                        connectedDevicesSet.insert(address);
-                    }
-                }
+            if (ifaceValues.value(QStringLiteral("Connected"), false).toBool()) {
+                QBluetoothAddress address(ifaceValues.value(QStringLiteral("Address")).toString());
+                connectedDevicesSet.insert(address);
             }
         }
     }
@@ -892,9 +826,9 @@ void QBluetoothLocalDevicePrivate::PropertiesChanged(const QString &interface,
 
         const QString currentPath = senderIface->path();
         bool isConnected = changed_properties.value(QStringLiteral("Connected"), false).toBool();
-        OrgBluezDevice1Interface device(QStringLiteral("org.bluez"), currentPath,
-                                        QDBusConnection::systemBus());
-        const QBluetoothAddress changedAddress(device.address());
+        const QBluetoothAddress changedAddress(
+                    QtBluezObjectMirror::instance()->properties(currentPath, interface)
+                        .value(QStringLiteral("Address")).toString());
         bool isInSet = connectedDevicesSet.contains(changedAddress);
         if (isConnected && !isInSet) {
             connectedDevicesSet.insert(changedAddress);
@@ -933,9 +867,9 @@ void QBluetoothLocalDevicePrivate::InterfacesAdded(const QDBusObjectPath &object
     if (pairingDiscoveryTimer && pairingDiscoveryTimer->isActive()
         && interfaces_and_properties.contains(QStringLiteral("org.bluez.Device1"))) {
         //device discovery for pairing found new remote device
-        OrgBluezDevice1Interface device(QStringLiteral("org.bluez"),
-                                        object_path.path(), QDBusConnection::systemBus());
-        if (!address.isNull() && address == QBluetoothAddress(device.address()))
+        const QVariantMap device = interfaces_and_properties.value(QStringLiteral("org.bluez.Device1"));
+        if (!address.isNull()
+                && address == QBluetoothAddress(device.value(QStringLiteral("Address")).toString()))
             processPairingBluez5(object_path.path(), pairing);
     }
 }
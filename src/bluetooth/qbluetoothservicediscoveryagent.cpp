@@ -303,6 +303,41 @@ QBluetoothAddress QBluetoothServiceDiscoveryAgent::remoteAddress() const
         return QBluetoothAddress();
 }
 
+/*!
+    Returns the maximum number of remote devices whose services are discovered
+    at the same time. The default is 4.
+
+    \sa setMaximumParallelDiscoveries()
+    \since 5.11
+*/
+int QBluetoothServiceDiscoveryAgent::maximumParallelDiscoveries() const
+{
+    Q_D(const QBluetoothServiceDiscoveryAgent);
+    return d->maxParallelDiscoveries;
+}
+
+/*!
+    Sets the maximum number of remote devices whose services are discovered at
+    the same time to \a count. Values smaller than 1 are treated as 1.
+
+    This only affects service discovery on all contactable devices, see
+    setRemoteAddress(). serviceDiscovered() is emitted as soon as a service was
+    found, regardless of the progress on other devices. A new limit applies to
+    the next call of start().
+
+    \note Currently only BlueZ 5 scans several devices at the same time, devices
+    whose UUIDs are already cached by BlueZ are scanned first. On all other
+    platforms the devices are processed one after another.
+
+    \sa maximumParallelDiscoveries()
+    \since 5.11
+*/
+void QBluetoothServiceDiscoveryAgent::setMaximumParallelDiscoveries(int count)
+{
+    Q_D(QBluetoothServiceDiscoveryAgent);
+    d->maxParallelDiscoveries = qMax(1, count);
+}
+
 /*!
     Starts service discovery. \a mode specifies the type of service discovery to perform.
 
@@ -97,6 +97,9 @@ public:
     bool setRemoteAddress(const QBluetoothAddress &address);
     QBluetoothAddress remoteAddress() const;
 
+    int maximumParallelDiscoveries() const;
+    void setMaximumParallelDiscoveries(int count);
+
 public Q_SLOTS:
     void start(DiscoveryMode mode = MinimalDiscovery);
     void stop();
@@ -121,7 +124,10 @@ private:
     Q_PRIVATE_SLOT(d_func(), void _q_discoveredServices(QDBusPendingCallWatcher*))
     Q_PRIVATE_SLOT(d_func(), void _q_createdDevice(QDBusPendingCallWatcher*))
     Q_PRIVATE_SLOT(d_func(), void _q_foundDevice(QDBusPendingCallWatcher*))
-    Q_PRIVATE_SLOT(d_func(), void _q_sdpScannerDone(int,QProcess::ExitStatus))
+    Q_PRIVATE_SLOT(d_func(), void _q_sdpServiceFound(const QBluetoothAddress &address, const QBluetoothServiceInfo &serviceInfo))
+    Q_PRIVATE_SLOT(d_func(), void _q_sdpQueryFinished(const QBluetoothAddress &address, const QString &errorDescription))
+    Q_PRIVATE_SLOT(d_func(), void _q_scheduledDiscoveryStarted(const QBluetoothDeviceInfo &device))
+    Q_PRIVATE_SLOT(d_func(), void _q_scheduledDiscoveriesFinished())
 #endif
 #ifdef QT_ANDROID_BLUETOOTH
     Q_PRIVATE_SLOT(d_func(), void _q_processFetchedUuids(const QBluetoothAddress &address,
@@ -46,11 +46,11 @@
 #include "bluez/bluez5_helper_p.h"
 #include "bluez/objectmanager_p.h"
 #include "bluez/adapter1_bluez5_p.h"
+#include "bluez/sdpclient_p.h"
+#include "bluez/servicediscoveryscheduler_p.h"
 
-#include <QtCore/QFile>
-#include <QtCore/QLibraryInfo>
 #include <QtCore/QLoggingCategory>
-#include <QtCore/QProcess>
+#include <QtCore/QXmlStreamReader>
 #include <QtDBus/QDBusPendingCallWatcher>
 #include <QtConcurrent/QtConcurrentRun>
 
@@ -62,13 +62,11 @@ QBluetoothServiceDiscoveryAgentPrivate::QBluetoothServiceDiscoveryAgentPrivate(
     QBluetoothServiceDiscoveryAgent *qp, const QBluetoothAddress &deviceAdapter)
 :   error(QBluetoothServiceDiscoveryAgent::NoError), m_deviceAdapterAddress(deviceAdapter), state(Inactive), deviceDiscoveryAgent(0),
     mode(QBluetoothServiceDiscoveryAgent::MinimalDiscovery), singleDevice(false),
-    manager(0), managerBluez5(0), adapter(0), device(0), sdpScannerProcess(0),
+    manager(0), managerBluez5(0), adapter(0), device(0), sdpClient(0), scheduler(0),
     q_ptr(qp)
 {
     if (isBluez5()) {
-        managerBluez5 = new OrgFreedesktopDBusObjectManagerInterface(
-                                    QStringLiteral("org.bluez"), QStringLiteral("/"),
-                                    QDBusConnection::systemBus());
+        managerBluez5 = QtBluezObjectMirror::instance();
         qRegisterMetaType<QBluetoothServiceDiscoveryAgent::Error>();
     } else {
         qRegisterMetaType<ServiceMap>();
@@ -83,7 +81,6 @@ QBluetoothServiceDiscoveryAgentPrivate::~QBluetoothServiceDiscoveryAgentPrivate(
 {
     delete device;
     delete manager;
-    delete managerBluez5;
     delete adapter;
 }
 
@@ -180,145 +177,130 @@ void QBluetoothServiceDiscoveryAgentPrivate::startBluez5(const QBluetoothAddress
         return;
     }
 
-    if (DiscoveryMode() == QBluetoothServiceDiscoveryAgent::MinimalDiscovery) {
-        performMinimalServiceDiscovery(address);
-    } else {
-        runExternalSdpScan(address, QBluetoothAddress(adapter.address()));
+    if (DiscoveryMode() == QBluetoothServiceDiscoveryAgent::FullDiscovery && !sdpClient) {
+        sdpClient = new SdpClient(QBluetoothAddress(adapter.address()), q);
+        QObject::connect(sdpClient, SIGNAL(serviceFound(QBluetoothAddress,QBluetoothServiceInfo)),
+                         q, SLOT(_q_sdpServiceFound(QBluetoothAddress,QBluetoothServiceInfo)));
+        QObject::connect(sdpClient, SIGNAL(queryFinished(QBluetoothAddress,QString)),
+                         q, SLOT(_q_sdpQueryFinished(QBluetoothAddress,QString)));
     }
-}
-
-/* Bluez 5
- * src/tools/sdpscanner performs an SDP scan. This is
- * done out-of-process to avoid license issues. At this stage Bluez uses GPLv2.
- */
-void QBluetoothServiceDiscoveryAgentPrivate::runExternalSdpScan(
-        const QBluetoothAddress &remoteAddress, const QBluetoothAddress &localAddress)
-{
-    Q_Q(QBluetoothServiceDiscoveryAgent);
 
-    if (!sdpScannerProcess) {
-        const QString binPath = QLibraryInfo::location(QLibraryInfo::BinariesPath);
-        QFileInfo fileInfo(binPath, QStringLiteral("sdpscanner"));
-        if (!fileInfo.exists() || !fileInfo.isExecutable()) {
-            _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::InputOutputError,
-                             QBluetoothServiceDiscoveryAgent::tr("Unable to find sdpscanner"),
-                             QStringList());
-            qCWarning(QT_BT_BLUEZ) << "Cannot find sdpscanner:"
-                                   << fileInfo.canonicalFilePath();
-            return;
-        }
-
-        sdpScannerProcess = new QProcess(q);
-        sdpScannerProcess->setReadChannel(QProcess::StandardOutput);
-        if (QT_BT_BLUEZ().isDebugEnabled())
-            sdpScannerProcess->setProcessChannelMode(QProcess::ForwardedErrorChannel);
-        sdpScannerProcess->setProgram(fileInfo.canonicalFilePath());
-        q->connect(sdpScannerProcess, SIGNAL(finished(int,QProcess::ExitStatus)),
-                   q, SLOT(_q_sdpScannerDone(int,QProcess::ExitStatus)));
+    if (!scheduler) {
+        scheduler = new ServiceDiscoveryScheduler(q);
+        QObject::connect(scheduler, SIGNAL(discoveryStarted(QBluetoothDeviceInfo)),
+                         q, SLOT(_q_scheduledDiscoveryStarted(QBluetoothDeviceInfo)));
+        QObject::connect(scheduler, SIGNAL(finished()),
+                         q, SLOT(_q_scheduledDiscoveriesFinished()));
     }
 
-    QStringList arguments;
-    arguments << remoteAddress.toString() << localAddress.toString();
+    // All discovered devices are scheduled at once rather than one after another,
+    // address is merely the first of them.
+    Q_UNUSED(address);
+    scheduler->setMaximumParallelDiscoveries(maxParallelDiscoveries);
+    if (sdpClient)
+        sdpClient->setMaximumParallelQueries(maxParallelDiscoveries);
 
-    // No filter implies PUBLIC_BROWSE_GROUP based SDP scan
-    if (!uuidFilter.isEmpty()) {
-        arguments << QLatin1String("-u"); // cmd line option for list of uuids
-        foreach (const QBluetoothUuid& uuid, uuidFilter)
-            arguments << uuid.toString();
-    }
+    foreach (const QBluetoothDeviceInfo &device, discoveredDevices)
+        scheduler->enqueue(device, !cachedUuids(device.address()).isEmpty());
+    scheduler->start();
+}
 
-    sdpScannerProcess->setArguments(arguments);
-    sdpScannerProcess->start();
+// Bluez 5
+QStringList QBluetoothServiceDiscoveryAgentPrivate::cachedUuids(
+        const QBluetoothAddress &address) const
+{
+    const QString devicePath = managerBluez5->devicePath(foundHostAdapterPath, address);
+    if (devicePath.isEmpty())
+        return QStringList();
+
+    return managerBluez5->properties(devicePath, QStringLiteral("org.bluez.Device1"))
+            .value(QStringLiteral("UUIDs")).toStringList();
 }
 
 // Bluez 5
-void QBluetoothServiceDiscoveryAgentPrivate::_q_sdpScannerDone(int exitCode, QProcess::ExitStatus status)
+void QBluetoothServiceDiscoveryAgentPrivate::_q_scheduledDiscoveryStarted(
+        const QBluetoothDeviceInfo &device)
 {
-    if (status != QProcess::NormalExit || exitCode != 0) {
-        qCWarning(QT_BT_BLUEZ) << "SDP scan failure" << status << exitCode;
-        if (singleDevice) {
-            _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::InputOutputError,
-                             QBluetoothServiceDiscoveryAgent::tr("Unable to perform SDP scan"),
-                             QStringList());
-        } else {
-            // go to next device
-            _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::NoError, QString(), QStringList());
-        }
+    // SDP is a BR/EDR protocol, there is nothing to query on LE only devices
+    if (DiscoveryMode() == QBluetoothServiceDiscoveryAgent::MinimalDiscovery
+            || device.coreConfigurations() == QBluetoothDeviceInfo::LowEnergyCoreConfiguration) {
+        performMinimalServiceDiscovery(device);
+        scheduler->deviceFinished(device.address());
         return;
     }
 
-    QStringList xmlRecords;
-    const QByteArray output = sdpScannerProcess->readAllStandardOutput();
-    const QString decodedData = QString::fromUtf8(QByteArray::fromBase64(output));
-
-    // split the various xml docs up
-    int next;
-    int start = decodedData.indexOf(QStringLiteral("<?xml"), 0);
-    if (start != -1) {
-        do {
-            next = decodedData.indexOf(QStringLiteral("<?xml"), start + 1);
-            if (next != -1)
-                xmlRecords.append(decodedData.mid(start, next-start));
-            else
-                xmlRecords.append(decodedData.mid(start, decodedData.size() - start));
-            start = next;
-        } while ( start != -1);
-    }
+    sdpClient->query(device.address(), uuidFilter);
+}
 
-    _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::NoError, QString(), xmlRecords);
+// Bluez 5
+void QBluetoothServiceDiscoveryAgentPrivate::_q_scheduledDiscoveriesFinished()
+{
+    discoveredDevices.clear();
+    _q_serviceDiscoveryFinished();
 }
 
 // Bluez 5
-void QBluetoothServiceDiscoveryAgentPrivate::_q_finishSdpScan(QBluetoothServiceDiscoveryAgent::Error errorCode,
-                                                              const QString &errorDescription,
-                                                              const QStringList &xmlRecords)
+void QBluetoothServiceDiscoveryAgentPrivate::_q_sdpServiceFound(const QBluetoothAddress &address,
+                                                                const QBluetoothServiceInfo &record)
 {
     Q_Q(QBluetoothServiceDiscoveryAgent);
 
-    if (errorCode != QBluetoothServiceDiscoveryAgent::NoError) {
-        qCWarning(QT_BT_BLUEZ) << "SDP search failed for"
-                              << (!discoveredDevices.isEmpty()
-                                     ? discoveredDevices.at(0).address().toString()
-                                     : QStringLiteral("<Unknown>"));
-        // We have an error which we need to indicate and stop further processing
-        discoveredDevices.clear();
-        error = errorCode;
-        errorString = errorDescription;
-        emit q->error(error);
-    } else if (!xmlRecords.isEmpty() && discoveryState() != Inactive) {
-        foreach (const QString &record, xmlRecords) {
-            const QBluetoothServiceInfo serviceInfo = parseServiceXml(record);
-
-            //apply uuidFilter
-            if (!uuidFilter.isEmpty()) {
-                bool serviceNameMatched = uuidFilter.contains(serviceInfo.serviceUuid());
-                bool serviceClassMatched = false;
-                foreach (const QBluetoothUuid &id, serviceInfo.serviceClassUuids()) {
-                    if (uuidFilter.contains(id)) {
-                        serviceClassMatched = true;
-                        break;
-                    }
-                }
+    if (discoveryState() == Inactive || !scheduler || !scheduler->isRunning(address))
+        return;
+
+    QBluetoothServiceInfo serviceInfo = record;
+    serviceInfo.setDevice(scheduler->runningDevice(address));
 
-                if (!serviceNameMatched && !serviceClassMatched)
-                    continue;
+    //apply uuidFilter
+    if (!uuidFilter.isEmpty()) {
+        bool serviceNameMatched = uuidFilter.contains(serviceInfo.serviceUuid());
+        bool serviceClassMatched = false;
+        foreach (const QBluetoothUuid &id, serviceInfo.serviceClassUuids()) {
+            if (uuidFilter.contains(id)) {
+                serviceClassMatched = true;
+                break;
             }
+        }
+
+        if (!serviceNameMatched && !serviceClassMatched)
+            return;
+    }
 
-            if (!serviceInfo.isValid())
-                continue;
+    if (!serviceInfo.isValid())
+        return;
 
-            if (!isDuplicatedService(serviceInfo)) {
-                discoveredServices.append(serviceInfo);
-                qCDebug(QT_BT_BLUEZ) << "Discovered services" << discoveredDevices.at(0).address().toString()
-                                     << serviceInfo.serviceName() << serviceInfo.serviceUuid()
-                                     << ">>>" << serviceInfo.serviceClassUuids();
+    if (!isDuplicatedService(serviceInfo)) {
+        discoveredServices.append(serviceInfo);
+        qCDebug(QT_BT_BLUEZ) << "Discovered services" << address.toString()
+                             << serviceInfo.serviceName() << serviceInfo.serviceUuid()
+                             << ">>>" << serviceInfo.serviceClassUuids();
 
-                emit q->serviceDiscovered(serviceInfo);
-            }
+        emit q->serviceDiscovered(serviceInfo);
+    }
+}
+
+// Bluez 5
+void QBluetoothServiceDiscoveryAgentPrivate::_q_sdpQueryFinished(const QBluetoothAddress &address,
+                                                                 const QString &errorDescription)
+{
+    Q_Q(QBluetoothServiceDiscoveryAgent);
+
+    if (!scheduler || !scheduler->isRunning(address))
+        return;
+
+    if (!errorDescription.isEmpty()) {
+        qCWarning(QT_BT_BLUEZ) << "SDP scan failure" << address.toString() << errorDescription;
+
+        if (singleDevice) {
+            // We have an error which we need to indicate
+            error = QBluetoothServiceDiscoveryAgent::InputOutputError;
+            errorString = QBluetoothServiceDiscoveryAgent::tr("Unable to perform SDP scan");
+            emit q->error(error);
         }
+        // otherwise errors of individual devices are suppressed
     }
 
-    _q_serviceDiscoveryFinished();
+    scheduler->deviceFinished(address);
 }
 
 void QBluetoothServiceDiscoveryAgentPrivate::stop()
@@ -344,14 +326,10 @@ void QBluetoothServiceDiscoveryAgentPrivate::stop()
     discoveredDevices.clear();
     setDiscoveryState(Inactive);
 
-    // must happen after discoveredDevices.clear() above to avoid retrigger of next scan
-    // while waitForFinished() is waiting
-    if (sdpScannerProcess) { // Bluez 5
-        if (sdpScannerProcess->state() != QProcess::NotRunning) {
-            sdpScannerProcess->kill();
-            sdpScannerProcess->waitForFinished();
-        }
-    }
+    if (scheduler) // Bluez 5
+        scheduler->clear();
+    if (sdpClient)
+        sdpClient->cancel();
 
     Q_Q(QBluetoothServiceDiscoveryAgent);
     emit q->canceled();
@@ -635,57 +613,17 @@ QBluetoothServiceInfo QBluetoothServiceDiscoveryAgentPrivate::parseServiceXml(
 }
 
 // Bluez 5
-void QBluetoothServiceDiscoveryAgentPrivate::performMinimalServiceDiscovery(const QBluetoothAddress &deviceAddress)
+void QBluetoothServiceDiscoveryAgentPrivate::performMinimalServiceDiscovery(const QBluetoothDeviceInfo &device)
 {
-    if (foundHostAdapterPath.isEmpty()) {
-        _q_serviceDiscoveryFinished();
-        return;
-    }
-
     Q_Q(QBluetoothServiceDiscoveryAgent);
 
-    QDBusPendingReply<ManagedObjectList> reply = managerBluez5->GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
-        if (singleDevice) {
-            error = QBluetoothServiceDiscoveryAgent::InputOutputError;
-            errorString = reply.error().message();
-            emit q->error(error);
-
-        }
-        _q_serviceDiscoveryFinished();
-        return;
-    }
-
-    QStringList uuidStrings;
-
-    ManagedObjectList managedObjectList = reply.value();
-    for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-        const InterfaceList &ifaceList = it.value();
-
-        for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-            const QString &iface = jt.key();
-            const QVariantMap &ifaceValues = jt.value();
-
-            if (iface == QStringLiteral("org.bluez.Device1")) {
-                if (deviceAddress.toString() == ifaceValues.value(QStringLiteral("Address")).toString()) {
-                    uuidStrings = ifaceValues.value(QStringLiteral("UUIDs")).toStringList();
-                    break;
-                }
-            }
-        }
-        if (!uuidStrings.isEmpty())
-            break;
-    }
-
-    if (uuidStrings.isEmpty() || discoveredDevices.isEmpty()) {
-        qCWarning(QT_BT_BLUEZ) << "No uuids found for" << deviceAddress.toString();
-         // nothing found -> go to next uuid
-        _q_serviceDiscoveryFinished();
+    const QStringList uuidStrings = cachedUuids(device.address());
+    if (uuidStrings.isEmpty()) {
+        qCWarning(QT_BT_BLUEZ) << "No uuids found for" << device.address().toString();
         return;
     }
 
-    qCDebug(QT_BT_BLUEZ) << "Minimal uuid list for" << deviceAddress.toString() << uuidStrings;
+    qCDebug(QT_BT_BLUEZ) << "Minimal uuid list for" << device.address().toString() << uuidStrings;
 
     QBluetoothUuid uuid;
     for (int i = 0; i < uuidStrings.count(); i++) {
@@ -698,7 +636,7 @@ void QBluetoothServiceDiscoveryAgentPrivate::performMinimalServiceDiscovery(cons
             continue;
 
         QBluetoothServiceInfo serviceInfo;
-        serviceInfo.setDevice(discoveredDevices.at(0));
+        serviceInfo.setDevice(device);
 
         if (uuid.minimumSize() == 16) { // not derived from Bluetooth Base UUID
             serviceInfo.setServiceUuid(uuid);
@@ -729,13 +667,11 @@ void QBluetoothServiceDiscoveryAgentPrivate::performMinimalServiceDiscovery(cons
         //don't include the service if we already discovered it before
         if (!isDuplicatedService(serviceInfo)) {
             discoveredServices << serviceInfo;
-            qCDebug(QT_BT_BLUEZ) << "Discovered services" << discoveredDevices.at(0).address().toString()
+            qCDebug(QT_BT_BLUEZ) << "Discovered services" << device.address().toString()
                                  << serviceInfo.serviceName();
             emit q->serviceDiscovered(serviceInfo);
         }
     }
-
-    _q_serviceDiscoveryFinished();
 }
 
 QVariant QBluetoothServiceDiscoveryAgentPrivate::readAttributeValue(QXmlStreamReader &xml)
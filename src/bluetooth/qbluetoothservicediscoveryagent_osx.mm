@@ -108,6 +108,7 @@ private:
     bool singleDevice;
     QBluetoothAddress deviceAddress;
     QBluetoothAddress localAdapterAddress;
+    int maxParallelDiscoveries = 4;
 
     DiscoveryState state;
     QBluetoothServiceDiscoveryAgent::DiscoveryMode discoveryMode;
@@ -524,6 +525,17 @@ QBluetoothAddress QBluetoothServiceDiscoveryAgent::remoteAddress() const
     return QBluetoothAddress();
 }
 
+int QBluetoothServiceDiscoveryAgent::maximumParallelDiscoveries() const
+{
+    return d_ptr->maxParallelDiscoveries;
+}
+
+void QBluetoothServiceDiscoveryAgent::setMaximumParallelDiscoveries(int count)
+{
+    // devices are processed one after another
+    d_ptr->maxParallelDiscoveries = qMax(1, count);
+}
+
 void QBluetoothServiceDiscoveryAgent::start(DiscoveryMode mode)
 {
     OSXBluetooth::qt_test_iobluetooth_runloop();
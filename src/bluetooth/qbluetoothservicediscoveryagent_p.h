@@ -63,12 +63,13 @@
 class OrgBluezManagerInterface;
 class OrgBluezAdapterInterface;
 class OrgBluezDeviceInterface;
-class OrgFreedesktopDBusObjectManagerInterface;
-#include <QtCore/qprocess.h>
 
 QT_BEGIN_NAMESPACE
 class QDBusPendingCallWatcher;
 class QXmlStreamReader;
+class QtBluezObjectMirror;
+class SdpClient;
+class ServiceDiscoveryScheduler;
 QT_END_NAMESPACE
 #endif
 
@@ -136,10 +137,11 @@ public:
     void _q_discoverGattCharacteristics(QDBusPendingCallWatcher *watcher);
     void _q_discoveredGattCharacteristic(QDBusPendingCallWatcher *watcher);
     */
-    void _q_sdpScannerDone(int exitCode, QProcess::ExitStatus status);
-    void _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::Error errorCode,
-                          const QString &errorDescription,
-                          const QStringList &xmlRecords);
+    void _q_sdpServiceFound(const QBluetoothAddress &address,
+                            const QBluetoothServiceInfo &serviceInfo);
+    void _q_sdpQueryFinished(const QBluetoothAddress &address, const QString &errorDescription);
+    void _q_scheduledDiscoveryStarted(const QBluetoothDeviceInfo &device);
+    void _q_scheduledDiscoveriesFinished();
 #endif
 #ifdef QT_ANDROID_BLUETOOTH
     void _q_processFetchedUuids(const QBluetoothAddress &address, const QList<QBluetoothUuid> &uuids);
@@ -157,12 +159,10 @@ private:
 
 #if QT_CONFIG(bluez)
     void startBluez5(const QBluetoothAddress &address);
-    void runExternalSdpScan(const QBluetoothAddress &remoteAddress,
-                    const QBluetoothAddress &localAddress);
-    void sdpScannerDone(int exitCode, QProcess::ExitStatus exitStatus);
+    QStringList cachedUuids(const QBluetoothAddress &address) const;
     QVariant readAttributeValue(QXmlStreamReader &xml);
     QBluetoothServiceInfo parseServiceXml(const QString& xml);
-    void performMinimalServiceDiscovery(const QBluetoothAddress &deviceAddress);
+    void performMinimalServiceDiscovery(const QBluetoothDeviceInfo &device);
     void discoverServices(const QString &deviceObjectPath);
 #endif
 
@@ -173,6 +173,7 @@ public:
     QList<QBluetoothServiceInfo> discoveredServices;
     QList<QBluetoothDeviceInfo> discoveredDevices;
     QBluetoothAddress m_deviceAdapterAddress;
+    int maxParallelDiscoveries = 4;
 
 private:
     DiscoveryState state;
@@ -186,10 +187,11 @@ private:
 #if QT_CONFIG(bluez)
     QString foundHostAdapterPath;
     OrgBluezManagerInterface *manager;
-    OrgFreedesktopDBusObjectManagerInterface *managerBluez5;
+    QtBluezObjectMirror *managerBluez5;
     OrgBluezAdapterInterface *adapter;
     OrgBluezDeviceInterface *device;
-    QProcess *sdpScannerProcess;
+    SdpClient *sdpClient;
+    ServiceDiscoveryScheduler *scheduler;
 #endif
 
 #ifdef QT_ANDROID_BLUETOOTH
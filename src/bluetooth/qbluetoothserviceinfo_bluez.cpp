@@ -44,9 +44,9 @@
 #include "bluez/service_p.h"
 #include "bluez/bluez5_helper_p.h"
 #include "bluez/profile1_p.h"
+#include "bluez/sdpdataelement_p.h"
 
 #include <QtCore/QLoggingCategory>
-#include <QtCore/QXmlStreamWriter>
 #include <QtCore/QAtomicInt>
 
 QT_BEGIN_NAMESPACE
@@ -56,124 +56,6 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 static const QLatin1String profilePathTemplate("/qt/profile");
 static QAtomicInt pathCounter;
 
-static void writeAttribute(QXmlStreamWriter *stream, const QVariant &attribute)
-{
-    const QString unsignedFormat(QStringLiteral("0x%1"));
-
-    switch (int(attribute.type())) {
-    case QMetaType::Void:
-        stream->writeEmptyElement(QStringLiteral("nil"));
-        break;
-    case QMetaType::UChar:
-        stream->writeEmptyElement(QStringLiteral("uint8"));
-        stream->writeAttribute(QStringLiteral("value"),
-                               unsignedFormat.arg(attribute.value<quint8>(), 2, 16,
-                                                  QLatin1Char('0')));
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-    case QMetaType::UShort:
-        stream->writeEmptyElement(QStringLiteral("uint16"));
-        stream->writeAttribute(QStringLiteral("value"),
-                               unsignedFormat.arg(attribute.value<quint16>(), 4, 16,
-                                                  QLatin1Char('0')));
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-    case QMetaType::UInt:
-        stream->writeEmptyElement(QStringLiteral("uint32"));
-        stream->writeAttribute(QStringLiteral("value"),
-                               unsignedFormat.arg(attribute.value<quint32>(), 8, 16,
-                                                  QLatin1Char('0')));
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-    case QMetaType::Char:
-        stream->writeEmptyElement(QStringLiteral("int8"));
-        stream->writeAttribute(QStringLiteral("value"),
-                               QString::number(attribute.value<uchar>(), 16));
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-    case QMetaType::Short:
-        stream->writeEmptyElement(QStringLiteral("int16"));
-        stream->writeAttribute(QStringLiteral("value"),
-                               QString::number(attribute.value<qint16>(), 16));
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-    case QMetaType::Int:
-        stream->writeEmptyElement(QStringLiteral("int32"));
-        stream->writeAttribute(QStringLiteral("value"),
-                               QString::number(attribute.value<qint32>(), 16));
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-    case QMetaType::QString:
-        stream->writeEmptyElement(QStringLiteral("text"));
-        if (/* require hex encoding */ false) {
-            stream->writeAttribute(QStringLiteral("value"), QString::fromLatin1(
-                                       attribute.value<QString>().toUtf8().toHex().constData()));
-            stream->writeAttribute(QStringLiteral("encoding"), QStringLiteral("hex"));
-        } else {
-            stream->writeAttribute(QStringLiteral("value"), attribute.value<QString>());
-            stream->writeAttribute(QStringLiteral("encoding"), QStringLiteral("normal"));
-        }
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-            case QMetaType::Bool:
-        stream->writeEmptyElement(QStringLiteral("boolean"));
-        if (attribute.value<bool>())
-            stream->writeAttribute(QStringLiteral("value"), QStringLiteral("true"));
-        else
-            stream->writeAttribute(QStringLiteral("value"), QStringLiteral("false"));
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-            case QMetaType::QUrl:
-        stream->writeEmptyElement(QStringLiteral("url"));
-        stream->writeAttribute(QStringLiteral("value"), attribute.value<QUrl>().toString());
-        //stream->writeAttribute(QStringLiteral("name"), foo);
-        break;
-            case QVariant::UserType:
-        if (attribute.userType() == qMetaTypeId<QBluetoothUuid>()) {
-            stream->writeEmptyElement(QStringLiteral("uuid"));
-
-            QBluetoothUuid uuid = attribute.value<QBluetoothUuid>();
-            switch (uuid.minimumSize()) {
-            case 0:
-                stream->writeAttribute(QStringLiteral("value"),
-                                       unsignedFormat.arg(quint16(0), 4, 16, QLatin1Char('0')));
-                break;
-            case 2:
-                stream->writeAttribute(QStringLiteral("value"),
-                                       unsignedFormat.arg(uuid.toUInt16(), 4, 16,
-                                                          QLatin1Char('0')));
-                break;
-            case 4:
-                stream->writeAttribute(QStringLiteral("value"),
-                                       unsignedFormat.arg(uuid.toUInt32(), 8, 16,
-                                                          QLatin1Char('0')));
-                break;
-            case 16:
-                stream->writeAttribute(QStringLiteral("value"), uuid.toString().mid(1, 36));
-                break;
-            default:
-                stream->writeAttribute(QStringLiteral("value"), uuid.toString().mid(1, 36));
-            }
-        } else if (attribute.userType() == qMetaTypeId<QBluetoothServiceInfo::Sequence>()) {
-            stream->writeStartElement(QStringLiteral("sequence"));
-            const QBluetoothServiceInfo::Sequence *sequence =
-                    static_cast<const QBluetoothServiceInfo::Sequence *>(attribute.data());
-            foreach (const QVariant &v, *sequence)
-                writeAttribute(stream, v);
-            stream->writeEndElement();
-        } else if (attribute.userType() == qMetaTypeId<QBluetoothServiceInfo::Alternative>()) {
-            const QBluetoothServiceInfo::Alternative *alternative =
-                    static_cast<const QBluetoothServiceInfo::Alternative *>(attribute.data());
-            foreach (const QVariant &v, *alternative)
-                writeAttribute(stream, v);
-            stream->writeEndElement();
-        }
-        break;
-            default:
-        qCWarning(QT_BT_BLUEZ) << "Unknown variant type", attribute.userType();
-    }
-}
-
 QBluetoothServiceInfoPrivate::QBluetoothServiceInfoPrivate()
 :   service(0), serviceBluez5(0), serviceRecord(0), registered(false)
 {
@@ -271,31 +153,20 @@ bool QBluetoothServiceInfoPrivate::registerService(const QBluetoothAddress &loca
         }
     }
 
-    QString xmlServiceRecord;
-
-    QXmlStreamWriter stream(&xmlServiceRecord);
-    stream.setAutoFormatting(true);
-
-    stream.writeStartDocument(QStringLiteral("1.0"));
-
-    stream.writeStartElement(QStringLiteral("record"));
-
-    const QString unsignedFormat(QStringLiteral("0x%1"));
-
-    QMap<quint16, QVariant>::ConstIterator i = attributes.constBegin();
-    while (i != attributes.constEnd()) {
-        stream.writeStartElement(QStringLiteral("attribute"));
-        stream.writeAttribute(QStringLiteral("id"), unsignedFormat.arg(i.key(), 4, 16, QLatin1Char('0')));
-        writeAttribute(&stream, i.value());
-        stream.writeEndElement();
-
-        ++i;
+    // BlueZ only accepts XML records. The record is kept in its binary form
+    // and only converted when it changes; re-registering an unchanged service
+    // reuses the previous XML document.
+    QByteArray record;
+    SdpDataElement::encodeAttributeList(attributes, &record);
+    if (record != encodedServiceRecord) {
+        if (!SdpDataElement::attributeListToXml(record, &xmlServiceRecord)) {
+            qCWarning(QT_BT_BLUEZ) << "Cannot convert service record";
+            encodedServiceRecord.clear();
+            return false;
+        }
+        encodedServiceRecord = record;
     }
 
-    stream.writeEndElement();
-
-    stream.writeEndDocument();
-
     if (serviceBluez5) { // Bluez 5
         // create path
         profilePath = profilePathTemplate;
@@ -112,6 +112,8 @@ private:
     quint32 serviceRecord;
     QBluetoothAddress currentLocalAdapter;
     QString profilePath;
+    QByteArray encodedServiceRecord;
+    QString xmlServiceRecord;
 #endif
 
 #ifdef QT_WINRT_BLUETOOTH
@@ -219,6 +219,33 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
     \fn QString QBluetoothSocket::peerName() const
 
     Returns the name of the peer device.
+
+    On BlueZ the name is served from a process wide copy of the BlueZ device
+    database which is kept current by D-Bus signals. If BlueZ has not learned the
+    name of the peer yet, an empty string is returned. Use \l requestPeerName()
+    to be notified once the name becomes known.
+
+    \sa requestPeerName()
+*/
+
+/*!
+    \fn void QBluetoothSocket::requestPeerName()
+    \since 5.11
+
+    Requests the name of the peer device without blocking. The name is reported
+    by \l peerNameResolved(), which is always emitted from the event loop. If
+    the name is not known yet, the signal is emitted as soon as the platform
+    learns it.
+
+    \sa peerName()
+*/
+
+/*!
+    \fn void QBluetoothSocket::peerNameResolved(const QString &name)
+    \since 5.11
+
+    This signal is emitted when the \a name of the peer device, which was asked
+    for by \l requestPeerName(), is known.
 */
 
 /*!
@@ -603,6 +630,68 @@ QBluetooth::SecurityFlags QBluetoothSocket::preferredSecurityFlags() const
     return d->secFlags;
 }
 
+/*!
+    Enables kernel receive timestamps if \a enabled is \c true; otherwise disables them.
+    They are disabled by default.
+
+    While enabled, \l lastReceiveTimestamp() tells when the data which was read last
+    arrived at the local device, independently of when the event loop got around to
+    reading it. The setting can be changed at any time and is kept across connections.
+
+    \note Currently, this functionality is only implemented on Linux. L2CAP sockets
+    are stamped by the kernel, RFCOMM sockets only if the kernel supports it.
+
+    \sa isReceiveTimestampsEnabled(), lastReceiveTimestamp()
+    \since 5.11
+*/
+void QBluetoothSocket::setReceiveTimestampsEnabled(bool enabled)
+{
+#if QT_CONFIG(bluez)
+    Q_D(QBluetoothSocket);
+    d->setReceiveTimestampsEnabled(enabled);
+#else
+    Q_UNUSED(enabled);
+    qCWarning(QT_BT) << "Receive timestamps are not implemented on this platform";
+#endif
+}
+
+/*!
+    Returns \c true if kernel receive timestamps are enabled; otherwise returns \c false.
+
+    \sa setReceiveTimestampsEnabled()
+    \since 5.11
+*/
+bool QBluetoothSocket::isReceiveTimestampsEnabled() const
+{
+#if QT_CONFIG(bluez)
+    Q_D(const QBluetoothSocket);
+    return d->receiveTimestamps;
+#else
+    return false;
+#endif
+}
+
+/*!
+    Returns the time at which the data which was read from the device last arrived,
+    in nanoseconds since 1970-01-01T00:00:00 UTC. Returns -1 if receive timestamps are
+    disabled or no data has been received yet.
+
+    If the kernel does not stamp the data of this socket, the time at which the data
+    was read is returned instead.
+
+    \sa setReceiveTimestampsEnabled()
+    \since 5.11
+*/
+qint64 QBluetoothSocket::lastReceiveTimestamp() const
+{
+#if QT_CONFIG(bluez)
+    Q_D(const QBluetoothSocket);
+    return d->receiveTimestamps ? d->receiveTimestamp : -1;
+#else
+    return -1;
+#endif
+}
+
 /*!
     Sets the socket state to \a state.
 */
@@ -765,6 +854,17 @@ QString QBluetoothSocket::peerName() const
     return d->peerName();
 }
 
+void QBluetoothSocket::requestPeerName()
+{
+    Q_D(QBluetoothSocket);
+#if QT_CONFIG(bluez)
+    d->requestPeerName();
+#else
+    QMetaObject::invokeMethod(this, "peerNameResolved", Qt::QueuedConnection,
+                              Q_ARG(QString, d->peerName()));
+#endif
+}
+
 QBluetoothAddress QBluetoothSocket::peerAddress() const
 {
     Q_D(const QBluetoothSocket);
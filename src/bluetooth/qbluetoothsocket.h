@@ -116,6 +116,7 @@ public:
     quint16 localPort() const;
 
     QString peerName() const;
+    void requestPeerName();
     QBluetoothAddress peerAddress() const;
     quint16 peerPort() const;
     //QBluetoothServiceInfo peerService() const;
@@ -140,11 +141,16 @@ public:
     void setPreferredSecurityFlags(QBluetooth::SecurityFlags flags);
     QBluetooth::SecurityFlags preferredSecurityFlags() const;
 
+    void setReceiveTimestampsEnabled(bool enabled);
+    bool isReceiveTimestampsEnabled() const;
+    qint64 lastReceiveTimestamp() const;
+
 Q_SIGNALS:
     void connected();
     void disconnected();
     void error(QBluetoothSocket::SocketError error);
     void stateChanged(QBluetoothSocket::SocketState state);
+    void peerNameResolved(const QString &name);
 
 protected:
     virtual qint64 readData(char *data, qint64 maxSize);
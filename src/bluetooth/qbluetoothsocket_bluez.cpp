@@ -43,9 +43,10 @@
 #include "bluez/manager_p.h"
 #include "bluez/adapter_p.h"
 #include "bluez/device_p.h"
-#include "bluez/objectmanager_p.h"
+#include "bluez/bluez5_helper_p.h"
 #include <QtBluetooth/QBluetoothLocalDevice>
 #include "bluez/bluez_data_p.h"
+#include "bluez/btsnooptracer_p.h"
 
 #include <qplatformdefs.h>
 #include <QtCore/private/qcore_unix_p.h>
@@ -55,6 +56,9 @@
 #include <errno.h>
 #include <unistd.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
 
 #include <QtCore/QSocketNotifier>
 
@@ -72,10 +76,39 @@ QBluetoothSocketPrivate::QBluetoothSocketPrivate()
       connecting(false),
       discoveryAgent(0),
       secFlags(QBluetooth::Authorization),
-      lowEnergySocketType(0)
+      peerNameRequested(false),
+      lowEnergySocketType(0),
+      traceConnectionHandle(-1),
+      receiveTimestamps(false),
+      receiveTimestamp(-1)
 {
 }
 
+static void tracePacket(QBluetoothSocketPrivate *d, BtSnoopTracer::Direction direction,
+                        const char *data, int size)
+{
+    BtSnoopTracer::Reference tracer;
+    if (Q_LIKELY(tracer.isNull()))
+        return;
+
+    if (d->traceConnectionHandle < 0) {
+        bt_conninfo info;
+        socklen_t len = sizeof(info);
+        memset(&info, 0, sizeof(info));
+        const bool rfcomm = d->socketType == QBluetoothServiceInfo::RfcommProtocol;
+        if (::getsockopt(d->socket, rfcomm ? SOL_RFCOMM : SOL_L2CAP,
+                         rfcomm ? RFCOMM_CONNINFO : L2CAP_CONNINFO, &info, &len) == 0)
+            d->traceConnectionHandle = info.hci_handle;
+        else
+            d->traceConnectionHandle = 0;
+    }
+
+    // all non-ATT traffic is shown on the first dynamic channel
+    const quint16 channelId = d->lowEnergySocketType ? ATTRIBUTE_CHANNEL_ID
+                                                     : BtSnoopTracer::DynamicChannelId;
+    tracer->trace(direction, d->traceConnectionHandle, channelId, data, size);
+}
+
 QBluetoothSocketPrivate::~QBluetoothSocketPrivate()
 {
     delete readNotifier;
@@ -98,6 +131,8 @@ bool QBluetoothSocketPrivate::ensureNativeSocket(QBluetoothServiceInfo::Protocol
     }
 
     socketType = type;
+    traceConnectionHandle = -1;
+    receiveTimestamp = -1;
 
     switch (type) {
     case QBluetoothServiceInfo::L2capProtocol:
@@ -116,6 +151,9 @@ bool QBluetoothSocketPrivate::ensureNativeSocket(QBluetoothServiceInfo::Protocol
     int flags = fcntl(socket, F_GETFL, 0);
     fcntl(socket, F_SETFL, flags | O_NONBLOCK);
 
+    if (receiveTimestamps)
+        enableReceiveTimestamps();
+
     Q_Q(QBluetoothSocket);
     readNotifier = new QSocketNotifier(socket, QSocketNotifier::Read);
     QObject::connect(readNotifier, SIGNAL(activated(int)), this, SLOT(_q_readNotify()));
@@ -261,8 +299,10 @@ void QBluetoothSocketPrivate::_q_writeNotify()
                 char* remainder = buf + writtenBytes;
                 txBuffer.ungetBlock(remainder, size - writtenBytes);
             }
-            if (writtenBytes > 0)
+            if (writtenBytes > 0) {
+                tracePacket(this, BtSnoopTracer::Sent, buf, writtenBytes);
                 emit q->bytesWritten(writtenBytes);
+            }
         }
 
         if (txBuffer.size()) {
@@ -275,12 +315,100 @@ void QBluetoothSocketPrivate::_q_writeNotify()
     }
 }
 
+void QBluetoothSocketPrivate::setReceiveTimestampsEnabled(bool enabled)
+{
+    if (receiveTimestamps == enabled)
+        return;
+
+    receiveTimestamps = enabled;
+    receiveTimestamp = -1;
+    if (socket == -1)
+        return;
+
+    if (enabled) {
+        enableReceiveTimestamps();
+    } else {
+        const int off = 0;
+        ::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &off, sizeof(off));
+        ::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMP, &off, sizeof(off));
+    }
+}
+
+void QBluetoothSocketPrivate::enableReceiveTimestamps()
+{
+    // older kernels only offer microsecond resolution
+    const int on = 1;
+    if (::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0
+            && ::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot enable receive timestamps:" << qt_error_string(errno);
+    }
+}
+
+/*
+ * Behaves like read() and stores the time at which the kernel received the data
+ * in receiveTimestamp. Sockets which are not stamped by the kernel get the current time.
+ */
+int QBluetoothSocketPrivate::readWithTimestamp(char *data, int maxSize)
+{
+    iovec vector;
+    vector.iov_base = data;
+    vector.iov_len = maxSize;
+
+    union {
+        cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(timeval))];
+    } control;
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    int result;
+    do {
+        result = ::recvmsg(socket, &message, 0);
+    } while (result < 0 && errno == EINTR);
+
+    if (result <= 0)
+        return result;
+
+    qint64 timestamp = -1;
+    for (cmsghdr *header = CMSG_FIRSTHDR(&message); header;
+         header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level != SOL_SOCKET)
+            continue;
+
+        if (header->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec time;
+            memcpy(&time, CMSG_DATA(header), sizeof(time));
+            timestamp = qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+        } else if (header->cmsg_type == SCM_TIMESTAMP) {
+            timeval time;
+            memcpy(&time, CMSG_DATA(header), sizeof(time));
+            timestamp = qint64(time.tv_sec) * 1000000000 + qint64(time.tv_usec) * 1000;
+        }
+    }
+
+    if (timestamp < 0) {
+        timespec now;
+        ::clock_gettime(CLOCK_REALTIME, &now);
+        timestamp = qint64(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+
+    receiveTimestamp = timestamp;
+    return result;
+}
+
 void QBluetoothSocketPrivate::_q_readNotify()
 {
     Q_Q(QBluetoothSocket);
     char *writePointer = buffer.reserve(QPRIVATELINEARBUFFER_BUFFERSIZE);
 //    qint64 readFromDevice = q->readData(writePointer, QPRIVATELINEARBUFFER_BUFFERSIZE);
-    int readFromDevice = ::read(socket, writePointer, QPRIVATELINEARBUFFER_BUFFERSIZE);
+    int readFromDevice = receiveTimestamps
+            ? readWithTimestamp(writePointer, QPRIVATELINEARBUFFER_BUFFERSIZE)
+            : ::read(socket, writePointer, QPRIVATELINEARBUFFER_BUFFERSIZE);
     buffer.chop(QPRIVATELINEARBUFFER_BUFFERSIZE - (readFromDevice < 0 ? 0 : readFromDevice));
     if(readFromDevice <= 0){
         int errsv = errno;
@@ -298,6 +426,7 @@ void QBluetoothSocketPrivate::_q_readNotify()
         q->disconnectFromService();
     }
     else {
+        tracePacket(this, BtSnoopTracer::Received, writePointer, readFromDevice);
         emit q->readyRead();
     }
 }
@@ -314,6 +443,12 @@ void QBluetoothSocketPrivate::abort()
     // QBluetoothSocket::close
     QT_CLOSE(socket);
     socket = -1;
+    traceConnectionHandle = -1;
+
+    if (peerNameRequested) {
+        peerNameRequested = false;
+        QObject::disconnect(QtBluezObjectMirror::instance(), 0, this, SLOT(_q_checkPeerName()));
+    }
 }
 
 QString QBluetoothSocketPrivate::localName() const
@@ -322,6 +457,12 @@ QString QBluetoothSocketPrivate::localName() const
     if (address.isNull())
         return QString();
 
+    if (isBluez5()) {
+        QtBluezObjectMirror *mirror = QtBluezObjectMirror::instance();
+        return mirror->properties(mirror->adapterPath(address), QStringLiteral("org.bluez.Adapter1"))
+                .value(QStringLiteral("Alias")).toString();
+    }
+
     QBluetoothLocalDevice device(address);
     return device.name();
 }
@@ -393,29 +534,14 @@ QString QBluetoothSocketPrivate::peerName() const
     const QString localAdapter = localAddress().toString();
 
     if (isBluez5()) {
-        OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
-                                                         QStringLiteral("/"),
-                                                         QDBusConnection::systemBus());
-        QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
-        reply.waitForFinished();
-        if (reply.isError())
+        QtBluezObjectMirror *mirror = QtBluezObjectMirror::instance();
+        const QString devicePath = mirror->devicePath(mirror->adapterPath(localAddress()),
+                                                      QBluetoothAddress(bdaddr));
+        if (devicePath.isEmpty())
             return QString();
 
-        ManagedObjectList managedObjectList = reply.value();
-        for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-            const InterfaceList &ifaceList = it.value();
-
-            for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-                const QString &iface = jt.key();
-                const QVariantMap &ifaceValues = jt.value();
-
-                if (iface == QStringLiteral("org.bluez.Device1")) {
-                    if (ifaceValues.value(QStringLiteral("Address")).toString() == peerAddress)
-                        return ifaceValues.value(QStringLiteral("Alias")).toString();
-                }
-            }
-        }
-        return QString();
+        return mirror->properties(devicePath, QStringLiteral("org.bluez.Device1"))
+                .value(QStringLiteral("Alias")).toString();
     } else {
         OrgBluezManagerInterface manager(QStringLiteral("org.bluez"), QStringLiteral("/"),
                                          QDBusConnection::systemBus());
@@ -452,6 +578,45 @@ QString QBluetoothSocketPrivate::peerName() const
     }
 }
 
+/*
+    On BlueZ 5 the name is reported as soon as the mirrored device object
+    carries an alias. BlueZ 4 has no such cache, the lookup is merely
+    deferred to the event loop.
+*/
+void QBluetoothSocketPrivate::requestPeerName()
+{
+    Q_Q(QBluetoothSocket);
+
+    const QString name = peerName();
+    if (!name.isEmpty() || !isBluez5()) {
+        QMetaObject::invokeMethod(q, "peerNameResolved", Qt::QueuedConnection,
+                                  Q_ARG(QString, name));
+        return;
+    }
+
+    if (peerNameRequested)
+        return;
+
+    peerNameRequested = true;
+    connect(QtBluezObjectMirror::instance(), SIGNAL(deviceNameChanged(QString)),
+            this, SLOT(_q_checkPeerName()));
+}
+
+void QBluetoothSocketPrivate::_q_checkPeerName()
+{
+    Q_Q(QBluetoothSocket);
+
+    // only name changes arrive here and the lookup is a hash access,
+    // no need to inspect which device changed
+    const QString name = peerName();
+    if (name.isEmpty())
+        return;
+
+    peerNameRequested = false;
+    QObject::disconnect(QtBluezObjectMirror::instance(), 0, this, SLOT(_q_checkPeerName()));
+    emit q->peerNameResolved(name);
+}
+
 QBluetoothAddress QBluetoothSocketPrivate::peerAddress() const
 {
     if (socketType == QBluetoothServiceInfo::RfcommProtocol) {
@@ -513,8 +678,10 @@ qint64 QBluetoothSocketPrivate::writeData(const char *data, qint64 maxSize)
             }
         }
 
-        if (sz > 0)
+        if (sz > 0) {
+            tracePacket(this, BtSnoopTracer::Sent, data, sz);
             emit q->bytesWritten(sz);
+        }
 
         return sz;
     }
@@ -572,6 +739,10 @@ bool QBluetoothSocketPrivate::setSocketDescriptor(int socketDescriptor, QBluetoo
 
     socketType = socketType_;
     socket = socketDescriptor;
+    traceConnectionHandle = -1;
+    receiveTimestamp = -1;
+    if (receiveTimestamps)
+        enableReceiveTimestamps();
 
     // ensure that O_NONBLOCK is set on new connections.
     int flags = fcntl(socket, F_GETFL, 0);
@@ -668,6 +668,13 @@ QString QBluetoothSocket::peerName() const
     return d_ptr->peerName();
 }
 
+void QBluetoothSocket::requestPeerName()
+{
+    // IOBluetooth knows the name of the connected peer
+    QMetaObject::invokeMethod(this, "peerNameResolved", Qt::QueuedConnection,
+                              Q_ARG(QString, d_ptr->peerName()));
+}
+
 QBluetoothAddress QBluetoothSocket::peerAddress() const
 {
     return d_ptr->peerAddress();
@@ -758,6 +765,22 @@ QBluetooth::SecurityFlags QBluetoothSocket::preferredSecurityFlags() const
     return QBluetooth::Secure;
 }
 
+/* not supported on OS X */
+void QBluetoothSocket::setReceiveTimestampsEnabled(bool enabled)
+{
+    Q_UNUSED(enabled)
+}
+
+bool QBluetoothSocket::isReceiveTimestampsEnabled() const
+{
+    return false;
+}
+
+qint64 QBluetoothSocket::lastReceiveTimestamp() const
+{
+    return -1;
+}
+
 #ifndef QT_NO_DEBUG_STREAM
 
 QDebug operator<<(QDebug debug, QBluetoothSocket::SocketError error)
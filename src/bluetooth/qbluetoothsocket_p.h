@@ -235,9 +235,20 @@ private slots:
 #endif // QT_WINRT_BLUETOOTH
 
 #if QT_CONFIG(bluez)
+public:
+    void requestPeerName();
+    void setReceiveTimestampsEnabled(bool enabled);
+
 private slots:
     void _q_readNotify();
     void _q_writeNotify();
+    void _q_checkPeerName();
+
+private:
+    void enableReceiveTimestamps();
+    int readWithTimestamp(char *data, int maxSize);
+
+    bool peerNameRequested;
 #endif
 
 protected:
@@ -252,6 +263,10 @@ private:
 #if QT_CONFIG(bluez)
 public:
     quint8 lowEnergySocketType;
+    int traceConnectionHandle;
+    bool receiveTimestamps;
+    // nanoseconds since the epoch, taken by the kernel when the last read data arrived
+    qint64 receiveTimestamp;
 #endif
 };
 
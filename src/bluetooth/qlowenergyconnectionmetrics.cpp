@@ -0,0 +1,254 @@
+/***************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qlowenergyconnectionmetrics.h"
+#include "qlowenergyconnectionmetrics_p.h"
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \since 5.11
+    \class QLowEnergyConnectionMetrics
+    \brief The QLowEnergyConnectionMetrics class is a snapshot of the performance
+           counters of a Bluetooth LE connection.
+
+    The counters are collected by QLowEnergyController once
+    \l {QLowEnergyController::setMetricsEnabled()}{enabled} and are retrieved via
+    QLowEnergyController::metrics(). They cover the ATT protocol data units (PDUs)
+    exchanged with the remote device, the round trip times
+    of the requests sent to it and a few events which are known to slow a connection down.
+
+    All counters start when the collection is enabled. Rates such as the number of
+    notifications per second are obtained by dividing a counter by \l elapsedTime().
+
+    \inmodule QtBluetooth
+    \ingroup shared
+
+    \sa QLowEnergyController::metrics()
+*/
+
+void QLowEnergyConnectionMetricsPrivate::addRoundTripTime(qint64 usecs)
+{
+    int bucket = 0;
+    qint64 limit = 1000;
+    while (bucket < RoundTripTimeBuckets - 1 && usecs >= limit) {
+        ++bucket;
+        limit *= 2;
+    }
+
+    ++roundTripTimes[bucket];
+}
+
+/*!
+   Constructs an invalid object of this class. All counters are zero.
+ */
+QLowEnergyConnectionMetrics::QLowEnergyConnectionMetrics()
+    : d(new QLowEnergyConnectionMetricsPrivate)
+{
+}
+
+/*! Constructs a new object of this class that is a copy of \a other. */
+QLowEnergyConnectionMetrics::QLowEnergyConnectionMetrics(const QLowEnergyConnectionMetrics &other)
+    : d(other.d)
+{
+}
+
+/*! Destroys this object. */
+QLowEnergyConnectionMetrics::~QLowEnergyConnectionMetrics()
+{
+}
+
+/*! Makes this object a copy of \a other and returns the new value of this object. */
+QLowEnergyConnectionMetrics &QLowEnergyConnectionMetrics::operator=(
+        const QLowEnergyConnectionMetrics &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+    Returns \c true if this object was obtained from a controller which collects metrics;
+    otherwise returns \c false.
+ */
+bool QLowEnergyConnectionMetrics::isValid() const
+{
+    return d->valid;
+}
+
+/*!
+    Returns the number of milliseconds between enabling the collection and taking
+    this snapshot.
+ */
+qint64 QLowEnergyConnectionMetrics::elapsedTime() const
+{
+    return d->elapsedTime;
+}
+
+/*!
+    Returns the number of PDUs with the ATT \a opcode which were sent to the remote device.
+ */
+quint64 QLowEnergyConnectionMetrics::pdusSent(quint8 opcode) const
+{
+    return d->pdusSent[opcode];
+}
+
+/*!
+    Returns the number of bytes sent to the remote device in PDUs with the ATT \a opcode.
+ */
+quint64 QLowEnergyConnectionMetrics::bytesSent(quint8 opcode) const
+{
+    return d->bytesSent[opcode];
+}
+
+/*!
+    Returns the number of PDUs with the ATT \a opcode which were received from the
+    remote device. Error responses are counted under their own opcode.
+ */
+quint64 QLowEnergyConnectionMetrics::pdusReceived(quint8 opcode) const
+{
+    return d->pdusReceived[opcode];
+}
+
+/*!
+    Returns the number of bytes received from the remote device in PDUs with the
+    ATT \a opcode.
+ */
+quint64 QLowEnergyConnectionMetrics::bytesReceived(quint8 opcode) const
+{
+    return d->bytesReceived[opcode];
+}
+
+/*!
+    Returns the largest number of requests which were queued at the same time,
+    including the request waiting for its response.
+ */
+int QLowEnergyConnectionMetrics::maximumRequestQueueDepth() const
+{
+    return d->maximumRequestQueueDepth;
+}
+
+/*!
+    Returns the histogram of the time between sending a request and receiving its
+    response. Each entry holds the number of round trips which fell into the bucket
+    of the same index.
+
+    \sa roundTripTimeBucketLimit()
+ */
+QVector<quint64> QLowEnergyConnectionMetrics::roundTripTimeHistogram() const
+{
+    QVector<quint64> histogram(QLowEnergyConnectionMetricsPrivate::RoundTripTimeBuckets);
+    std::copy(d->roundTripTimes,
+              d->roundTripTimes + QLowEnergyConnectionMetricsPrivate::RoundTripTimeBuckets,
+              histogram.begin());
+    return histogram;
+}
+
+/*!
+    Returns the exclusive upper limit in milliseconds of the round trip times counted
+    in \a bucket of \l roundTripTimeHistogram(). Bucket \c 0 holds round trips shorter
+    than one millisecond, every further bucket doubles the limit. The last bucket has
+    no limit, for it -1 is returned.
+ */
+qint64 QLowEnergyConnectionMetrics::roundTripTimeBucketLimit(int bucket)
+{
+    if (bucket < 0 || bucket >= QLowEnergyConnectionMetricsPrivate::RoundTripTimeBuckets - 1)
+        return -1;
+    return qint64(1) << bucket;
+}
+
+/*!
+    Returns the number of notifications and indications received from the remote device.
+ */
+quint64 QLowEnergyConnectionMetrics::notificationsReceived() const
+{
+    return d->notificationsReceived;
+}
+
+/*!
+    Returns the number of PDUs which could not be written to the socket because it
+    would have blocked. Such PDUs are discarded.
+ */
+quint64 QLowEnergyConnectionMetrics::droppedWrites() const
+{
+    return d->droppedWrites;
+}
+
+/*!
+    Returns how often the request queue stalled because the remote device demanded an
+    encrypted link first.
+
+    \sa encryptionChangeStallTime()
+ */
+quint64 QLowEnergyConnectionMetrics::encryptionChangeStalls() const
+{
+    return d->encryptionChangeStalls;
+}
+
+/*!
+    Returns the number of milliseconds the request queue waited for encryption changes
+    in total.
+
+    \sa encryptionChangeStalls()
+ */
+qint64 QLowEnergyConnectionMetrics::encryptionChangeStallTime() const
+{
+    return d->encryptionChangeStallTime;
+}
+
+/*!
+    Returns the number of Read Blob requests, which are needed for every part of a
+    value beyond the first that does not fit into a single PDU.
+ */
+quint64 QLowEnergyConnectionMetrics::blobReads() const
+{
+    return d->blobReads;
+}
+
+/*!
+    Returns the number of Prepare Write requests, which are needed to write values that
+    do not fit into a single PDU.
+ */
+quint64 QLowEnergyConnectionMetrics::prepareWrites() const
+{
+    return d->prepareWrites;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,93 @@
+/***************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QLOWENERGYCONNECTIONMETRICS_H
+#define QLOWENERGYCONNECTIONMETRICS_H
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qshareddata.h>
+#include <QtCore/qvector.h>
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyConnectionMetricsPrivate;
+
+class Q_BLUETOOTH_EXPORT QLowEnergyConnectionMetrics
+{
+public:
+    QLowEnergyConnectionMetrics();
+    QLowEnergyConnectionMetrics(const QLowEnergyConnectionMetrics &other);
+    ~QLowEnergyConnectionMetrics();
+
+    QLowEnergyConnectionMetrics &operator=(const QLowEnergyConnectionMetrics &other);
+
+    bool isValid() const;
+    qint64 elapsedTime() const;
+
+    quint64 pdusSent(quint8 opcode) const;
+    quint64 bytesSent(quint8 opcode) const;
+    quint64 pdusReceived(quint8 opcode) const;
+    quint64 bytesReceived(quint8 opcode) const;
+
+    int maximumRequestQueueDepth() const;
+    QVector<quint64> roundTripTimeHistogram() const;
+    static qint64 roundTripTimeBucketLimit(int bucket);
+
+    quint64 notificationsReceived() const;
+    quint64 droppedWrites() const;
+    quint64 encryptionChangeStalls() const;
+    qint64 encryptionChangeStallTime() const;
+    quint64 blobReads() const;
+    quint64 prepareWrites() const;
+
+    void swap(QLowEnergyConnectionMetrics &other) Q_DECL_NOTHROW { qSwap(d, other.d); }
+
+private:
+    friend class QLowEnergyController;
+    QSharedDataPointer<QLowEnergyConnectionMetricsPrivate> d;
+};
+
+Q_DECLARE_SHARED(QLowEnergyConnectionMetrics)
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QLowEnergyConnectionMetrics)
+
+#endif // Include guard
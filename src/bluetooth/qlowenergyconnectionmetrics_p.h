@@ -0,0 +1,115 @@
+/***************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QLOWENERGYCONNECTIONMETRICS_P_H
+#define QLOWENERGYCONNECTIONMETRICS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtBluetooth/qlowenergyconnectionmetrics.h>
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+
+QT_BEGIN_NAMESPACE
+
+class Q_AUTOTEST_EXPORT QLowEnergyConnectionMetricsPrivate : public QSharedData
+{
+public:
+    enum { RoundTripTimeBuckets = 16 };
+
+    // called for every ATT PDU, hence kept inline
+    void countSentPdu(const char *pdu, int size)
+    {
+        if (size <= 0)
+            return;
+        const quint8 opcode = pdu[0];
+        ++pdusSent[opcode];
+        bytesSent[opcode] += size;
+    }
+    void countSentPdu(const QByteArray &pdu) { countSentPdu(pdu.constData(), pdu.size()); }
+    void countReceivedPdu(const QByteArray &pdu)
+    {
+        if (pdu.isEmpty())
+            return;
+        const quint8 opcode = pdu.at(0);
+        ++pdusReceived[opcode];
+        bytesReceived[opcode] += pdu.size();
+    }
+    void sampleRequestQueueDepth(int depth)
+    {
+        if (depth > maximumRequestQueueDepth)
+            maximumRequestQueueDepth = depth;
+    }
+    qint64 now() const { return clock.nsecsElapsed() / 1000; }
+
+    void addRoundTripTime(qint64 usecs);
+
+    bool valid = false;
+    QElapsedTimer clock;
+    qint64 elapsedTime = 0;
+
+    // start time of the pending encryption change in usecs since clock started
+    qint64 encryptionChangeRequestedAt = -1;
+
+    quint64 pdusSent[256] = {};
+    quint64 bytesSent[256] = {};
+    quint64 pdusReceived[256] = {};
+    quint64 bytesReceived[256] = {};
+    int maximumRequestQueueDepth = 0;
+    quint64 roundTripTimes[RoundTripTimeBuckets] = {};
+    quint64 notificationsReceived = 0;
+    quint64 droppedWrites = 0;
+    quint64 encryptionChangeStalls = 0;
+    qint64 encryptionChangeStallTime = 0;
+    quint64 blobReads = 0;
+    quint64 prepareWrites = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYCONNECTIONMETRICS_P_H
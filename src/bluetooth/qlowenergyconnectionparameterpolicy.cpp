@@ -0,0 +1,247 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qlowenergyconnectionparameterpolicy.h"
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyConnectionParameterPolicyPrivate : public QSharedData
+{
+public:
+    QLowEnergyConnectionParameterPolicyPrivate()
+        : idleTimeout(2000)
+        , burstQueueDepth(3)
+        , burstThroughput(2000)
+    {
+        burstParameters.setIntervalRange(7.5, 15);
+        burstParameters.setLatency(0);
+        burstParameters.setSupervisionTimeout(4000);
+
+        idleParameters.setIntervalRange(400, 600);
+        idleParameters.setLatency(4);
+        idleParameters.setSupervisionTimeout(8000);
+    }
+
+    QLowEnergyConnectionParameters burstParameters;
+    QLowEnergyConnectionParameters idleParameters;
+    int idleTimeout;
+    int burstQueueDepth;
+    int burstThroughput;
+};
+
+/*!
+    \since 5.11
+    \class QLowEnergyConnectionParameterPolicy
+    \brief The QLowEnergyConnectionParameterPolicy class describes how QLowEnergyController
+           adapts the connection parameters to the traffic of a Bluetooth LE connection.
+
+    Short connection intervals let a connection transfer data quickly but cost power on
+    both devices, long intervals save power but make every request wait. A device which
+    is idle most of the time and occasionally transfers a lot of data benefits from both.
+
+    Once the policy is set via QLowEnergyController::setConnectionParameterPolicy(), the
+    controller watches the ATT traffic of the connection. The connection is in a burst while
+    at least \l burstQueueDepth() requests are waiting for their turn or more than
+    \l burstThroughput() bytes are exchanged within a second. At the start of a burst the
+    controller requests the \l burstParameters(). After \l idleTimeout() milliseconds without
+    any traffic it requests the \l idleParameters().
+
+    The parameters which the devices agree on are reported via
+    QLowEnergyController::connectionUpdated().
+
+    \inmodule QtBluetooth
+    \ingroup shared
+
+    \sa QLowEnergyController::requestConnectionUpdate()
+*/
+
+/*!
+   Constructs a new object of this class. The burst parameters request a connection interval
+   between 7.5 and 15 milliseconds without slave latency, the idle parameters an interval
+   between 400 and 600 milliseconds with a slave latency of 4.
+ */
+QLowEnergyConnectionParameterPolicy::QLowEnergyConnectionParameterPolicy()
+    : d(new QLowEnergyConnectionParameterPolicyPrivate)
+{
+}
+
+/*! Constructs a new object of this class that is a copy of \a other. */
+QLowEnergyConnectionParameterPolicy::QLowEnergyConnectionParameterPolicy(
+        const QLowEnergyConnectionParameterPolicy &other)
+    : d(other.d)
+{
+}
+
+/*! Destroys this object. */
+QLowEnergyConnectionParameterPolicy::~QLowEnergyConnectionParameterPolicy()
+{
+}
+
+/*! Makes this object a copy of \a other and returns the new value of this object. */
+QLowEnergyConnectionParameterPolicy &QLowEnergyConnectionParameterPolicy::operator=(
+        const QLowEnergyConnectionParameterPolicy &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+   Sets the connection \a parameters which are requested at the start of a burst.
+   \sa burstParameters()
+ */
+void QLowEnergyConnectionParameterPolicy::setBurstParameters(
+        const QLowEnergyConnectionParameters &parameters)
+{
+    d->burstParameters = parameters;
+}
+
+/*!
+   Returns the connection parameters which are requested at the start of a burst.
+   \sa setBurstParameters()
+ */
+QLowEnergyConnectionParameters QLowEnergyConnectionParameterPolicy::burstParameters() const
+{
+    return d->burstParameters;
+}
+
+/*!
+   Sets the connection \a parameters which are requested once the connection is idle.
+   \sa idleParameters()
+ */
+void QLowEnergyConnectionParameterPolicy::setIdleParameters(
+        const QLowEnergyConnectionParameters &parameters)
+{
+    d->idleParameters = parameters;
+}
+
+/*!
+   Returns the connection parameters which are requested once the connection is idle.
+   \sa setIdleParameters()
+ */
+QLowEnergyConnectionParameters QLowEnergyConnectionParameterPolicy::idleParameters() const
+{
+    return d->idleParameters;
+}
+
+/*!
+   Sets the number of milliseconds without traffic after which the connection is
+   considered idle to \a timeout. The default is 2000.
+   \sa idleTimeout()
+ */
+void QLowEnergyConnectionParameterPolicy::setIdleTimeout(int timeout)
+{
+    d->idleTimeout = timeout;
+}
+
+/*!
+   Returns the number of milliseconds without traffic after which the connection is
+   considered idle.
+   \sa setIdleTimeout()
+ */
+int QLowEnergyConnectionParameterPolicy::idleTimeout() const
+{
+    return d->idleTimeout;
+}
+
+/*!
+   Sets the number of queued requests which starts a burst to \a depth. The default is 3.
+   \sa burstQueueDepth()
+ */
+void QLowEnergyConnectionParameterPolicy::setBurstQueueDepth(int depth)
+{
+    d->burstQueueDepth = depth;
+}
+
+/*!
+   Returns the number of queued requests which starts a burst.
+   \sa setBurstQueueDepth()
+ */
+int QLowEnergyConnectionParameterPolicy::burstQueueDepth() const
+{
+    return d->burstQueueDepth;
+}
+
+/*!
+   Sets the number of bytes per second, sent and received, which starts a burst
+   to \a bytesPerSecond. The default is 2000.
+   \sa burstThroughput()
+ */
+void QLowEnergyConnectionParameterPolicy::setBurstThroughput(int bytesPerSecond)
+{
+    d->burstThroughput = bytesPerSecond;
+}
+
+/*!
+   Returns the number of bytes per second which starts a burst.
+   \sa setBurstThroughput()
+ */
+int QLowEnergyConnectionParameterPolicy::burstThroughput() const
+{
+    return d->burstThroughput;
+}
+
+/*!
+   \fn void QLowEnergyConnectionParameterPolicy::swap(QLowEnergyConnectionParameterPolicy &other)
+   Swaps this object with \a other.
+ */
+
+/*!
+   Returns \a true if \a p1 and \a p2 are equal with respect to their public state,
+   otherwise returns false.
+ */
+bool operator==(const QLowEnergyConnectionParameterPolicy &p1,
+                const QLowEnergyConnectionParameterPolicy &p2)
+{
+    if (p1.d == p2.d)
+        return true;
+    return p1.burstParameters() == p2.burstParameters()
+            && p1.idleParameters() == p2.idleParameters()
+            && p1.idleTimeout() == p2.idleTimeout()
+            && p1.burstQueueDepth() == p2.burstQueueDepth()
+            && p1.burstThroughput() == p2.burstThroughput();
+}
+
+/*!
+   \fn bool operator!=(const QLowEnergyConnectionParameterPolicy &p1,
+                       const QLowEnergyConnectionParameterPolicy &p2)
+   Returns \a true if \a p1 and \a p2 are not equal with respect to their public state,
+   otherwise returns false.
+ */
+
+QT_END_NAMESPACE
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QLOWENERGYCONNECTIONPARAMETERPOLICY_H
+#define QLOWENERGYCONNECTIONPARAMETERPOLICY_H
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtBluetooth/qlowenergyconnectionparameters.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qshareddata.h>
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyConnectionParameterPolicyPrivate;
+
+class Q_BLUETOOTH_EXPORT QLowEnergyConnectionParameterPolicy
+{
+    friend Q_BLUETOOTH_EXPORT bool operator==(const QLowEnergyConnectionParameterPolicy &p1,
+                                              const QLowEnergyConnectionParameterPolicy &p2);
+public:
+    QLowEnergyConnectionParameterPolicy();
+    QLowEnergyConnectionParameterPolicy(const QLowEnergyConnectionParameterPolicy &other);
+    ~QLowEnergyConnectionParameterPolicy();
+
+    QLowEnergyConnectionParameterPolicy &operator=(const QLowEnergyConnectionParameterPolicy &other);
+
+    void setBurstParameters(const QLowEnergyConnectionParameters &parameters);
+    QLowEnergyConnectionParameters burstParameters() const;
+
+    void setIdleParameters(const QLowEnergyConnectionParameters &parameters);
+    QLowEnergyConnectionParameters idleParameters() const;
+
+    void setIdleTimeout(int timeout);
+    int idleTimeout() const;
+
+    void setBurstQueueDepth(int depth);
+    int burstQueueDepth() const;
+
+    void setBurstThroughput(int bytesPerSecond);
+    int burstThroughput() const;
+
+    void swap(QLowEnergyConnectionParameterPolicy &other) Q_DECL_NOTHROW { qSwap(d, other.d); }
+
+private:
+    QSharedDataPointer<QLowEnergyConnectionParameterPolicyPrivate> d;
+};
+
+Q_BLUETOOTH_EXPORT bool operator==(const QLowEnergyConnectionParameterPolicy &p1,
+                                   const QLowEnergyConnectionParameterPolicy &p2);
+inline bool operator!=(const QLowEnergyConnectionParameterPolicy &p1,
+                       const QLowEnergyConnectionParameterPolicy &p2)
+{
+    return !(p1 == p2);
+}
+
+Q_DECLARE_SHARED(QLowEnergyConnectionParameterPolicy)
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QLowEnergyConnectionParameterPolicy)
+
+#endif // Include guard
@@ -41,6 +41,8 @@
 #include "qlowenergycontroller_p.h"
 
 #include "qlowenergycharacteristicdata.h"
+#include "qlowenergyconnectionmetrics.h"
+#include "qlowenergyconnectionparameterpolicy.h"
 #include "qlowenergyconnectionparameters.h"
 #include "qlowenergydescriptordata.h"
 #include "qlowenergyservicedata.h"
@@ -140,6 +142,12 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
                                         This value was introduced by Qt 5.7.
     \value RemoteHostClosedError        The remote device closed the connection.
                                         This value was introduced by Qt 5.10.
+    \value RequestTimeoutError          The remote device did not answer a GATT request
+                                        in time. The request is abandoned, the failure is
+                                        reported by the affected QLowEnergyService and the
+                                        controller continues with the next request. On BlueZ
+                                        the timeout adapts to the measured round trip times
+                                        of the connection. This value was introduced by Qt 5.11.
 */
 
 /*!
@@ -304,6 +312,9 @@ void QLowEnergyControllerPrivate::setError(
     case QLowEnergyController::RemoteHostClosedError:
         errorString = QLowEnergyController::tr("Remote device closed the connection");
         break;
+    case QLowEnergyController::RequestTimeoutError:
+        errorString = QLowEnergyController::tr("Remote device did not answer a request in time");
+        break;
     case QLowEnergyController::NoError:
         return;
     default:
@@ -804,10 +815,94 @@ void QLowEnergyController::discoverServices()
     if (d->state != QLowEnergyController::ConnectedState)
         return;
 
+    d->serviceDiscoveryFilter.clear();
+    d->setState(QLowEnergyController::DiscoveringState);
+    d->discoverServices();
+}
+
+/*!
+    \since 5.11
+
+    Initiates the discovery of the primary services whose UUIDs are listed in
+    \a filter. Services of the remote device which are not in \a filter are
+    not discovered, which makes the discovery considerably faster if only a
+    few of many services are needed. Secondary services are only found as
+    included services of the discovered services. An empty \a filter discovers
+    all services, just like discoverServices().
+
+    The discovery progress is indicated via the \l serviceDiscovered() signal.
+    The \l discoveryFinished() signal is emitted when the process has finished.
+    Services in \a filter which the remote device does not offer are silently
+    skipped.
+
+    \note Only BlueZ supports the filter. On all other platforms every service
+    is discovered.
+ */
+void QLowEnergyController::discoverServices(const QList<QBluetoothUuid> &filter)
+{
+    Q_D(QLowEnergyController);
+
+    if (d->role != CentralRole) {
+        qCWarning(QT_BT) << "Cannot discover services in peripheral role";
+        return;
+    }
+    if (d->state != QLowEnergyController::ConnectedState)
+        return;
+
+    d->serviceDiscoveryFilter = filter;
     d->setState(QLowEnergyController::DiscoveringState);
     d->discoverServices();
 }
 
+/*!
+    \since 5.11
+
+    Initiates the discovery of the details of all services which are in the
+    \l {QLowEnergyService::DiscoveryRequired}{DiscoveryRequired} state, using the
+    given discovery \a mode. This requires a completed \l discoverServices() run.
+
+    The affected services enter the
+    \l {QLowEnergyService::DiscoveringServices}{DiscoveringServices} state right away.
+    Each of them reaches the \l {QLowEnergyService::ServiceDiscovered}{ServiceDiscovered}
+    state independently, which is advertised via QLowEnergyService::stateChanged().
+    Service objects created afterwards via \l createServiceObject() report the
+    current state of their service.
+
+    \note On Linux with BlueZ the characteristics and descriptors of all services are
+    enumerated in one pass over the attribute database of the remote device. This
+    requires considerably fewer requests than calling
+    QLowEnergyService::discoverDetails() for each service. All other platforms
+    discover the services one after another.
+
+    \sa QLowEnergyService::discoverDetails()
+ */
+void QLowEnergyController::discoverAllServiceDetails(QLowEnergyService::DiscoveryMode mode)
+{
+    Q_D(QLowEnergyController);
+
+    if (d->role != CentralRole) {
+        qCWarning(QT_BT) << "Cannot discover service details in peripheral role";
+        return;
+    }
+    if (d->state != QLowEnergyController::DiscoveredState)
+        return;
+
+    QList<QBluetoothUuid> services;
+    ServiceDataMap::const_iterator it = d->serviceList.constBegin();
+    for ( ; it != d->serviceList.constEnd(); ++it) {
+        const QSharedPointer<QLowEnergyServicePrivate> &serviceData = it.value();
+        if (serviceData->state != QLowEnergyService::DiscoveryRequired)
+            continue;
+
+        serviceData->discoveryMode = mode;
+        serviceData->setState(QLowEnergyService::DiscoveringServices);
+        services.append(it.key());
+    }
+
+    if (!services.isEmpty())
+        d->discoverAllServiceDetails(services);
+}
+
 /*!
     Returns the list of services offered by the remote device, if the controller is in
     the \l CentralRole. Otherwise, the result is unspecified.
@@ -1028,6 +1123,157 @@ void QLowEnergyController::requestConnectionUpdate(const QLowEnergyConnectionPar
     }
 }
 
+/*!
+    Enables the collection of performance counters for the connection if \a enabled
+    is \c true; otherwise disables it. The collection is disabled by default.
+
+    Enabling the collection resets all counters, disabling it discards them.
+    While enabled, the counters cost a few increments per exchanged PDU.
+
+    \note Currently, this functionality is only implemented on Linux with BlueZ.
+
+    \sa metrics(), isMetricsEnabled()
+    \since 5.11
+ */
+void QLowEnergyController::setMetricsEnabled(bool enabled)
+{
+#if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
+    Q_D(QLowEnergyController);
+
+    if (!enabled) {
+        d->metrics.reset();
+        return;
+    }
+
+    d->metrics.reset(new QLowEnergyConnectionMetricsPrivate);
+    d->metrics->valid = true;
+    d->metrics->clock.start();
+#else
+    Q_UNUSED(enabled);
+    qCWarning(QT_BT) << "Connection metrics are not implemented on this platform";
+#endif
+}
+
+/*!
+    Returns \c true if performance counters are collected for the connection;
+    otherwise returns \c false.
+
+    \sa setMetricsEnabled()
+    \since 5.11
+ */
+bool QLowEnergyController::isMetricsEnabled() const
+{
+#if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
+    return !d_ptr->metrics.isNull();
+#else
+    return false;
+#endif
+}
+
+/*!
+    Returns a snapshot of the performance counters collected since \l setMetricsEnabled()
+    was called. The returned object is invalid if the collection is disabled.
+
+    \sa setMetricsEnabled()
+    \since 5.11
+ */
+QLowEnergyConnectionMetrics QLowEnergyController::metrics() const
+{
+    QLowEnergyConnectionMetrics snapshot;
+#if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
+    if (d_ptr->metrics) {
+        snapshot.d = new QLowEnergyConnectionMetricsPrivate(*d_ptr->metrics);
+        snapshot.d->elapsedTime = d_ptr->metrics->clock.elapsed();
+    }
+#endif
+    return snapshot;
+}
+
+/*!
+    Lets the controller adapt the connection parameters to the traffic of the connection
+    according to \a policy. Any previously set policy is replaced.
+
+    The controller requests the burst parameters of the \a policy while many requests
+    are queued or much data is exchanged, and the idle parameters once the connection
+    has been idle for a while. Each request behaves like \l requestConnectionUpdate(), the
+    parameters which are actually applied are reported via \l connectionUpdated().
+    Requests which fail, or which the remote device rejects, are repeated a few times.
+    Parameters requested via \l requestConnectionUpdate() are replaced by the policy
+    with the next change between burst and idle traffic.
+
+    \note Currently, this functionality is only implemented on Linux.
+
+    \sa clearConnectionParameterPolicy(), QLowEnergyConnectionParameterPolicy
+    \since 5.11
+ */
+void QLowEnergyController::setConnectionParameterPolicy(
+        const QLowEnergyConnectionParameterPolicy &policy)
+{
+#if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
+    Q_D(QLowEnergyController);
+
+    if (d->connectionTuner) {
+        d->connectionTuner->setPolicy(policy);
+        return;
+    }
+
+    d->connectionTuner = new ConnectionParameterTuner(policy, d);
+    connect(d->connectionTuner, &ConnectionParameterTuner::updateRequested,
+            this, &QLowEnergyController::requestConnectionUpdate);
+    if (d->l2cpSocket && d->l2cpSocket->state() == QBluetoothSocket::ConnectedState)
+        d->connectionTuner->start();
+#else
+    Q_UNUSED(policy);
+    qCWarning(QT_BT) << "Connection parameter policy is not implemented on this platform";
+#endif
+}
+
+/*!
+    Stops adapting the connection parameters to the traffic. The parameters which were
+    requested last remain in effect.
+
+    \sa setConnectionParameterPolicy()
+    \since 5.11
+ */
+void QLowEnergyController::clearConnectionParameterPolicy()
+{
+#if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
+    Q_D(QLowEnergyController);
+    delete d->connectionTuner;
+    d->connectionTuner = nullptr;
+#endif
+}
+
+/*!
+    Returns \c true if a connection parameter policy is set; otherwise returns \c false.
+
+    \sa setConnectionParameterPolicy()
+    \since 5.11
+ */
+bool QLowEnergyController::hasConnectionParameterPolicy() const
+{
+#if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
+    return d_ptr->connectionTuner != nullptr;
+#else
+    return false;
+#endif
+}
+
+/*!
+    Returns the connection parameter policy, or a default constructed policy if none is set.
+
+    \sa setConnectionParameterPolicy(), hasConnectionParameterPolicy()
+    \since 5.11
+ */
+QLowEnergyConnectionParameterPolicy QLowEnergyController::connectionParameterPolicy() const
+{
+#if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
+    if (d_ptr->connectionTuner)
+        return d_ptr->connectionTuner->policy();
+#endif
+    return QLowEnergyConnectionParameterPolicy();
+}
+
 /*!
     Returns the last occurred error or \l NoError.
 */
@@ -50,6 +50,8 @@
 QT_BEGIN_NAMESPACE
 
 class QLowEnergyAdvertisingParameters;
+class QLowEnergyConnectionMetrics;
+class QLowEnergyConnectionParameterPolicy;
 class QLowEnergyConnectionParameters;
 class QLowEnergyControllerPrivate;
 class QLowEnergyServiceData;
@@ -66,7 +68,8 @@ public:
         InvalidBluetoothAdapterError,
         ConnectionError,
         AdvertisingError,
-        RemoteHostClosedError
+        RemoteHostClosedError,
+        RequestTimeoutError
     };
     Q_ENUM(Error)
 
@@ -121,6 +124,9 @@ public:
     void disconnectFromDevice();
 
     void discoverServices();
+    void discoverServices(const QList<QBluetoothUuid> &filter);
+    void discoverAllServiceDetails(
+            QLowEnergyService::DiscoveryMode mode = QLowEnergyService::FullDiscovery);
     QList<QBluetoothUuid> services() const;
     QLowEnergyService *createServiceObject(const QBluetoothUuid &service, QObject *parent = Q_NULLPTR);
 
@@ -133,6 +139,15 @@ public:
 
     void requestConnectionUpdate(const QLowEnergyConnectionParameters &parameters);
 
+    void setMetricsEnabled(bool enabled);
+    bool isMetricsEnabled() const;
+    QLowEnergyConnectionMetrics metrics() const;
+
+    void setConnectionParameterPolicy(const QLowEnergyConnectionParameterPolicy &policy);
+    void clearConnectionParameterPolicy();
+    bool hasConnectionParameterPolicy() const;
+    QLowEnergyConnectionParameterPolicy connectionParameterPolicy() const;
+
     Error error() const;
     QString errorString() const;
 
@@ -234,6 +234,13 @@ void QLowEnergyControllerPrivate::discoverServiceDetails(const QBluetoothUuid &s
     qCDebug(QT_BT_ANDROID) << "Discovery of" << service << "started";
 }
 
+void QLowEnergyControllerPrivate::discoverAllServiceDetails(const QList<QBluetoothUuid> &services)
+{
+    // the Java side queues the detail discoveries of several services
+    foreach (const QBluetoothUuid &uuid, services)
+        discoverServiceDetails(uuid);
+}
+
 void QLowEnergyControllerPrivate::writeCharacteristic(
         const QSharedPointer<QLowEnergyServicePrivate> service,
         const QLowEnergyHandle charHandle,
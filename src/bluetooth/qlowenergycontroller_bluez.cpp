@@ -47,10 +47,9 @@
 #include "bluez/remotedevicemanager_p.h"
 #include "bluez/bluez5_helper_p.h"
 #include "bluez/bluetoothmanagement_p.h"
+#include "bluez/signcounterstore_p.h"
 
-#include <QtCore/QFileInfo>
 #include <QtCore/QLoggingCategory>
-#include <QtCore/QSettings>
 #include <QtCore/QTimer>
 #include <QtBluetooth/QBluetoothLocalDevice>
 #include <QtBluetooth/QBluetoothSocket>
@@ -62,6 +61,7 @@
 #include <algorithm>
 #include <climits>
 #include <cstring>
+#include <utility>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -109,6 +109,7 @@
 #define ERROR_RESPONSE_HEADER_SIZE 5
 #define FIND_INFO_REQUEST_HEADER_SIZE 5
 #define GRP_TYPE_REQ_HEADER_SIZE 7
+#define FIND_BY_TYPE_VALUE_REQ_HEADER_SIZE 7
 #define READ_BY_TYPE_REQ_HEADER_SIZE 7
 #define READ_REQUEST_HEADER_SIZE 3
 #define READ_BLOB_REQUEST_HEADER_SIZE 5
@@ -297,10 +298,17 @@ void QLowEnergyControllerPrivate::init()
     });
     connect(hciManager, &HciManager::connectionUpdate,
             [this](quint16 handle, const QLowEnergyConnectionParameters &params) {
-                if (handle == connectionHandle)
-                    emit q_ptr->connectionUpdated(params);
+                if (handle != connectionHandle)
+                    return;
+                if (connectionTuner)
+                    connectionTuner->updateApplied(params);
+                emit q_ptr->connectionUpdated(params);
             }
     );
+    connect(hciManager, &HciManager::connectionUpdateFailed, [this](quint16 handle) {
+        if (handle == connectionHandle && connectionTuner)
+            connectionTuner->updateFailed();
+    });
     connect(hciManager, &HciManager::signatureResolvingKeyReceived,
             [this](quint16 handle, bool remoteKey, const quint128 &csrk) {
                 if (handle != connectionHandle)
@@ -313,6 +321,9 @@ void QLowEnergyControllerPrivate::init()
                                      << QByteArray(reinterpret_cast<const char *>(csrk.data),
                                                    sizeof csrk).toHex();
                 signingData.insert(remoteDevice.toUInt64(), SigningData(csrk));
+                signCounterStoreForPeer()->resetCounter(remoteKey
+                        ? SignCounterStore::RemoteSigningKey
+                        : SignCounterStore::LocalSigningKey);
         }
     );
 
@@ -323,10 +334,19 @@ void QLowEnergyControllerPrivate::init()
             if (ok)
                 gattRequestTimeout = value;
         }
+        if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("BLUETOOTH_GATT_TIMEOUT_MIN"))) {
+            bool ok = false;
+            int value = qEnvironmentVariableIntValue("BLUETOOTH_GATT_TIMEOUT_MIN", &ok);
+            if (ok && value > 0)
+                minimumGattRequestTimeout = value;
+        }
 
         // permit disabling of timeout behavior via environment variable
         if (gattRequestTimeout > 0) {
-            qCWarning(QT_BT_BLUEZ) << "Enabling GATT request timeout behavior" << gattRequestTimeout;
+            qCWarning(QT_BT_BLUEZ) << "Enabling GATT request timeout behavior"
+                                   << minimumGattRequestTimeout << "-" << gattRequestTimeout;
+            requestTimeoutEstimator.setTimeoutRange(minimumGattRequestTimeout,
+                                                    gattRequestTimeout);
             requestTimer = new QTimer(this);
             requestTimer->setSingleShot(true);
             requestTimer->setInterval(gattRequestTimeout);
@@ -347,10 +367,18 @@ void QLowEnergyControllerPrivate::handleGattRequestTimeout()
 
     if (!openRequests.isEmpty() && requestPending) {
         requestPending = false; // reset pending flag
-        const Request currentRequest = openRequests.dequeue();
+        const Request currentRequest = openRequests.dequeueTimedOut();
+
+        // the round trip of a timed out request lasted at least the timeout,
+        // and a late response must not be mistaken for the round trip of the next request
+        if (metrics && requestRoundTrip.isValid())
+            metrics->addRoundTripTime(requestRoundTrip.nsecsElapsed() / 1000);
+        requestRoundTrip.invalidate();
+        requestTimeoutEstimator.backOff();
 
         qCWarning(QT_BT_BLUEZ).nospace() << "****** Request type 0x" << hex << currentRequest.command
-                           << " to server/peripheral timed out";
+                           << " to server/peripheral timed out, next timeout "
+                           << dec << requestTimeoutEstimator.timeout() << " ms";
         qCWarning(QT_BT_BLUEZ) << "****** Looks like the characteristic or descriptor does NOT act in"
                                <<  "accordance to Bluetooth 4.x spec.";
         qCWarning(QT_BT_BLUEZ) << "****** Please check server implementation."
@@ -375,6 +403,7 @@ void QLowEnergyControllerPrivate::handleGattRequestTimeout()
             sendNextPendingRequest();
             break;
         case ATT_OP_READ_BY_GROUP_REQUEST: // primary or secondary service discovery
+        case ATT_OP_FIND_BY_TYPE_VALUE_REQUEST: // primary service discovery by uuid
         case ATT_OP_READ_BY_TYPE_REQUEST:  // characteristic or included service discovery
             // jump back into usual response handling with custom error code
             // 2nd param "0" as required by spec
@@ -383,31 +412,27 @@ void QLowEnergyControllerPrivate::handleGattRequestTimeout()
         case ATT_OP_READ_REQUEST:          // read descriptor or characteristic value
         case ATT_OP_READ_BLOB_REQUEST:     // read long descriptor or characteristic
         case ATT_OP_WRITE_REQUEST:         // write descriptor or characteristic
-        {
-            uint handleData = currentRequest.reference.toUInt();
-            const QLowEnergyHandle charHandle = (handleData & 0xffff);
-            const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
             processReply(currentRequest, createRequestErrorMessage(command,
-                                descriptorHandle ? descriptorHandle : charHandle));
-        }
+                                currentRequest.descriptorHandle
+                                    ? currentRequest.descriptorHandle
+                                    : currentRequest.charHandle));
             break;
         case ATT_OP_FIND_INFORMATION_REQUEST: // get descriptor information
             processReply(currentRequest, createRequestErrorMessage(
-                                            command, currentRequest.reference2.toUInt()));
+                                            command, currentRequest.startingHandle));
             break;
         case ATT_OP_PREPARE_WRITE_REQUEST: // prepare to write long desc or char
         case ATT_OP_EXECUTE_WRITE_REQUEST: // execute long write of desc or char
-        {
-            uint handleData = currentRequest.reference.toUInt();
-            const QLowEnergyHandle attrHandle = (handleData & 0xffff);
             processReply(currentRequest,
-                         createRequestErrorMessage(command, attrHandle));
-        }
+                         createRequestErrorMessage(command, currentRequest.attributeHandle));
             break;
         default:
             // not a command used by central role implementation
             return;
         }
+
+        // the request queue has already moved on, this only informs the application
+        setError(QLowEnergyController::RequestTimeoutError);
     }
 }
 
@@ -512,10 +537,14 @@ void QLowEnergyControllerPrivate::requestConnectionUpdate(const QLowEnergyConnec
     // devices, but BlueZ allows it only for master devices. So for slave devices, we have to use a
     // connection parameter update request, which we need to wrap in an ACL command, as BlueZ
     // does not allow user-space sockets for the signaling channel.
+    bool sent;
     if (role == QLowEnergyController::CentralRole)
-        hciManager->sendConnectionUpdateCommand(connectionHandle, params);
+        sent = hciManager->sendConnectionUpdateCommand(connectionHandle, params);
     else
-        hciManager->sendConnectionParameterUpdateRequest(connectionHandle, params);
+        sent = hciManager->sendConnectionParameterUpdateRequest(connectionHandle, params);
+
+    if (!sent && connectionTuner)
+        connectionTuner->updateFailed();
 }
 
 void QLowEnergyControllerPrivate::connectToDevice()
@@ -603,6 +632,8 @@ void QLowEnergyControllerPrivate::establishL2cpClientSocket()
     connect(l2cpSocket, SIGNAL(error(QBluetoothSocket::SocketError)),
             this, SLOT(l2cpErrorChanged(QBluetoothSocket::SocketError)));
     connect(l2cpSocket, SIGNAL(readyRead()), this, SLOT(l2cpReadyRead()));
+    // tells when notifications arrived, see QLowEnergyService::lastNotificationTimestamp()
+    l2cpSocket->setReceiveTimestampsEnabled(true);
 
     quint32 addressTypeToUse = (addressType == QLowEnergyController::PublicAddress)
                                     ? BDADDR_LE_PUBLIC : BDADDR_LE_RANDOM;
@@ -722,6 +753,9 @@ void QLowEnergyControllerPrivate::l2cpConnected()
     securityLevelValue = securityLevel();
     exchangeMTU();
 
+    if (connectionTuner)
+        connectionTuner->start();
+
     setState(QLowEnergyController::ConnectedState);
     emit q->connected();
 }
@@ -789,6 +823,7 @@ void QLowEnergyControllerPrivate::l2cpErrorChanged(QBluetoothSocket::SocketError
 void QLowEnergyControllerPrivate::resetController()
 {
     openRequests.clear();
+    databaseDiscoveryServices.clear();
     openPrepareWriteRequests.clear();
     scheduledIndications.clear();
     indicationInFlight = false;
@@ -798,6 +833,18 @@ void QLowEnergyControllerPrivate::resetController()
     securityLevelValue = -1;
     connectionHandle = 0;
 
+    if (signCounterStore)
+        signCounterStore->flush();
+
+    if (metrics)
+        metrics->encryptionChangeRequestedAt = -1;
+
+    // the next connection may use entirely different connection parameters
+    requestTimeoutEstimator.reset();
+    requestRoundTrip.invalidate();
+    if (connectionTuner)
+        connectionTuner->stop();
+
     // public API behavior requires stop of advertisement
     if (role == QLowEnergyController::PeripheralRole && advertiser)
         advertiser->stopAdvertising();
@@ -809,7 +856,7 @@ void QLowEnergyControllerPrivate::restartRequestTimer()
         return;
 
     if (gattRequestTimeout > 0)
-        requestTimer->start(gattRequestTimeout);
+        requestTimer->start(requestTimeoutEstimator.timeout());
 }
 
 void QLowEnergyControllerPrivate::l2cpReadyRead()
@@ -821,6 +868,14 @@ void QLowEnergyControllerPrivate::l2cpReadyRead()
         return;
 
     const quint8 command = incomingPacket.constData()[0];
+    if (connectionTuner)
+        connectionTuner->observeTraffic(openRequests.count(), incomingPacket.size());
+    if (metrics) {
+        metrics->countReceivedPdu(incomingPacket);
+        if (command == ATT_OP_HANDLE_VAL_NOTIFICATION || command == ATT_OP_HANDLE_VAL_INDICATION)
+            ++metrics->notificationsReceived;
+    }
+
     switch (command) {
     case ATT_OP_HANDLE_VAL_NOTIFICATION:
     {
@@ -884,18 +939,32 @@ void QLowEnergyControllerPrivate::l2cpReadyRead()
         return;
     //--------------------------------------------------
     default:
-        //only solicited replies finish pending requests
-        requestPending = false;
         break;
     }
 
-    if (openRequests.isEmpty()) {
+    switch (openRequests.matchResponse(incomingPacket, requestPending)) {
+    case RequestQueue::HeadResponse:
+        break;
+    case RequestQueue::LateResponse:
+        qCWarning(QT_BT_BLUEZ).nospace() << "Dropping late response 0x" << hex << command
+                                         << " to a timed out request";
+        return;
+    case RequestQueue::UnexpectedResponse:
         qCWarning(QT_BT_BLUEZ) << "Received unexpected packet from peer, disconnecting.";
         disconnectFromDevice();
         return;
     }
 
+    //only solicited replies finish pending requests
+    requestPending = false;
     const Request request = openRequests.dequeue();
+    if (requestRoundTrip.isValid()) {
+        const qint64 roundTrip = requestRoundTrip.nsecsElapsed() / 1000;
+        requestRoundTrip.invalidate();
+        requestTimeoutEstimator.addSample(roundTrip);
+        if (metrics)
+            metrics->addRoundTripTime(roundTrip);
+    }
     processReply(request, incomingPacket);
 
     sendNextPendingRequest();
@@ -927,13 +996,12 @@ void QLowEnergyControllerPrivate::encryptionChangedEvent(
         // The next request was requeued due to security error
         // skip it to avoid endless loop of security negotiations
         Q_ASSERT(!openRequests.isEmpty());
-        Request failedRequest = openRequests.takeFirst();
+        const Request failedRequest = openRequests.dequeue();
 
         if (failedRequest.command == ATT_OP_WRITE_REQUEST) {
              // Failing write requests trigger some sort of response
-            uint ref = failedRequest.reference.toUInt();
-            const QLowEnergyHandle charHandle = (ref & 0xffff);
-            const QLowEnergyHandle descriptorHandle = ((ref >> 16) & 0xffff);
+            const QLowEnergyHandle charHandle = failedRequest.charHandle;
+            const QLowEnergyHandle descriptorHandle = failedRequest.descriptorHandle;
 
             QSharedPointer<QLowEnergyServicePrivate> service
                                                 = serviceForHandle(charHandle);
@@ -944,52 +1012,155 @@ void QLowEnergyControllerPrivate::encryptionChangedEvent(
                     service->setError(QLowEnergyService::DescriptorWriteError);
             }
         } else if (failedRequest.command == ATT_OP_PREPARE_WRITE_REQUEST) {
-            uint handleData = failedRequest.reference.toUInt();
-            const QLowEnergyHandle attrHandle = (handleData & 0xffff);
-            const QByteArray newValue = failedRequest.reference2.toByteArray();
-
             // Prepare command failed, cancel pending prepare queue on
             // the device. The appropriate (Descriptor|Characteristic)WriteError
             // is emitted too once the execute write request comes through
-            sendExecuteWriteRequest(attrHandle, newValue, true);
+            sendExecuteWriteRequest(failedRequest.attributeHandle, failedRequest.value, true);
         }
     }
 
+    if (metrics && metrics->encryptionChangeRequestedAt >= 0) {
+        metrics->encryptionChangeStallTime +=
+                (metrics->now() - metrics->encryptionChangeRequestedAt) / 1000;
+        metrics->encryptionChangeRequestedAt = -1;
+    }
+
     encryptionChangePending = false;
     sendNextPendingRequest();
 }
 
-void QLowEnergyControllerPrivate::sendPacket(const QByteArray &packet)
+void QLowEnergyControllerPrivate::sendPacket(const char *packet, int size)
 {
-    qint64 result = l2cpSocket->write(packet.constData(),
-                                      packet.size());
+    qint64 result = l2cpSocket->write(packet, size);
     // We ignore result == 0 which is likely to be caused by EAGAIN.
     // This packet is effectively discarded but the controller can still recover
 
+    if (connectionTuner)
+        connectionTuner->observeTraffic(openRequests.count(), size);
+    if (metrics) {
+        metrics->countSentPdu(packet, size);
+        if (result == 0)
+            ++metrics->droppedWrites;
+    }
+
     if (result == -1) {
         qCDebug(QT_BT_BLUEZ) << "Cannot write L2CP packet:" << hex
-                             << packet.toHex()
+                             << QByteArray(packet, size).toHex()
                              << l2cpSocket->errorString();
         setError(QLowEnergyController::NetworkError);
-    } else if (result < packet.size()) {
+    } else if (result < size) {
         qCWarning(QT_BT_BLUEZ) << "L2CP write request incomplete:"
-                               << result << "of" << packet.size();
+                               << result << "of" << size;
     }
 
 }
 
+void QLowEnergyControllerPrivate::RequestQueue::enqueue(const Request &request)
+{
+    reserveOne();
+    ring[(first + used) & (ring.size() - 1)] = request;
+    ++used;
+}
+
+void QLowEnergyControllerPrivate::RequestQueue::prepend(const Request &request)
+{
+    reserveOne();
+    first = (first - 1) & (ring.size() - 1);
+    ring[first] = request;
+    ++used;
+}
+
+QLowEnergyControllerPrivate::Request QLowEnergyControllerPrivate::RequestQueue::dequeue()
+{
+    Q_ASSERT(used > 0);
+    // moving leaves an empty slot behind, which drops the references to payload and value
+    Request request = std::move(ring[first]);
+    first = (first + 1) & (ring.size() - 1);
+    --used;
+    return request;
+}
+
+/*
+ * Dequeues the head request after it timed out. Its response may still arrive
+ * and must not be mistaken for the response to the next request.
+ */
+QLowEnergyControllerPrivate::Request QLowEnergyControllerPrivate::RequestQueue::dequeueTimedOut()
+{
+    Request request = dequeue();
+    lateCommands.append(request.command);
+    return request;
+}
+
+void QLowEnergyControllerPrivate::RequestQueue::clear()
+{
+    while (used > 0)
+        dequeue();
+    first = 0;
+    lateCommands.clear();
+}
+
+static bool isResponseTo(quint8 command, const QByteArray &response)
+{
+    // responses use the opcode following their request, errors name the request
+    const quint8 opcode = response.at(0);
+    if (opcode == ATT_OP_ERROR_RESPONSE)
+        return response.size() >= 2 && quint8(response.at(1)) == command;
+    return opcode == command + 1;
+}
+
+/*
+ * Decides whether \a response answers the head request, which was sent if
+ * \a headSent is true, or a request which timed out earlier. The peer answers
+ * requests in order, so a late response arrives before all others. If it could
+ * belong to either, it is taken as the late one: wrongly skipping the response
+ * of the head request only lets that request time out as well, while wrongly
+ * accepting it would hand the data of another request to the head request.
+ */
+QLowEnergyControllerPrivate::RequestQueue::ResponseMatch
+QLowEnergyControllerPrivate::RequestQueue::matchResponse(const QByteArray &response,
+                                                         bool headSent)
+{
+    Q_ASSERT(!response.isEmpty());
+    // a timed out request which is not answered first is never answered
+    while (!lateCommands.isEmpty()) {
+        if (isResponseTo(lateCommands.takeFirst(), response))
+            return LateResponse;
+    }
+
+    if (headSent && !isEmpty() && isResponseTo(head().command, response))
+        return HeadResponse;
+    return UnexpectedResponse;
+}
+
+// The capacity is always a power of two, so that indices can wrap with a mask.
+void QLowEnergyControllerPrivate::RequestQueue::reserveOne()
+{
+    if (used < ring.size())
+        return;
+
+    QVector<Request> larger(ring.size() * 2);
+    for (int i = 0; i < used; ++i)
+        larger[i] = std::move(ring[(first + i) & (ring.size() - 1)]);
+    ring.swap(larger);
+    first = 0;
+}
+
 void QLowEnergyControllerPrivate::sendNextPendingRequest()
 {
+    if (metrics)
+        metrics->sampleRequestQueueDepth(openRequests.count());
+
     if (openRequests.isEmpty() || requestPending || encryptionChangePending)
         return;
 
     const Request &request = openRequests.head();
 //    qCDebug(QT_BT_BLUEZ) << "Sending request, type:" << hex << request.command
-//             << request.payload.toHex();
+//             << request.payload.toByteArray().toHex();
 
     requestPending = true;
+    requestRoundTrip.start();
     restartRequestTimer();
-    sendPacket(request.payload);
+    sendPacket(request.payload.constData(), request.payload.size());
 }
 
 QLowEnergyHandle parseReadByTypeCharDiscovery(
@@ -1032,6 +1203,9 @@ QLowEnergyHandle parseReadByTypeIncludeDiscovery(
     // data[2] -> included service start handle
     // data[4] -> included service end handle
 
+    if (elementLength == 6) // 128 bit uuid, omitted from the declaration
+        return attributeHandle;
+
     if (elementLength == 8) //16 bit uuid
         foundServices->append(QBluetoothUuid(bt_get_le16(&data[6])));
     else
@@ -1083,7 +1257,7 @@ void QLowEnergyControllerPrivate::processReply(
         // Discovering services
         Q_ASSERT(request.command == ATT_OP_READ_BY_GROUP_REQUEST);
 
-        const quint16 type = request.reference.toUInt();
+        const quint16 type = request.attributeType;
 
         if (isErrorResponse) {
             if (type == GATT_SECONDARY_SERVICE) {
@@ -1143,15 +1317,116 @@ void QLowEnergyControllerPrivate::processReply(
         }
     }
         break;
+    case ATT_OP_FIND_BY_TYPE_VALUE_REQUEST: // in case of error
+    case ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE:
+    {
+        // Discovering services by uuid
+        Q_ASSERT(request.command == ATT_OP_FIND_BY_TYPE_VALUE_REQUEST);
+
+        // An error means the remote device does not offer the service.
+        // Only the first instance of a service is of interest as serviceList
+        // is keyed by uuid, hence there is no need to ask for further instances.
+        if (!isErrorResponse && response.size() >= 5) {
+            const QLowEnergyHandle start = bt_get_le16(response.constData() + 1);
+            const QLowEnergyHandle end = bt_get_le16(response.constData() + 3);
+            qCDebug(QT_BT_BLUEZ) << "Found uuid:" << request.serviceUuid << "start handle:" << hex
+                                 << start << "end handle:" << end;
+
+            QLowEnergyServicePrivate *priv = new QLowEnergyServicePrivate();
+            priv->uuid = request.serviceUuid;
+            priv->startHandle = start;
+            priv->endHandle = end;
+            priv->setController(this);
+
+            QSharedPointer<QLowEnergyServicePrivate> pointer(priv);
+
+            serviceList.insert(priv->uuid, pointer);
+            emit q->serviceDiscovered(priv->uuid);
+        }
+
+        if (request.isLastValue) {
+            setState(QLowEnergyController::DiscoveredState);
+            emit q->discoveryFinished();
+        }
+    }
+        break;
     case ATT_OP_READ_BY_TYPE_REQUEST: //in case of error
     case ATT_OP_READ_BY_TYPE_RESPONSE:
     {
         // Discovering characteristics
         Q_ASSERT(request.command == ATT_OP_READ_BY_TYPE_REQUEST);
 
-        QSharedPointer<QLowEnergyServicePrivate> p =
-                request.reference.value<QSharedPointer<QLowEnergyServicePrivate> >();
-        const quint16 attributeType = request.reference2.toUInt();
+        QSharedPointer<QLowEnergyServicePrivate> p = request.service;
+        const quint16 attributeType = request.attributeType;
+
+        if (p.isNull()) {
+            // discoverAllServiceDetails() covers the handle ranges of all its services at once
+            if (databaseDiscoveryServices.isEmpty())
+                break;
+
+            // Characteristic declarations carry a 16 or 128 bit UUID, included service
+            // declarations a 16 bit one or none at all, which then has to be read from
+            // the included service. Anything else ends the discovery phase.
+            quint16 elementLength = 0;
+            if (!isErrorResponse && response.size() >= 2)
+                elementLength = quint8(response.constData()[1]);
+            const bool validLength = attributeType == GATT_CHARACTERISTIC
+                    ? (elementLength == 7 || elementLength == 21)
+                    : (elementLength == 6 || elementLength == 8);
+            if (!isErrorResponse && !validLength) {
+                qCWarning(QT_BT_BLUEZ) << "Invalid element length" << elementLength
+                                       << "in read by type response";
+            }
+
+            QLowEnergyHandle lastHandle = 0;
+            if (!isErrorResponse && validLength) {
+                const quint16 numElements = (response.size() - 2) / elementLength;
+                const char *data = response.constData() + 2;
+                for (int i = 0; i < numElements; i++, data += elementLength) {
+                    if (attributeType == GATT_CHARACTERISTIC) {
+                        QLowEnergyServicePrivate::CharData characteristic;
+                        lastHandle = parseReadByTypeCharDiscovery(
+                                    &characteristic, data, elementLength);
+                        QSharedPointer<QLowEnergyServicePrivate> service =
+                                databaseServiceForHandle(lastHandle);
+                        if (!service.isNull())
+                            service->characteristicList[lastHandle] = characteristic;
+                    } else if (attributeType == GATT_INCLUDED_SERVICE) {
+                        QList<QBluetoothUuid> includedServices;
+                        lastHandle = parseReadByTypeIncludeDiscovery(
+                                    &includedServices, data, elementLength);
+                        QSharedPointer<QLowEnergyServicePrivate> service =
+                                databaseServiceForHandle(lastHandle);
+                        if (service.isNull())
+                            continue;
+                        if (includedServices.isEmpty()) {
+                            readIncludedServiceUuid(p, lastHandle, bt_get_le16(&data[2]));
+                            continue;
+                        }
+                        service->includedServices += includedServices;
+                        foreach (const QBluetoothUuid &uuid, includedServices) {
+                            if (serviceList.contains(uuid))
+                                serviceList[uuid]->type |= QLowEnergyService::IncludedService;
+                        }
+                    }
+                }
+            }
+
+            if (lastHandle && lastHandle < databaseDiscoveryServices.constLast()->endHandle) {
+                sendReadByTypeRequest(p, lastHandle + 1, attributeType);
+            } else if (attributeType == GATT_INCLUDED_SERVICE) {
+                sendReadByTypeRequest(p, databaseDiscoveryServices.constFirst()->startHandle,
+                                      GATT_CHARACTERISTIC);
+            } else {
+                QList<QLowEnergyHandle> charHandles;
+                foreach (const QSharedPointer<QLowEnergyServicePrivate> &service,
+                         databaseDiscoveryServices)
+                    charHandles += service->characteristicList.keys();
+                std::sort(charHandles.begin(), charHandles.end());
+                discoverNextDatabaseDescriptor(charHandles, 0);
+            }
+            break;
+        }
 
         if (isErrorResponse) {
             if (attributeType == GATT_CHARACTERISTIC) {
@@ -1182,7 +1457,7 @@ void QLowEnergyControllerPrivate::processReply(
          *      <opcode><elementLength>
          *          [<handle><startHandle_included><endHandle_included><uuid>]+
          *
-         *  The uuid can be 16 or 128 bit.
+         *  The uuid can be 16 or 128 bit. Included services omit 128 bit uuids.
          */
         QLowEnergyHandle lastHandle;
         const quint16 elementLength = response.constData()[1];
@@ -1200,11 +1475,14 @@ void QLowEnergyControllerPrivate::processReply(
                 QList<QBluetoothUuid> includedServices;
                 lastHandle = parseReadByTypeIncludeDiscovery(
                             &includedServices, &data[offset], elementLength);
-                p->includedServices = includedServices;
+                if (includedServices.isEmpty())
+                    readIncludedServiceUuid(p, lastHandle, bt_get_le16(&data[offset + 2]));
+                p->includedServices += includedServices;
                 foreach (const QBluetoothUuid &uuid, includedServices) {
                     if (serviceList.contains(uuid))
                         serviceList[uuid]->type |= QLowEnergyService::IncludedService;
                 }
+                offset += elementLength;
             }
         }
 
@@ -1224,9 +1502,32 @@ void QLowEnergyControllerPrivate::processReply(
         //Reading characteristics and descriptors
         Q_ASSERT(request.command == ATT_OP_READ_REQUEST);
 
-        uint handleData = request.reference.toUInt();
-        const QLowEnergyHandle charHandle = (handleData & 0xffff);
-        const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
+        if (request.attributeType == GATT_INCLUDED_SERVICE) {
+            // the value of a service declaration is the uuid of the service
+            QSharedPointer<QLowEnergyServicePrivate> service = request.service.isNull()
+                    ? databaseServiceForHandle(request.attributeHandle) : request.service;
+            QBluetoothUuid uuid;
+            if (!isErrorResponse && response.size() == 17)
+                uuid = convert_uuid128(reinterpret_cast<const quint128 *>(response.constData() + 1));
+            else if (!isErrorResponse && response.size() == 3)
+                uuid = QBluetoothUuid(bt_get_le16(response.constData() + 1));
+
+            if (uuid.isNull() || service.isNull()) {
+                qCWarning(QT_BT_BLUEZ) << "Cannot read uuid of service included at" << hex
+                                       << request.attributeHandle;
+                break;
+            }
+
+            qCDebug(QT_BT_BLUEZ) << "Found included service: " << hex
+                                 << request.attributeHandle << "uuid:" << uuid;
+            service->includedServices.append(uuid);
+            if (serviceList.contains(uuid))
+                serviceList[uuid]->type |= QLowEnergyService::IncludedService;
+            break;
+        }
+
+        const QLowEnergyHandle charHandle = request.charHandle;
+        const QLowEnergyHandle descriptorHandle = request.descriptorHandle;
 
         QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
         Q_ASSERT(!service.isNull());
@@ -1260,8 +1561,8 @@ void QLowEnergyControllerPrivate::processReply(
                          << charHandle << descriptorHandle
                          << service->characteristicList[charHandle].uuid.toString();
                 // Potentially more data -> switch to blob reads
-                readServiceValuesByOffset(handleData, mtuSize-1,
-                                          request.reference2.toBool());
+                readServiceValuesByOffset(charHandle, descriptorHandle, mtuSize-1,
+                                          request.isLastValue);
                 break;
             } else if (!isServiceDiscoveryRun) {
                 // readCharacteristic() or readDescriptor() ongoing
@@ -1276,7 +1577,7 @@ void QLowEnergyControllerPrivate::processReply(
             }
         }
 
-        if (request.reference2.toBool() && isServiceDiscoveryRun) {
+        if (request.isLastValue && isServiceDiscoveryRun) {
             // we only run into this code path during the initial service discovery
             // and not when processing readCharacteristics() after service discovery
 
@@ -1295,9 +1596,8 @@ void QLowEnergyControllerPrivate::processReply(
         //Reading characteristic or descriptor with value longer value than MTU
         Q_ASSERT(request.command == ATT_OP_READ_BLOB_REQUEST);
 
-        uint handleData = request.reference.toUInt();
-        const QLowEnergyHandle charHandle = (handleData & 0xffff);
-        const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
+        const QLowEnergyHandle charHandle = request.charHandle;
+        const QLowEnergyHandle descriptorHandle = request.descriptorHandle;
 
         QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
         Q_ASSERT(!service.isNull());
@@ -1317,8 +1617,8 @@ void QLowEnergyControllerPrivate::processReply(
                                         response.mid(1), APPEND_VALUE);
 
             if (response.size() == mtuSize) {
-                readServiceValuesByOffset(handleData, length,
-                                          request.reference2.toBool());
+                readServiceValuesByOffset(charHandle, descriptorHandle, length,
+                                          request.isLastValue);
                 break;
             } else if (service->state == QLowEnergyService::ServiceDiscovered) {
                 // readCharacteristic() or readDescriptor() ongoing
@@ -1338,7 +1638,7 @@ void QLowEnergyControllerPrivate::processReply(
                        << (service->state == QLowEnergyService::ServiceDiscovered) << ")";
         }
 
-        if (request.reference2.toBool()) {
+        if (request.isLastValue) {
             //last overlong characteristic -> progress to descriptor discovery
             //last overlong descriptor -> service discovery is done
 
@@ -1362,7 +1662,7 @@ void QLowEnergyControllerPrivate::processReply(
          *  The uuid can be 16 or 128 bit which is indicated by format.
          */
 
-        QList<QLowEnergyHandle> keys = request.reference.value<QList<QLowEnergyHandle> >();
+        QList<QLowEnergyHandle> keys = request.pendingCharHandles;
         if (keys.isEmpty()) {
             qCWarning(QT_BT_BLUEZ) << "Descriptor discovery for unknown characteristic received";
             break;
@@ -1374,7 +1674,11 @@ void QLowEnergyControllerPrivate::processReply(
         Q_ASSERT(!p.isNull());
 
         if (isErrorResponse) {
-            if (keys.count() == 1) {
+            if (request.service.isNull()) {
+                // no further descriptors of this characteristic
+                keys.removeFirst();
+                discoverNextDatabaseDescriptor(keys, 0);
+            } else if (keys.count() == 1) {
                 // no more descriptors to discover
                 readServiceValues(p->uuid, false); //read descriptor values
             } else {
@@ -1441,6 +1745,11 @@ void QLowEnergyControllerPrivate::processReply(
                                  << "descriptor handle:" << hex << descriptorHandle;
         }
 
+        if (request.service.isNull()) {
+            discoverNextDatabaseDescriptor(keys, quint32(descriptorHandle) + 1);
+            break;
+        }
+
         const QLowEnergyHandle nextPotentialHandle = descriptorHandle + 1;
         if (keys.count() == 1) {
             // Reached last characteristic of service
@@ -1473,9 +1782,8 @@ void QLowEnergyControllerPrivate::processReply(
         //Write command response
         Q_ASSERT(request.command == ATT_OP_WRITE_REQUEST);
 
-        uint ref = request.reference.toUInt();
-        const QLowEnergyHandle charHandle = (ref & 0xffff);
-        const QLowEnergyHandle descriptorHandle = ((ref >> 16) & 0xffff);
+        const QLowEnergyHandle charHandle = request.charHandle;
+        const QLowEnergyHandle descriptorHandle = request.descriptorHandle;
 
         QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
         if (service.isNull() || !service->characteristicList.contains(charHandle))
@@ -1496,7 +1804,7 @@ void QLowEnergyControllerPrivate::processReply(
             break;
         }
 
-        const QByteArray newValue = request.reference2.toByteArray();
+        const QByteArray &newValue = request.value;
         if (!descriptorHandle) {
             QLowEnergyCharacteristic ch(service, charHandle);
             if (ch.properties() & QLowEnergyCharacteristic::Read)
@@ -1515,10 +1823,9 @@ void QLowEnergyControllerPrivate::processReply(
         //Prepare write command response
         Q_ASSERT(request.command == ATT_OP_PREPARE_WRITE_REQUEST);
 
-        uint handleData = request.reference.toUInt();
-        const QLowEnergyHandle attrHandle = (handleData & 0xffff);
-        const QByteArray newValue = request.reference2.toByteArray();
-        const int writtenPayload = ((handleData >> 16) & 0xffff);
+        const QLowEnergyHandle attrHandle = request.attributeHandle;
+        const QByteArray &newValue = request.value;
+        const int writtenPayload = request.writtenLength;
 
         if (isErrorResponse) {
             Q_ASSERT(!encryptionChangePending);
@@ -1545,10 +1852,9 @@ void QLowEnergyControllerPrivate::processReply(
         // not catering for reliable writes
         Q_ASSERT(request.command == ATT_OP_EXECUTE_WRITE_REQUEST);
 
-        uint handleData = request.reference.toUInt();
-        const QLowEnergyHandle attrHandle = handleData & 0xffff;
-        bool wasCancellation = !((handleData >> 16) & 0xffff);
-        const QByteArray newValue = request.reference2.toByteArray();
+        const QLowEnergyHandle attrHandle = request.attributeHandle;
+        const bool wasCancellation = request.isCancelation;
+        const QByteArray &newValue = request.value;
 
         // is it a descriptor or characteristic?
         const QLowEnergyDescriptor descriptor = descriptorForHandle(attrHandle);
@@ -1581,9 +1887,67 @@ void QLowEnergyControllerPrivate::processReply(
     }
 }
 
+static QByteArray uuidToByteArray(const QBluetoothUuid &uuid)
+{
+    QByteArray ba;
+    if (uuid.minimumSize() == 2) {
+        ba.resize(2);
+        putBtData(uuid.toUInt16(), ba.data());
+    } else {
+        ba.resize(16);
+        quint128 hostOrder;
+        quint128 qtUuidOrder = uuid.toUInt128();
+        ntoh128(&qtUuidOrder, &hostOrder);
+        putBtData(hostOrder, ba.data());
+    }
+    return ba;
+}
+
 void QLowEnergyControllerPrivate::discoverServices()
 {
-    sendReadByGroupRequest(0x0001, 0xFFFF, GATT_PRIMARY_SERVICE);
+    if (serviceDiscoveryFilter.isEmpty()) {
+        sendReadByGroupRequest(0x0001, 0xFFFF, GATT_PRIMARY_SERVICE);
+        return;
+    }
+
+    // one round trip per service instead of walking the whole handle range
+    QList<QBluetoothUuid> uuids;
+    for (const QBluetoothUuid &uuid : qAsConst(serviceDiscoveryFilter)) {
+        if (!uuids.contains(uuid))
+            uuids.append(uuid);
+    }
+    for (int i = 0; i < uuids.count(); i++)
+        sendFindByTypeValueRequest(uuids.at(i), i + 1 == uuids.count());
+
+    sendNextPendingRequest();
+}
+
+/*!
+    \internal
+
+    Queues a request for the handle range of the primary service \a serviceUuid.
+    \a isLastValue marks the last service of a filtered service discovery.
+ */
+void QLowEnergyControllerPrivate::sendFindByTypeValueRequest(
+        const QBluetoothUuid &serviceUuid, bool isLastValue)
+{
+    const QByteArray value = uuidToByteArray(serviceUuid);
+
+    QByteArray data(FIND_BY_TYPE_VALUE_REQ_HEADER_SIZE + value.size(), Qt::Uninitialized);
+    data[0] = ATT_OP_FIND_BY_TYPE_VALUE_REQUEST;
+    putBtData(quint16(0x0001), data.data() + 1);
+    putBtData(quint16(0xFFFF), data.data() + 3);
+    putBtData(GATT_PRIMARY_SERVICE, data.data() + 5);
+    memcpy(data.data() + FIND_BY_TYPE_VALUE_REQ_HEADER_SIZE, value.constData(), value.size());
+    qCDebug(QT_BT_BLUEZ) << "Sending find_by_type_value request for service"
+                         << serviceUuid.toString();
+
+    Request request;
+    request.payload = data;
+    request.command = ATT_OP_FIND_BY_TYPE_VALUE_REQUEST;
+    request.serviceUuid = serviceUuid;
+    request.isLastValue = isLastValue;
+    openRequests.enqueue(request);
 }
 
 void QLowEnergyControllerPrivate::sendReadByGroupRequest(
@@ -1597,15 +1961,13 @@ void QLowEnergyControllerPrivate::sendReadByGroupRequest(
     putBtData(end, &packet[3]);
     putBtData(type, &packet[5]);
 
-    QByteArray data(GRP_TYPE_REQ_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet,  GRP_TYPE_REQ_HEADER_SIZE);
     qCDebug(QT_BT_BLUEZ) << "Sending read_by_group_type request, startHandle:" << hex
              << start << "endHandle:" << end << type;
 
     Request request;
-    request.payload = data;
+    request.payload.assign(packet, GRP_TYPE_REQ_HEADER_SIZE);
     request.command = ATT_OP_READ_BY_GROUP_REQUEST;
-    request.reference = type;
+    request.attributeType = type;
     openRequests.enqueue(request);
 
     sendNextPendingRequest();
@@ -1621,31 +1983,197 @@ void QLowEnergyControllerPrivate::discoverServiceDetails(const QBluetoothUuid &s
 
     QSharedPointer<QLowEnergyServicePrivate> serviceData = serviceList.value(service);
     serviceData->characteristicList.clear();
+    serviceData->includedServices.clear();
     sendReadByTypeRequest(serviceData, serviceData->startHandle, GATT_INCLUDED_SERVICE);
 }
 
+/*!
+    \internal
+
+    Discovers the details of all \a services in one pass over the remote attribute
+    database. The included services and characteristics are found with Read By Type
+    requests spanning the handle ranges of all services, the descriptors with Find
+    Information requests for the handles between a characteristic's value and the next
+    characteristic. Afterwards the values are read per service and every service
+    enters the ServiceDiscovered state on its own.
+ */
+void QLowEnergyControllerPrivate::discoverAllServiceDetails(const QList<QBluetoothUuid> &services)
+{
+    if (!databaseDiscoveryServices.isEmpty()) {
+        // a previous run is still going on, its request stream cannot be extended
+        foreach (const QBluetoothUuid &uuid, services)
+            discoverServiceDetails(uuid);
+        return;
+    }
+
+    foreach (const QBluetoothUuid &uuid, services) {
+        if (!serviceList.contains(uuid)) {
+            qCWarning(QT_BT_BLUEZ) << "Discovery of unknown service" << uuid.toString()
+                                   << "not possible";
+            continue;
+        }
+
+        QSharedPointer<QLowEnergyServicePrivate> serviceData = serviceList.value(uuid);
+        serviceData->characteristicList.clear();
+        serviceData->includedServices.clear();
+        databaseDiscoveryServices.append(serviceData);
+    }
+
+    if (databaseDiscoveryServices.isEmpty())
+        return;
+
+    std::sort(databaseDiscoveryServices.begin(), databaseDiscoveryServices.end(),
+              [](const QSharedPointer<QLowEnergyServicePrivate> &a,
+                 const QSharedPointer<QLowEnergyServicePrivate> &b) {
+        return a->startHandle < b->startHandle;
+    });
+
+    qCDebug(QT_BT_BLUEZ) << "Discovering details of" << databaseDiscoveryServices.count()
+                         << "services in one pass";
+    sendReadByTypeRequest(QSharedPointer<QLowEnergyServicePrivate>(),
+                          databaseDiscoveryServices.constFirst()->startHandle,
+                          GATT_INCLUDED_SERVICE);
+}
+
+/*!
+    \internal
+
+    Returns the service of the running discoverAllServiceDetails() whose handle range
+    contains \a handle; otherwise a null pointer.
+ */
+QSharedPointer<QLowEnergyServicePrivate> QLowEnergyControllerPrivate::databaseServiceForHandle(
+        QLowEnergyHandle handle) const
+{
+    foreach (const QSharedPointer<QLowEnergyServicePrivate> &service, databaseDiscoveryServices) {
+        if (service->startHandle <= handle && handle <= service->endHandle)
+            return service;
+    }
+
+    return QSharedPointer<QLowEnergyServicePrivate>();
+}
+
+/*
+ * Returns the last handle which may belong to a descriptor of the characteristic
+ * declared at charHandle, that is the handle before the next characteristic
+ * declaration or the end handle of the service.
+ */
+static QLowEnergyHandle descriptorRangeEnd(
+        const QSharedPointer<QLowEnergyServicePrivate> &service, QLowEnergyHandle charHandle)
+{
+    QLowEnergyHandle end = service->endHandle;
+    CharacteristicDataMap::const_iterator it = service->characteristicList.constBegin();
+    for ( ; it != service->characteristicList.constEnd(); ++it) {
+        if (it.key() > charHandle && it.key() <= end)
+            end = it.key() - 1;
+    }
+
+    return end;
+}
+
+/*!
+    \internal
+
+    Continues the descriptor discovery of discoverAllServiceDetails() at \a nextHandle
+    within the descriptor range of the first of \a pendingCharHandles. A \a nextHandle
+    of 0 starts right after the characteristic's value handle. Characteristics without
+    any handles in between their value and the next characteristic do not cost a
+    request at all.
+ */
+void QLowEnergyControllerPrivate::discoverNextDatabaseDescriptor(
+        QList<QLowEnergyHandle> pendingCharHandles, quint32 nextHandle)
+{
+    while (!pendingCharHandles.isEmpty()) {
+        const QLowEnergyHandle charHandle = pendingCharHandles.first();
+        QSharedPointer<QLowEnergyServicePrivate> service = databaseServiceForHandle(charHandle);
+        Q_ASSERT(!service.isNull());
+
+        if (nextHandle == 0)
+            nextHandle = quint32(service->characteristicList.value(charHandle).valueHandle) + 1;
+
+        if (nextHandle <= descriptorRangeEnd(service, charHandle)) {
+            discoverNextDescriptor(QSharedPointer<QLowEnergyServicePrivate>(),
+                                   pendingCharHandles, nextHandle);
+            return;
+        }
+
+        pendingCharHandles.removeFirst();
+        nextHandle = 0;
+    }
+
+    readDatabaseValues();
+}
+
+/*!
+    \internal
+
+    Reads the values of all services of the running discoverAllServiceDetails().
+    Once the characteristic values of a service are read, discoverServiceDescriptors()
+    removes it from the run and continues with its descriptor values.
+ */
+void QLowEnergyControllerPrivate::readDatabaseValues()
+{
+    const QVector<QSharedPointer<QLowEnergyServicePrivate> > services = databaseDiscoveryServices;
+    foreach (const QSharedPointer<QLowEnergyServicePrivate> &service, services)
+        readServiceValues(service->uuid, true);
+}
+
 void QLowEnergyControllerPrivate::sendReadByTypeRequest(
         QSharedPointer<QLowEnergyServicePrivate> serviceData,
         QLowEnergyHandle nextHandle, quint16 attributeType)
 {
     quint8 packet[READ_BY_TYPE_REQ_HEADER_SIZE];
 
+    // a null service spans all services of discoverAllServiceDetails()
+    const QLowEnergyHandle endHandle = serviceData.isNull()
+            ? databaseDiscoveryServices.constLast()->endHandle
+            : serviceData->endHandle;
+
     packet[0] = ATT_OP_READ_BY_TYPE_REQUEST;
     putBtData(nextHandle, &packet[1]);
-    putBtData(serviceData->endHandle, &packet[3]);
+    putBtData(endHandle, &packet[3]);
     putBtData(attributeType, &packet[5]);
 
-    QByteArray data(READ_BY_TYPE_REQ_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet,  READ_BY_TYPE_REQ_HEADER_SIZE);
     qCDebug(QT_BT_BLUEZ) << "Sending read_by_type request, startHandle:" << hex
-             << nextHandle << "endHandle:" << serviceData->endHandle
-             << "type:" << attributeType << "packet:" << data.toHex();
+             << nextHandle << "endHandle:" << endHandle
+             << "type:" << attributeType << "packet:"
+             << QByteArray(reinterpret_cast<const char *>(packet),
+                           READ_BY_TYPE_REQ_HEADER_SIZE).toHex();
 
     Request request;
-    request.payload = data;
+    request.payload.assign(packet, READ_BY_TYPE_REQ_HEADER_SIZE);
     request.command = ATT_OP_READ_BY_TYPE_REQUEST;
-    request.reference = QVariant::fromValue(serviceData);
-    request.reference2 = attributeType;
+    request.service = serviceData;
+    request.attributeType = attributeType;
+    openRequests.enqueue(request);
+
+    sendNextPendingRequest();
+}
+
+/*!
+    \internal
+
+    Reads the 128 bit uuid of the service included by the declaration at
+    \a declarationHandle from the service declaration at \a startHandle, as included
+    service declarations omit such uuids. \a serviceData is the including service or
+    null for discoverAllServiceDetails(). The request is queued before the next step of
+    the discovery, so the uuid is known when the discovery moves on.
+ */
+void QLowEnergyControllerPrivate::readIncludedServiceUuid(
+        QSharedPointer<QLowEnergyServicePrivate> serviceData,
+        QLowEnergyHandle declarationHandle, QLowEnergyHandle startHandle)
+{
+    quint8 packet[READ_REQUEST_HEADER_SIZE];
+    packet[0] = ATT_OP_READ_REQUEST;
+    putBtData(startHandle, &packet[1]);
+
+    qCDebug(QT_BT_BLUEZ) << "Reading uuid of included service at" << hex << startHandle;
+
+    Request request;
+    request.payload.assign(packet, READ_REQUEST_HEADER_SIZE);
+    request.command = ATT_OP_READ_REQUEST;
+    request.service = serviceData;
+    request.attributeType = GATT_INCLUDED_SERVICE;
+    request.attributeHandle = declarationHandle;
     openRequests.enqueue(request);
 
     sendNextPendingRequest();
@@ -1663,6 +2191,17 @@ void QLowEnergyControllerPrivate::sendReadByTypeRequest(
 void QLowEnergyControllerPrivate::readServiceValues(
         const QBluetoothUuid &serviceUuid, bool readCharacteristics)
 {
+    QSharedPointer<QLowEnergyServicePrivate> service = serviceList.value(serviceUuid);
+
+    if (service->discoveryMode == QLowEnergyService::SkipValueDiscovery) {
+        // values are only read on request via readCharacteristic() and readDescriptor()
+        if (readCharacteristics)
+            discoverServiceDescriptors(service->uuid);
+        else
+            service->setState(QLowEnergyService::ServiceDiscovered);
+        return;
+    }
+
     quint8 packet[READ_REQUEST_HEADER_SIZE];
     if (QT_BT_BLUEZ().isDebugEnabled()) {
         if (readCharacteristics)
@@ -1673,8 +2212,6 @@ void QLowEnergyControllerPrivate::readServiceValues(
                          << serviceUuid.toString();
     }
 
-    QSharedPointer<QLowEnergyServicePrivate> service = serviceList.value(serviceUuid);
-
     // pair.first -> target attribute
     // pair.second -> context information for read request
     QPair<QLowEnergyHandle, quint32> pair;
@@ -1729,15 +2266,14 @@ void QLowEnergyControllerPrivate::readServiceValues(
         packet[0] = ATT_OP_READ_REQUEST;
         putBtData(pair.first, &packet[1]);
 
-        QByteArray data(READ_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-        memcpy(data.data(), packet,  READ_REQUEST_HEADER_SIZE);
 
         Request request;
-        request.payload = data;
+        request.payload.assign(packet, READ_REQUEST_HEADER_SIZE);
         request.command = ATT_OP_READ_REQUEST;
-        request.reference = pair.second;
+        request.charHandle = pair.second & 0xffff;
+        request.descriptorHandle = (pair.second >> 16) & 0xffff;
         // last entry?
-        request.reference2 = QVariant((bool)(i + 1 == targetHandles.count()));
+        request.isLastValue = (i + 1 == targetHandles.count());
         openRequests.enqueue(request);
     }
 
@@ -1755,12 +2291,10 @@ void QLowEnergyControllerPrivate::readServiceValues(
     starting the next read request.
  */
 void QLowEnergyControllerPrivate::readServiceValuesByOffset(
-        uint handleData, quint16 offset, bool isLastValue)
+        QLowEnergyHandle charHandle, QLowEnergyHandle descriptorHandle,
+        quint16 offset, bool isLastValue)
 {
-    const QLowEnergyHandle charHandle = (handleData & 0xffff);
-    const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
-
-    QByteArray data(READ_BLOB_REQUEST_HEADER_SIZE, Qt::Uninitialized);
+    char data[READ_BLOB_REQUEST_HEADER_SIZE];
     data[0] = ATT_OP_READ_BLOB_REQUEST;
 
     QLowEnergyHandle handleToRead = charHandle;
@@ -1782,23 +2316,34 @@ void QLowEnergyControllerPrivate::readServiceValuesByOffset(
         }
     }
 
-    putBtData(handleToRead, data.data() + 1);
-    putBtData(offset, data.data() + 3);
+    putBtData(handleToRead, data + 1);
+    putBtData(offset, data + 3);
 
     Request request;
-    request.payload = data;
+    request.payload.assign(data, READ_BLOB_REQUEST_HEADER_SIZE);
     request.command = ATT_OP_READ_BLOB_REQUEST;
-    request.reference = handleData;
-    request.reference2 = isLastValue;
+    request.charHandle = charHandle;
+    request.descriptorHandle = descriptorHandle;
+    request.isLastValue = isLastValue;
     openRequests.prepend(request);
+
+    if (metrics)
+        ++metrics->blobReads;
 }
 
 void QLowEnergyControllerPrivate::discoverServiceDescriptors(
         const QBluetoothUuid &serviceUuid)
 {
+    QSharedPointer<QLowEnergyServicePrivate> service = serviceList.value(serviceUuid);
+
+    if (databaseDiscoveryServices.removeOne(service)) {
+        // discoverAllServiceDetails() has found the descriptors already
+        readServiceValues(serviceUuid, false);
+        return;
+    }
+
     qCDebug(QT_BT_BLUEZ) << "Discovering descriptor values for"
                          << serviceUuid.toString();
-    QSharedPointer<QLowEnergyServicePrivate> service = serviceList.value(serviceUuid);
 
     if (service->characteristicList.isEmpty()) { // service has no characteristics
         // implies that characteristic & descriptor discovery can be skipped
@@ -1830,6 +2375,7 @@ void QLowEnergyControllerPrivate::processUnsolicitedReply(const QByteArray &payl
     if (ch.isValid() && ch.handle() == changedHandle) {
         if (ch.properties() & QLowEnergyCharacteristic::Read)
             updateValueOfCharacteristic(ch.attributeHandle(), payload.mid(3), NEW_VALUE);
+        ch.d_ptr->lastNotificationTimestamp = l2cpSocket->lastReceiveTimestamp();
         emit ch.d_ptr->characteristicChanged(ch, payload.mid(3));
     } else {
         qCWarning(QT_BT_BLUEZ) << "Cannot find matching characteristic for "
@@ -1845,11 +2391,9 @@ void QLowEnergyControllerPrivate::exchangeMTU()
     packet[0] = ATT_OP_EXCHANGE_MTU_REQUEST;
     putBtData(quint16(ATT_MAX_LE_MTU), &packet[1]);
 
-    QByteArray data(MTU_EXCHANGE_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet, MTU_EXCHANGE_HEADER_SIZE);
 
     Request request;
-    request.payload = data;
+    request.payload.assign(packet, MTU_EXCHANGE_HEADER_SIZE);
     request.command = ATT_OP_EXCHANGE_MTU_REQUEST;
     openRequests.enqueue(request);
 
@@ -1948,7 +2492,6 @@ void QLowEnergyControllerPrivate::discoverNextDescriptor(
         const QLowEnergyHandle startingHandle)
 {
     Q_ASSERT(!pendingCharHandles.isEmpty());
-    Q_ASSERT(!serviceData.isNull());
 
     qCDebug(QT_BT_BLUEZ) << "Sending find_info request" << hex
                          << pendingCharHandles << startingHandle;
@@ -1958,7 +2501,10 @@ void QLowEnergyControllerPrivate::discoverNextDescriptor(
 
     const QLowEnergyHandle charStartHandle = startingHandle;
     QLowEnergyHandle charEndHandle = 0;
-    if (pendingCharHandles.count() == 1) //single characteristic
+    if (serviceData.isNull()) // discoverAllServiceDetails()
+        charEndHandle = descriptorRangeEnd(databaseServiceForHandle(pendingCharHandles[0]),
+                                           pendingCharHandles[0]);
+    else if (pendingCharHandles.count() == 1) //single characteristic
         charEndHandle = serviceData->endHandle;
     else
         charEndHandle = pendingCharHandles[1] - 1;
@@ -1966,14 +2512,13 @@ void QLowEnergyControllerPrivate::discoverNextDescriptor(
     putBtData(charStartHandle, &packet[1]);
     putBtData(charEndHandle, &packet[3]);
 
-    QByteArray data(FIND_INFO_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet, FIND_INFO_REQUEST_HEADER_SIZE);
 
     Request request;
-    request.payload = data;
+    request.payload.assign(packet, FIND_INFO_REQUEST_HEADER_SIZE);
     request.command = ATT_OP_FIND_INFORMATION_REQUEST;
-    request.reference = QVariant::fromValue<QList<QLowEnergyHandle> >(pendingCharHandles);
-    request.reference2 = startingHandle;
+    request.service = serviceData;
+    request.pendingCharHandles = pendingCharHandles;
+    request.startingHandle = startingHandle;
     openRequests.enqueue(request);
 
     sendNextPendingRequest();
@@ -2021,9 +2566,13 @@ void QLowEnergyControllerPrivate::sendNextPrepareWriteRequest(
     Request request;
     request.payload = data;
     request.command = ATT_OP_PREPARE_WRITE_REQUEST;
-    request.reference = (handle | ((offset + requiredPayload) << 16));
-    request.reference2 = newValue;
+    request.attributeHandle = handle;
+    request.writtenLength = offset + requiredPayload;
+    request.value = newValue;
     openRequests.enqueue(request);
+
+    if (metrics)
+        ++metrics->prepareWrites;
 }
 
 /*!
@@ -2045,17 +2594,16 @@ void QLowEnergyControllerPrivate::sendExecuteWriteRequest(
     else
         packet[1] = 0x01; // execute pending write prepare requests
 
-    QByteArray data(EXECUTE_WRITE_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet, EXECUTE_WRITE_HEADER_SIZE);
 
     qCDebug(QT_BT_BLUEZ) << "Sending Execute Write Request for long characteristic value"
                          << hex << attrHandle;
 
     Request request;
-    request.payload = data;
+    request.payload.assign(packet, EXECUTE_WRITE_HEADER_SIZE);
     request.command = ATT_OP_EXECUTE_WRITE_REQUEST;
-    request.reference  = (attrHandle | ((isCancelation ? 0x00 : 0x01) << 16));
-    request.reference2 = newValue;
+    request.attributeHandle = attrHandle;
+    request.isCancelation = isCancelation;
+    request.value = newValue;
     openRequests.prepend(request);
 }
 
@@ -2124,18 +2672,15 @@ void QLowEnergyControllerPrivate::readCharacteristic(
     packet[0] = ATT_OP_READ_REQUEST;
     putBtData(charDetails.valueHandle, &packet[1]);
 
-    QByteArray data(READ_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet,  READ_REQUEST_HEADER_SIZE);
 
     qCDebug(QT_BT_BLUEZ) << "Targeted reading characteristic" << hex << charHandle;
 
     Request request;
-    request.payload = data;
+    request.payload.assign(packet, READ_REQUEST_HEADER_SIZE);
     request.command = ATT_OP_READ_REQUEST;
-    request.reference = charHandle;
-    // reference2 not really required but false prevents service discovery
+    request.charHandle = charHandle;
+    // isLastValue is false, which prevents service discovery
     // code from running in ATT_OP_READ_RESPONSE handler
-    request.reference2 = false;
     openRequests.enqueue(request);
 
     sendNextPendingRequest();
@@ -2159,18 +2704,16 @@ void QLowEnergyControllerPrivate::readDescriptor(
     packet[0] = ATT_OP_READ_REQUEST;
     putBtData(descriptorHandle, &packet[1]);
 
-    QByteArray data(READ_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet,  READ_REQUEST_HEADER_SIZE);
 
     qCDebug(QT_BT_BLUEZ) << "Targeted reading descriptor" << hex << descriptorHandle;
 
     Request request;
-    request.payload = data;
+    request.payload.assign(packet, READ_REQUEST_HEADER_SIZE);
     request.command = ATT_OP_READ_REQUEST;
-    request.reference = (charHandle | (descriptorHandle << 16));
-    // reference2 not really required but false prevents service discovery
+    request.charHandle = charHandle;
+    request.descriptorHandle = descriptorHandle;
+    // isLastValue is false, which prevents service discovery
     // code from running in ATT_OP_READ_RESPONSE handler
-    request.reference2 = false;
     openRequests.enqueue(request);
 
     sendNextPendingRequest();
@@ -2196,7 +2739,15 @@ bool QLowEnergyControllerPrivate::increaseEncryptLevelfRequired(quint8 errorCode
         if (securityLevelValue != BT_SECURITY_HIGH) {
             qCDebug(QT_BT_BLUEZ) << "Requesting encrypted link";
             if (setSecurityLevel(BT_SECURITY_HIGH)) {
-                restartRequestTimer();
+                // the link change takes far longer than a round trip, and the
+                // request is sent again once it is finished
+                requestRoundTrip.invalidate();
+                if (requestTimer)
+                    requestTimer->start(gattRequestTimeout);
+                if (metrics) {
+                    ++metrics->encryptionChangeStalls;
+                    metrics->encryptionChangeRequestedAt = metrics->now();
+                }
                 return true;
             }
         }
@@ -2691,7 +3242,9 @@ void QLowEnergyControllerPrivate::writeCharacteristicForCentral(const QSharedPoi
         }
         ++signingDataIt.value().counter;
         packet = LeCmacCalculator::createFullMessage(packet, signingDataIt.value().counter);
-        const quint64 mac = LeCmacCalculator().calculateMac(packet, signingDataIt.value().key);
+        if (!cmacCalculator)
+            cmacCalculator = new LeCmacCalculator;
+        const quint64 mac = cmacCalculator->calculateMac(packet, signingDataIt.value().key);
         packet.resize(packet.count() + sizeof mac);
         putBtData(mac, packet.data() + packet.count() - sizeof mac);
         storeSignCounter(LocalSigningKey);
@@ -2714,8 +3267,8 @@ void QLowEnergyControllerPrivate::writeCharacteristicForCentral(const QSharedPoi
     Request request;
     request.payload = packet;
     request.command = ATT_OP_WRITE_REQUEST;
-    request.reference = charHandle;
-    request.reference2 = newValue;
+    request.charHandle = charHandle;
+    request.value = newValue;
     openRequests.enqueue(request);
 
     sendNextPendingRequest();
@@ -2764,8 +3317,9 @@ void QLowEnergyControllerPrivate::writeDescriptorForCentral(
     Request request;
     request.payload = data;
     request.command = ATT_OP_WRITE_REQUEST;
-    request.reference = (charHandle | (descriptorHandle << 16));
-    request.reference2 = newValue;
+    request.charHandle = charHandle;
+    request.descriptorHandle = descriptorHandle;
+    request.value = newValue;
     openRequests.enqueue(request);
 
     sendNextPendingRequest();
@@ -3042,11 +3596,15 @@ void QLowEnergyControllerPrivate::handleConnectionRequest()
     connect(l2cpSocket, &QIODevice::readyRead, this, &QLowEnergyControllerPrivate::l2cpReadyRead);
     l2cpSocket->d_ptr->lowEnergySocketType = addressType == QLowEnergyController::PublicAddress
             ? BDADDR_LE_PUBLIC : BDADDR_LE_RANDOM;
+    l2cpSocket->setReceiveTimestampsEnabled(true);
     l2cpSocket->setSocketDescriptor(clientSocket, QBluetoothServiceInfo::L2capProtocol,
             QBluetoothSocket::ConnectedState, QIODevice::ReadWrite | QIODevice::Unbuffered);
     restoreClientConfigurations();
     loadSigningDataIfNecessary(RemoteSigningKey);
 
+    if (connectionTuner)
+        connectionTuner->start();
+
     Q_Q(QLowEnergyController);
     setState(QLowEnergyController::ConnectedState);
     emit q->connected();
@@ -3149,57 +3707,38 @@ void QLowEnergyControllerPrivate::loadSigningDataIfNecessary(SigningKeyType keyT
     const auto signingDataIt = signingData.constFind(remoteDevice.toUInt64());
     if (signingDataIt != signingData.constEnd())
         return; // We are up to date for this device.
-    const QString settingsFilePath = keySettingsFilePath();
-    if (!QFileInfo(settingsFilePath).exists()) {
-        qCDebug(QT_BT_BLUEZ) << "No settings found for peer device.";
-        return;
-    }
-    QSettings settings(settingsFilePath, QSettings::IniFormat);
-    const QString group = signingKeySettingsGroup(keyType);
-    settings.beginGroup(group);
-    const QByteArray keyString = settings.value(QLatin1String("Key")).toByteArray();
-    if (keyString.isEmpty()) {
-        qCDebug(QT_BT_BLUEZ) << "Group" << group << "not found in settings file";
-        return;
-    }
-    const QByteArray keyData = QByteArray::fromHex(keyString);
-    if (keyData.count() != int(sizeof(quint128))) {
-        qCWarning(QT_BT_BLUEZ) << "Signing key in settings file has invalid size"
-                               << keyString.count();
-        return;
-    }
-    qCDebug(QT_BT_BLUEZ) << "CSRK of peer device is" << keyString;
-    const quint32 counter = settings.value(QLatin1String("Counter"), 0).toUInt();
     quint128 csrk;
-    using namespace std;
-    memcpy(csrk.data, keyData.constData(), keyData.count());
+    quint32 counter;
+    const auto storeKeyType = keyType == LocalSigningKey
+            ? SignCounterStore::LocalSigningKey : SignCounterStore::RemoteSigningKey;
+    if (!signCounterStoreForPeer()->readKey(storeKeyType, &csrk, &counter))
+        return;
     signingData.insert(remoteDevice.toUInt64(), SigningData(csrk, counter - 1));
 }
 
-void QLowEnergyControllerPrivate::storeSignCounter(SigningKeyType keyType) const
+/*!
+    Records the last used sign counter. SignCounterStore persists both counters
+    ahead of their use, so the counter of the peer is covered before the signed
+    write is processed.
+*/
+void QLowEnergyControllerPrivate::storeSignCounter(SigningKeyType keyType)
 {
     const auto signingDataIt = signingData.constFind(remoteDevice.toUInt64());
     if (signingDataIt == signingData.constEnd())
         return;
-    const QString settingsFilePath = keySettingsFilePath();
-    if (!QFileInfo(settingsFilePath).exists())
-        return;
-    QSettings settings(settingsFilePath, QSettings::IniFormat);
-    if (!settings.isWritable())
-        return;
-    settings.beginGroup(signingKeySettingsGroup(keyType));
-    const QString counterKey = QLatin1String("Counter");
-    if (!settings.allKeys().contains(counterKey))
-        return;
-    const quint32 counterValue = signingDataIt.value().counter + 1;
-    if (counterValue == settings.value(counterKey).toUInt())
-        return;
-    settings.setValue(counterKey, counterValue);
+    const auto storeKeyType = keyType == LocalSigningKey
+            ? SignCounterStore::LocalSigningKey : SignCounterStore::RemoteSigningKey;
+    signCounterStoreForPeer()->setCounter(storeKeyType, signingDataIt.value().counter);
 }
 
-QString QLowEnergyControllerPrivate::signingKeySettingsGroup(SigningKeyType keyType) const
+SignCounterStore *QLowEnergyControllerPrivate::signCounterStoreForPeer()
 {
-    return QLatin1String(keyType == LocalSigningKey ? "LocalSignatureKey" : "RemoteSignatureKey");
+    const QString settingsFilePath = keySettingsFilePath();
+    if (!signCounterStore || signCounterStore->settingsFilePath() != settingsFilePath) {
+        delete signCounterStore; // releases the reservation of the previous peer
+        signCounterStore = new SignCounterStore(settingsFilePath, this);
+    }
+    return signCounterStore;
 }
 
 QString QLowEnergyControllerPrivate::keySettingsFilePath() const
@@ -3208,22 +3747,6 @@ QString QLowEnergyControllerPrivate::keySettingsFilePath() const
             .arg(localAdapter.toString(), remoteDevice.toString());
 }
 
-static QByteArray uuidToByteArray(const QBluetoothUuid &uuid)
-{
-    QByteArray ba;
-    if (uuid.minimumSize() == 2) {
-        ba.resize(2);
-        putBtData(uuid.toUInt16(), ba.data());
-    } else {
-        ba.resize(16);
-        quint128 hostOrder;
-        quint128 qtUuidOrder = uuid.toUInt128();
-        ntoh128(&qtUuidOrder, &hostOrder);
-        putBtData(hostOrder, ba.data());
-    }
-    return ba;
-}
-
 void QLowEnergyControllerPrivate::addToGenericAttributeList(const QLowEnergyServiceData &service,
                                                             QLowEnergyHandle startHandle)
 {
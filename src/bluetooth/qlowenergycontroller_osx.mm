@@ -49,6 +49,8 @@
 #include "qbluetoothlocaldevice.h"
 #include "qbluetoothdeviceinfo.h"
 #include "qlowenergycontroller.h"
+#include "qlowenergyconnectionmetrics.h"
+#include "qlowenergyconnectionparameterpolicy.h"
 #include "qbluetoothuuid.h"
 
 #include <QtCore/qloggingcategory.h>
@@ -1216,6 +1218,38 @@ void QLowEnergyController::discoverServices()
     osx_d_ptr->discoverServices();
 }
 
+void QLowEnergyController::discoverServices(const QList<QBluetoothUuid> &filter)
+{
+    // The filter is not supported by this backend, all services are discovered.
+    Q_UNUSED(filter)
+
+    discoverServices();
+}
+
+void QLowEnergyController::discoverAllServiceDetails(QLowEnergyService::DiscoveryMode mode)
+{
+    if (role() == PeripheralRole) {
+        qCWarning(QT_BT_OSX) << "invalid role (peripheral)";
+        return;
+    }
+
+    if (state() != DiscoveredState)
+        return;
+
+    OSX_D_PTR;
+
+    // Core Bluetooth discovers the details of one service after another.
+    const QList<QBluetoothUuid> services(osx_d_ptr->discoveredServices.keys());
+    for (const QBluetoothUuid &uuid : services) {
+        ServicePrivate qtService(osx_d_ptr->discoveredServices.value(uuid));
+        if (qtService->state != QLowEnergyService::DiscoveryRequired)
+            continue;
+
+        qtService->discoveryMode = mode;
+        osx_d_ptr->discoverServiceDetails(uuid);
+    }
+}
+
 QList<QBluetoothUuid> QLowEnergyController::services() const
 {
     OSX_D_PTR;
@@ -1380,6 +1414,43 @@ void QLowEnergyController::requestConnectionUpdate(const QLowEnergyConnectionPar
     qCWarning(QT_BT_OSX) << "Connection update not implemented on your platform";
 }
 
+void QLowEnergyController::setMetricsEnabled(bool enabled)
+{
+    Q_UNUSED(enabled);
+    qCWarning(QT_BT_OSX) << "Connection metrics not implemented on your platform";
+}
+
+bool QLowEnergyController::isMetricsEnabled() const
+{
+    return false;
+}
+
+QLowEnergyConnectionMetrics QLowEnergyController::metrics() const
+{
+    return QLowEnergyConnectionMetrics();
+}
+
+void QLowEnergyController::setConnectionParameterPolicy(
+        const QLowEnergyConnectionParameterPolicy &policy)
+{
+    Q_UNUSED(policy);
+    qCWarning(QT_BT_OSX) << "Connection parameter policy not implemented on your platform";
+}
+
+void QLowEnergyController::clearConnectionParameterPolicy()
+{
+}
+
+bool QLowEnergyController::hasConnectionParameterPolicy() const
+{
+    return false;
+}
+
+QLowEnergyConnectionParameterPolicy QLowEnergyController::connectionParameterPolicy() const
+{
+    return QLowEnergyConnectionParameterPolicy();
+}
+
 QT_END_NAMESPACE
 
 #include "moc_qlowenergycontroller_osx_p.cpp"
@@ -92,6 +92,11 @@ void QLowEnergyControllerPrivate::discoverServiceDetails(const QBluetoothUuid &/
 
 }
 
+void QLowEnergyControllerPrivate::discoverAllServiceDetails(const QList<QBluetoothUuid> &/*services*/)
+{
+
+}
+
 void QLowEnergyControllerPrivate::readCharacteristic(const QSharedPointer<QLowEnergyServicePrivate> /*service*/,
                         const QLowEnergyHandle /*charHandle*/)
 {
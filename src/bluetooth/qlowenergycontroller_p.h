@@ -70,15 +70,18 @@ QT_END_NAMESPACE
 #else
 
 #include <qglobal.h>
-#include <QtCore/QQueue>
 #include <QtCore/QVector>
 #include <QtBluetooth/qbluetooth.h>
 #include <QtBluetooth/qlowenergycharacteristic.h>
 #include "qlowenergycontroller.h"
 #include "qlowenergyserviceprivate_p.h"
+#include "qlowenergyconnectionmetrics_p.h"
 
 #if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
 #include <QtBluetooth/QBluetoothSocket>
+#include <QtCore/QElapsedTimer>
+#include "bluez/roundtriptimeestimator_p.h"
+#include "bluez/connectionparametertuner_p.h"
 #elif defined(QT_ANDROID_BLUETOOTH)
 #include <QtAndroidExtras/QAndroidJniObject>
 #include "android/lowenergynotificationhub_p.h"
@@ -99,6 +102,7 @@ class HciManager;
 class LeCmacCalculator;
 class QSocketNotifier;
 class RemoteDeviceManager;
+class SignCounterStore;
 #elif defined(QT_ANDROID_BLUETOOTH)
 class LowEnergyNotificationHub;
 #elif defined(QT_WINRT_BLUETOOTH)
@@ -132,6 +136,7 @@ public:
     void invalidateServices();
 
     void discoverServiceDetails(const QBluetoothUuid &service);
+    void discoverAllServiceDetails(const QList<QBluetoothUuid> &services);
 
     void startAdvertising(const QLowEnergyAdvertisingParameters &params,
                           const QLowEnergyAdvertisingData &advertisingData,
@@ -189,6 +194,8 @@ public:
 
     // list of all found service uuids on remote device
     ServiceDataMap serviceList;
+    // services to look for in the current discovery, all services if empty
+    QList<QBluetoothUuid> serviceDiscoveryFilter;
 
     QLowEnergyHandle lastLocalHandle;
     // list of all service uuids on local peripheral device
@@ -211,19 +218,112 @@ public:
 
     QLowEnergyController::RemoteAddressType addressType;
 
-private:
 #if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
-    quint16 connectionHandle = 0;
-    QBluetoothSocket *l2cpSocket;
+    // PDUs up to the default ATT MTU are stored inline, longer ones share a QByteArray
+    class Payload
+    {
+    public:
+        enum { InlineSize = 23 };
+
+        Payload &operator=(const QByteArray &data)
+        {
+            if (data.size() <= InlineSize) {
+                assign(data.constData(), data.size());
+            } else {
+                heapData = data;
+                length = data.size();
+            }
+            return *this;
+        }
+        void assign(const void *data, int size)
+        {
+            if (size <= InlineSize) {
+                memcpy(inlineData, data, size);
+                heapData.clear();
+            } else {
+                heapData = QByteArray(static_cast<const char *>(data), size);
+            }
+            length = size;
+        }
+
+        const char *constData() const
+        { return length <= InlineSize ? inlineData : heapData.constData(); }
+        int size() const { return length; }
+        QByteArray toByteArray() const { return QByteArray(constData(), length); }
+
+    private:
+        char inlineData[InlineSize];
+        int length = 0;
+        QByteArray heapData;
+    };
+
     struct Request {
-        quint8 command;
-        QByteArray payload;
-        // TODO reference below is ugly but until we know all commands and their
-        // requirements this is WIP
-        QVariant reference;
-        QVariant reference2;
+        quint8 command = 0;
+        Payload payload;
+
+        // What the request refers to. Which members are used depends on the command:
+        //  READ_BY_GROUP:      attributeType
+        //  FIND_BY_TYPE_VALUE: serviceUuid, isLastValue
+        //  READ_BY_TYPE:       service (null for discoverAllServiceDetails()), attributeType
+        //  READ, READ_BLOB:    charHandle, descriptorHandle, isLastValue; or service (null
+        //                      for discoverAllServiceDetails()), attributeType and
+        //                      attributeHandle when reading the uuid of an included service
+        //  FIND_INFORMATION:   service (null for discoverAllServiceDetails()),
+        //                      pendingCharHandles, startingHandle
+        //  WRITE:              charHandle, descriptorHandle, value
+        //  PREPARE_WRITE:      attributeHandle, writtenLength, value
+        //  EXECUTE_WRITE:      attributeHandle, isCancelation, value
+        QLowEnergyHandle charHandle = 0;
+        QLowEnergyHandle descriptorHandle = 0;
+        QLowEnergyHandle attributeHandle = 0;
+        QLowEnergyHandle startingHandle = 0;
+        quint16 attributeType = 0;
+        quint16 writtenLength = 0;
+        bool isLastValue = false;
+        bool isCancelation = false;
+        QBluetoothUuid serviceUuid;
+        QSharedPointer<QLowEnergyServicePrivate> service;
+        QList<QLowEnergyHandle> pendingCharHandles;
+        // shares the data of the written value, even across all requests of a long write
+        QByteArray value;
+    };
+
+    // Ring buffer of requests; it only allocates when it grows beyond its largest size so far.
+    class Q_AUTOTEST_EXPORT RequestQueue
+    {
+    public:
+        RequestQueue() : ring(16) {}
+
+        bool isEmpty() const { return used == 0; }
+        int count() const { return used; }
+        const Request &head() const { return ring.at(first); }
+
+        void enqueue(const Request &request);
+        void prepend(const Request &request);
+        Request dequeue();
+        Request dequeueTimedOut();
+        void clear();
+
+        enum ResponseMatch { HeadResponse, LateResponse, UnexpectedResponse };
+        ResponseMatch matchResponse(const QByteArray &response, bool headSent);
+
+    private:
+        void reserveOne();
+
+        QVector<Request> ring;
+        int first = 0;
+        int used = 0;
+        // commands of timed out requests whose response may still arrive
+        QVector<quint8> lateCommands;
     };
-    QQueue<Request> openRequests;
+
+private:
+    quint16 connectionHandle = 0;
+    QBluetoothSocket *l2cpSocket;
+    RequestQueue openRequests;
+
+    // services of the running discoverAllServiceDetails(), sorted by start handle
+    QVector<QSharedPointer<QLowEnergyServicePrivate> > databaseDiscoveryServices;
 
     struct WriteRequest {
         WriteRequest() {}
@@ -271,6 +371,12 @@ private:
     };
     QHash<quint64, SigningData> signingData;
     LeCmacCalculator *cmacCalculator = nullptr;
+    SignCounterStore *signCounterStore = nullptr;
+
+    // null unless QLowEnergyController::setMetricsEnabled() was called
+    QScopedPointer<QLowEnergyConnectionMetricsPrivate> metrics;
+    // null unless QLowEnergyController::setConnectionParameterPolicy() was called
+    ConnectionParameterTuner *connectionTuner = nullptr;
 
     bool requestPending;
     quint16 mtuSize;
@@ -298,8 +404,15 @@ private:
       appropriate response. Potentially this can cause problems when the
       response for the dropped requests arrives very late. That's why a big warning
       is printed about the compromised state when a timeout is triggered.
+
+      The actual timeout is derived from the round trip times of the answered
+      requests and only bounded by this value, see requestTimeoutEstimator.
      */
     int gattRequestTimeout = 20000;
+    int minimumGattRequestTimeout = 1000;
+    RoundTripTimeEstimator requestTimeoutEstimator;
+    // measures the pending request, invalid if its round trip must not be sampled
+    QElapsedTimer requestRoundTrip;
 
     void handleConnectionRequest();
     void closeServerSocket();
@@ -311,28 +424,39 @@ private:
 
     enum SigningKeyType { LocalSigningKey, RemoteSigningKey };
     void loadSigningDataIfNecessary(SigningKeyType keyType);
-    void storeSignCounter(SigningKeyType keyType) const;
-    QString signingKeySettingsGroup(SigningKeyType keyType) const;
+    void storeSignCounter(SigningKeyType keyType);
+    SignCounterStore *signCounterStoreForPeer();
     QString keySettingsFilePath() const;
 
-    void sendPacket(const QByteArray &packet);
+    void sendPacket(const char *packet, int size);
+    void sendPacket(const QByteArray &packet) { sendPacket(packet.constData(), packet.size()); }
     void sendNextPendingRequest();
     void processReply(const Request &request, const QByteArray &reply);
 
     void sendReadByGroupRequest(QLowEnergyHandle start, QLowEnergyHandle end,
                                 quint16 type);
+    void sendFindByTypeValueRequest(const QBluetoothUuid &serviceUuid, bool isLastValue);
     void sendReadByTypeRequest(QSharedPointer<QLowEnergyServicePrivate> serviceData,
                                QLowEnergyHandle nextHandle, quint16 attributeType);
+    void readIncludedServiceUuid(QSharedPointer<QLowEnergyServicePrivate> serviceData,
+                                 QLowEnergyHandle declarationHandle,
+                                 QLowEnergyHandle startHandle);
     void sendReadValueRequest(QLowEnergyHandle attributeHandle, bool isDescriptor);
     void readServiceValues(const QBluetoothUuid &service,
                            bool readCharacteristics);
-    void readServiceValuesByOffset(uint handleData, quint16 offset,
+    void readServiceValuesByOffset(QLowEnergyHandle charHandle,
+                                   QLowEnergyHandle descriptorHandle, quint16 offset,
                                    bool isLastValue);
 
     void discoverServiceDescriptors(const QBluetoothUuid &serviceUuid);
     void discoverNextDescriptor(QSharedPointer<QLowEnergyServicePrivate> serviceData,
                                 const QList<QLowEnergyHandle> pendingCharHandles,
                                 QLowEnergyHandle startingHandle);
+    QSharedPointer<QLowEnergyServicePrivate> databaseServiceForHandle(
+            QLowEnergyHandle handle) const;
+    void discoverNextDatabaseDescriptor(QList<QLowEnergyHandle> pendingCharHandles,
+                                        quint32 nextHandle);
+    void readDatabaseValues();
     void processUnsolicitedReply(const QByteArray &msg);
     void exchangeMTU();
     bool setSecurityLevel(int level);
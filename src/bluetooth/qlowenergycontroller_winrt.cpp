@@ -657,6 +657,13 @@ void QLowEnergyControllerPrivate::discoverServiceDetails(const QBluetoothUuid &s
     thread->start();
 }
 
+void QLowEnergyControllerPrivate::discoverAllServiceDetails(const QList<QBluetoothUuid> &services)
+{
+    // every service is discovered by a worker thread of its own
+    foreach (const QBluetoothUuid &uuid, services)
+        discoverServiceDetails(uuid);
+}
+
 void QLowEnergyControllerPrivate::startAdvertising(const QLowEnergyAdvertisingParameters &, const QLowEnergyAdvertisingData &, const QLowEnergyAdvertisingData &)
 {
     setError(QLowEnergyController::AdvertisingError);
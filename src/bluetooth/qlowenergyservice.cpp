@@ -270,6 +270,25 @@ QT_BEGIN_NAMESPACE
                                 3.7 or newer.
  */
 
+/*!
+  \enum QLowEnergyService::DiscoveryMode
+  \since 5.11
+
+  This enum describes the amount of work done by \l discoverDetails().
+
+  \value FullDiscovery          All included services, characteristics and descriptors are
+                                discovered and the values of all readable characteristics and
+                                all descriptors are read before the service enters the
+                                \l ServiceDiscovered state.
+  \value SkipValueDiscovery     Only the handles, UUIDs and properties of the included services,
+                                characteristics and descriptors are discovered. Their values
+                                remain empty until they are read via \l readCharacteristic() or
+                                \l readDescriptor(). This reduces the time needed to discover
+                                services with many or long values. The mode is currently only
+                                supported on Linux with BlueZ; other platforms perform a
+                                \l FullDiscovery.
+ */
+
 /*!
     \fn void QLowEnergyService::stateChanged(QLowEnergyService::ServiceState newState)
 
@@ -557,9 +576,26 @@ QString QLowEnergyService::serviceName() const
     and descriptors contained by the service. The discovery process is indicated
     via the \l stateChanged() signal.
 
+    This is equivalent to calling discoverDetails() with \l FullDiscovery.
+
     \sa state()
  */
 void QLowEnergyService::discoverDetails()
+{
+    discoverDetails(FullDiscovery);
+}
+
+/*!
+    \overload
+    \since 5.11
+
+    Initiates the discovery of the services, characteristics
+    and descriptors contained by the service using the given discovery \a mode.
+    The discovery process is indicated via the \l stateChanged() signal.
+
+    \sa state(), DiscoveryMode
+ */
+void QLowEnergyService::discoverDetails(DiscoveryMode mode)
 {
     Q_D(QLowEnergyService);
 
@@ -571,6 +607,7 @@ void QLowEnergyService::discoverDetails()
     if (d->state != QLowEnergyService::DiscoveryRequired)
         return;
 
+    d->discoveryMode = mode;
     d->setState(QLowEnergyService::DiscoveringServices);
 
     d->controller->discoverServiceDetails(d->uuid);
@@ -584,6 +621,26 @@ QLowEnergyService::ServiceError QLowEnergyService::error() const
     return d_ptr->lastError;
 }
 
+/*!
+    Returns the time at which the last notification or indication of this service
+    arrived at the local Bluetooth device, in nanoseconds since
+    1970-01-01T00:00:00 UTC. Returns -1 if no notification has been received yet
+    or the time is unknown.
+
+    The time is taken by the kernel, not by the event loop which delivers the
+    notification. When called from a slot connected to \l characteristicChanged(),
+    it refers to the notification which is being delivered.
+
+    \note Currently, this functionality is only implemented on Linux.
+
+    \sa characteristicChanged(), QBluetoothSocket::lastReceiveTimestamp()
+    \since 5.11
+ */
+qint64 QLowEnergyService::lastNotificationTimestamp() const
+{
+    return d_ptr->lastNotificationTimestamp;
+}
+
 /*!
     Returns \c true if \a characteristic belongs to this service;
     otherwise \c false.
@@ -87,6 +87,12 @@ public:
     };
     Q_ENUM(WriteMode)
 
+    enum DiscoveryMode {
+        FullDiscovery = 0,
+        SkipValueDiscovery
+    };
+    Q_ENUM(DiscoveryMode)
+
     ~QLowEnergyService();
 
     QList<QBluetoothUuid> includedServices() const;
@@ -100,9 +106,12 @@ public:
     QString serviceName() const;
 
     void discoverDetails();
+    void discoverDetails(DiscoveryMode mode);
 
     ServiceError error() const;
 
+    qint64 lastNotificationTimestamp() const;
+
     bool contains(const QLowEnergyCharacteristic &characteristic) const;
     void readCharacteristic(const QLowEnergyCharacteristic &characteristic);
     void writeCharacteristic(const QLowEnergyCharacteristic &characteristic,
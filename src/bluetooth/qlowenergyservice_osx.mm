@@ -159,6 +159,11 @@ QString QLowEnergyService::serviceName() const
 }
 
 void QLowEnergyService::discoverDetails()
+{
+    discoverDetails(FullDiscovery);
+}
+
+void QLowEnergyService::discoverDetails(DiscoveryMode mode)
 {
     QLowEnergyControllerPrivateOSX *const controller = qt_mac_le_controller(d_ptr);
 
@@ -170,6 +175,7 @@ void QLowEnergyService::discoverDetails()
     if (d_ptr->state != DiscoveryRequired)
         return;
 
+    d_ptr->discoveryMode = mode;
     d_ptr->setState(QLowEnergyService::DiscoveringServices);
     controller->discoverServiceDetails(d_ptr->uuid);
 }
@@ -179,6 +185,11 @@ QLowEnergyService::ServiceError QLowEnergyService::error() const
     return d_ptr->lastError;
 }
 
+qint64 QLowEnergyService::lastNotificationTimestamp() const
+{
+    return d_ptr->lastNotificationTimestamp;
+}
+
 bool QLowEnergyService::contains(const QLowEnergyCharacteristic &characteristic) const
 {
     if (characteristic.d_ptr.isNull() || !characteristic.data)
@@ -49,7 +49,9 @@ QLowEnergyServicePrivate::QLowEnergyServicePrivate(QObject *parent) :
     endHandle(0),
     type(QLowEnergyService::PrimaryService),
     state(QLowEnergyService::InvalidService),
-    lastError(QLowEnergyService::NoError)
+    lastError(QLowEnergyService::NoError),
+    discoveryMode(QLowEnergyService::FullDiscovery),
+    lastNotificationTimestamp(-1)
 {
 }
 
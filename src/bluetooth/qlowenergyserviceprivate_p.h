@@ -119,6 +119,9 @@ public:
     QLowEnergyService::ServiceTypes type;
     QLowEnergyService::ServiceState state;
     QLowEnergyService::ServiceError lastError;
+    QLowEnergyService::DiscoveryMode discoveryMode;
+    // nanoseconds since the epoch, -1 if unknown
+    qint64 lastNotificationTimestamp;
 
     QHash<QLowEnergyHandle, CharData> characteristicList;
 
@@ -81,6 +81,11 @@ public:
         qmlRegisterType<QDeclarativeBluetoothService        >(uri, major, minor, "BluetoothService");
         qmlRegisterType<QDeclarativeBluetoothSocket         >(uri, major, minor, "BluetoothSocket");
 
+        // Register the 5.11 types
+        minor = 11;
+        qmlRegisterType<QDeclarativeBluetoothDiscoveryModel, 1>(uri, major, minor, "BluetoothDiscoveryModel");
+        qmlRegisterType<QDeclarativeBluetoothSocket, 1      >(uri, major, minor, "BluetoothSocket");
+
         // Register the latest Qt version as QML type version
         qmlRegisterModule(uri, QT_VERSION_MAJOR, QT_VERSION_MINOR);
     }
@@ -42,7 +42,9 @@
 
 #include <QPixmap>
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QTimer>
 #include <QtBluetooth/QBluetoothDeviceInfo>
 #include <QtBluetooth/QBluetoothAddress>
 
@@ -61,8 +63,13 @@
     limited to a single service such as a game.
 
     The model roles provided by BluetoothDiscoveryModel are
-    \c service, \c name, \c remoteAddress and \c deviceName. The meaning of the roles
-    changes based on the current \l discoveryMode.
+    \c service, \c name, \c remoteAddress, \c deviceName and \c rssi. The meaning of
+    the roles changes based on the current \l discoveryMode.
+
+    Every device and every service is listed only once. If a known device is seen
+    again, its row is updated in place and views are notified about the changed roles.
+    Rows which have not been seen for a while can be removed automatically by setting
+    \l expiryTimeout.
 
     \table
         \header
@@ -85,6 +92,11 @@
             \li \c remoteAddress
             \li The address of the found device.
             \li The address of the device offering the service.
+         \row
+            \li \c rssi
+            \li The signal strength of the device in dBm, as of its last sighting.
+                 This role was introduced by Qt 5.11.
+            \li The role is undefined in this mode.
     \endtable
 
     \sa QBluetoothServiceDiscoveryAgent
@@ -105,8 +117,10 @@ public:
         m_componentCompleted(false),
         m_currentState(QDeclarativeBluetoothDiscoveryModel::IdleAction),
         m_nextState(QDeclarativeBluetoothDiscoveryModel::IdleAction),
-        m_wasDirectDeviceAgentCancel(false)
+        m_wasDirectDeviceAgentCancel(false),
+        m_expiryTimeout(0)
     {
+        m_clock.start();
     }
     ~QDeclarativeBluetoothDiscoveryModelPrivate()
     {
@@ -125,6 +139,12 @@ public:
     QDeclarativeBluetoothDiscoveryModel::Error m_error;
     QList<QDeclarativeBluetoothService *> m_services;
     QList<QBluetoothDeviceInfo> m_devices;
+    // rows of m_services and m_devices by serviceKey() and device address
+    QHash<QString, int> m_serviceRows;
+    QHash<quint64, int> m_deviceRows;
+    // time of the last sighting of every row, see m_clock
+    QVector<qint64> m_serviceLastSeen;
+    QVector<qint64> m_deviceLastSeen;
     QDeclarativeBluetoothDiscoveryModel::DiscoveryMode m_discoveryMode;
     QString m_uuid;
     bool m_running;
@@ -135,8 +155,40 @@ public:
     QDeclarativeBluetoothDiscoveryModel::Action m_currentState;
     QDeclarativeBluetoothDiscoveryModel::Action m_nextState;
     bool m_wasDirectDeviceAgentCancel;
+
+    int m_expiryTimeout;
+    QElapsedTimer m_clock;
+    QTimer m_expiryTimer;
+
+    static QString serviceKey(const QBluetoothServiceInfo &service);
+    void rebuildRows();
 };
 
+/*!
+    Returns the key under which \a service is listed in m_serviceRows. Services are
+    identified by the address of their device, their name and their UUID.
+*/
+QString QDeclarativeBluetoothDiscoveryModelPrivate::serviceKey(const QBluetoothServiceInfo &service)
+{
+    return service.device().address().toString() + QLatin1Char('\n')
+            + service.serviceUuid().toString() + QLatin1Char('\n')
+            + service.serviceName();
+}
+
+/*!
+    Recreates the row indices after rows have been removed.
+*/
+void QDeclarativeBluetoothDiscoveryModelPrivate::rebuildRows()
+{
+    m_serviceRows.clear();
+    for (int i = 0; i < m_services.count(); ++i)
+        m_serviceRows.insert(serviceKey(*m_services.at(i)->serviceInfo()), i);
+
+    m_deviceRows.clear();
+    for (int i = 0; i < m_devices.count(); ++i)
+        m_deviceRows.insert(m_devices.at(i).address().toUInt64(), i);
+}
+
 QDeclarativeBluetoothDiscoveryModel::QDeclarativeBluetoothDiscoveryModel(QObject *parent) :
     QAbstractListModel(parent),
     d(new QDeclarativeBluetoothDiscoveryModelPrivate)
@@ -144,6 +196,9 @@ QDeclarativeBluetoothDiscoveryModel::QDeclarativeBluetoothDiscoveryModel(QObject
     d->m_deviceAgent = new QBluetoothDeviceDiscoveryAgent(this);
     connect(d->m_deviceAgent, SIGNAL(deviceDiscovered(QBluetoothDeviceInfo)),
             this, SLOT(deviceDiscovered(QBluetoothDeviceInfo)));
+    connect(d->m_deviceAgent,
+            SIGNAL(deviceUpdated(QBluetoothDeviceInfo,QBluetoothDeviceInfo::Fields)),
+            this, SLOT(deviceUpdated(QBluetoothDeviceInfo)));
     connect(d->m_deviceAgent, SIGNAL(finished()), this, SLOT(finishedDiscovery()));
     connect(d->m_deviceAgent, SIGNAL(canceled()), this, SLOT(finishedDiscovery()));
     connect(d->m_deviceAgent, SIGNAL(error(QBluetoothDeviceDiscoveryAgent::Error)),
@@ -165,7 +220,10 @@ QDeclarativeBluetoothDiscoveryModel::QDeclarativeBluetoothDiscoveryModel(QObject
     roleNames.insert(ServiceRole, "service");
     roleNames.insert(RemoteAddress, "remoteAddress");
     roleNames.insert(DeviceName, "deviceName");
+    roleNames.insert(Rssi, "rssi");
     setRoleNames(roleNames);
+
+    connect(&d->m_expiryTimer, SIGNAL(timeout()), this, SLOT(removeExpiredRows()));
 }
 
 QDeclarativeBluetoothDiscoveryModel::~QDeclarativeBluetoothDiscoveryModel()
@@ -214,9 +272,23 @@ void QDeclarativeBluetoothDiscoveryModel::clearModel()
     qDeleteAll(d->m_services);
     d->m_services.clear();
     d->m_devices.clear();
+    d->m_serviceRows.clear();
+    d->m_deviceRows.clear();
+    d->m_serviceLastSeen.clear();
+    d->m_deviceLastSeen.clear();
+    d->m_expiryTimer.stop();
     endResetModel();
 }
 
+/*!
+    Starts the expiry timer after a row has been inserted or seen again.
+*/
+void QDeclarativeBluetoothDiscoveryModel::rowsSeen()
+{
+    if (d->m_expiryTimeout > 0 && !d->m_expiryTimer.isActive())
+        d->m_expiryTimer.start();
+}
+
 /*!
     \qmlproperty enumeration BluetoothDiscoveryModel::error
 
@@ -301,6 +373,8 @@ QVariant QDeclarativeBluetoothDiscoveryModel::data(const QModelIndex &index, int
                 return device.name();
             case RemoteAddress:
                 return device.address().toString();
+            case Rssi:
+                return device.rssi();
         }
     }
 
@@ -322,21 +396,21 @@ void QDeclarativeBluetoothDiscoveryModel::serviceDiscovered(const QBluetoothServ
 {
     //qDebug() << "service discovered";
 
-    QDeclarativeBluetoothService *bs = new QDeclarativeBluetoothService(service, this);
-    QDeclarativeBluetoothService *current = 0;
-    for (int i = 0; i < d->m_services.count(); i++) {
-        current = d->m_services.at(i);
-        if (bs->deviceAddress() == current->deviceAddress()
-                && bs->serviceName() == current->serviceName()
-                && bs->serviceUuid() == current->serviceUuid()) {
-            delete bs;
-            return;
-        }
+    const QString key = QDeclarativeBluetoothDiscoveryModelPrivate::serviceKey(service);
+    const int row = d->m_serviceRows.value(key, -1);
+    if (row != -1) {
+        d->m_serviceLastSeen[row] = d->m_clock.elapsed();
+        return;
     }
 
+    QDeclarativeBluetoothService *bs = new QDeclarativeBluetoothService(service, this);
+
     beginInsertRows(QModelIndex(),d->m_services.count(), d->m_services.count());
+    d->m_serviceRows.insert(key, d->m_services.count());
     d->m_services.append(bs);
+    d->m_serviceLastSeen.append(d->m_clock.elapsed());
     endInsertRows();
+    rowsSeen();
     emit serviceDiscovered(bs);
 }
 
@@ -344,7 +418,8 @@ void QDeclarativeBluetoothDiscoveryModel::serviceDiscovered(const QBluetoothServ
   \qmlsignal BluetoothDiscoveryModel::deviceDiscovered(string device)
 
   This signal is emitted when a new device is discovered. \a device contains
-  the Bluetooth address of the discovered device.
+  the Bluetooth address of the discovered device. It is not emitted again when
+  an already listed device is seen again.
 
   The corresponding handler is \c onDeviceDiscovered.
   */
@@ -353,12 +428,89 @@ void QDeclarativeBluetoothDiscoveryModel::deviceDiscovered(const QBluetoothDevic
 {
     //qDebug() << "Device discovered" << device.address().toString() << device.name();
 
+    if (d->m_deviceRows.contains(device.address().toUInt64())) {
+        deviceUpdated(device);
+        return;
+    }
+
     beginInsertRows(QModelIndex(),d->m_devices.count(), d->m_devices.count());
+    d->m_deviceRows.insert(device.address().toUInt64(), d->m_devices.count());
     d->m_devices.append(device);
+    d->m_deviceLastSeen.append(d->m_clock.elapsed());
     endInsertRows();
+    rowsSeen();
     emit deviceDiscovered(device.address().toString());
 }
 
+void QDeclarativeBluetoothDiscoveryModel::deviceUpdated(const QBluetoothDeviceInfo &device)
+{
+    const int row = d->m_deviceRows.value(device.address().toUInt64(), -1);
+    if (row == -1) {
+        deviceDiscovered(device);
+        return;
+    }
+
+    QBluetoothDeviceInfo &known = d->m_devices[row];
+    d->m_deviceLastSeen[row] = d->m_clock.elapsed();
+    rowsSeen();
+
+    QVector<int> roles;
+    // updates for LE advertisements may not carry the name
+    if (!device.name().isEmpty() && device.name() != known.name())
+        roles << Name << DeviceName;
+    if (device.rssi() != known.rssi())
+        roles << Rssi;
+
+    const QString name = known.name();
+    known = device;
+    if (known.name().isEmpty())
+        known.setName(name);
+
+    if (!roles.isEmpty() && discoveryMode() == DeviceDiscovery)
+        emit dataChanged(index(row), index(row), roles);
+}
+
+/*!
+    Removes the rows which have not been seen for longer than the expiry timeout.
+    Consecutive rows are removed together.
+*/
+void QDeclarativeBluetoothDiscoveryModel::removeExpiredRows()
+{
+    const bool devices = discoveryMode() == DeviceDiscovery;
+    QVector<qint64> &lastSeen = devices ? d->m_deviceLastSeen : d->m_serviceLastSeen;
+    const qint64 deadline = d->m_clock.elapsed() - d->m_expiryTimeout;
+
+    bool removed = false;
+    for (int last = lastSeen.count() - 1; last >= 0; --last) {
+        if (lastSeen.at(last) > deadline)
+            continue;
+
+        int first = last;
+        while (first > 0 && lastSeen.at(first - 1) <= deadline)
+            --first;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        lastSeen.remove(first, last - first + 1);
+        if (devices) {
+            d->m_devices.erase(d->m_devices.begin() + first, d->m_devices.begin() + last + 1);
+        } else {
+            for (int i = first; i <= last; ++i)
+                delete d->m_services.at(i);
+            d->m_services.erase(d->m_services.begin() + first, d->m_services.begin() + last + 1);
+        }
+        endRemoveRows();
+
+        removed = true;
+        last = first;
+    }
+
+    if (removed)
+        d->rebuildRows();
+
+    if (lastSeen.isEmpty())
+        d->m_expiryTimer.stop();
+}
+
 void QDeclarativeBluetoothDiscoveryModel::finishedDiscovery()
 {
     QDeclarativeBluetoothDiscoveryModel::Action previous = d->m_currentState;
@@ -642,3 +794,40 @@ void QDeclarativeBluetoothDiscoveryModel::setRemoteAddress(QString address)
     d->m_remoteAddress = address;
     emit remoteAddressChanged();
 }
+
+/*!
+    \qmlproperty int BluetoothDiscoveryModel::expiryTimeout
+    \since 5.11
+
+    This property holds the time in milliseconds after which a device or service that
+    has not been seen again is removed from the model. Rows of devices which are still
+    in range are kept because every new sighting restarts their timeout. Rows are
+    removed even after the discovery has finished.
+
+    The default value is \c 0, which means that rows are only removed when a new
+    discovery is started.
+*/
+
+int QDeclarativeBluetoothDiscoveryModel::expiryTimeout() const
+{
+    return d->m_expiryTimeout;
+}
+
+void QDeclarativeBluetoothDiscoveryModel::setExpiryTimeout(int timeout)
+{
+    timeout = qMax(0, timeout);
+    if (timeout == d->m_expiryTimeout)
+        return;
+
+    d->m_expiryTimeout = timeout;
+    if (timeout > 0) {
+        // stale rows are removed at most a quarter of the timeout late
+        d->m_expiryTimer.setInterval(qMax(timeout / 4, 100));
+        if (!d->m_serviceLastSeen.isEmpty() || !d->m_deviceLastSeen.isEmpty())
+            d->m_expiryTimer.start();
+    } else {
+        d->m_expiryTimer.stop();
+    }
+
+    emit expiryTimeoutChanged();
+}
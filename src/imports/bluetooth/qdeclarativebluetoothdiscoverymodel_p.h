@@ -75,6 +75,7 @@ class QDeclarativeBluetoothDiscoveryModel : public QAbstractListModel, public QQ
     Q_PROPERTY(bool running READ running WRITE setRunning NOTIFY runningChanged)
     Q_PROPERTY(QString uuidFilter READ uuidFilter WRITE setUuidFilter NOTIFY uuidFilterChanged)
     Q_PROPERTY(QString remoteAddress READ remoteAddress WRITE setRemoteAddress NOTIFY remoteAddressChanged)
+    Q_PROPERTY(int expiryTimeout READ expiryTimeout WRITE setExpiryTimeout NOTIFY expiryTimeoutChanged REVISION 1)
     Q_INTERFACES(QQmlParserStatus)
 public:
     explicit QDeclarativeBluetoothDiscoveryModel(QObject *parent = 0);
@@ -84,7 +85,8 @@ public:
         Name = Qt::UserRole + 1,
         ServiceRole,
         DeviceName,
-        RemoteAddress
+        RemoteAddress,
+        Rssi
     };
 
     enum DiscoveryMode {
@@ -128,6 +130,9 @@ public:
     QString remoteAddress();
     void setRemoteAddress(QString);
 
+    int expiryTimeout() const;
+    void setExpiryTimeout(int timeout);
+
 signals:
     void errorChanged();
     void discoveryModeChanged();
@@ -136,16 +141,20 @@ signals:
     void runningChanged();
     void uuidFilterChanged();
     void remoteAddressChanged();
+    Q_REVISION(1) void expiryTimeoutChanged();
 
 private slots:
     void serviceDiscovered(const QBluetoothServiceInfo &service);
     void deviceDiscovered(const QBluetoothDeviceInfo &device);
+    void deviceUpdated(const QBluetoothDeviceInfo &device);
+    void removeExpiredRows();
     void finishedDiscovery();
     void errorDiscovery(QBluetoothServiceDiscoveryAgent::Error error);
     void errorDeviceDiscovery(QBluetoothDeviceDiscoveryAgent::Error);
 
 private:
     void clearModel();
+    void rowsSeen();
 
     enum Action {
         IdleAction = 0,
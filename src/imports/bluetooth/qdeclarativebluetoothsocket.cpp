@@ -44,6 +44,7 @@
 #include <QtCore/QStringList>
 #include <QtCore/QDataStream>
 #include <QtCore/QByteArray>
+#include <QtCore/QTimer>
 
 #include <QtBluetooth/QBluetoothDeviceInfo>
 #include <QtBluetooth/QBluetoothAddress>
@@ -66,7 +67,7 @@
     decoded by non-Qt applications. Note that for the ease of use, BluetoothSocket
     is only well suited for use with strings. If you want to
     use a binary protocol for your application's communication you should
-    consider using its C++ counterpart QBluetoothSocket.
+    enable \l binaryMode or consider using its C++ counterpart QBluetoothSocket.
 
     Connections to remote devices can be over RFCOMM or L2CAP.  Either the remote port
     or service UUID is required.  This is specified by creating a BluetoothService,
@@ -83,7 +84,11 @@ public:
           m_error(QDeclarativeBluetoothSocket::NoError),
           m_state(QDeclarativeBluetoothSocket::NoServiceSet),
           m_componentCompleted(false),
-          m_connected(false)
+          m_connected(false),
+          m_binaryMode(false),
+          m_maxBatchSize(0),
+          m_maxBatchLatency(0),
+          m_batchTimer(0)
     {
 
     }
@@ -126,6 +131,10 @@ public:
     QDeclarativeBluetoothSocket::SocketState m_state;
     bool m_componentCompleted;
     bool m_connected;
+    bool m_binaryMode;
+    int m_maxBatchSize;
+    int m_maxBatchLatency;
+    QTimer *m_batchTimer;
 };
 
 QDeclarativeBluetoothSocket::QDeclarativeBluetoothSocket(QObject *parent) :
@@ -263,6 +272,12 @@ void QDeclarativeBluetoothSocket::socket_connected()
 
 void QDeclarativeBluetoothSocket::socket_disconnected()
 {
+    // hand out what is left before the socket goes away
+    if (d->m_binaryMode)
+        deliverData();
+    if (!d->m_socket)
+        return;
+
     d->m_socket->deleteLater();
     d->m_socket = 0;
     emit connectedChanged();
@@ -309,7 +324,51 @@ QDeclarativeBluetoothSocket::SocketState QDeclarativeBluetoothSocket::state() co
 
 void QDeclarativeBluetoothSocket::socket_readyRead()
 {
-    emit dataAvailable();
+    if (!d->m_binaryMode) {
+        emit dataAvailable();
+        return;
+    }
+
+    // full batches are delivered right away, the remainder once the latency expired
+    if (d->m_maxBatchSize > 0) {
+        while (d->m_socket && d->m_socket->bytesAvailable() >= d->m_maxBatchSize)
+            emit dataReceived(d->m_socket->read(d->m_maxBatchSize));
+    }
+
+    if (!d->m_socket || d->m_socket->bytesAvailable() == 0) {
+        if (d->m_batchTimer)
+            d->m_batchTimer->stop();
+        return;
+    }
+
+    if (d->m_maxBatchLatency <= 0) {
+        deliverData();
+        return;
+    }
+
+    if (!d->m_batchTimer) {
+        d->m_batchTimer = new QTimer(this);
+        d->m_batchTimer->setSingleShot(true);
+        connect(d->m_batchTimer, SIGNAL(timeout()), this, SLOT(deliverData()));
+    }
+
+    if (!d->m_batchTimer->isActive())
+        d->m_batchTimer->start(d->m_maxBatchLatency);
+}
+
+void QDeclarativeBluetoothSocket::deliverData()
+{
+    if (d->m_batchTimer)
+        d->m_batchTimer->stop();
+
+    // read() moves the data out of the socket buffer, the QByteArray is then
+    // shared with the ArrayBuffer handed to QML
+    while (d->m_socket && d->m_binaryMode && d->m_socket->bytesAvailable() > 0) {
+        qint64 size = d->m_socket->bytesAvailable();
+        if (d->m_maxBatchSize > 0)
+            size = qMin<qint64>(size, d->m_maxBatchSize);
+        emit dataReceived(d->m_socket->read(size));
+    }
 }
 
 /*!
@@ -351,6 +410,121 @@ void QDeclarativeBluetoothSocket::sendStringData(const QString &data)
     d->m_socket->write(text);
 }
 
+/*!
+    \qmlproperty bool BluetoothSocket::binaryMode
+    \since 5.11
+
+    This property holds whether received data is delivered as binary data by the
+    \l dataReceived() signal. If \c false, which is the default, received data
+    is read as text lines through \l stringData.
+
+    \sa maximumBatchSize, maximumBatchLatency
+*/
+
+bool QDeclarativeBluetoothSocket::binaryMode() const
+{
+    return d->m_binaryMode;
+}
+
+void QDeclarativeBluetoothSocket::setBinaryMode(bool enabled)
+{
+    if (d->m_binaryMode == enabled)
+        return;
+
+    d->m_binaryMode = enabled;
+    if (!enabled && d->m_batchTimer)
+        d->m_batchTimer->stop();
+    emit binaryModeChanged();
+
+    if (enabled && d->m_socket && d->m_socket->bytesAvailable() > 0)
+        socket_readyRead();
+}
+
+/*!
+    \qmlproperty int BluetoothSocket::maximumBatchSize
+    \since 5.11
+
+    This property holds the maximum number of bytes passed to a single
+    \l dataReceived() signal in \l binaryMode. As soon as this many bytes are
+    available they are delivered, without waiting for \l maximumBatchLatency.
+    Protocols with fixed size frames can set it to the frame size.
+
+    The default value \c 0 imposes no limit.
+*/
+
+int QDeclarativeBluetoothSocket::maximumBatchSize() const
+{
+    return d->m_maxBatchSize;
+}
+
+void QDeclarativeBluetoothSocket::setMaximumBatchSize(int size)
+{
+    size = qMax(0, size);
+    if (d->m_maxBatchSize == size)
+        return;
+
+    d->m_maxBatchSize = size;
+    emit maximumBatchSizeChanged();
+}
+
+/*!
+    \qmlproperty int BluetoothSocket::maximumBatchLatency
+    \since 5.11
+
+    This property holds the time in milliseconds received data may be held back
+    in \l binaryMode to combine it with data arriving later. Fewer, larger
+    \l dataReceived() signals reduce the overhead of calling into JavaScript
+    for fast data streams.
+
+    The default value \c 0 delivers the data as soon as it arrives.
+
+    \sa maximumBatchSize
+*/
+
+int QDeclarativeBluetoothSocket::maximumBatchLatency() const
+{
+    return d->m_maxBatchLatency;
+}
+
+void QDeclarativeBluetoothSocket::setMaximumBatchLatency(int latency)
+{
+    latency = qMax(0, latency);
+    if (d->m_maxBatchLatency == latency)
+        return;
+
+    d->m_maxBatchLatency = latency;
+    emit maximumBatchLatencyChanged();
+}
+
+/*!
+    \qmlsignal BluetoothSocket::dataReceived(ArrayBuffer data)
+    \since 5.11
+
+    This signal is emitted in \l binaryMode when \a data was received from
+    the remote device. The corresponding handler is \c onDataReceived.
+
+    \sa maximumBatchSize, maximumBatchLatency
+*/
+
+/*!
+    \qmlmethod BluetoothSocket::sendData(ArrayBuffer data)
+    \since 5.11
+
+    Transmits \a data to the remote device as is, without any encoding or line
+    termination. If excessive amounts of data are sent, the function may block
+    sending.
+*/
+
+void QDeclarativeBluetoothSocket::sendData(const QByteArray &data)
+{
+    if (!d->m_connected || !d->m_socket) {
+        qCWarning(QT_BT_QML) << "Writing data to unconnected socket";
+        return;
+    }
+
+    d->m_socket->write(data);
+}
+
 void QDeclarativeBluetoothSocket::newSocket(QBluetoothSocket *socket, QDeclarativeBluetoothService *service)
 {
     if (d->m_socket){
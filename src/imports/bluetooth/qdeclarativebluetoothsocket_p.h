@@ -72,6 +72,9 @@ class QDeclarativeBluetoothSocket : public QObject, public QQmlParserStatus
     Q_PROPERTY(Error error READ error NOTIFY errorChanged)
     Q_PROPERTY(SocketState socketState READ state NOTIFY stateChanged)
     Q_PROPERTY(QString stringData READ stringData WRITE sendStringData NOTIFY dataAvailable)
+    Q_PROPERTY(bool binaryMode READ binaryMode WRITE setBinaryMode NOTIFY binaryModeChanged REVISION 1)
+    Q_PROPERTY(int maximumBatchSize READ maximumBatchSize WRITE setMaximumBatchSize NOTIFY maximumBatchSizeChanged REVISION 1)
+    Q_PROPERTY(int maximumBatchLatency READ maximumBatchLatency WRITE setMaximumBatchLatency NOTIFY maximumBatchLatencyChanged REVISION 1)
     Q_INTERFACES(QQmlParserStatus)
 
 public:
@@ -112,6 +115,13 @@ public:
 
     QString stringData();
 
+    bool binaryMode() const;
+    void setBinaryMode(bool enabled);
+    int maximumBatchSize() const;
+    void setMaximumBatchSize(int size);
+    int maximumBatchLatency() const;
+    void setMaximumBatchLatency(int latency);
+
     // From QDeclarativeParserStatus
     void classBegin() {}
     void componentComplete();
@@ -124,11 +134,16 @@ signals:
     void errorChanged();
     void stateChanged();
     void dataAvailable();
+    Q_REVISION(1) void binaryModeChanged();
+    Q_REVISION(1) void maximumBatchSizeChanged();
+    Q_REVISION(1) void maximumBatchLatencyChanged();
+    Q_REVISION(1) void dataReceived(const QByteArray &data);
 
 public slots:
     void setService(QDeclarativeBluetoothService *service);
     void setConnected(bool connected);
     void sendStringData(const QString& data);
+    Q_REVISION(1) void sendData(const QByteArray &data);
 
 private slots:
     void socket_connected();
@@ -136,6 +151,7 @@ private slots:
     void socket_error(QBluetoothSocket::SocketError);
     void socket_state(QBluetoothSocket::SocketState);
     void socket_readyRead();
+    void deliverData();
 
 private:
     QDeclarativeBluetoothSocketPrivate* d;
@@ -148,9 +148,45 @@ QT_BEGIN_NAMESPACE
     \sa Q_DECLARE_NDEF_RECORD()
 */
 
+/*!
+    \internal
+
+    Returns the hash of the record contents. The hash is calculated once and cached until the
+    record is modified.
+*/
+uint QNdefRecordPrivate::contentHash() const
+{
+    uint h = hash.load();
+    if (h)
+        return h;
+
+    // combine the field hashes, see QtPrivate::QHashCombine
+    h = typeNameFormat;
+    h ^= qHash(type) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= qHash(id) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= qHash(payload) + 0x9e3779b9 + (h << 6) + (h >> 2);
+
+    // 0 marks an invalid hash
+    if (!h)
+        h = 1;
+
+    hash.store(h);
+
+    return h;
+}
+
+/*!
+    \relates QNdefRecord
+
+    Returns the hash value for \a key. The hash is cached in the record and only recalculated after
+    the record has been modified.
+*/
 uint qHash(const QNdefRecord &key)
 {
-    return qHash(key.type() + key.id() + key.payload());
+    if (!key.d)
+        return 0;
+
+    return key.d->contentHash();
 }
 
 /*!
@@ -244,6 +280,7 @@ void QNdefRecord::setTypeNameFormat(TypeNameFormat typeNameFormat)
         d = new QNdefRecordPrivate;
 
     d->typeNameFormat = typeNameFormat;
+    d->invalidateHash();
 }
 
 /*!
@@ -269,6 +306,7 @@ void QNdefRecord::setType(const QByteArray &type)
         d = new QNdefRecordPrivate;
 
     d->type = type;
+    d->invalidateHash();
 }
 
 /*!
@@ -291,6 +329,7 @@ void QNdefRecord::setId(const QByteArray &id)
         d = new QNdefRecordPrivate;
 
     d->id = id;
+    d->invalidateHash();
 }
 
 /*!
@@ -313,6 +352,7 @@ void QNdefRecord::setPayload(const QByteArray &payload)
         d = new QNdefRecordPrivate;
 
     d->payload = payload;
+    d->invalidateHash();
 }
 
 /*!
@@ -339,6 +379,12 @@ bool QNdefRecord::isEmpty() const
     return d->payload.isEmpty();
 }
 
+// Byte arrays that share their data are equal without comparing the contents.
+static inline bool equalBytes(const QByteArray &a, const QByteArray &b)
+{
+    return a.size() == b.size() && (a.constData() == b.constData() || a == b);
+}
+
 /*!
     Returns true if \a other and this NDEF record are the same.
 */
@@ -353,13 +399,17 @@ bool QNdefRecord::operator==(const QNdefRecord &other) const
     if (d->typeNameFormat != other.d->typeNameFormat)
         return false;
 
-    if (d->type != other.d->type)
+    // records that have already been hashed can be told apart without comparing the payload
+    if (d->hasHash() && other.d->hasHash() && d->contentHash() != other.d->contentHash())
+        return false;
+
+    if (!equalBytes(d->type, other.d->type))
         return false;
 
-    if (d->id != other.d->id)
+    if (!equalBytes(d->id, other.d->id))
         return false;
 
-    if (d->payload != other.d->payload)
+    if (!equalBytes(d->payload, other.d->payload))
         return false;
 
     return true;
@@ -97,6 +97,8 @@ protected:
 
 private:
     QSharedDataPointer<QNdefRecordPrivate> d;
+
+    friend Q_NFC_EXPORT uint qHash(const QNdefRecord &key);
 };
 
 #define Q_DECLARE_NDEF_RECORD(className, typeNameFormat, type, initialPayload) \
@@ -55,22 +55,37 @@
 
 #include <QtCore/QSharedData>
 #include <QtCore/QByteArray>
+#include <QtCore/QAtomicInteger>
 
 QT_BEGIN_NAMESPACE
 
 class QNdefRecordPrivate : public QSharedData
 {
 public:
-    QNdefRecordPrivate() : QSharedData()
+    QNdefRecordPrivate() : QSharedData(), hash(0)
     {
         typeNameFormat = 0; //TypeNameFormat::Empty
     }
 
+    QNdefRecordPrivate(const QNdefRecordPrivate &other)
+    :   QSharedData(other), typeNameFormat(other.typeNameFormat), type(other.type), id(other.id),
+        payload(other.payload), hash(other.hash.load())
+    {
+    }
+
+    uint contentHash() const;
+    bool hasHash() const { return hash.load() != 0; }
+    void invalidateHash() { hash.store(0); }
+
     unsigned int typeNameFormat : 3;
 
     QByteArray type;
     QByteArray id;
     QByteArray payload;
+
+private:
+    // hash of the record contents, 0 if it has not been calculated since the last change
+    mutable QAtomicInteger<uint> hash;
 };
 
 QT_END_NAMESPACE
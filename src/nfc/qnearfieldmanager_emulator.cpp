@@ -79,6 +79,8 @@ void QNearFieldManagerPrivateImpl::tagActivated(TagBase *tag)
             target = new TagType1(tag, this);
         else if (dynamic_cast<NfcTagType2 *>(tag))
             target = new TagType2(tag, this);
+        else if (dynamic_cast<NfcTagType4 *>(tag))
+            target = new TagType4(tag, this);
         else
             qFatal("Unknown emulator tag type");
 
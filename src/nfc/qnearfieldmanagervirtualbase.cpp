@@ -41,6 +41,9 @@
 #include "qndefmessage.h"
 #include "qtlv_p.h"
 
+#include <QtCore/QEventLoop>
+#include <QtCore/QTimer>
+
 QT_BEGIN_NAMESPACE
 
 //static inline bool matchesTarget(QNearFieldTarget::Type type,
@@ -124,6 +127,13 @@ void QNearFieldManagerPrivateVirtualBase::targetActivated(QNearFieldTarget *targ
     //if (matchesTarget(target->type(), m_detectTargetTypes))
     emit targetDetected(target);
 
+    if (target->type() == QNearFieldTarget::NfcTagType4) {
+        // NDEF messages are stored in a file rather than in TLVs
+        if (target->hasNdefMessage())
+            readNdefFile(target);
+        return;
+    }
+
     if (target->hasNdefMessage()) {
         QTlvReader reader(target);
         while (!reader.atEnd()) {
@@ -141,6 +151,54 @@ void QNearFieldManagerPrivateVirtualBase::targetActivated(QNearFieldTarget *targ
     }
 }
 
+/*!
+    Reads the NDEF messages of \a target with QNearFieldTarget::readNdefMessages() and blocks until
+    the request has finished.
+*/
+void QNearFieldManagerPrivateVirtualBase::readNdefFile(QNearFieldTarget *target)
+{
+    QList<QNdefMessage> messages;
+    QNearFieldTarget::RequestId id;
+    bool finished = false;
+
+    QEventLoop loop;
+
+    QMetaObject::Connection messageConnection =
+        connect(target, &QNearFieldTarget::ndefMessageRead,
+                [&messages](const QNdefMessage &message) { messages.append(message); });
+    QMetaObject::Connection completedConnection =
+        connect(target, &QNearFieldTarget::requestCompleted,
+                [&](const QNearFieldTarget::RequestId &completedId) {
+                    if (completedId == id) {
+                        finished = true;
+                        loop.quit();
+                    }
+                });
+    QMetaObject::Connection errorConnection =
+        connect(target, &QNearFieldTarget::error,
+                [&](QNearFieldTarget::Error, const QNearFieldTarget::RequestId &errorId) {
+                    if (errorId == id) {
+                        messages.clear();
+                        finished = true;
+                        loop.quit();
+                    }
+                });
+
+    id = target->readNdefMessages();
+
+    if (!finished) {
+        QTimer::singleShot(5000, &loop, SLOT(quit()));
+        loop.exec();
+    }
+
+    disconnect(messageConnection);
+    disconnect(completedConnection);
+    disconnect(errorConnection);
+
+    foreach (const QNdefMessage &message, messages)
+        ndefReceived(message, target);
+}
+
 void QNearFieldManagerPrivateVirtualBase::targetDeactivated(QNearFieldTarget *target)
 {
     emit targetLost(target);
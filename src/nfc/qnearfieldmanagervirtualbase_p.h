@@ -87,6 +87,7 @@ protected:
 
 private:
     int getFreeId();
+    void readNdefFile(QNearFieldTarget *target);
     void ndefReceived(const QNdefMessage &message, QNearFieldTarget *target);
 
     QList<Callback> m_registeredHandlers;
@@ -42,6 +42,7 @@
 #include "qndefmessage.h"
 #include "qtlv_p.h"
 
+#include <QtCore/QBitArray>
 #include <QtCore/QByteArray>
 #include <QtCore/QVariant>
 
@@ -83,7 +84,7 @@ public:
     :   q_ptr(q), m_readNdefMessageState(NotReadingNdefMessage),
         m_tlvReader(0),
         m_writeNdefMessageState(NotWritingNdefMessage),
-        m_tlvWriter(0)
+        m_hr0(0)
     { }
 
     QNearFieldTagType1 *q_ptr;
@@ -106,24 +107,131 @@ public:
 
     enum WriteNdefMessageState {
         NotWritingNdefMessage,
-        NdefWriteCheckingIdentification,
-        NdefWriteCheckingNdefMagicNumber,
-        NdefWriteReadingTlv,
-        NdefWriteWritingTlv,
-        NdefWriteWritingTlvFlush
+        NdefWriteReadingStaticMemory,
+        NdefWriteReadingDynamicMemory,
+        NdefWriteWritingMemory
     };
 
     void progressToNextNdefWriteMessageState();
+    void abortNdefWriteMessage();
     WriteNdefMessageState m_writeNdefMessageState;
     QNearFieldTarget::RequestId m_writeNdefRequestId;
     QList<QNdefMessage> m_ndefWriteMessages;
 
-    QTlvWriter *m_tlvWriter;
+    bool planNdefWrite();
+    void writeNdefMemory();
+    QByteArray staticCommand(quint8 opcode, quint8 address, quint8 data = 0x00) const;
+    QByteArray dynamicCommand(quint8 opcode, quint8 address,
+                              const QByteArray &data = QByteArray(8, char(0x00))) const;
 
-    typedef QPair<quint8, QByteArray> Tlv;
-    QList<Tlv> m_tlvs;
+    quint8 m_hr0;
+    QByteArray m_memory;
+    QList<QByteArray> m_writeCommands;
+
+    void _q_requestCompleted(const QNearFieldTarget::RequestId &id);
+    void _q_requestError(QNearFieldTarget::Error error, const QNearFieldTarget::RequestId &id);
 };
 
+static QVariant decodeResponse(const QByteArray &command, const QByteArray &response)
+{
+    switch (command.at(0)) {
+    case 0x01:  // READ
+        if (command.at(1) == response.at(0))
+            return quint8(response.at(1));
+        break;
+    case 0x53: { // WRITE-E
+        quint8 address = command.at(1);
+        quint8 data = command.at(2);
+        quint8 writeAddress = response.at(0);
+        quint8 writeData = response.at(1);
+
+        return ((writeAddress == address) && (writeData == data));
+    }
+    case 0x1a: { // WRITE-NE
+        quint8 address = command.at(1);
+        quint8 data = command.at(2);
+        quint8 writeAddress = response.at(0);
+        quint8 writeData = response.at(1);
+
+        return ((writeAddress == address) && ((writeData & data) == data));
+    }
+    case 0x10: { // RSEG
+        quint8 segmentAddress = quint8(command.at(1)) >> 4;
+        quint8 readSegmentAddress = quint8(response.at(0)) >> 4;
+        if (readSegmentAddress == segmentAddress)
+            return response.mid(1);
+        break;
+    }
+    case 0x02: { // READ8
+        quint8 blockAddress = command.at(1);
+        quint8 readBlockAddress = response.at(0);
+        if (readBlockAddress == blockAddress)
+            return response.mid(1);
+        break;
+    }
+    case 0x54: { // WRITE-E8
+        quint8 blockAddress = command.at(1);
+        QByteArray data = command.mid(2, 8);
+        quint8 writeBlockAddress = response.at(0);
+        QByteArray writeData = response.mid(1);
+
+        return ((writeBlockAddress == blockAddress) && (writeData == data));
+    }
+    case 0x1b: { // WRITE-NE8
+        quint8 blockAddress = command.at(1);
+        QByteArray data = command.mid(2, 8);
+        quint8 writeBlockAddress = response.at(0);
+        QByteArray writeData = response.mid(1);
+
+        if (writeBlockAddress != blockAddress)
+            return false;
+
+        for (int i = 0; i < writeData.length(); ++i) {
+            if ((writeData.at(i) & data.at(i)) != data.at(i))
+                return false;
+        }
+
+        return true;
+    }
+    }
+
+    return QVariant();
+}
+
+/*!
+    Returns a static memory model command with \a opcode, \a address and \a data.
+*/
+QByteArray QNearFieldTagType1Private::staticCommand(quint8 opcode, quint8 address,
+                                                    quint8 data) const
+{
+    Q_Q(const QNearFieldTagType1);
+
+    QByteArray command;
+    command.append(char(opcode));       // Opcode
+    command.append(char(address));      // Address
+    command.append(char(data));         // Data
+    command.append(q->uid().left(4));   // 4 bytes of UID
+
+    return command;
+}
+
+/*!
+    Returns a dynamic memory model command with \a opcode, \a address and 8 bytes of \a data.
+*/
+QByteArray QNearFieldTagType1Private::dynamicCommand(quint8 opcode, quint8 address,
+                                                     const QByteArray &data) const
+{
+    Q_Q(const QNearFieldTagType1);
+
+    QByteArray command;
+    command.append(char(opcode));       // Opcode
+    command.append(char(address));      // Address
+    command.append(data);               // Data
+    command.append(q->uid().left(4));   // 4 bytes of UID
+
+    return command;
+}
+
 void QNearFieldTagType1Private::progressToNextNdefReadMessageState()
 {
     Q_Q(QNearFieldTagType1);
@@ -202,185 +310,319 @@ void QNearFieldTagType1Private::progressToNextNdefReadMessageState()
     }
 }
 
-void QNearFieldTagType1Private::progressToNextNdefWriteMessageState()
+void QNearFieldTagType1Private::abortNdefWriteMessage()
 {
     Q_Q(QNearFieldTagType1);
 
-    switch (m_writeNdefMessageState) {
-    case NotWritingNdefMessage:
-        m_writeNdefMessageState = NdefWriteCheckingIdentification;
-        m_nextExpectedRequestId = q->readIdentification();
-        break;
-    case NdefWriteCheckingIdentification: {
-        const QByteArray data = q->requestResponse(m_nextExpectedRequestId).toByteArray();
-
-        if (data.isEmpty()) {
-            m_writeNdefMessageState = NotWritingNdefMessage;
-            m_nextExpectedRequestId = QNearFieldTarget::RequestId();
-            emit q->error(QNearFieldTarget::NdefWriteError, m_writeNdefRequestId);
-            m_writeNdefRequestId = QNearFieldTarget::RequestId();
-            break;
-        }
+    m_memory.clear();
+    m_writeCommands.clear();
+    m_writeNdefMessageState = NotWritingNdefMessage;
+    m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+    emit q->error(QNearFieldTarget::NdefWriteError, m_writeNdefRequestId);
+    m_writeNdefRequestId = QNearFieldTarget::RequestId();
+}
 
-        quint8 hr0 = data.at(0);
+/*!
+    Lays out the preserved and new TLVs on top of the memory contents read from the tag and
+    converts every difference into a write command. Blocks in the dynamic memory model are written
+    with WRITE-E8 or WRITE-NE8, single bytes in the static memory area with WRITE-E or WRITE-NE.
+    The erase variants are only used if a bit has to be cleared. Reserved memory, including the
+    areas described by Lock Control and Memory Control TLVs, is never modified.
 
-        // Check if target is a NFC TagType1 tag
-        if (!(hr0 & 0x10)) {
-            m_writeNdefMessageState = NotWritingNdefMessage;
-            m_nextExpectedRequestId = QNearFieldTarget::RequestId();
-            emit q->error(QNearFieldTarget::NdefWriteError, m_writeNdefRequestId);
-            m_writeNdefRequestId = QNearFieldTarget::RequestId();
+    Returns false if the messages do not fit on the tag or a locked block would be modified.
+*/
+bool QNearFieldTagType1Private::planNdefWrite()
+{
+    // existing lock control, memory control and proprietary TLVs are preserved
+    QTlvReader reader(m_memory);
+    reader.addReservedMemory(0, 12);    // skip uid, cc
+    reader.addReservedMemory(104, 16);  // skip reserved block D, lock block E
+    reader.addReservedMemory(120, 8);   // skip reserved block F
+
+    QList<QPair<quint8, QByteArray> > tlvs;
+    while (!reader.atEnd()) {
+        if (!reader.readNext())
             break;
-        }
 
-        m_writeNdefMessageState = NdefWriteCheckingNdefMagicNumber;
-        m_nextExpectedRequestId = q->readByte(8);
-        break;
+        quint8 tag = reader.tag();
+        if (tag == 0x01 || tag == 0x02 || tag == 0xfd)
+            tlvs.append(qMakePair(tag, reader.data()));
     }
-    case NdefWriteCheckingNdefMagicNumber: {
-        quint8 ndefMagicNumber = q->requestResponse(m_nextExpectedRequestId).toUInt();
-        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
 
-        if (ndefMagicNumber != 0xe1) {
-            m_writeNdefMessageState = NotWritingNdefMessage;
-            emit q->error(QNearFieldTarget::NdefWriteError, m_writeNdefRequestId);
-            m_writeNdefRequestId = QNearFieldTarget::RequestId();
-            break;
+    QMap<int, int> reservedMemory;
+    reservedMemory.insert(0, 12);       // uid, cc
+    reservedMemory.insert(104, 16);     // reserved block D, lock block E
+    reservedMemory.insert(120, 8);      // reserved block F
+
+    // dynamic lock bits lock the memory from block 0x10 onwards
+    QBitArray lockedBytes(m_memory.length());
+    for (int i = 0; i < tlvs.count(); ++i) {
+        const QByteArray &data = tlvs.at(i).second;
+        if (tlvs.at(i).first == 0x02) {
+            if (data.length() < 3)
+                return false;
+            const QPair<int, int> reserved = qParseReservedMemoryControlTlv(data);
+            if (reserved.second > 0)
+                reservedMemory.insert(reserved.first, reserved.second);
+        } else if (tlvs.at(i).first == 0x01) {
+            if (data.length() < 3)
+                return false;
+            const QPair<int, int> lockBytes = qParseLockControlTlv(data);
+            if (lockBytes.second <= 0)
+                continue;
+            reservedMemory.insert(lockBytes.first, lockBytes.second);
+
+            const int lockBits = quint8(data.at(1)) ? quint8(data.at(1)) : 256;
+            const int bytesPerLockBit = 1 << (quint8(data.at(2)) >> 4);
+            for (int bit = 0; bit < lockBits; ++bit) {
+                const int lockByte = lockBytes.first + bit / 8;
+                if (lockByte >= m_memory.length())
+                    break;
+                if (!(quint8(m_memory.at(lockByte)) & (0x01 << (bit % 8))))
+                    continue;
+
+                const int first = 0x80 + bit * bytesPerLockBit;
+                const int last = qMin(first + bytesPerLockBit, lockedBytes.size());
+                if (first < last)
+                    lockedBytes.fill(true, first, last);
+            }
         }
-
-        m_writeNdefMessageState = NdefWriteReadingTlv;
-        delete m_tlvReader;
-        m_tlvReader = new QTlvReader(q);
-
-        Q_FALLTHROUGH(); // fall through
     }
-    case NdefWriteReadingTlv:
-        Q_ASSERT(m_tlvReader);
-        while (!m_tlvReader->atEnd()) {
-            if (!m_tlvReader->readNext())
-                break;
 
-            quint8 tag = m_tlvReader->tag();
-            if (tag == 0x01 || tag == 0x02 || tag == 0xfd)
-                m_tlvs.append(qMakePair(tag, m_tlvReader->data()));
-        }
+    QByteArray memory = m_memory;
 
-        m_nextExpectedRequestId = m_tlvReader->requestId();
-        if (m_nextExpectedRequestId.isValid())
-            break;
+    {
+        QTlvWriter writer(&memory);
 
-        delete m_tlvReader;
-        m_tlvReader = 0;
-        m_writeNdefMessageState = NdefWriteWritingTlv;
-
-        // fall through
-    case NdefWriteWritingTlv:
-        delete m_tlvWriter;
-        m_tlvWriter = new QTlvWriter(q);
+        QMap<int, int>::ConstIterator it;
+        for (it = reservedMemory.constBegin(); it != reservedMemory.constEnd(); ++it)
+            writer.addReservedMemory(it.key(), it.value());
 
         // write old TLVs
-        foreach (const Tlv &tlv, m_tlvs)
-            m_tlvWriter->writeTlv(tlv.first, tlv.second);
+        for (int i = 0; i < tlvs.count(); ++i)
+            writer.writeTlv(tlvs.at(i).first, tlvs.at(i).second);
 
         // write new NDEF message TLVs
         foreach (const QNdefMessage &message, m_ndefWriteMessages)
-            m_tlvWriter->writeTlv(0x03, message.toByteArray());
+            writer.writeTlv(0x03, message.toByteArray());
 
         // write terminator TLV
-        m_tlvWriter->writeTlv(0xfe);
+        writer.writeTlv(0xfe);
+
+        if (!writer.process())
+            return false;
+    }
 
-        m_writeNdefMessageState = NdefWriteWritingTlvFlush;
+    const bool dynamicModel = (m_hr0 & 0x0f) != 0x01;
+    const quint16 lock = (quint8(m_memory.at(0x71)) << 8) | quint8(m_memory.at(0x70));
 
-        // fall through
-    case NdefWriteWritingTlvFlush:
-        // flush the writer
-        Q_ASSERT(m_tlvWriter);
-        if (m_tlvWriter->process(true)) {
-            m_nextExpectedRequestId = QNearFieldTarget::RequestId();
-            m_writeNdefMessageState = NotWritingNdefMessage;
-            delete m_tlvWriter;
-            m_tlvWriter = 0;
-            emit q->ndefMessagesWritten();
-            emit q->requestCompleted(m_writeNdefRequestId);
-            m_writeNdefRequestId = QNearFieldTarget::RequestId();
-        } else {
-            m_nextExpectedRequestId = m_tlvWriter->requestId();
-            if (!m_nextExpectedRequestId.isValid()) {
-                m_writeNdefMessageState = NotWritingNdefMessage;
-                delete m_tlvWriter;
-                m_tlvWriter = 0;
-                emit q->error(QNearFieldTarget::NdefWriteError, m_writeNdefRequestId);
-                m_writeNdefRequestId = QNearFieldTarget::RequestId();
-            }
+    m_writeCommands.clear();
+
+    for (int block = 0; block * 8 < memory.length(); ++block) {
+        const QByteArray original = m_memory.mid(block * 8, 8);
+        const QByteArray updated = memory.mid(block * 8, 8);
+
+        if (original == updated)
+            continue;
+
+        // locked blocks
+        if (block <= 0x0e && ((0x01 << block) & lock))
+            return false;
+
+        int changedBytes = 0;
+        bool erase = false;
+        for (int i = 0; i < updated.length(); ++i) {
+            if (original.at(i) == updated.at(i))
+                continue;
+            if (lockedBytes.testBit(block * 8 + i))
+                return false;
+            ++changedBytes;
+            if (original.at(i) & ~updated.at(i))
+                erase = true;
+        }
+
+        // a single byte in the static memory area is cheaper to write on its own
+        if (dynamicModel && (block >= 0x10 || changedBytes > 1)) {
+            m_writeCommands.append(dynamicCommand(erase ? 0x54 : 0x1b, block, updated));
+            continue;
+        }
+
+        // static memory model can only write the static memory area
+        if (block >= 0x10)
+            return false;
+
+        for (int i = 0; i < updated.length(); ++i) {
+            if (original.at(i) == updated.at(i))
+                continue;
+
+            quint8 opcode = (original.at(i) & ~updated.at(i)) ? 0x53 : 0x1a;
+            m_writeCommands.append(staticCommand(opcode, block * 8 + i, updated.at(i)));
         }
-        break;
     }
+
+    return true;
 }
 
-static QVariant decodeResponse(const QByteArray &command, const QByteArray &response)
+/*!
+    Plans the NDEF write once the memory contents are known and sends all write commands with a
+    single sendCommands() call.
+*/
+void QNearFieldTagType1Private::writeNdefMemory()
 {
-    switch (command.at(0)) {
-    case 0x01:  // READ
-        if (command.at(1) == response.at(0))
-            return quint8(response.at(1));
-        break;
-    case 0x53: { // WRITE-E
-        quint8 address = command.at(1);
-        quint8 data = command.at(2);
-        quint8 writeAddress = response.at(0);
-        quint8 writeData = response.at(1);
+    Q_Q(QNearFieldTagType1);
 
-        return ((writeAddress == address) && (writeData == data));
+    if (!planNdefWrite()) {
+        abortNdefWriteMessage();
+        return;
     }
-    case 0x1a: { // WRITE-NE
-        quint8 address = command.at(1);
-        quint8 data = command.at(2);
-        quint8 writeAddress = response.at(0);
-        quint8 writeData = response.at(1);
 
-        return ((writeAddress == address) && ((writeData & data) == data));
+    if (m_writeCommands.isEmpty()) {
+        // tag already contains the messages
+        m_memory.clear();
+        m_writeNdefMessageState = NotWritingNdefMessage;
+        emit q->ndefMessagesWritten();
+        emit q->requestCompleted(m_writeNdefRequestId);
+        m_writeNdefRequestId = QNearFieldTarget::RequestId();
+        return;
     }
-    case 0x10: { // RSEG
-        quint8 segmentAddress = quint8(command.at(1)) >> 4;
-        quint8 readSegmentAddress = quint8(response.at(0)) >> 4;
-        if (readSegmentAddress == segmentAddress)
-            return response.mid(1);
+
+    m_writeNdefMessageState = NdefWriteWritingMemory;
+    m_nextExpectedRequestId = q->sendCommands(m_writeCommands);
+    if (!m_nextExpectedRequestId.isValid())
+        abortNdefWriteMessage();
+}
+
+void QNearFieldTagType1Private::progressToNextNdefWriteMessageState()
+{
+    Q_Q(QNearFieldTagType1);
+
+    switch (m_writeNdefMessageState) {
+    case NotWritingNdefMessage:
+        m_writeNdefMessageState = NdefWriteReadingStaticMemory;
+        m_nextExpectedRequestId = q->readAll();
         break;
-    }
-    case 0x02: { // READ8
-        quint8 blockAddress = command.at(1);
-        quint8 readBlockAddress = response.at(0);
-        if (readBlockAddress == blockAddress)
-            return response.mid(1);
+    case NdefWriteReadingStaticMemory: {
+        const QByteArray data = q->requestResponse(m_nextExpectedRequestId).toByteArray();
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+
+        if (data.length() < 122) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        m_hr0 = data.at(0);
+        m_memory = data.mid(2, 120);
+
+        // Check if target is a NFC TagType1 tag
+        if (!(m_hr0 & 0x10)) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        // Check if NDEF Message Magic number is present and the tag is writable
+        if (quint8(m_memory.at(8)) != 0xe1 || (quint8(m_memory.at(11)) & 0x0f) != 0x00) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        int memorySize = 8 * (quint8(m_memory.at(10)) + 1);
+        if (memorySize > 120 && (m_hr0 & 0x0f) != 0x01) {
+            // read all remaining segments at once, block F is reserved
+            m_memory.append(QByteArray(8, char(0x00)));
+
+            QList<QByteArray> commands;
+            for (int segment = 1; segment * 128 < memorySize; ++segment)
+                commands.append(dynamicCommand(0x10, segment << 4));   // RSEG
+
+            m_writeNdefMessageState = NdefWriteReadingDynamicMemory;
+            m_nextExpectedRequestId = q->sendCommands(commands);
+            if (!m_nextExpectedRequestId.isValid())
+                abortNdefWriteMessage();
+            break;
+        }
+
+        writeNdefMemory();
         break;
     }
-    case 0x54: { // WRITE-E8
-        quint8 blockAddress = command.at(1);
-        QByteArray data = command.mid(2, 8);
-        quint8 writeBlockAddress = response.at(0);
-        QByteArray writeData = response.mid(1);
+    case NdefWriteReadingDynamicMemory: {
+        const QList<QByteArray> responses =
+            q->requestResponse(m_nextExpectedRequestId).value<QList<QByteArray> >();
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
 
-        return ((writeBlockAddress == blockAddress) && (writeData == data));
+        for (int i = 0; i < responses.count(); ++i) {
+            const QByteArray &response = responses.at(i);
+            if (response.length() != 129 || (quint8(response.at(0)) >> 4) != i + 1) {
+                abortNdefWriteMessage();
+                return;
+            }
+
+            m_memory.append(response.mid(1));
+        }
+
+        m_memory.truncate(8 * (quint8(m_memory.at(10)) + 1));
+
+        writeNdefMemory();
+        break;
     }
-    case 0x1b: { // WRITE-NE8
-        quint8 blockAddress = command.at(1);
-        QByteArray data = command.mid(2, 8);
-        quint8 writeBlockAddress = response.at(0);
-        QByteArray writeData = response.mid(1);
+    case NdefWriteWritingMemory: {
+        const QList<QByteArray> responses =
+            q->requestResponse(m_nextExpectedRequestId).value<QList<QByteArray> >();
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
 
-        if (writeBlockAddress != blockAddress)
-            return false;
+        if (responses.count() != m_writeCommands.count()) {
+            abortNdefWriteMessage();
+            break;
+        }
 
-        for (int i = 0; i < writeData.length(); ++i) {
-            if ((writeData.at(i) & data.at(i)) != data.at(i))
-                return false;
+        for (int i = 0; i < responses.count(); ++i) {
+            if (!decodeResponse(m_writeCommands.at(i), responses.at(i)).toBool()) {
+                abortNdefWriteMessage();
+                return;
+            }
         }
 
-        return true;
+        m_memory.clear();
+        m_writeCommands.clear();
+        m_writeNdefMessageState = NotWritingNdefMessage;
+        emit q->ndefMessagesWritten();
+        emit q->requestCompleted(m_writeNdefRequestId);
+        m_writeNdefRequestId = QNearFieldTarget::RequestId();
+        break;
     }
     }
+}
 
-    return QVariant();
+void QNearFieldTagType1Private::_q_requestCompleted(const QNearFieldTarget::RequestId &id)
+{
+    if (!m_nextExpectedRequestId.isValid() || m_nextExpectedRequestId != id)
+        return;
+
+    // continue reading / writing NDEF message
+    if (m_readNdefMessageState != NotReadingNdefMessage)
+        progressToNextNdefReadMessageState();
+    else if (m_writeNdefMessageState != NotWritingNdefMessage)
+        progressToNextNdefWriteMessageState();
+}
+
+void QNearFieldTagType1Private::_q_requestError(QNearFieldTarget::Error error,
+                                                const QNearFieldTarget::RequestId &id)
+{
+    Q_Q(QNearFieldTagType1);
+    Q_UNUSED(error);
+
+    if (!m_nextExpectedRequestId.isValid() || m_nextExpectedRequestId != id)
+        return;
+
+    if (m_readNdefMessageState != NotReadingNdefMessage) {
+        delete m_tlvReader;
+        m_tlvReader = 0;
+        m_readNdefMessageState = NotReadingNdefMessage;
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+        emit q->error(QNearFieldTarget::NdefReadError, m_readNdefRequestId);
+        m_readNdefRequestId = QNearFieldTarget::RequestId();
+    } else if (m_writeNdefMessageState != NotWritingNdefMessage) {
+        abortNdefWriteMessage();
+    }
 }
 
 /*!
@@ -389,6 +631,10 @@ static QVariant decodeResponse(const QByteArray &command, const QByteArray &resp
 QNearFieldTagType1::QNearFieldTagType1(QObject *parent)
 :   QNearFieldTarget(parent), d_ptr(new QNearFieldTagType1Private(this))
 {
+    connect(this, SIGNAL(requestCompleted(QNearFieldTarget::RequestId)),
+            this, SLOT(_q_requestCompleted(QNearFieldTarget::RequestId)));
+    connect(this, SIGNAL(error(QNearFieldTarget::Error,QNearFieldTarget::RequestId)),
+            this, SLOT(_q_requestError(QNearFieldTarget::Error,QNearFieldTarget::RequestId)));
 }
 
 /*!
@@ -435,17 +681,19 @@ QNearFieldTarget::RequestId QNearFieldTagType1::readNdefMessages()
 {
     Q_D(QNearFieldTagType1);
 
-    d->m_readNdefRequestId = RequestId(new RequestIdPrivate);
+    RequestId id(new RequestIdPrivate);
 
-    if (d->m_readNdefMessageState == QNearFieldTagType1Private::NotReadingNdefMessage) {
+    if (d->m_readNdefMessageState == QNearFieldTagType1Private::NotReadingNdefMessage &&
+        d->m_writeNdefMessageState == QNearFieldTagType1Private::NotWritingNdefMessage) {
+        d->m_readNdefRequestId = id;
         d->progressToNextNdefReadMessageState();
     } else {
         QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
                                   Q_ARG(QNearFieldTarget::Error, NdefReadError),
-                                  Q_ARG(QNearFieldTarget::RequestId, d->m_readNdefRequestId));
+                                  Q_ARG(QNearFieldTarget::RequestId, id));
     }
 
-    return d->m_readNdefRequestId;
+    return id;
 }
 
 /*!
@@ -455,19 +703,20 @@ QNearFieldTarget::RequestId QNearFieldTagType1::writeNdefMessages(const QList<QN
 {
     Q_D(QNearFieldTagType1);
 
-    d->m_writeNdefRequestId = RequestId(new RequestIdPrivate);
+    RequestId id(new RequestIdPrivate);
 
     if (d->m_readNdefMessageState == QNearFieldTagType1Private::NotReadingNdefMessage &&
         d->m_writeNdefMessageState == QNearFieldTagType1Private::NotWritingNdefMessage) {
         d->m_ndefWriteMessages = messages;
+        d->m_writeNdefRequestId = id;
         d->progressToNextNdefWriteMessageState();
     } else {
         QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
                                   Q_ARG(QNearFieldTarget::Error, NdefWriteError),
-                                  Q_ARG(QNearFieldTarget::RequestId, d->m_readNdefRequestId));
+                                  Q_ARG(QNearFieldTarget::RequestId, id));
     }
 
-    return d->m_writeNdefRequestId;
+    return id;
 }
 
 /*!
@@ -554,15 +803,11 @@ QNearFieldTarget::RequestId QNearFieldTagType1::readByte(quint8 address)
     if (address & 0x80)
         return RequestId();
 
-    QByteArray command;
-    command.append(char(0x01));     // READ
-    command.append(char(address));  // Address
-    command.append(char(0x00));     // Data (unused)
-    command.append(uid().left(4));  // 4 bytes of UID
+    Q_D(QNearFieldTagType1);
 
-    RequestId id = sendCommand(command);
+    const QByteArray command = d->staticCommand(0x01, address); // READ
 
-    Q_D(QNearFieldTagType1);
+    RequestId id = sendCommand(command);
 
     d->m_pendingInternalCommands.insert(id, command);
 
@@ -588,23 +833,19 @@ QNearFieldTarget::RequestId QNearFieldTagType1::writeByte(quint8 address, quint8
     if (address & 0x80)
         return RequestId();
 
+    Q_D(QNearFieldTagType1);
+
     QByteArray command;
 
     if (mode == EraseAndWrite)
-        command.append(char(0x53)); // WRITE-E
+        command = d->staticCommand(0x53, address, data);    // WRITE-E
     else if (mode == WriteOnly)
-        command.append(char(0x1a)); // WRITE-NE
+        command = d->staticCommand(0x1a, address, data);    // WRITE-NE
     else
         return RequestId();
 
-    command.append(char(address));  // Address
-    command.append(char(data));     // Data
-    command.append(uid().left(4));  // 4 bytes of UID
-
     RequestId id = sendCommand(command);
 
-    Q_D(QNearFieldTagType1);
-
     d->m_pendingInternalCommands.insert(id, command);
 
     return id;
@@ -624,15 +865,11 @@ QNearFieldTarget::RequestId QNearFieldTagType1::readSegment(quint8 segmentAddres
     if (segmentAddress & 0xf0)
         return RequestId();
 
-    QByteArray command;
-    command.append(char(0x10));                 // RSEG
-    command.append(char(segmentAddress << 4));  // Segment address
-    command.append(QByteArray(8, char(0x00)));  // Data (unused)
-    command.append(uid().left(4));              // 4 bytes of UID
+    Q_D(QNearFieldTagType1);
 
-    RequestId id = sendCommand(command);
+    const QByteArray command = d->dynamicCommand(0x10, segmentAddress << 4);   // RSEG
 
-    Q_D(QNearFieldTagType1);
+    RequestId id = sendCommand(command);
 
     d->m_pendingInternalCommands.insert(id, command);
 
@@ -650,15 +887,11 @@ QNearFieldTarget::RequestId QNearFieldTagType1::readSegment(quint8 segmentAddres
 */
 QNearFieldTarget::RequestId QNearFieldTagType1::readBlock(quint8 blockAddress)
 {
-    QByteArray command;
-    command.append(char(0x02));                 // READ8
-    command.append(char(blockAddress));         // Block address
-    command.append(QByteArray(8, char(0x00)));  // Data (unused)
-    command.append(uid().left(4));              // 4 bytes of UID
+    Q_D(QNearFieldTagType1);
 
-    RequestId id = sendCommand(command);
+    const QByteArray command = d->dynamicCommand(0x02, blockAddress);  // READ8
 
-    Q_D(QNearFieldTagType1);
+    RequestId id = sendCommand(command);
 
     d->m_pendingInternalCommands.insert(id, command);
 
@@ -685,23 +918,19 @@ QNearFieldTarget::RequestId QNearFieldTagType1::writeBlock(quint8 blockAddress,
     if (data.length() != 8)
         return RequestId();
 
+    Q_D(QNearFieldTagType1);
+
     QByteArray command;
 
     if (mode == EraseAndWrite)
-        command.append(char(0x54));     // WRITE-E8
+        command = d->dynamicCommand(0x54, blockAddress, data);  // WRITE-E8
     else if (mode == WriteOnly)
-        command.append(char(0x1b));     // WRITE-NE8
+        command = d->dynamicCommand(0x1b, blockAddress, data);  // WRITE-NE8
     else
         return RequestId();
 
-    command.append(char(blockAddress)); // Block address
-    command.append(data);               // Data
-    command.append(uid().left(4));      // 4 bytes of UID
-
     RequestId id = sendCommand(command);
 
-    Q_D(QNearFieldTagType1);
-
     d->m_pendingInternalCommands.insert(id, command);
 
     return id;
@@ -715,28 +944,19 @@ bool QNearFieldTagType1::handleResponse(const QNearFieldTarget::RequestId &id,
 {
     Q_D(QNearFieldTagType1);
 
-    bool handled;
-
+    // the NDEF state machines continue from requestCompleted()
     if (d->m_pendingInternalCommands.contains(id)) {
         const QByteArray command = d->m_pendingInternalCommands.take(id);
 
         QVariant decodedResponse = decodeResponse(command, response);
         setResponseForRequest(id, decodedResponse);
 
-        handled = true;
-    } else {
-        handled = QNearFieldTarget::handleResponse(id, response);
-    }
-
-    // continue reading / writing NDEF message
-    if (d->m_nextExpectedRequestId == id) {
-        if (d->m_readNdefMessageState != QNearFieldTagType1Private::NotReadingNdefMessage)
-            d->progressToNextNdefReadMessageState();
-        else if (d->m_writeNdefMessageState != QNearFieldTagType1Private::NotWritingNdefMessage)
-            d->progressToNextNdefWriteMessageState();
+        return true;
     }
 
-    return handled;
+    return QNearFieldTarget::handleResponse(id, response);
 }
 
 QT_END_NAMESPACE
+
+#include "moc_qnearfieldtagtype1_p.cpp"
@@ -101,6 +101,10 @@ protected:
 
 private:
     QNearFieldTagType1Private *d_ptr;
+
+    Q_PRIVATE_SLOT(d_func(), void _q_requestCompleted(const QNearFieldTarget::RequestId &id))
+    Q_PRIVATE_SLOT(d_func(), void _q_requestError(QNearFieldTarget::Error error,
+                                                  const QNearFieldTarget::RequestId &id))
 };
 
 QT_END_NAMESPACE
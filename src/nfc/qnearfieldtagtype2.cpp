@@ -39,6 +39,8 @@
 
 #include "qnearfieldtagtype2_p.h"
 #include "qnearfieldtarget_p.h"
+#include "qndefmessage.h"
+#include "qtlv_p.h"
 
 #include <QtCore/QVariant>
 #include <QtCore/QCoreApplication>
@@ -68,18 +70,507 @@ struct SectorSelectState {
     quint8 sector;  // sector being selected
 };
 
+// Commands sent together with sendCommands() once their sector has been selected.
+struct BlockCommandBatch {
+    quint8 sector;
+    QList<QByteArray> commands;
+};
+
 class QNearFieldTagType2Private
 {
+    Q_DECLARE_PUBLIC(QNearFieldTagType2)
+
 public:
-    QNearFieldTagType2Private() : m_currentSector(0) { }
+    QNearFieldTagType2Private(QNearFieldTagType2 *q)
+    :   q_ptr(q), m_currentSector(0),
+        m_readNdefMessageState(NotReadingNdefMessage),
+        m_writeNdefMessageState(NotWritingNdefMessage),
+        m_dataAreaSize(0), m_tlvReader(0)
+    { }
+
+    QNearFieldTagType2 *q_ptr;
 
     QMap<QNearFieldTarget::RequestId, QByteArray> m_pendingInternalCommands;
 
     quint8 m_currentSector;
 
     QMap<QNearFieldTarget::RequestId, SectorSelectState> m_pendingSectorSelectCommands;
+
+    enum ReadNdefMessageState {
+        NotReadingNdefMessage,
+        NdefReadSelectingSector,
+        NdefReadReadingCapabilityContainer,
+        NdefReadReadingTlv
+    };
+
+    void progressToNextNdefReadMessageState();
+    void abortNdefReadMessage();
+    ReadNdefMessageState m_readNdefMessageState;
+    QNearFieldTarget::RequestId m_readNdefRequestId;
+
+    enum WriteNdefMessageState {
+        NotWritingNdefMessage,
+        NdefWriteSelectingSector,
+        NdefWriteReadingCapabilityContainer,
+        NdefWriteReadingTlv,
+        NdefWriteReadingReservedBlocks,
+        NdefWriteWritingBlocks
+    };
+
+    void progressToNextNdefWriteMessageState();
+    void abortNdefWriteMessage();
+    WriteNdefMessageState m_writeNdefMessageState;
+    QNearFieldTarget::RequestId m_writeNdefRequestId;
+    QList<QNdefMessage> m_ndefWriteMessages;
+
+    bool checkCapabilityContainer(bool write);
+    bool layoutNdefWrite();
+    void queueBlockCommands(const QList<int> &blocks, bool write);
+    bool sendNextBatch();
+    bool isReserved(int offset) const;
+
+    int m_dataAreaSize;
+
+    QTlvReader *m_tlvReader;
+    QNearFieldTarget::RequestId m_nextExpectedRequestId;
+
+    typedef QPair<quint8, QByteArray> Tlv;
+    QList<Tlv> m_tlvs;
+    QMap<int, int> m_reservedMemory;
+
+    QByteArray m_memoryImage;
+    QList<int> m_writeBlocks;
+    QList<int> m_reservedBlocks;
+    QList<BlockCommandBatch> m_batches;
+    QList<QByteArray> m_batchResponses;
+
+    void _q_requestCompleted(const QNearFieldTarget::RequestId &id);
+    void _q_requestError(QNearFieldTarget::Error error, const QNearFieldTarget::RequestId &id);
 };
 
+/*!
+    Verifies the capability container returned in response to reading block 0 and extracts the
+    size of the data area. If \a write is true the tag must also grant write access. Returns true
+    if the tag is NDEF formatted and accessible; otherwise returns false.
+*/
+bool QNearFieldTagType2Private::checkCapabilityContainer(bool write)
+{
+    Q_Q(QNearFieldTagType2);
+
+    const QByteArray data = q->requestResponse(m_nextExpectedRequestId).toByteArray();
+    m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+
+    if (data.length() < 16)
+        return false;
+
+    // NDEF magic number
+    if (quint8(data.at(12)) != 0xe1)
+        return false;
+
+    // only major version 1 is supported
+    if ((quint8(data.at(13)) >> 4) != 0x01)
+        return false;
+
+    quint8 access = data.at(15);
+    if ((access >> 4) != 0x00)
+        return false;
+    if (write && (access & 0x0f) != 0x00)
+        return false;
+
+    m_dataAreaSize = 8 * quint8(data.at(14));
+
+    return true;
+}
+
+void QNearFieldTagType2Private::abortNdefReadMessage()
+{
+    Q_Q(QNearFieldTagType2);
+
+    delete m_tlvReader;
+    m_tlvReader = 0;
+    m_readNdefMessageState = NotReadingNdefMessage;
+    m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+    emit q->error(QNearFieldTarget::NdefReadError, m_readNdefRequestId);
+    m_readNdefRequestId = QNearFieldTarget::RequestId();
+}
+
+void QNearFieldTagType2Private::progressToNextNdefReadMessageState()
+{
+    Q_Q(QNearFieldTagType2);
+
+    switch (m_readNdefMessageState) {
+    case NotReadingNdefMessage:
+        // the capability container lives in sector 0
+        if (m_currentSector != 0) {
+            m_readNdefMessageState = NdefReadSelectingSector;
+            m_nextExpectedRequestId = q->selectSector(0);
+            break;
+        }
+
+        m_readNdefMessageState = NdefReadReadingCapabilityContainer;
+        m_nextExpectedRequestId = q->readBlock(0);
+        break;
+    case NdefReadSelectingSector:
+        if (!q->requestResponse(m_nextExpectedRequestId).toBool()) {
+            abortNdefReadMessage();
+            break;
+        }
+
+        m_readNdefMessageState = NdefReadReadingCapabilityContainer;
+        m_nextExpectedRequestId = q->readBlock(0);
+        break;
+    case NdefReadReadingCapabilityContainer:
+        if (!checkCapabilityContainer(false)) {
+            abortNdefReadMessage();
+            break;
+        }
+
+        m_readNdefMessageState = NdefReadReadingTlv;
+        delete m_tlvReader;
+        m_tlvReader = new QTlvReader(q);
+        m_tlvReader->setTagMemorySize(16 + m_dataAreaSize);
+
+        Q_FALLTHROUGH(); // fall through
+    case NdefReadReadingTlv:
+        Q_ASSERT(m_tlvReader);
+        while (!m_tlvReader->atEnd()) {
+            if (!m_tlvReader->readNext())
+                break;
+
+            // NDEF Message TLV
+            if (m_tlvReader->tag() == 0x03)
+                emit q->ndefMessageRead(QNdefMessage::fromByteArray(m_tlvReader->data()));
+        }
+
+        m_nextExpectedRequestId = m_tlvReader->requestId();
+        if (!m_nextExpectedRequestId.isValid()) {
+            delete m_tlvReader;
+            m_tlvReader = 0;
+            m_readNdefMessageState = NotReadingNdefMessage;
+            emit q->requestCompleted(m_readNdefRequestId);
+            m_readNdefRequestId = QNearFieldTarget::RequestId();
+        }
+        break;
+    }
+}
+
+void QNearFieldTagType2Private::abortNdefWriteMessage()
+{
+    Q_Q(QNearFieldTagType2);
+
+    delete m_tlvReader;
+    m_tlvReader = 0;
+    m_tlvs.clear();
+    m_reservedMemory.clear();
+    m_memoryImage.clear();
+    m_writeBlocks.clear();
+    m_reservedBlocks.clear();
+    m_batches.clear();
+    m_batchResponses.clear();
+    m_writeNdefMessageState = NotWritingNdefMessage;
+    m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+    emit q->error(QNearFieldTarget::NdefWriteError, m_writeNdefRequestId);
+    m_writeNdefRequestId = QNearFieldTarget::RequestId();
+}
+
+bool QNearFieldTagType2Private::isReserved(int offset) const
+{
+    QMap<int, int>::ConstIterator i;
+    for (i = m_reservedMemory.constBegin(); i != m_reservedMemory.constEnd(); ++i) {
+        if (offset >= i.key() && offset < i.key() + i.value())
+            return true;
+    }
+
+    return false;
+}
+
+/*!
+    Lays out the preserved and new TLVs in an image of the tag memory and determines the blocks
+    that have to be written. Blocks that only partially overlap reserved memory are also recorded
+    in m_reservedBlocks; they must be read back first so that the reserved bytes are preserved.
+
+    Returns false if the messages do not fit on the tag.
+*/
+bool QNearFieldTagType2Private::layoutNdefWrite()
+{
+    m_reservedMemory.clear();
+    m_reservedMemory.insert(0, 16);     // uid, static lock bytes, cc
+    foreach (const Tlv &tlv, m_tlvs) {
+        QPair<int, int> reserved;
+        if (tlv.first == 0x01)
+            reserved = qParseLockControlTlv(tlv.second);
+        else if (tlv.first == 0x02)
+            reserved = qParseReservedMemoryControlTlv(tlv.second);
+        else
+            continue;
+
+        if (reserved.second > 0)
+            m_reservedMemory.insert(reserved.first, reserved.second);
+    }
+
+    m_memoryImage = QByteArray(16 + m_dataAreaSize, '\0');
+
+    {
+        QTlvWriter writer(&m_memoryImage);
+
+        QMap<int, int>::ConstIterator i;
+        for (i = m_reservedMemory.constBegin(); i != m_reservedMemory.constEnd(); ++i)
+            writer.addReservedMemory(i.key(), i.value());
+
+        // write old TLVs
+        foreach (const Tlv &tlv, m_tlvs)
+            writer.writeTlv(tlv.first, tlv.second);
+
+        // write new NDEF message TLVs
+        foreach (const QNdefMessage &message, m_ndefWriteMessages)
+            writer.writeTlv(0x03, message.toByteArray());
+
+        // write terminator TLV
+        writer.writeTlv(0xfe);
+
+        if (!writer.process())
+            return false;
+    }
+
+    // The image is zero filled, so the terminator TLV is the last non-zero byte written.
+    int lastBlock = m_memoryImage.lastIndexOf(char(0xfe)) / 4;
+
+    m_writeBlocks.clear();
+    m_reservedBlocks.clear();
+    for (int block = 4; block <= lastBlock; ++block) {
+        int reservedBytes = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (isReserved(block * 4 + i))
+                ++reservedBytes;
+        }
+
+        if (reservedBytes == 4)
+            continue;
+
+        if (reservedBytes != 0)
+            m_reservedBlocks.append(block);
+
+        m_writeBlocks.append(block);
+    }
+
+    return true;
+}
+
+/*!
+    Queues a READ (\a write is false) or WRITE (\a write is true) command for each of \a blocks,
+    grouped into one batch per sector.
+*/
+void QNearFieldTagType2Private::queueBlockCommands(const QList<int> &blocks, bool write)
+{
+    m_batches.clear();
+
+    foreach (int block, blocks) {
+        if (m_batches.isEmpty() || m_batches.last().sector != block / 256) {
+            BlockCommandBatch batch;
+            batch.sector = block / 256;
+            m_batches.append(batch);
+        }
+
+        QByteArray command;
+        if (write) {
+            command.append(char(0xa2));                         // WRITE
+            command.append(char(block % 256));                  // Block address
+            command.append(m_memoryImage.mid(block * 4, 4));    // Data
+        } else {
+            command.append(char(0x30));                         // READ
+            command.append(char(block % 256));                  // Block address
+        }
+        m_batches.last().commands.append(command);
+    }
+}
+
+/*!
+    Sends the next pending batch of commands, selecting its sector first if required. Returns
+    false if a request could not be issued.
+*/
+bool QNearFieldTagType2Private::sendNextBatch()
+{
+    Q_Q(QNearFieldTagType2);
+
+    const BlockCommandBatch &batch = m_batches.first();
+
+    if (batch.sector != m_currentSector)
+        m_nextExpectedRequestId = q->selectSector(batch.sector);
+    else
+        m_nextExpectedRequestId = q->sendCommands(batch.commands);
+
+    return m_nextExpectedRequestId.isValid();
+}
+
+void QNearFieldTagType2Private::progressToNextNdefWriteMessageState()
+{
+    Q_Q(QNearFieldTagType2);
+
+    switch (m_writeNdefMessageState) {
+    case NotWritingNdefMessage:
+        m_tlvs.clear();
+
+        // the capability container lives in sector 0
+        if (m_currentSector != 0) {
+            m_writeNdefMessageState = NdefWriteSelectingSector;
+            m_nextExpectedRequestId = q->selectSector(0);
+            break;
+        }
+
+        m_writeNdefMessageState = NdefWriteReadingCapabilityContainer;
+        m_nextExpectedRequestId = q->readBlock(0);
+        break;
+    case NdefWriteSelectingSector:
+        if (!q->requestResponse(m_nextExpectedRequestId).toBool()) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        m_writeNdefMessageState = NdefWriteReadingCapabilityContainer;
+        m_nextExpectedRequestId = q->readBlock(0);
+        break;
+    case NdefWriteReadingCapabilityContainer:
+        if (!checkCapabilityContainer(true)) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        m_writeNdefMessageState = NdefWriteReadingTlv;
+        delete m_tlvReader;
+        m_tlvReader = new QTlvReader(q);
+        m_tlvReader->setTagMemorySize(16 + m_dataAreaSize);
+
+        Q_FALLTHROUGH(); // fall through
+    case NdefWriteReadingTlv:
+        Q_ASSERT(m_tlvReader);
+        while (!m_tlvReader->atEnd()) {
+            if (!m_tlvReader->readNext())
+                break;
+
+            quint8 tag = m_tlvReader->tag();
+            if (tag == 0x01 || tag == 0x02 || tag == 0xfd)
+                m_tlvs.append(qMakePair(tag, m_tlvReader->data()));
+        }
+
+        m_nextExpectedRequestId = m_tlvReader->requestId();
+        if (m_nextExpectedRequestId.isValid())
+            break;
+
+        delete m_tlvReader;
+        m_tlvReader = 0;
+
+        if (!layoutNdefWrite() || m_writeBlocks.isEmpty()) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        m_batchResponses.clear();
+        if (m_reservedBlocks.isEmpty()) {
+            m_writeNdefMessageState = NdefWriteWritingBlocks;
+            queueBlockCommands(m_writeBlocks, true);
+        } else {
+            m_writeNdefMessageState = NdefWriteReadingReservedBlocks;
+            queueBlockCommands(m_reservedBlocks, false);
+        }
+
+        if (!sendNextBatch())
+            abortNdefWriteMessage();
+        break;
+    case NdefWriteReadingReservedBlocks:
+    case NdefWriteWritingBlocks: {
+        const QVariant response = q->requestResponse(m_nextExpectedRequestId);
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+
+        if (response.type() == QVariant::Bool) {
+            // sector select completed, send the batch itself
+            if (!response.toBool() || !sendNextBatch())
+                abortNdefWriteMessage();
+            break;
+        }
+
+        const QList<QByteArray> responses = response.value<QList<QByteArray> >();
+        if (responses.count() != m_batches.first().commands.count()) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        if (m_writeNdefMessageState == NdefWriteWritingBlocks) {
+            foreach (const QByteArray &ack, responses) {
+                if (ack.isEmpty() || quint8(ack.at(0)) != 0x0a) {
+                    abortNdefWriteMessage();
+                    return;
+                }
+            }
+        } else {
+            m_batchResponses.append(responses);
+        }
+
+        m_batches.removeFirst();
+        if (!m_batches.isEmpty()) {
+            if (!sendNextBatch())
+                abortNdefWriteMessage();
+            break;
+        }
+
+        if (m_writeNdefMessageState == NdefWriteReadingReservedBlocks) {
+            // preserve the reserved bytes read back from the tag
+            for (int i = 0; i < m_reservedBlocks.count(); ++i) {
+                const int blockStart = m_reservedBlocks.at(i) * 4;
+                const QByteArray &original = m_batchResponses.at(i);
+                for (int j = 0; j < 4 && j < original.length(); ++j) {
+                    if (isReserved(blockStart + j))
+                        m_memoryImage[blockStart + j] = original.at(j);
+                }
+            }
+
+            m_reservedBlocks.clear();
+            m_batchResponses.clear();
+
+            m_writeNdefMessageState = NdefWriteWritingBlocks;
+            queueBlockCommands(m_writeBlocks, true);
+            if (!sendNextBatch())
+                abortNdefWriteMessage();
+            break;
+        }
+
+        m_tlvs.clear();
+        m_reservedMemory.clear();
+        m_memoryImage.clear();
+        m_writeBlocks.clear();
+        m_writeNdefMessageState = NotWritingNdefMessage;
+        emit q->ndefMessagesWritten();
+        emit q->requestCompleted(m_writeNdefRequestId);
+        m_writeNdefRequestId = QNearFieldTarget::RequestId();
+        break;
+    }
+    }
+}
+void QNearFieldTagType2Private::_q_requestCompleted(const QNearFieldTarget::RequestId &id)
+{
+    if (!m_nextExpectedRequestId.isValid() || m_nextExpectedRequestId != id)
+        return;
+
+    // continue reading / writing NDEF message
+    if (m_readNdefMessageState != NotReadingNdefMessage)
+        progressToNextNdefReadMessageState();
+    else if (m_writeNdefMessageState != NotWritingNdefMessage)
+        progressToNextNdefWriteMessageState();
+}
+
+void QNearFieldTagType2Private::_q_requestError(QNearFieldTarget::Error error,
+                                                const QNearFieldTarget::RequestId &id)
+{
+    Q_UNUSED(error);
+
+    if (!m_nextExpectedRequestId.isValid() || m_nextExpectedRequestId != id)
+        return;
+
+    if (m_readNdefMessageState != NotReadingNdefMessage)
+        abortNdefReadMessage();
+    else if (m_writeNdefMessageState != NotWritingNdefMessage)
+        abortNdefWriteMessage();
+}
+
 static QVariant decodeResponse(const QByteArray &command, const QByteArray &response)
 {
     quint8 opcode = command.at(0);
@@ -98,8 +589,12 @@ static QVariant decodeResponse(const QByteArray &command, const QByteArray &resp
     Constructs a new tag type 2 near field target with \a parent.
 */
 QNearFieldTagType2::QNearFieldTagType2(QObject *parent)
-:   QNearFieldTarget(parent), d_ptr(new QNearFieldTagType2Private)
+:   QNearFieldTarget(parent), d_ptr(new QNearFieldTagType2Private(this))
 {
+    connect(this, SIGNAL(requestCompleted(QNearFieldTarget::RequestId)),
+            this, SLOT(_q_requestCompleted(QNearFieldTarget::RequestId)));
+    connect(this, SIGNAL(error(QNearFieldTarget::Error,QNearFieldTarget::RequestId)),
+            this, SLOT(_q_requestError(QNearFieldTarget::Error,QNearFieldTarget::RequestId)));
 }
 
 /*!
@@ -107,6 +602,7 @@ QNearFieldTagType2::QNearFieldTagType2(QObject *parent)
 */
 QNearFieldTagType2::~QNearFieldTagType2()
 {
+    delete d_ptr->m_tlvReader;
     delete d_ptr;
 }
 
@@ -115,26 +611,81 @@ QNearFieldTagType2::~QNearFieldTagType2()
 */
 bool QNearFieldTagType2::hasNdefMessage()
 {
-    qWarning() << Q_FUNC_INFO << "is unimplemeted";
-    return false;
+    Q_D(QNearFieldTagType2);
+    if (d->m_currentSector != 0) {
+        RequestId id = selectSector(0);
+        if (!waitForRequestCompleted(id))
+            return false;
+    }
+
+    RequestId id = readBlock(0);
+    if (!waitForRequestCompleted(id))
+        return false;
+
+    const QByteArray data = requestResponse(id).toByteArray();
+
+    if (data.length() < 16)
+        return false;
+
+    // Check if NDEF Message Magic number is present
+    quint8 nmn = data.at(12);
+    if (nmn != 0xe1)
+        return false;
+
+    // Check if TLV contains NDEF Message
+    return true;
 }
 
 /*!
     \reimp
+
+    The capability container is read first. The TLV area is then read with as few READ commands
+    as possible; every READ returns 16 bytes, which are all consumed, and where more than one READ
+    is required they are pipelined with sendCommands().
 */
 QNearFieldTarget::RequestId QNearFieldTagType2::readNdefMessages()
 {
-    return RequestId();
+    Q_D(QNearFieldTagType2);
+
+    RequestId id(new RequestIdPrivate);
+
+    if (d->m_readNdefMessageState == QNearFieldTagType2Private::NotReadingNdefMessage &&
+        d->m_writeNdefMessageState == QNearFieldTagType2Private::NotWritingNdefMessage) {
+        d->m_readNdefRequestId = id;
+        d->progressToNextNdefReadMessageState();
+    } else {
+        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
+                                  Q_ARG(QNearFieldTarget::Error, NdefReadError),
+                                  Q_ARG(QNearFieldTarget::RequestId, id));
+    }
+
+    return id;
 }
 
 /*!
     \reimp
+
+    Existing Lock Control, Memory Control and proprietary TLVs are preserved. The new TLV area is
+    planned up front and written with one sendCommands() batch of WRITE commands per sector.
 */
 QNearFieldTarget::RequestId QNearFieldTagType2::writeNdefMessages(const QList<QNdefMessage> &messages)
 {
-    Q_UNUSED(messages);
+    Q_D(QNearFieldTagType2);
+
+    RequestId id(new RequestIdPrivate);
+
+    if (d->m_readNdefMessageState == QNearFieldTagType2Private::NotReadingNdefMessage &&
+        d->m_writeNdefMessageState == QNearFieldTagType2Private::NotWritingNdefMessage) {
+        d->m_ndefWriteMessages = messages;
+        d->m_writeNdefRequestId = id;
+        d->progressToNextNdefWriteMessageState();
+    } else {
+        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
+                                  Q_ARG(QNearFieldTarget::Error, NdefWriteError),
+                                  Q_ARG(QNearFieldTarget::RequestId, id));
+    }
 
-    return RequestId();
+    return id;
 }
 
 /*!
@@ -326,3 +877,5 @@ void QNearFieldTagType2::timerEvent(QTimerEvent *event)
 }
 
 QT_END_NAMESPACE
+
+#include "moc_qnearfieldtagtype2_p.cpp"
@@ -38,6 +38,10 @@
 ****************************************************************************/
 
 #include "qnearfieldtagtype4_p.h"
+#include "qnearfieldtarget_p.h"
+#include "qndefmessage.h"
+
+#include <QtCore/QVariant>
 
 QT_BEGIN_NAMESPACE
 
@@ -56,12 +60,495 @@ QT_BEGIN_NAMESPACE
     \reimp
 */
 
+static const char ndefApplicationName[] = "\xd2\x76\x00\x00\x85\x01\x01";
+static const quint16 capabilityContainerFileId = 0xe103;
+
+// Largest Lc and Le that can be encoded in a short APDU.
+static const int maxShortLc = 255;
+static const int maxShortLe = 256;
+
+static QByteArray selectApplicationCommand(const QByteArray &name)
+{
+    QByteArray command;
+    command.append(char(0x00));             // CLA
+    command.append(char(0xa4));             // INS: SELECT
+    command.append(char(0x04));             // P1: select by name
+    command.append(char(0x00));             // P2: first or only occurrence
+    command.append(char(name.length()));    // Lc
+    command.append(name);                   // Data
+    command.append(char(0x00));             // Le
+
+    return command;
+}
+
+static QByteArray selectFileCommand(quint16 fileIdentifier)
+{
+    QByteArray command;
+    command.append(char(0x00));                 // CLA
+    command.append(char(0xa4));                 // INS: SELECT
+    command.append(char(0x00));                 // P1: select by file identifier
+    command.append(char(0x0c));                 // P2: first or only occurrence, no FCI
+    command.append(char(0x02));                 // Lc
+    command.append(char(fileIdentifier >> 8));  // Data
+    command.append(char(fileIdentifier & 0xff));
+
+    return command;
+}
+
+static QByteArray readBinaryCommand(quint16 offset, int length)
+{
+    QByteArray command;
+    command.append(char(0x00));             // CLA
+    command.append(char(0xb0));             // INS: READ BINARY
+    command.append(char(offset >> 8));      // P1, P2: offset
+    command.append(char(offset & 0xff));
+    command.append(char(length & 0xff));    // Le, 0 requests 256 bytes
+
+    return command;
+}
+
+static QByteArray updateBinaryCommand(quint16 offset, const QByteArray &data)
+{
+    QByteArray command;
+    command.append(char(0x00));             // CLA
+    command.append(char(0xd6));             // INS: UPDATE BINARY
+    command.append(char(offset >> 8));      // P1, P2: offset
+    command.append(char(offset & 0xff));
+    command.append(char(data.length()));    // Lc
+    command.append(data);                   // Data
+
+    return command;
+}
+
+static inline bool isSuccess(const QByteArray &response)
+{
+    // status word 90 00
+    return response.length() >= 2 &&
+           quint8(response.at(response.length() - 2)) == 0x90 &&
+           quint8(response.at(response.length() - 1)) == 0x00;
+}
+
+static inline quint16 readUint16(const QByteArray &data, int offset)
+{
+    return (quint8(data.at(offset)) << 8) | quint8(data.at(offset + 1));
+}
+
+class QNearFieldTagType4Private
+{
+    Q_DECLARE_PUBLIC(QNearFieldTagType4)
+
+public:
+    QNearFieldTagType4Private(QNearFieldTagType4 *q)
+    :   q_ptr(q), m_readNdefMessageState(NotReadingNdefMessage),
+        m_writeNdefMessageState(NotWritingNdefMessage),
+        m_version(0), m_maxReadLength(0), m_maxUpdateLength(0), m_ndefFileId(0),
+        m_maxNdefFileSize(0), m_ndefReadAccess(0xff), m_ndefWriteAccess(0xff), m_ndefLength(0)
+    { }
+
+    QNearFieldTagType4 *q_ptr;
+
+    QMap<QNearFieldTarget::RequestId, QByteArray> m_pendingInternalCommands;
+
+    enum ReadNdefMessageState {
+        NotReadingNdefMessage,
+        NdefReadReadingCapabilityContainer,
+        NdefReadReadingNdefLength,
+        NdefReadReadingNdefFile
+    };
+
+    void progressToNextNdefReadMessageState();
+    void abortNdefReadMessage();
+    ReadNdefMessageState m_readNdefMessageState;
+    QNearFieldTarget::RequestId m_readNdefRequestId;
+
+    enum WriteNdefMessageState {
+        NotWritingNdefMessage,
+        NdefWriteReadingCapabilityContainer,
+        NdefWriteWritingNdefFile
+    };
+
+    void progressToNextNdefWriteMessageState();
+    void abortNdefWriteMessage();
+    WriteNdefMessageState m_writeNdefMessageState;
+    QNearFieldTarget::RequestId m_writeNdefRequestId;
+    QList<QNdefMessage> m_ndefWriteMessages;
+
+    QList<QByteArray> capabilityContainerCommands() const;
+    bool parseCapabilityContainer(const QList<QByteArray> &responses);
+    int maxReadLength() const;
+    int maxUpdateLength() const;
+    QList<QByteArray> readCommands(int offset, int length) const;
+
+    QNearFieldTarget::RequestId m_nextExpectedRequestId;
+    QList<QByteArray> m_sentCommands;
+
+    // capability container
+    quint8 m_version;
+    int m_maxReadLength;
+    int m_maxUpdateLength;
+    quint16 m_ndefFileId;
+    int m_maxNdefFileSize;
+    quint8 m_ndefReadAccess;
+    quint8 m_ndefWriteAccess;
+
+    int m_ndefLength;
+    QByteArray m_ndefData;
+
+    void _q_requestCompleted(const QNearFieldTarget::RequestId &id);
+    void _q_requestError(QNearFieldTarget::Error error, const QNearFieldTarget::RequestId &id);
+};
+
+/*!
+    Returns the commands that select the NDEF Tag Application and read the capability container.
+    They are sent together so that the capability container is known after a single exchange.
+*/
+QList<QByteArray> QNearFieldTagType4Private::capabilityContainerCommands() const
+{
+    QList<QByteArray> commands;
+    commands.append(selectApplicationCommand(QByteArray::fromRawData(ndefApplicationName, 7)));
+    commands.append(selectFileCommand(capabilityContainerFileId));
+    commands.append(readBinaryCommand(0, 15));
+
+    return commands;
+}
+
+/*!
+    Parses the responses to capabilityContainerCommands(). Returns false if the NDEF Tag
+    Application or a valid capability container is not present.
+*/
+bool QNearFieldTagType4Private::parseCapabilityContainer(const QList<QByteArray> &responses)
+{
+    if (responses.count() != 3)
+        return false;
+
+    foreach (const QByteArray &response, responses) {
+        if (!isSuccess(response))
+            return false;
+    }
+
+    const QByteArray cc = responses.at(2).left(responses.at(2).length() - 2);
+    if (cc.length() < 15)
+        return false;
+
+    m_version = cc.at(2);
+
+    // only mapping version 2.0 is supported
+    if ((m_version >> 4) != 0x02)
+        return false;
+
+    m_maxReadLength = readUint16(cc, 3);
+    m_maxUpdateLength = readUint16(cc, 5);
+
+    // NDEF File Control TLV
+    if (quint8(cc.at(7)) != 0x04 || quint8(cc.at(8)) < 0x06)
+        return false;
+
+    m_ndefFileId = readUint16(cc, 9);
+    m_maxNdefFileSize = readUint16(cc, 11);
+    m_ndefReadAccess = cc.at(13);
+    m_ndefWriteAccess = cc.at(14);
+
+    return m_maxReadLength > 0 && m_maxUpdateLength > 0 && m_maxNdefFileSize >= 2;
+}
+
+/*!
+    Returns the largest number of bytes that can be read with one READ BINARY command, limited by
+    MLe from the capability container and the short APDU encoding.
+*/
+int QNearFieldTagType4Private::maxReadLength() const
+{
+    return qMin(m_maxReadLength, maxShortLe);
+}
+
+/*!
+    Returns the largest number of bytes that can be written with one UPDATE BINARY command,
+    limited by MLc from the capability container, the short APDU encoding and the maximum command
+    length of the target.
+*/
+int QNearFieldTagType4Private::maxUpdateLength() const
+{
+    Q_Q(const QNearFieldTagType4);
+
+    int length = qMin(m_maxUpdateLength, maxShortLc);
+
+    // 5 byte command header
+    const int maxCommandLength = q->maxCommandLength();
+    if (maxCommandLength > 5)
+        length = qMin(length, maxCommandLength - 5);
+
+    return length;
+}
+
+/*!
+    Returns the READ BINARY commands that read \a length bytes of the selected file starting at
+    \a offset with as few commands as possible.
+*/
+QList<QByteArray> QNearFieldTagType4Private::readCommands(int offset, int length) const
+{
+    QList<QByteArray> commands;
+
+    const int chunk = maxReadLength();
+    for (int i = 0; i < length; i += chunk)
+        commands.append(readBinaryCommand(offset + i, qMin(chunk, length - i)));
+
+    return commands;
+}
+
+void QNearFieldTagType4Private::abortNdefReadMessage()
+{
+    Q_Q(QNearFieldTagType4);
+
+    m_ndefData.clear();
+    m_sentCommands.clear();
+    m_readNdefMessageState = NotReadingNdefMessage;
+    m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+    emit q->error(QNearFieldTarget::NdefReadError, m_readNdefRequestId);
+    m_readNdefRequestId = QNearFieldTarget::RequestId();
+}
+
+void QNearFieldTagType4Private::progressToNextNdefReadMessageState()
+{
+    Q_Q(QNearFieldTagType4);
+
+    switch (m_readNdefMessageState) {
+    case NotReadingNdefMessage:
+        m_readNdefMessageState = NdefReadReadingCapabilityContainer;
+        m_nextExpectedRequestId = q->sendCommands(capabilityContainerCommands());
+        if (!m_nextExpectedRequestId.isValid())
+            abortNdefReadMessage();
+        break;
+    case NdefReadReadingCapabilityContainer: {
+        const QList<QByteArray> responses =
+            q->requestResponse(m_nextExpectedRequestId).value<QList<QByteArray> >();
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+
+        if (!parseCapabilityContainer(responses) || m_ndefReadAccess != 0x00) {
+            abortNdefReadMessage();
+            break;
+        }
+
+        // select the NDEF file and read NLEN together with as much of the message as possible
+        QList<QByteArray> commands;
+        commands.append(selectFileCommand(m_ndefFileId));
+        commands.append(readBinaryCommand(0, qMin(maxReadLength(), m_maxNdefFileSize)));
+
+        m_readNdefMessageState = NdefReadReadingNdefLength;
+        m_nextExpectedRequestId = q->sendCommands(commands);
+        if (!m_nextExpectedRequestId.isValid())
+            abortNdefReadMessage();
+        break;
+    }
+    case NdefReadReadingNdefLength: {
+        const QList<QByteArray> responses =
+            q->requestResponse(m_nextExpectedRequestId).value<QList<QByteArray> >();
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+
+        if (responses.count() != 2 || !isSuccess(responses.at(0)) ||
+            !isSuccess(responses.at(1)) || responses.at(1).length() < 4) {
+            abortNdefReadMessage();
+            break;
+        }
+
+        const QByteArray data = responses.at(1).left(responses.at(1).length() - 2);
+
+        m_ndefLength = readUint16(data, 0);
+        if (m_ndefLength > m_maxNdefFileSize - 2) {
+            abortNdefReadMessage();
+            break;
+        }
+
+        m_ndefData = data.mid(2, m_ndefLength);
+
+        // read the rest of the message with one batch of maximum sized reads
+        const int remaining = m_ndefLength - m_ndefData.length();
+        if (remaining > 0) {
+            m_readNdefMessageState = NdefReadReadingNdefFile;
+            m_nextExpectedRequestId =
+                q->sendCommands(readCommands(2 + m_ndefData.length(), remaining));
+            if (!m_nextExpectedRequestId.isValid())
+                abortNdefReadMessage();
+            break;
+        }
+
+        Q_FALLTHROUGH(); // fall through
+    }
+    case NdefReadReadingNdefFile:
+        if (m_nextExpectedRequestId.isValid()) {
+            const QList<QByteArray> responses =
+                q->requestResponse(m_nextExpectedRequestId).value<QList<QByteArray> >();
+            m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+
+            foreach (const QByteArray &response, responses) {
+                if (!isSuccess(response)) {
+                    abortNdefReadMessage();
+                    return;
+                }
+
+                m_ndefData.append(response.left(response.length() - 2));
+            }
+
+            if (m_ndefData.length() != m_ndefLength) {
+                abortNdefReadMessage();
+                break;
+            }
+        }
+
+        if (!m_ndefData.isEmpty())
+            emit q->ndefMessageRead(QNdefMessage::fromByteArray(m_ndefData));
+
+        m_ndefData.clear();
+        m_readNdefMessageState = NotReadingNdefMessage;
+        emit q->requestCompleted(m_readNdefRequestId);
+        m_readNdefRequestId = QNearFieldTarget::RequestId();
+        break;
+    }
+}
+
+void QNearFieldTagType4Private::abortNdefWriteMessage()
+{
+    Q_Q(QNearFieldTagType4);
+
+    m_sentCommands.clear();
+    m_writeNdefMessageState = NotWritingNdefMessage;
+    m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+    emit q->error(QNearFieldTarget::NdefWriteError, m_writeNdefRequestId);
+    m_writeNdefRequestId = QNearFieldTarget::RequestId();
+}
+
+void QNearFieldTagType4Private::progressToNextNdefWriteMessageState()
+{
+    Q_Q(QNearFieldTagType4);
+
+    switch (m_writeNdefMessageState) {
+    case NotWritingNdefMessage:
+        m_writeNdefMessageState = NdefWriteReadingCapabilityContainer;
+        m_nextExpectedRequestId = q->sendCommands(capabilityContainerCommands());
+        if (!m_nextExpectedRequestId.isValid())
+            abortNdefWriteMessage();
+        break;
+    case NdefWriteReadingCapabilityContainer: {
+        const QList<QByteArray> responses =
+            q->requestResponse(m_nextExpectedRequestId).value<QList<QByteArray> >();
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+
+        if (!parseCapabilityContainer(responses) || m_ndefWriteAccess != 0x00) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        QByteArray message;
+        if (!m_ndefWriteMessages.isEmpty())
+            message = m_ndefWriteMessages.first().toByteArray();
+
+        if (message.length() > m_maxNdefFileSize - 2) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        // NLEN is cleared while the message is written so that a torn write leaves an empty
+        // NDEF file behind
+        const QByteArray emptyLength(2, char(0x00));
+        QByteArray length;
+        length.append(char(message.length() >> 8));
+        length.append(char(message.length() & 0xff));
+
+        m_sentCommands.clear();
+        m_sentCommands.append(selectFileCommand(m_ndefFileId));
+
+        if (!message.isEmpty()) {
+            m_sentCommands.append(updateBinaryCommand(0, emptyLength));
+
+            const int chunk = maxUpdateLength();
+            for (int i = 0; i < message.length(); i += chunk)
+                m_sentCommands.append(updateBinaryCommand(2 + i, message.mid(i, chunk)));
+        }
+
+        m_sentCommands.append(updateBinaryCommand(0, length));
+
+        m_writeNdefMessageState = NdefWriteWritingNdefFile;
+        m_nextExpectedRequestId = q->sendCommands(m_sentCommands);
+        if (!m_nextExpectedRequestId.isValid())
+            abortNdefWriteMessage();
+        break;
+    }
+    case NdefWriteWritingNdefFile: {
+        const QList<QByteArray> responses =
+            q->requestResponse(m_nextExpectedRequestId).value<QList<QByteArray> >();
+        m_nextExpectedRequestId = QNearFieldTarget::RequestId();
+
+        if (responses.count() != m_sentCommands.count()) {
+            abortNdefWriteMessage();
+            break;
+        }
+
+        foreach (const QByteArray &response, responses) {
+            if (!isSuccess(response)) {
+                abortNdefWriteMessage();
+                return;
+            }
+        }
+
+        m_sentCommands.clear();
+        m_writeNdefMessageState = NotWritingNdefMessage;
+        emit q->ndefMessagesWritten();
+        emit q->requestCompleted(m_writeNdefRequestId);
+        m_writeNdefRequestId = QNearFieldTarget::RequestId();
+        break;
+    }
+    }
+}
+
+void QNearFieldTagType4Private::_q_requestCompleted(const QNearFieldTarget::RequestId &id)
+{
+    if (!m_nextExpectedRequestId.isValid() || m_nextExpectedRequestId != id)
+        return;
+
+    // continue reading / writing NDEF message
+    if (m_readNdefMessageState != NotReadingNdefMessage)
+        progressToNextNdefReadMessageState();
+    else if (m_writeNdefMessageState != NotWritingNdefMessage)
+        progressToNextNdefWriteMessageState();
+}
+
+void QNearFieldTagType4Private::_q_requestError(QNearFieldTarget::Error error,
+                                                const QNearFieldTarget::RequestId &id)
+{
+    Q_UNUSED(error);
+
+    if (!m_nextExpectedRequestId.isValid() || m_nextExpectedRequestId != id)
+        return;
+
+    if (m_readNdefMessageState != NotReadingNdefMessage)
+        abortNdefReadMessage();
+    else if (m_writeNdefMessageState != NotWritingNdefMessage)
+        abortNdefWriteMessage();
+}
+
+static QVariant decodeResponse(const QByteArray &command, const QByteArray &response)
+{
+    switch (quint8(command.at(1))) {
+    case 0xa4:  // SELECT
+    case 0xd6:  // UPDATE BINARY
+        return isSuccess(response);
+    case 0xb0:  // READ BINARY
+        if (isSuccess(response))
+            return response.left(response.length() - 2);
+        break;
+    }
+
+    return QVariant();
+}
+
 /*!
     Constructs a new tag type 4 near field target with \a parent.
 */
 QNearFieldTagType4::QNearFieldTagType4(QObject *parent)
-:   QNearFieldTarget(parent)
+:   QNearFieldTarget(parent), d_ptr(new QNearFieldTagType4Private(this))
 {
+    connect(this, SIGNAL(requestCompleted(QNearFieldTarget::RequestId)),
+            this, SLOT(_q_requestCompleted(QNearFieldTarget::RequestId)));
+    connect(this, SIGNAL(error(QNearFieldTarget::Error,QNearFieldTarget::RequestId)),
+            this, SLOT(_q_requestError(QNearFieldTarget::Error,QNearFieldTarget::RequestId)));
 }
 
 /*!
@@ -69,6 +556,93 @@ QNearFieldTagType4::QNearFieldTagType4(QObject *parent)
 */
 QNearFieldTagType4::~QNearFieldTagType4()
 {
+    delete d_ptr;
+}
+
+/*!
+    \reimp
+*/
+bool QNearFieldTagType4::hasNdefMessage()
+{
+    Q_D(QNearFieldTagType4);
+
+    RequestId id = sendCommands(d->capabilityContainerCommands());
+    if (!waitForRequestCompleted(id))
+        return false;
+
+    if (!d->parseCapabilityContainer(requestResponse(id).value<QList<QByteArray> >()))
+        return false;
+
+    QList<QByteArray> commands;
+    commands.append(selectFileCommand(d->m_ndefFileId));
+    commands.append(readBinaryCommand(0, 2));
+
+    id = sendCommands(commands);
+    if (!waitForRequestCompleted(id))
+        return false;
+
+    const QList<QByteArray> responses = requestResponse(id).value<QList<QByteArray> >();
+    if (responses.count() != 2 || !isSuccess(responses.at(1)) || responses.at(1).length() < 4)
+        return false;
+
+    // NLEN
+    return readUint16(responses.at(1), 0) > 0;
+}
+
+/*!
+    \reimp
+
+    The NDEF Tag Application is selected and the capability container is read with a single
+    sendCommands() call. The NDEF file is then selected and read with READ BINARY commands of the
+    maximum size allowed by MLe; all but the first of them are sent together.
+*/
+QNearFieldTarget::RequestId QNearFieldTagType4::readNdefMessages()
+{
+    Q_D(QNearFieldTagType4);
+
+    RequestId id(new RequestIdPrivate);
+
+    if (d->m_readNdefMessageState == QNearFieldTagType4Private::NotReadingNdefMessage &&
+        d->m_writeNdefMessageState == QNearFieldTagType4Private::NotWritingNdefMessage) {
+        d->m_readNdefRequestId = id;
+        d->progressToNextNdefReadMessageState();
+    } else {
+        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
+                                  Q_ARG(QNearFieldTarget::Error, NdefReadError),
+                                  Q_ARG(QNearFieldTarget::RequestId, id));
+    }
+
+    return id;
+}
+
+/*!
+    \reimp
+
+    The NDEF file of an NFC Tag Type 4 tag holds a single NDEF message, writing more than one
+    message fails. After the capability container has been read all UPDATE BINARY commands, each
+    of the maximum size allowed by MLc and maxCommandLength(), are sent with a single
+    sendCommands() call.
+*/
+QNearFieldTarget::RequestId QNearFieldTagType4::writeNdefMessages(const QList<QNdefMessage> &messages)
+{
+    Q_D(QNearFieldTagType4);
+
+    RequestId id(new RequestIdPrivate);
+
+    // the NDEF file holds a single NDEF message
+    if (messages.count() <= 1 &&
+        d->m_readNdefMessageState == QNearFieldTagType4Private::NotReadingNdefMessage &&
+        d->m_writeNdefMessageState == QNearFieldTagType4Private::NotWritingNdefMessage) {
+        d->m_ndefWriteMessages = messages;
+        d->m_writeNdefRequestId = id;
+        d->progressToNextNdefWriteMessageState();
+    } else {
+        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
+                                  Q_ARG(QNearFieldTarget::Error, NdefWriteError),
+                                  Q_ARG(QNearFieldTarget::RequestId, id));
+    }
+
+    return id;
 }
 
 /*!
@@ -76,7 +650,16 @@ QNearFieldTagType4::~QNearFieldTagType4()
 */
 quint8 QNearFieldTagType4::version()
 {
-    return 0;
+    Q_D(QNearFieldTagType4);
+
+    RequestId id = sendCommands(d->capabilityContainerCommands());
+    if (!waitForRequestCompleted(id))
+        return 0;
+
+    if (!d->parseCapabilityContainer(requestResponse(id).value<QList<QByteArray> >()))
+        return 0;
+
+    return d->m_version;
 }
 
 /*!
@@ -91,9 +674,15 @@ quint8 QNearFieldTagType4::version()
 */
 QNearFieldTarget::RequestId QNearFieldTagType4::select(const QByteArray &name)
 {
-    Q_UNUSED(name);
+    const QByteArray command = selectApplicationCommand(name);
+
+    RequestId id = sendCommand(command);
+
+    Q_D(QNearFieldTagType4);
 
-    return RequestId();
+    d->m_pendingInternalCommands.insert(id, command);
+
+    return id;
 }
 
 /*!
@@ -108,9 +697,15 @@ QNearFieldTarget::RequestId QNearFieldTagType4::select(const QByteArray &name)
 */
 QNearFieldTarget::RequestId QNearFieldTagType4::select(quint16 fileIdentifier)
 {
-    Q_UNUSED(fileIdentifier);
+    const QByteArray command = selectFileCommand(fileIdentifier);
+
+    RequestId id = sendCommand(command);
+
+    Q_D(QNearFieldTagType4);
 
-    return RequestId();
+    d->m_pendingInternalCommands.insert(id, command);
+
+    return id;
 }
 
 /*!
@@ -126,10 +721,18 @@ QNearFieldTarget::RequestId QNearFieldTagType4::select(quint16 fileIdentifier)
 */
 QNearFieldTarget::RequestId QNearFieldTagType4::read(quint16 length, quint16 startOffset)
 {
-    Q_UNUSED(length);
-    Q_UNUSED(startOffset);
+    if (length > maxShortLe)
+        return RequestId();
+
+    const QByteArray command = readBinaryCommand(startOffset, length);
+
+    RequestId id = sendCommand(command);
 
-    return RequestId();
+    Q_D(QNearFieldTagType4);
+
+    d->m_pendingInternalCommands.insert(id, command);
+
+    return id;
 }
 
 /*!
@@ -143,10 +746,18 @@ QNearFieldTarget::RequestId QNearFieldTagType4::read(quint16 length, quint16 sta
 */
 QNearFieldTarget::RequestId QNearFieldTagType4::write(const QByteArray &data, quint16 startOffset)
 {
-    Q_UNUSED(data);
-    Q_UNUSED(startOffset);
+    if (data.isEmpty() || data.length() > maxShortLc)
+        return RequestId();
+
+    const QByteArray command = updateBinaryCommand(startOffset, data);
+
+    RequestId id = sendCommand(command);
+
+    Q_D(QNearFieldTagType4);
+
+    d->m_pendingInternalCommands.insert(id, command);
 
-    return RequestId();
+    return id;
 }
 
 /*!
@@ -155,7 +766,21 @@ QNearFieldTarget::RequestId QNearFieldTagType4::write(const QByteArray &data, qu
 bool QNearFieldTagType4::handleResponse(const QNearFieldTarget::RequestId &id,
                                         const QByteArray &response)
 {
+    Q_D(QNearFieldTagType4);
+
+    // the NDEF state machines continue from requestCompleted()
+    if (d->m_pendingInternalCommands.contains(id)) {
+        const QByteArray command = d->m_pendingInternalCommands.take(id);
+
+        QVariant decodedResponse = decodeResponse(command, response);
+        setResponseForRequest(id, decodedResponse);
+
+        return true;
+    }
+
     return QNearFieldTarget::handleResponse(id, response);
 }
 
 QT_END_NAMESPACE
+
+#include "moc_qnearfieldtagtype4_p.cpp"
@@ -55,16 +55,24 @@
 
 QT_BEGIN_NAMESPACE
 
+class QNearFieldTagType4Private;
+
 class Q_AUTOTEST_EXPORT QNearFieldTagType4 : public QNearFieldTarget
 {
     Q_OBJECT
 
+    Q_DECLARE_PRIVATE(QNearFieldTagType4)
+
 public:
     explicit QNearFieldTagType4(QObject *parent = 0);
     ~QNearFieldTagType4();
 
     Type type() const { return NfcTagType4; }
 
+    bool hasNdefMessage();
+    RequestId readNdefMessages();
+    RequestId writeNdefMessages(const QList<QNdefMessage> &messages);
+
     quint8 version();
 
     virtual RequestId select(const QByteArray &name);
@@ -75,6 +83,13 @@ public:
 
 protected:
     bool handleResponse(const QNearFieldTarget::RequestId &id, const QByteArray &response);
+
+private:
+    QNearFieldTagType4Private *d_ptr;
+
+    Q_PRIVATE_SLOT(d_func(), void _q_requestCompleted(const QNearFieldTarget::RequestId &id))
+    Q_PRIVATE_SLOT(d_func(), void _q_requestError(QNearFieldTarget::Error error,
+                                                  const QNearFieldTarget::RequestId &id))
 };
 
 QT_END_NAMESPACE
@@ -46,6 +46,7 @@
 #include <QtCore/QDirIterator>
 #include <QtCore/QMutex>
 #include <QtCore/QSettings>
+#include <QtCore/QTimer>
 
 QT_BEGIN_NAMESPACE
 
@@ -53,8 +54,118 @@ static QMutex tagMutex;
 static QMap<TagBase *, bool> tagMap;
 static TagActivator tagActivator;
 
+/*
+    Delivers \a response to request \a id of \a target once the emulated \a latency in
+    milliseconds has passed. Responses without latency are queued as before so that
+    waitForRequestCompleted() can deliver them immediately.
+*/
+static void postResponse(QNearFieldTarget *target, const QNearFieldTarget::RequestId &id,
+                         const QByteArray &response, int latency)
+{
+    if (latency > 0) {
+        QTimer::singleShot(latency, target, [target, id, response]() {
+            QMetaObject::invokeMethod(target, "handleResponse",
+                                      Q_ARG(QNearFieldTarget::RequestId, id),
+                                      Q_ARG(QByteArray, response));
+        });
+    } else {
+        QMetaObject::invokeMethod(target, "handleResponse", Qt::QueuedConnection,
+                                  Q_ARG(QNearFieldTarget::RequestId, id),
+                                  Q_ARG(QByteArray, response));
+    }
+}
+
+static void postResponses(QNearFieldTarget *target, const QNearFieldTarget::RequestId &id,
+                          const QList<QByteArray> &responses, int latency)
+{
+    if (latency > 0) {
+        QTimer::singleShot(latency, target, [target, id, responses]() {
+            QMetaObject::invokeMethod(target, "commandsCompleted",
+                                      Q_ARG(QNearFieldTarget::RequestId, id),
+                                      Q_ARG(QList<QByteArray>, responses));
+        });
+    } else {
+        QMetaObject::invokeMethod(target, "commandsCompleted", Qt::QueuedConnection,
+                                  Q_ARG(QNearFieldTarget::RequestId, id),
+                                  Q_ARG(QList<QByteArray>, responses));
+    }
+}
+
+static void postError(QNearFieldTarget *target, QNearFieldTarget::Error error,
+                      const QNearFieldTarget::RequestId &id, int latency)
+{
+    if (latency > 0) {
+        QTimer::singleShot(latency, target, [target, error, id]() {
+            emit target->error(error, id);
+        });
+    } else {
+        QMetaObject::invokeMethod(target, "error", Qt::QueuedConnection,
+                                  Q_ARG(QNearFieldTarget::Error, error),
+                                  Q_ARG(QNearFieldTarget::RequestId, id));
+    }
+}
+
+/*
+    Transceives \a commands with \a tag as a single request of \a target and posts the list of
+    responses, or the error of the first failing command, once the emulated latencies of all
+    commands have passed. Single byte acknowledgements carry no CRC if \a uncheckedAcks is set.
+*/
+static QNearFieldTarget::RequestId sendTagCommands(QNearFieldTarget *target, TagBase *tag,
+                                                   const QList<QByteArray> &commands,
+                                                   bool uncheckedAcks, int *requestCount,
+                                                   int *commandCount)
+{
+    QMutexLocker locker(&tagMutex);
+
+    QNearFieldTarget::RequestId id(new QNearFieldTarget::RequestIdPrivate);
+
+    // tag not in proximity
+    if (!tagMap.value(tag)) {
+        postError(target, QNearFieldTarget::TargetOutOfRangeError, id, 0);
+        return id;
+    }
+
+    ++*requestCount;
+
+    QList<QByteArray> responses;
+    int totalLatency = 0;
+
+    foreach (const QByteArray &command, commands) {
+        ++*commandCount;
+
+        quint16 crc = qChecksum(command.constData(), command.length(), Qt::ChecksumItuV41);
+
+        int latency;
+        QByteArray response = tag->transceive(command + char(crc & 0xff) + char(crc >> 8),
+                                              &latency);
+        totalLatency += latency;
+
+        // commands with a passive acknowledgement cannot be part of a command list
+        if (response.isEmpty()) {
+            postError(target, QNearFieldTarget::NoResponseError, id, totalLatency);
+            return id;
+        }
+
+        if (!uncheckedAcks || response.length() > 1) {
+            // check crc
+            if (qChecksum(response.constData(), response.length(), Qt::ChecksumItuV41) != 0) {
+                postError(target, QNearFieldTarget::ChecksumMismatchError, id, totalLatency);
+                return id;
+            }
+
+            response.chop(2);
+        }
+
+        responses.append(response);
+    }
+
+    postResponses(target, id, responses, totalLatency);
+
+    return id;
+}
+
 TagType1::TagType1(TagBase *tag, QObject *parent)
-:   QNearFieldTagType1(parent), m_tag(tag)
+:   QNearFieldTagType1(parent), m_tag(tag), m_requestCount(0), m_commandCount(0)
 {
 }
 
@@ -82,39 +193,47 @@ QNearFieldTarget::RequestId TagType1::sendCommand(const QByteArray &command)
 
     // tag not in proximity
     if (!tagMap.value(m_tag)) {
-        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
-                                  Q_ARG(QNearFieldTarget::Error, TargetOutOfRangeError),
-                                  Q_ARG(QNearFieldTarget::RequestId, id));
+        postError(this, TargetOutOfRangeError, id, 0);
         return id;
     }
 
+    ++m_requestCount;
+    ++m_commandCount;
+
     quint16 crc = qChecksum(command.constData(), command.length(), Qt::ChecksumItuV41);
 
-    QByteArray response = m_tag->processCommand(command + char(crc & 0xff) + char(crc >> 8));
+    int latency;
+    QByteArray response = m_tag->transceive(command + char(crc & 0xff) + char(crc >> 8), &latency);
 
     if (response.isEmpty()) {
-        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
-                                  Q_ARG(QNearFieldTarget::Error, NoResponseError),
-                                  Q_ARG(QNearFieldTarget::RequestId, id));
+        postError(this, NoResponseError, id, latency);
         return id;
     }
 
     // check crc
     if (qChecksum(response.constData(), response.length(), Qt::ChecksumItuV41) != 0) {
-        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
-                                  Q_ARG(QNearFieldTarget::Error, ChecksumMismatchError),
-                                  Q_ARG(QNearFieldTarget::RequestId, id));
+        postError(this, ChecksumMismatchError, id, latency);
         return id;
     }
 
     response.chop(2);
 
-    QMetaObject::invokeMethod(this, "handleResponse", Qt::QueuedConnection,
-                              Q_ARG(QNearFieldTarget::RequestId, id), Q_ARG(QByteArray, response));
+    postResponse(this, id, response, latency);
 
     return id;
 }
 
+QNearFieldTarget::RequestId TagType1::sendCommands(const QList<QByteArray> &commands)
+{
+    return sendTagCommands(this, m_tag, commands, false, &m_requestCount, &m_commandCount);
+}
+
+void TagType1::commandsCompleted(const QNearFieldTarget::RequestId &id,
+                                 const QList<QByteArray> &responses)
+{
+    setResponseForRequest(id, QVariant::fromValue(responses));
+}
+
 bool TagType1::waitForRequestCompleted(const RequestId &id, int msecs)
 {
     QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
@@ -124,7 +243,7 @@ bool TagType1::waitForRequestCompleted(const RequestId &id, int msecs)
 
 
 TagType2::TagType2(TagBase *tag, QObject *parent)
-:   QNearFieldTagType2(parent), m_tag(tag)
+:   QNearFieldTagType2(parent), m_tag(tag), m_requestCount(0), m_commandCount(0)
 {
 }
 
@@ -152,37 +271,48 @@ QNearFieldTarget::RequestId TagType2::sendCommand(const QByteArray &command)
 
     // tag not in proximity
     if (!tagMap.value(m_tag)) {
-        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
-                                  Q_ARG(QNearFieldTarget::Error, TargetOutOfRangeError),
-                                  Q_ARG(QNearFieldTarget::RequestId, id));
+        postError(this, TargetOutOfRangeError, id, 0);
         return id;
     }
 
+    ++m_requestCount;
+    ++m_commandCount;
+
     quint16 crc = qChecksum(command.constData(), command.length(), Qt::ChecksumItuV41);
 
-    QByteArray response = m_tag->processCommand(command + char(crc & 0xff) + char(crc >> 8));
+    int latency;
+    QByteArray response = m_tag->transceive(command + char(crc & 0xff) + char(crc >> 8), &latency);
 
+    // passive acknowledgement
     if (response.isEmpty())
         return id;
 
     if (response.length() > 1) {
         // check crc
         if (qChecksum(response.constData(), response.length(), Qt::ChecksumItuV41) != 0) {
-            QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection,
-                                      Q_ARG(QNearFieldTarget::Error, ChecksumMismatchError),
-                                      Q_ARG(QNearFieldTarget::RequestId, id));
+            postError(this, ChecksumMismatchError, id, latency);
             return id;
         }
 
         response.chop(2);
     }
 
-    QMetaObject::invokeMethod(this, "handleResponse", Qt::QueuedConnection,
-                              Q_ARG(QNearFieldTarget::RequestId, id), Q_ARG(QByteArray, response));
+    postResponse(this, id, response, latency);
 
     return id;
 }
 
+QNearFieldTarget::RequestId TagType2::sendCommands(const QList<QByteArray> &commands)
+{
+    return sendTagCommands(this, m_tag, commands, true, &m_requestCount, &m_commandCount);
+}
+
+void TagType2::commandsCompleted(const QNearFieldTarget::RequestId &id,
+                                 const QList<QByteArray> &responses)
+{
+    setResponseForRequest(id, QVariant::fromValue(responses));
+}
+
 bool TagType2::waitForRequestCompleted(const RequestId &id, int msecs)
 {
     QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
@@ -191,8 +321,86 @@ bool TagType2::waitForRequestCompleted(const RequestId &id, int msecs)
 }
 
 
+TagType4::TagType4(TagBase *tag, QObject *parent)
+:   QNearFieldTagType4(parent), m_tag(tag), m_requestCount(0), m_commandCount(0)
+{
+}
+
+TagType4::~TagType4()
+{
+}
+
+QByteArray TagType4::uid() const
+{
+    QMutexLocker locker(&tagMutex);
+
+    return m_tag->uid();
+}
+
+QNearFieldTarget::AccessMethods TagType4::accessMethods() const
+{
+    return NdefAccess | TagTypeSpecificAccess;
+}
+
+QNearFieldTarget::RequestId TagType4::sendCommand(const QByteArray &command)
+{
+    QMutexLocker locker(&tagMutex);
+
+    RequestId id(new RequestIdPrivate);
+
+    // tag not in proximity
+    if (!tagMap.value(m_tag)) {
+        postError(this, TargetOutOfRangeError, id, 0);
+        return id;
+    }
+
+    ++m_requestCount;
+    ++m_commandCount;
+
+    quint16 crc = qChecksum(command.constData(), command.length(), Qt::ChecksumItuV41);
+
+    int latency;
+    QByteArray response = m_tag->transceive(command + char(crc & 0xff) + char(crc >> 8), &latency);
+
+    if (response.isEmpty()) {
+        postError(this, NoResponseError, id, latency);
+        return id;
+    }
+
+    // check crc
+    if (qChecksum(response.constData(), response.length(), Qt::ChecksumItuV41) != 0) {
+        postError(this, ChecksumMismatchError, id, latency);
+        return id;
+    }
+
+    response.chop(2);
+
+    postResponse(this, id, response, latency);
+
+    return id;
+}
+
+QNearFieldTarget::RequestId TagType4::sendCommands(const QList<QByteArray> &commands)
+{
+    return sendTagCommands(this, m_tag, commands, false, &m_requestCount, &m_commandCount);
+}
+
+void TagType4::commandsCompleted(const QNearFieldTarget::RequestId &id,
+                                 const QList<QByteArray> &responses)
+{
+    setResponseForRequest(id, QVariant::fromValue(responses));
+}
+
+bool TagType4::waitForRequestCompleted(const RequestId &id, int msecs)
+{
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+
+    return QNearFieldTagType4::waitForRequestCompleted(id, msecs);
+}
+
+
 TagActivator::TagActivator()
-:   timerId(-1)
+:   timerId(-1), m_maximumActiveTargets(1)
 {
     qRegisterMetaType<QNearFieldTarget::Error>();
 }
@@ -226,11 +434,19 @@ void TagActivator::initialize()
         if (tagType == QLatin1String("TagType1")) {
             NfcTagType1 *tag = new NfcTagType1;
             tag->load(&target);
+            tag->loadEmulation(&target);
 
             tagMap.insert(tag, false);
         } else if (tagType == QLatin1String("TagType2")) {
             NfcTagType2 *tag = new NfcTagType2;
             tag->load(&target);
+            tag->loadEmulation(&target);
+
+            tagMap.insert(tag, false);
+        } else if (tagType == QLatin1String("TagType4")) {
+            NfcTagType4 *tag = new NfcTagType4;
+            tag->load(&target);
+            tag->loadEmulation(&target);
 
             tagMap.insert(tag, false);
         } else {
@@ -252,6 +468,7 @@ void TagActivator::reset()
 
     qDeleteAll(tagMap.keys());
     tagMap.clear();
+    m_active.clear();
 }
 
 TagActivator *TagActivator::instance()
@@ -259,41 +476,61 @@ TagActivator *TagActivator::instance()
     return &tagActivator;
 }
 
+/*!
+    Sets the number of tags that are in proximity at the same time to \a count. Tags are
+    activated in turn; once \a count tags are active the one activated first is removed after it
+    has not been accessed for 1.5 seconds. The default is a single tag. If \a count exceeds the
+    number of emulated tags all of them stay in proximity.
+*/
+void TagActivator::setMaximumActiveTargets(int count)
+{
+    QMutexLocker locker(&tagMutex);
+
+    m_maximumActiveTargets = qMax(1, count);
+}
+
 void TagActivator::timerEvent(QTimerEvent *e)
 {
     Q_UNUSED(e);
 
     tagMutex.lock();
 
-    if (m_current != tagMap.end()) {
-        if (m_current.key()->lastAccessTime() + 1500 > QDateTime::currentMSecsSinceEpoch()) {
+    if (m_active.count() >= m_maximumActiveTargets) {
+        TagBase *tag = m_active.first();
+        if (tag->lastAccessTime() + 1500 > QDateTime::currentMSecsSinceEpoch()) {
             tagMutex.unlock();
             return;
         }
 
-        *m_current = false;
-
-        TagBase *tag = m_current.key();
+        m_active.removeFirst();
+        tagMap[tag] = false;
 
         tagMutex.unlock();
         emit tagDeactivated(tag);
         tagMutex.lock();
     }
 
-    if (m_current != tagMap.end())
-        ++m_current;
+    // activate the next tag that is not in proximity yet
+    for (int i = 0; i < tagMap.count() && m_active.count() < m_maximumActiveTargets; ++i) {
+        if (m_current != tagMap.end())
+            ++m_current;
+
+        if (m_current == tagMap.end())
+            m_current = tagMap.begin();
 
-    if (m_current == tagMap.end())
-        m_current = tagMap.begin();
+        if (m_current == tagMap.end() || *m_current)
+            continue;
 
-    if (m_current != tagMap.end()) {
         *m_current = true;
 
         TagBase *tag = m_current.key();
+        m_active.append(tag);
 
         tagMutex.unlock();
         emit tagActivated(tag);
         tagMutex.lock();
+
+        break;
     }
 
     tagMutex.unlock();
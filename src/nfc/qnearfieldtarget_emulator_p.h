@@ -53,6 +53,7 @@
 
 #include "qnearfieldtagtype1_p.h"
 #include "qnearfieldtagtype2_p.h"
+#include "qnearfieldtagtype4_p.h"
 #include "targetemulator_p.h"
 
 #include <QtCore/QMap>
@@ -72,10 +73,20 @@ public:
     AccessMethods accessMethods() const;
 
     RequestId sendCommand(const QByteArray &command);
+    RequestId sendCommands(const QList<QByteArray> &commands);
     bool waitForRequestCompleted(const RequestId &id, int msecs = 5000);
 
+    int requestCount() const { return m_requestCount; }
+    int commandCount() const { return m_commandCount; }
+
+private slots:
+    void commandsCompleted(const QNearFieldTarget::RequestId &id,
+                           const QList<QByteArray> &responses);
+
 private:
     TagBase *m_tag;
+    int m_requestCount;
+    int m_commandCount;
 };
 
 class TagType2 : public QNearFieldTagType2
@@ -91,10 +102,49 @@ public:
     AccessMethods accessMethods() const;
 
     RequestId sendCommand(const QByteArray &command);
+    RequestId sendCommands(const QList<QByteArray> &commands);
     bool waitForRequestCompleted(const RequestId &id, int msecs = 5000);
 
+    int requestCount() const { return m_requestCount; }
+    int commandCount() const { return m_commandCount; }
+
+private slots:
+    void commandsCompleted(const QNearFieldTarget::RequestId &id,
+                           const QList<QByteArray> &responses);
+
 private:
     TagBase *m_tag;
+    int m_requestCount;
+    int m_commandCount;
+};
+
+class TagType4 : public QNearFieldTagType4
+{
+    Q_OBJECT
+
+public:
+    TagType4(TagBase *tag, QObject *parent);
+    ~TagType4();
+
+    QByteArray uid() const;
+
+    AccessMethods accessMethods() const;
+
+    RequestId sendCommand(const QByteArray &command);
+    RequestId sendCommands(const QList<QByteArray> &commands);
+    bool waitForRequestCompleted(const RequestId &id, int msecs = 5000);
+
+    int requestCount() const { return m_requestCount; }
+    int commandCount() const { return m_commandCount; }
+
+private slots:
+    void commandsCompleted(const QNearFieldTarget::RequestId &id,
+                           const QList<QByteArray> &responses);
+
+private:
+    TagBase *m_tag;
+    int m_requestCount;
+    int m_commandCount;
 };
 
 class TagActivator : public QObject
@@ -108,6 +158,8 @@ public:
     void initialize();
     void reset();
 
+    void setMaximumActiveTargets(int count);
+
     static TagActivator *instance();
 
 protected:
@@ -119,6 +171,8 @@ signals:
 
 private:
     QMap<TagBase *, bool>::Iterator m_current;
+    QList<TagBase *> m_active;
+    int m_maximumActiveTargets;
     int timerId;
 };
 
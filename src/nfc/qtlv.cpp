@@ -40,6 +40,7 @@
 #include "qtlv_p.h"
 
 #include "qnearfieldtagtype1_p.h"
+#include "qnearfieldtagtype2_p.h"
 
 #include <QtCore/QVariant>
 
@@ -89,18 +90,20 @@ QPair<int, int> qParseLockControlTlv(const QByteArray &tlvData)
 }
 
 QTlvReader::QTlvReader(QNearFieldTarget *target)
-:   m_target(target), m_index(-1)
+:   m_target(target), m_index(-1), m_tagMemorySize(-1), m_currentSector(0)
 {
     if (qobject_cast<QNearFieldTagType1 *>(m_target)) {
         addReservedMemory(0, 12);   // skip uid, cc
         addReservedMemory(104, 16); // skip reserved block D, lock block E
 
         addReservedMemory(120, 8);  // skip reserved block F
+    } else if (qobject_cast<QNearFieldTagType2 *>(m_target)) {
+        addReservedMemory(0, 16);   // skip uid, static lock bytes, cc
     }
 }
 
 QTlvReader::QTlvReader(const QByteArray &data)
-:   m_target(0), m_rawData(data), m_index(-1)
+:   m_target(0), m_rawData(data), m_index(-1), m_tagMemorySize(-1), m_currentSector(0)
 {
 }
 
@@ -124,6 +127,16 @@ int QTlvReader::reservedMemorySize() const
     return total;
 }
 
+/*!
+    Sets the total size of the tag memory, including the reserved header blocks, to \a size
+    bytes. The reader will not request data beyond this limit. By default the size is unknown;
+    for NFC Tag Type 2 targets it is then read from the capability container.
+*/
+void QTlvReader::setTagMemorySize(int size)
+{
+    m_tagMemorySize = size;
+}
+
 /*!
     Returns the request id that the TLV reader is currently waiting on.
 */
@@ -257,7 +270,14 @@ bool QTlvReader::readMoreData(int sparseOffset)
 
                 m_requestId = QNearFieldTarget::RequestId();
 
-                data = v.toByteArray();
+                if (v.type() == QVariant::ByteArray) {
+                    data = v.toByteArray();
+                } else {
+                    // batch of RSEG responses, each prefixed with the segment address
+                    const QList<QByteArray> responses = v.value<QList<QByteArray> >();
+                    foreach (const QByteArray &response, responses)
+                        data.append(response.mid(1));
+                }
 
                 if (absOffset < 120)
                     data = data.mid(2);
@@ -265,8 +285,118 @@ bool QTlvReader::readMoreData(int sparseOffset)
                 int length = dataLength(absOffset);
 
                 data = data.mid(absOffset - (segment * 128), length);
+            } else if (absOffset < 120) {
+                m_requestId = tag->readAll();
+                return false;
             } else {
-                m_requestId = (absOffset < 120) ? tag->readAll() : tag->readSegment(segment);
+                // read every segment required to reach sparseOffset in one go
+                int lastSegment = absoluteOffset(sparseOffset) / 128;
+
+                if (lastSegment > segment) {
+                    QList<QByteArray> commands;
+                    for (int i = segment; i <= lastSegment; ++i) {
+                        QByteArray command;
+                        command.append(char(0x10));                 // RSEG
+                        command.append(char(i << 4));               // Segment address
+                        command.append(QByteArray(8, char(0x00)));  // Data (unused)
+                        command.append(tag->uid().left(4));         // 4 bytes of UID
+                        commands.append(command);
+                    }
+
+                    m_requestId = tag->sendCommands(commands);
+                }
+
+                // fall back to a single RSEG if the target cannot process command lists
+                if (!m_requestId.isValid())
+                    m_requestId = tag->readSegment(segment);
+
+                return false;
+            }
+        } else if (QNearFieldTagType2 *tag = qobject_cast<QNearFieldTagType2 *>(m_target)) {
+            if (m_tagMemorySize == -1) {
+                // size of the data area is not known yet, read it from the capability container
+                if (m_requestId.isValid()) {
+                    QVariant v = m_target->requestResponse(m_requestId);
+                    if (!v.isValid())
+                        return false;
+
+                    m_requestId = QNearFieldTarget::RequestId();
+
+                    const QByteArray cc = v.toByteArray();
+                    m_tagMemorySize = (cc.length() < 16) ? 0 : 16 + 8 * quint8(cc.at(14));
+                } else {
+                    m_requestId = tag->readBlock(0);
+                    return false;
+                }
+            }
+
+            if (absOffset >= m_tagMemorySize)
+                return false;
+
+            // READ addresses 4 byte blocks within the 1 KiB sector selected on the tag
+            int block = absOffset / 4;
+            quint8 sector = block / 256;
+
+            // bytes that can be taken from a READ before the sector or the tag memory ends
+            int available = qMin((sector + 1) * 1024, m_tagMemorySize) - absOffset;
+
+            int length = dataLength(absOffset);
+            if (length == -1 || length > available)
+                length = available;
+
+            if (m_requestId.isValid()) {
+                QVariant v = m_target->requestResponse(m_requestId);
+                if (!v.isValid())
+                    return false;
+
+                m_requestId = QNearFieldTarget::RequestId();
+
+                if (v.type() == QVariant::Bool) {
+                    // sector select completed, treat the tag as ending here if it failed
+                    if (!v.toBool()) {
+                        m_tagMemorySize = absOffset;
+                        return false;
+                    }
+
+                    m_currentSector = sector;
+                    continue;
+                }
+
+                // A single READ returns 16 bytes, a batch of READs returns consecutive 16 byte
+                // chunks. Either way the data starts at the block containing absOffset.
+                if (v.type() == QVariant::ByteArray)
+                    data = v.toByteArray();
+                else
+                    data = v.value<QList<QByteArray> >().join();
+
+                data = data.mid(absOffset % 4, length);
+            } else {
+                if (sector != m_currentSector) {
+                    m_requestId = tag->selectSector(sector);
+                    return false;
+                }
+
+                // Fetch everything required to reach sparseOffset from the current contiguous
+                // data block in one go. Every READ returns 4 blocks, so issue one READ for every
+                // 16 bytes and pipeline them if more than one is required.
+                int required = qMin(sparseOffset - m_tlvData.length() + 1, length);
+                int reads = (absOffset % 4 + required + 15) / 16;
+
+                if (reads > 1) {
+                    QList<QByteArray> commands;
+                    for (int i = 0; i < reads; ++i) {
+                        QByteArray command;
+                        command.append(char(0x30));                 // READ
+                        command.append(char((block + 4 * i) % 256));  // Block address
+                        commands.append(command);
+                    }
+
+                    m_requestId = tag->sendCommands(commands);
+                }
+
+                // fall back to a single READ if the target cannot process command lists
+                if (!m_requestId.isValid())
+                    m_requestId = tag->readBlock(block % 256);
 
                 return false;
             }
@@ -309,26 +439,14 @@ int QTlvReader::dataLength(int startOffset) const
 }
 
 
-QTlvWriter::QTlvWriter(QNearFieldTarget *target)
-:   m_target(target), m_rawData(0), m_index(0), m_tagMemorySize(-1)
-{
-    if (qobject_cast<QNearFieldTagType1 *>(m_target)) {
-        addReservedMemory(0, 12);   // skip uid, cc
-        addReservedMemory(104, 16); // skip reserved block D, lock block E
-
-        addReservedMemory(120, 8);  // skip reserved block F
-    }
-}
-
 QTlvWriter::QTlvWriter(QByteArray *data)
-:   m_target(0), m_rawData(data), m_index(0), m_tagMemorySize(-1)
+:   m_rawData(data), m_index(0), m_tagMemorySize(data->length())
 {
 }
 
 QTlvWriter::~QTlvWriter()
 {
-    if (m_rawData)
-        process(true);
+    process();
 }
 
 void QTlvWriter::addReservedMemory(int offset, int length)
@@ -371,34 +489,15 @@ void QTlvWriter::writeTlv(quint8 tagType, const QByteArray &data)
 
 /*!
     Processes more of the TLV writer process. Returns true if the TLVs have been successfully
-    written to the target or buffer; otherwise returns false.
+    written to the buffer; otherwise returns false.
 
-    A false return value indicates that an NFC request is pending (if requestId() returns a valid
-    request identifier) or the write process has failed (requestId() returns an invalid request
-    identifier).
+    A false return value indicates that the TLVs do not fit into the buffer.
+
+    Tags are never written to directly; the caller lays out the TLVs on an image of the tag memory
+    and derives the write commands from the bytes that changed.
 */
-bool QTlvWriter::process(bool all)
+bool QTlvWriter::process()
 {
-    if (m_requestId.isValid()) {
-        QVariant v = m_target->requestResponse(m_requestId);
-        if (!v.isValid())
-            return false;
-    }
-
-    if (m_tagMemorySize == -1) {
-        if (m_rawData)
-            m_tagMemorySize = m_rawData->length();
-        else if (QNearFieldTagType1 *tag = qobject_cast<QNearFieldTagType1 *>(m_target)) {
-            if (m_requestId.isValid()) {
-                m_tagMemorySize = 8 * (tag->requestResponse(m_requestId).toUInt() + 1);
-                m_requestId = QNearFieldTarget::RequestId();
-            } else {
-                m_requestId = tag->readByte(10);
-                return false;
-            }
-        }
-    }
-
     while (!m_buffer.isEmpty()) {
         int spaceRemaining = moveToNextAvailable();
         if (spaceRemaining < 1)
@@ -406,102 +505,14 @@ bool QTlvWriter::process(bool all)
 
         int length = qMin(spaceRemaining, m_buffer.length());
 
-        if (m_rawData) {
-            m_rawData->replace(m_index, length, m_buffer);
-            m_index += length;
-            m_buffer = m_buffer.mid(length);
-        } else if (QNearFieldTagType1 *tag = qobject_cast<QNearFieldTagType1 *>(m_target)) {
-            int bufferIndex = 0;
-
-            // static memory - can only use writeByte()
-            while (m_index < 120 && bufferIndex < length) {
-                if (m_requestId.isValid()) {
-                    if (!m_target->requestResponse(m_requestId).toBool())
-                        return false;
-
-                    m_requestId = QNearFieldTarget::RequestId();
-
-                    ++m_index;
-                    ++bufferIndex;
-                } else {
-                    m_requestId = tag->writeByte(m_index, m_buffer.at(bufferIndex));
-                    m_buffer = m_buffer.mid(bufferIndex);
-                    return false;
-                }
-            }
-
-
-            // dynamic memory - writeBlock() full
-            while (m_index >= 120 && (m_index % 8 == 0) && bufferIndex + 8 < length) {
-                if (m_requestId.isValid()) {
-                    if (!m_target->requestResponse(m_requestId).toBool())
-                        return false;
-
-                    m_requestId = QNearFieldTarget::RequestId();
-
-                    m_index += 8;
-                    bufferIndex += 8;
-                } else {
-                    m_requestId = tag->writeBlock(m_index / 8, m_buffer.mid(bufferIndex, 8));
-                    m_buffer = m_buffer.mid(bufferIndex);
-                    return false;
-                }
-            }
-
-            // partial block
-            int currentBlock = m_index / 8;
-            int nextBlock = currentBlock + 1;
-            int currentBlockStart = currentBlock * 8;
-            int nextBlockStart = nextBlock * 8;
-
-            int fillLength = qMin(nextBlockStart - m_index, spaceRemaining - bufferIndex);
-
-            if (fillLength && (all || m_buffer.length() - bufferIndex >= fillLength) &&
-                (m_buffer.length() != bufferIndex)) {
-                // sufficient data available
-                if (m_requestId.isValid()) {
-                    const QVariant v = tag->requestResponse(m_requestId);
-                    if (v.type() == QVariant::ByteArray) {
-                        // read in block
-                        QByteArray block = v.toByteArray();
-
-                        int fill = qMin(fillLength, m_buffer.length() - bufferIndex);
-
-                        for (int i = m_index - currentBlockStart; i < fill; ++i)
-                            block[i] = m_buffer.at(bufferIndex++);
-
-                        // now write block
-                        m_requestId = tag->writeBlock(currentBlock, block);
-                        return false;
-                    } else if (v.type() == QVariant::Bool) {
-                        m_requestId = QNearFieldTarget::RequestId();
-                        int fill = qMin(fillLength, m_buffer.length() - bufferIndex);
-                        bufferIndex = fill - (m_index - currentBlockStart);
-
-                        // write complete
-                        if (!v.toBool())
-                            return false;
-                    }
-                } else {
-                    // read in block
-                    m_requestId = tag->readBlock(currentBlock);
-                    m_buffer = m_buffer.mid(bufferIndex);
-                    return false;
-                }
-            }
-
-            m_buffer = m_buffer.mid(bufferIndex);
-        }
+        m_rawData->replace(m_index, length, m_buffer.left(length));
+        m_index += length;
+        m_buffer = m_buffer.mid(length);
     }
 
     return true;
 }
 
-QNearFieldTarget::RequestId QTlvWriter::requestId() const
-{
-    return m_requestId;
-}
-
 int QTlvWriter::moveToNextAvailable()
 {
     int length = -1;
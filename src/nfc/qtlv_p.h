@@ -71,6 +71,8 @@ public:
     void addReservedMemory(int offset, int length);
     int reservedMemorySize() const;
 
+    void setTagMemorySize(int size);
+
     QNearFieldTarget::RequestId requestId() const;
 
     bool atEnd() const;
@@ -93,12 +95,14 @@ private:
     QByteArray m_tlvData;
     int m_index;
     QMap<int, int> m_reservedMemory;
+
+    int m_tagMemorySize;
+    quint8 m_currentSector;
 };
 
 class QTlvWriter
 {
 public:
-    explicit QTlvWriter(QNearFieldTarget *target);
     explicit QTlvWriter(QByteArray *data);
     ~QTlvWriter();
 
@@ -106,14 +110,11 @@ public:
 
     void writeTlv(quint8 tag, const QByteArray &data = QByteArray());
 
-    bool process(bool all = false);
-
-    QNearFieldTarget::RequestId requestId() const;
+    bool process();
 
 private:
     int moveToNextAvailable();
 
-    QNearFieldTarget *m_target;
     QByteArray *m_rawData;
 
     int m_index;
@@ -121,8 +122,6 @@ private:
     QMap<int, int> m_reservedMemory;
 
     QByteArray m_buffer;
-
-    QNearFieldTarget::RequestId m_requestId;
 };
 
 QPair<int, int> qParseReservedMemoryControlTlv(const QByteArray &tlvData);
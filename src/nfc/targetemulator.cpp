@@ -47,7 +47,8 @@
 QT_BEGIN_NAMESPACE
 
 TagBase::TagBase()
-:   lastAccess(0)
+:   lastAccess(0), m_commandLatency(0), m_byteLatency(0), m_maximumFrameSize(0),
+    m_errorInterval(0), m_injectedError(NoResponse), m_commandCount(0), m_traceEnabled(false)
 {
 }
 
@@ -55,6 +56,100 @@ TagBase::~TagBase()
 {
 }
 
+/*!
+    Loads the RF behavior of the emulated tag from the Emulation group of \a settings. All
+    values default to an ideal tag that responds instantly and never fails.
+
+    CommandLatency and ByteLatency are in microseconds; the latency of a command is the former
+    plus the latter for every byte sent and received, including the CRC. Commands or responses
+    longer than MaximumFrameSize bytes are not answered. Every ErrorInterval-th command fails
+    with the ErrorType NoResponse or CorruptChecksum. Trace enables the command trace.
+*/
+void TagBase::loadEmulation(QSettings *settings)
+{
+    settings->beginGroup(QStringLiteral("Emulation"));
+
+    setLatency(settings->value(QStringLiteral("CommandLatency"), 0).toInt(),
+               settings->value(QStringLiteral("ByteLatency"), 0).toInt());
+
+    setMaximumFrameSize(settings->value(QStringLiteral("MaximumFrameSize"), 0).toInt());
+
+    const QString errorType = settings->value(QStringLiteral("ErrorType")).toString();
+    setErrorInjection(settings->value(QStringLiteral("ErrorInterval"), 0).toInt(),
+                      errorType == QLatin1String("CorruptChecksum") ? CorruptChecksum
+                                                                     : NoResponse);
+
+    setTraceEnabled(settings->value(QStringLiteral("Trace"), false).toBool());
+
+    settings->endGroup();
+}
+
+/*!
+    Sets the fixed latency of every command to \a commandLatency and the transmission time of
+    every byte to \a byteLatency microseconds.
+*/
+void TagBase::setLatency(int commandLatency, int byteLatency)
+{
+    m_commandLatency = commandLatency;
+    m_byteLatency = byteLatency;
+}
+
+/*!
+    Makes every \a interval-th command fail with \a error. An \a interval of 0 disables error
+    injection.
+*/
+void TagBase::setErrorInjection(int interval, InjectedError error)
+{
+    m_errorInterval = interval;
+    m_injectedError = error;
+    m_commandCount = 0;
+}
+
+/*!
+    Passes \a command, including its CRC, through the emulated RF link and returns the
+    response of the tag. The time the exchange would take on air in milliseconds is stored in
+    \a latency.
+*/
+QByteArray TagBase::transceive(const QByteArray &command, int *latency)
+{
+    QByteArray response;
+
+    if (!m_maximumFrameSize || command.length() <= m_maximumFrameSize)
+        response = processCommand(command);
+
+    if (m_maximumFrameSize && response.length() > m_maximumFrameSize)
+        response.clear();
+
+    ++m_commandCount;
+    if (m_errorInterval > 0 && m_commandCount % m_errorInterval == 0) {
+        if (m_injectedError == NoResponse)
+            response.clear();
+        else if (!response.isEmpty())
+            response[response.length() - 1] = response.at(response.length() - 1) ^ 0xff;
+    }
+
+    const int microseconds = m_commandLatency +
+                             m_byteLatency * (command.length() + response.length());
+    const int msecs = (microseconds + 999) / 1000;
+
+    if (latency)
+        *latency = msecs;
+
+    if (m_traceEnabled) {
+        if (!m_traceTimer.isValid())
+            m_traceTimer.start();
+
+        TraceEntry entry;
+        entry.timestamp = m_traceTimer.elapsed();
+        entry.command = command;
+        entry.response = response;
+        entry.latency = msecs;
+        m_trace.append(entry);
+    }
+
+    return response;
+}
+
 static inline quint8 blockByteToAddress(quint8 block, quint8 byte)
 {
     return ((block & 0x0f) << 3) | (byte & 0x07);
@@ -386,4 +481,181 @@ QByteArray NfcTagType2::processCommand(const QByteArray &command)
     return response;
 }
 
+
+NfcTagType4::NfcTagType4()
+:   tagUid(7, char(0x44)), ndefFile(2, char(0x00)), ndefFileId(0xe104),
+    applicationSelected(false), selectedFile(NoFile)
+{
+}
+
+NfcTagType4::~NfcTagType4()
+{
+}
+
+void NfcTagType4::load(QSettings *settings)
+{
+    settings->beginGroup(QStringLiteral("TagType4"));
+
+    const QString uid = settings->value(QStringLiteral("UID")).toString();
+    if (!uid.isEmpty())
+        tagUid = QByteArray::fromHex(uid.toLatin1());
+
+    const int maxReadLength = settings->value(QStringLiteral("MaximumReadLength"), 0xff).toInt();
+    const int maxUpdateLength =
+        settings->value(QStringLiteral("MaximumUpdateLength"), 0xff).toInt();
+    ndefFileId = settings->value(QStringLiteral("NdefFileId"), 0xe104).toUInt();
+    const int maxNdefFileSize =
+        settings->value(QStringLiteral("MaximumNdefFileSize"), 0x0800).toInt();
+    const quint8 writeAccess = settings->value(QStringLiteral("WriteAccess"), 0x00).toUInt();
+
+    capabilityContainer.clear();
+    capabilityContainer.append(char(0x00));                 // CCLEN
+    capabilityContainer.append(char(0x0f));
+    capabilityContainer.append(char(0x20));                 // Mapping version 2.0
+    capabilityContainer.append(char(maxReadLength >> 8));   // MLe
+    capabilityContainer.append(char(maxReadLength & 0xff));
+    capabilityContainer.append(char(maxUpdateLength >> 8)); // MLc
+    capabilityContainer.append(char(maxUpdateLength & 0xff));
+    capabilityContainer.append(char(0x04));                 // NDEF File Control TLV
+    capabilityContainer.append(char(0x06));
+    capabilityContainer.append(char(ndefFileId >> 8));
+    capabilityContainer.append(char(ndefFileId & 0xff));
+    capabilityContainer.append(char(maxNdefFileSize >> 8));
+    capabilityContainer.append(char(maxNdefFileSize & 0xff));
+    capabilityContainer.append(char(0x00));                 // Read access
+    capabilityContainer.append(char(writeAccess));          // Write access
+
+    // NDEF file: NLEN followed by the NDEF message
+    const QByteArray message = settings->value(QStringLiteral("Data")).toByteArray();
+    ndefFile = QByteArray(maxNdefFileSize, char(0x00));
+    ndefFile[0] = char(message.length() >> 8);
+    ndefFile[1] = char(message.length() & 0xff);
+    ndefFile.replace(2, message.length(), message);
+    ndefFile.truncate(maxNdefFileSize);
+
+    settings->endGroup();
+}
+
+QByteArray NfcTagType4::uid() const
+{
+    lastAccess = QDateTime::currentMSecsSinceEpoch();
+
+    return tagUid;
+}
+
+QByteArray NfcTagType4::processCommand(const QByteArray &command)
+{
+    lastAccess = QDateTime::currentMSecsSinceEpoch();
+
+    // check checksum
+    if (command.length() < 3 ||
+        qChecksum(command.constData(), command.length(), Qt::ChecksumItuV41) != 0) {
+        return QByteArray();
+    }
+
+    QByteArray response = processApdu(command.left(command.length() - 2));
+
+    quint16 crc = qChecksum(response.constData(), response.length(), Qt::ChecksumItuV41);
+    response.append(quint8(crc & 0xff));
+    response.append(quint8(crc >> 8));
+
+    return response;
+}
+
+#define SW_SUCCESS QByteArray("\x90\x00", 2)
+#define SW_WRONG_LENGTH QByteArray("\x67\x00", 2)
+#define SW_SECURITY_STATUS QByteArray("\x69\x82", 2)
+#define SW_NOT_FOUND QByteArray("\x6a\x82", 2)
+#define SW_WRONG_PARAMETERS QByteArray("\x6b\x00", 2)
+#define SW_INS_NOT_SUPPORTED QByteArray("\x6d\x00", 2)
+
+QByteArray NfcTagType4::processApdu(const QByteArray &apdu)
+{
+    if (apdu.length() < 4)
+        return SW_WRONG_LENGTH;
+
+    const quint8 ins = apdu.at(1);
+    const quint8 p1 = apdu.at(2);
+    const quint8 p2 = apdu.at(3);
+
+    switch (ins) {
+    case 0xa4: {    // SELECT
+        if (apdu.length() < 5)
+            return SW_WRONG_LENGTH;
+
+        const QByteArray data = apdu.mid(5, quint8(apdu.at(4)));
+
+        if (p1 == 0x04) {
+            applicationSelected = (data == QByteArray("\xd2\x76\x00\x00\x85\x01\x01", 7));
+            selectedFile = NoFile;
+
+            return applicationSelected ? SW_SUCCESS : SW_NOT_FOUND;
+        }
+
+        if (p1 != 0x00 || data.length() != 2)
+            return SW_WRONG_PARAMETERS;
+
+        const quint16 fileId = (quint8(data.at(0)) << 8) | quint8(data.at(1));
+        if (applicationSelected && fileId == 0xe103)
+            selectedFile = CapabilityContainerFile;
+        else if (applicationSelected && fileId == ndefFileId)
+            selectedFile = NdefFile;
+        else
+            return SW_NOT_FOUND;
+
+        return SW_SUCCESS;
+    }
+    case 0xb0: {    // READ BINARY
+        if (apdu.length() != 5)
+            return SW_WRONG_LENGTH;
+
+        const QByteArray &file = (selectedFile == NdefFile) ? ndefFile : capabilityContainer;
+        if (selectedFile == NoFile)
+            return SW_NOT_FOUND;
+
+        const int offset = (p1 << 8) | p2;
+        int length = quint8(apdu.at(4));
+        if (length == 0)
+            length = 256;
+
+        // never return more than MLe bytes
+        const int maxReadLength = (quint8(capabilityContainer.at(3)) << 8) |
+                                  quint8(capabilityContainer.at(4));
+        if (length > maxReadLength)
+            return SW_WRONG_LENGTH;
+
+        if (offset > file.length())
+            return SW_WRONG_PARAMETERS;
+
+        return file.mid(offset, length) + SW_SUCCESS;
+    }
+    case 0xd6: {    // UPDATE BINARY
+        if (apdu.length() < 5 || apdu.length() != 5 + quint8(apdu.at(4)))
+            return SW_WRONG_LENGTH;
+
+        if (selectedFile != NdefFile)
+            return SW_NOT_FOUND;
+
+        if (capabilityContainer.at(14) != 0x00)
+            return SW_SECURITY_STATUS;
+
+        const int maxUpdateLength = (quint8(capabilityContainer.at(5)) << 8) |
+                                    quint8(capabilityContainer.at(6));
+        const QByteArray data = apdu.mid(5);
+        if (data.length() > maxUpdateLength)
+            return SW_WRONG_LENGTH;
+
+        const int offset = (p1 << 8) | p2;
+        if (offset + data.length() > ndefFile.length())
+            return SW_WRONG_PARAMETERS;
+
+        ndefFile.replace(offset, data.length(), data);
+
+        return SW_SUCCESS;
+    }
+    default:
+        return SW_INS_NOT_SUPPORTED;
+    }
+}
+
 QT_END_NAMESPACE
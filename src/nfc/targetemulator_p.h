@@ -53,6 +53,8 @@
 
 #include <QtCore/QtGlobal>
 #include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
 #include <QtNfc/qtnfcglobal.h>
 
 QT_FORWARD_DECLARE_CLASS(QSettings)
@@ -62,19 +64,58 @@ QT_BEGIN_NAMESPACE
 class TagBase
 {
 public:
+    enum InjectedError {
+        NoResponse,
+        CorruptChecksum
+    };
+
+    struct TraceEntry {
+        qint64 timestamp;
+        QByteArray command;
+        QByteArray response;
+        int latency;
+    };
+
     TagBase();
     virtual ~TagBase();
 
     virtual void load(QSettings *settings) = 0;
+    void loadEmulation(QSettings *settings);
 
     virtual QByteArray processCommand(const QByteArray &command) = 0;
+    QByteArray transceive(const QByteArray &command, int *latency = 0);
 
     virtual QByteArray uid() const = 0;
 
     qint64 lastAccessTime() const { return lastAccess; }
 
+    void setLatency(int commandLatency, int byteLatency);
+    int commandLatency() const { return m_commandLatency; }
+    int byteLatency() const { return m_byteLatency; }
+
+    void setMaximumFrameSize(int size) { m_maximumFrameSize = size; }
+    int maximumFrameSize() const { return m_maximumFrameSize; }
+
+    void setErrorInjection(int interval, InjectedError error = NoResponse);
+
+    void setTraceEnabled(bool enabled) { m_traceEnabled = enabled; }
+    bool isTraceEnabled() const { return m_traceEnabled; }
+    QList<TraceEntry> trace() const { return m_trace; }
+    void clearTrace() { m_trace.clear(); }
+
 protected:
     mutable qint64 lastAccess;
+
+private:
+    int m_commandLatency;
+    int m_byteLatency;
+    int m_maximumFrameSize;
+    int m_errorInterval;
+    InjectedError m_injectedError;
+    int m_commandCount;
+    bool m_traceEnabled;
+    QList<TraceEntry> m_trace;
+    QElapsedTimer m_traceTimer;
 };
 
 class NfcTagType1 : public TagBase
@@ -116,6 +157,35 @@ private:
     bool expectPacket2;
 };
 
+class NfcTagType4 : public TagBase
+{
+public:
+    NfcTagType4();
+    ~NfcTagType4();
+
+    void load(QSettings *settings);
+
+    QByteArray processCommand(const QByteArray &command);
+
+    QByteArray uid() const;
+
+private:
+    QByteArray processApdu(const QByteArray &apdu);
+
+    enum SelectedFile {
+        NoFile,
+        CapabilityContainerFile,
+        NdefFile
+    };
+
+    QByteArray tagUid;
+    QByteArray capabilityContainer;
+    QByteArray ndefFile;
+    quint16 ndefFileId;
+    bool applicationSelected;
+    SelectedFile selectedFile;
+};
+
 QT_END_NAMESPACE
 
 #endif // TARGETEMULATOR_P_H
@@ -20,11 +20,3 @@ qtHaveModule(quick) {
     imports.depends += bluetooth nfc
     SUBDIRS += imports
 }
-
-include($$OUT_PWD/bluetooth/qtbluetooth-config.pri)
-QT_FOR_CONFIG += bluetooth
-qtConfig(bluez) {
-    sdpscanner.subdir = tools/sdpscanner
-    sdpscanner.depends = bluetooth
-    SUBDIRS += sdpscanner
-}
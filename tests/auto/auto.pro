@@ -18,10 +18,18 @@ qtHaveModule(bluetooth) {
         qbluetoothuuid \
         qbluetoothserver \
         qlowenergycharacteristic \
+        qlowenergyconnectionmetrics \
         qlowenergydescriptor \
         qlowenergycontroller \
         qlowenergycontroller-gattserver \
         qlowenergyservice
+
+    qtConfig(bluez): SUBDIRS += qtbluezobjectmirror bluetoothmanagement sdpclient sdpdataelement \
+        servicediscoveryscheduler signcounterstore btsnooptracer roundtriptimeestimator \
+        connectionparametertuner remotedevicemanager
+    qtConfig(bluez_le): SUBDIRS += requestqueue
+    qtConfig(bluez):qtHaveModule(qml): SUBDIRS += declarativebluetoothsocket
+    qtHaveModule(qml): SUBDIRS += declarativebluetoothdiscoverymodel
 }
 
 qtHaveModule(nfc) {
@@ -31,5 +39,6 @@ qtHaveModule(nfc) {
         qnearfieldmanager \
         qnearfieldtagtype1 \
         qnearfieldtagtype2 \
+        qnearfieldtagtype4 \
         qndefnfcsmartposterrecord
 }
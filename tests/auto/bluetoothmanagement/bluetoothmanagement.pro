@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_bluetoothmanagement.cpp
+TARGET = tst_bluetoothmanagement
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
@@ -0,0 +1,259 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/private/bluetoothmanagement_p.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+QT_USE_NAMESPACE
+
+// Device Found event of an LE device with random address 11:22:33:44:55:66
+// as recorded on the Bluetooth Management control channel
+static const char leDeviceFound[] =
+        "120000002600"                          // header: Device Found, hci0, length 38
+        "665544332211" "02" "c5" "00000000"     // address, LE random, RSSI -59, flags
+        "1800"                                  // EIR length 24
+        "020106"                                // Flags
+        "05094e616d65"                          // Complete Local Name "Name"
+        "0303" "0f18"                           // Complete 16 bit UUIDs: Battery Service
+        "05ff" "4c00" "0215"                    // Manufacturer Data, company 0x004c
+        "0416" "0f18" "64";                     // Service Data, Battery Service
+
+// BR/EDR device 00:11:22:33:44:55 with class of device and a 128 bit UUID
+static const char bredrDeviceFound[] =
+        "120001002a00"                          // header: Device Found, hci1, length 42
+        "554433221100" "00" "d0" "00000000"     // address, BR/EDR, RSSI -48, flags
+        "1c00"                                  // EIR length 28
+        "040d" "0c025a"                         // Class of Device 0x5a020c
+        "1107" "fb349b5f800000800010000001110000" // Complete 128 bit UUIDs: Serial Port
+        "0408" "4465"                           // Shortened Local Name "De"
+        "00";                                   // end of significant part
+
+class tst_BluetoothManagement : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_BluetoothManagement();
+
+private slots:
+    void init();
+    void cleanup();
+
+    void tst_startStopDiscovery();
+    void tst_deviceFound();
+    void tst_classicDeviceFound();
+    void tst_multipleEvents();
+    void tst_splitEvent();
+    void tst_malformedEvent();
+    void tst_discovering();
+    void tst_commandFailed();
+
+private:
+    void send(const QByteArray &hex);
+    QByteArray receive();
+
+    BluetoothManagement *management;
+    int peer;
+};
+
+tst_BluetoothManagement::tst_BluetoothManagement()
+    : management(0), peer(-1)
+{
+    qRegisterMetaType<QBluetoothDeviceInfo>();
+}
+
+void tst_BluetoothManagement::init()
+{
+    int fds[2];
+    QCOMPARE(::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0, fds), 0);
+
+    management = new BluetoothManagement(fds[0]);
+    peer = fds[1];
+    QVERIFY(management->isMonitoringEnabled());
+}
+
+void tst_BluetoothManagement::cleanup()
+{
+    delete management;
+    management = 0;
+    ::close(peer);
+    peer = -1;
+}
+
+void tst_BluetoothManagement::send(const QByteArray &hex)
+{
+    const QByteArray data = QByteArray::fromHex(hex);
+    QCOMPARE(::write(peer, data.constData(), data.size()), ssize_t(data.size()));
+}
+
+QByteArray tst_BluetoothManagement::receive()
+{
+    char data[64];
+    const ssize_t size = ::read(peer, data, sizeof(data));
+    return size < 0 ? QByteArray() : QByteArray(data, size).toHex();
+}
+
+void tst_BluetoothManagement::tst_startStopDiscovery()
+{
+    const quint8 types = BluetoothManagement::BrEdrAddress
+            | BluetoothManagement::LePublicAddress | BluetoothManagement::LeRandomAddress;
+
+    QVERIFY(management->startDiscovery(0, types));
+    QCOMPARE(receive(), QByteArray("230000000100" "07"));
+
+    QVERIFY(management->stopDiscovery(1, BluetoothManagement::LePublicAddress));
+    QCOMPARE(receive(), QByteArray("240001000100" "02"));
+
+    BluetoothManagement disabled(-1);
+    QVERIFY(!disabled.isMonitoringEnabled());
+    QVERIFY(!disabled.startDiscovery(0, types));
+}
+
+void tst_BluetoothManagement::tst_deviceFound()
+{
+    QSignalSpy spy(management, SIGNAL(deviceFound(quint16,QBluetoothDeviceInfo,qint64)));
+
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 before = timer.msecsSinceReference();
+
+    send(leDeviceFound);
+    QTRY_COMPARE(spy.count(), 1);
+
+    QCOMPARE(spy.at(0).at(0).value<quint16>(), quint16(0));
+    QVERIFY(spy.at(0).at(2).toLongLong() >= before);
+
+    const QBluetoothDeviceInfo info = spy.at(0).at(1).value<QBluetoothDeviceInfo>();
+    const QBluetoothAddress address(QStringLiteral("11:22:33:44:55:66"));
+    QCOMPARE(info.address(), address);
+    QCOMPARE(info.name(), QStringLiteral("Name"));
+    QCOMPARE(info.rssi(), qint16(-59));
+    QCOMPARE(info.coreConfigurations(), QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+    QCOMPARE(info.serviceUuids(),
+             QList<QBluetoothUuid>() << QBluetoothUuid(QBluetoothUuid::BatteryService));
+    QCOMPARE(info.serviceUuidsCompleteness(), QBluetoothDeviceInfo::DataIncomplete);
+    QCOMPARE(info.manufacturerIds(), QVector<quint16>() << 0x004c);
+    QCOMPARE(info.manufacturerData(0x004c), QByteArray::fromHex("0215"));
+    QCOMPARE(info.serviceData(QBluetoothUuid(QBluetoothUuid::BatteryService)),
+             QByteArray::fromHex("64"));
+
+    QVERIFY(management->isAddressRandom(address));
+}
+
+void tst_BluetoothManagement::tst_classicDeviceFound()
+{
+    QSignalSpy spy(management, SIGNAL(deviceFound(quint16,QBluetoothDeviceInfo,qint64)));
+
+    send(bredrDeviceFound);
+    QTRY_COMPARE(spy.count(), 1);
+
+    QCOMPARE(spy.at(0).at(0).value<quint16>(), quint16(1));
+
+    const QBluetoothDeviceInfo info = spy.at(0).at(1).value<QBluetoothDeviceInfo>();
+    QCOMPARE(info.address(), QBluetoothAddress(QStringLiteral("00:11:22:33:44:55")));
+    QCOMPARE(info.name(), QStringLiteral("De"));
+    QCOMPARE(info.rssi(), qint16(-48));
+    QCOMPARE(info.coreConfigurations(), QBluetoothDeviceInfo::BaseRateCoreConfiguration);
+    QCOMPARE(info.majorDeviceClass(), QBluetoothDeviceInfo::PhoneDevice);
+    QCOMPARE(info.serviceUuids(),
+             QList<QBluetoothUuid>() << QBluetoothUuid(QBluetoothUuid::SerialPort));
+
+    QVERIFY(!management->isAddressRandom(info.address()));
+}
+
+void tst_BluetoothManagement::tst_multipleEvents()
+{
+    QSignalSpy spy(management, SIGNAL(deviceFound(quint16,QBluetoothDeviceInfo,qint64)));
+
+    // a single read returns both events, they share the timestamp
+    send(QByteArray(leDeviceFound) + QByteArray(bredrDeviceFound));
+    QTRY_COMPARE(spy.count(), 2);
+
+    QCOMPARE(spy.at(0).at(0).value<quint16>(), quint16(0));
+    QCOMPARE(spy.at(1).at(0).value<quint16>(), quint16(1));
+    QCOMPARE(spy.at(0).at(2).toLongLong(), spy.at(1).at(2).toLongLong());
+}
+
+void tst_BluetoothManagement::tst_splitEvent()
+{
+    QSignalSpy spy(management, SIGNAL(deviceFound(quint16,QBluetoothDeviceInfo,qint64)));
+
+    const QByteArray event(leDeviceFound);
+    send(event.left(20));
+    QTest::qWait(50);
+    QCOMPARE(spy.count(), 0);
+
+    send(event.mid(20));
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(1).value<QBluetoothDeviceInfo>().name(), QStringLiteral("Name"));
+}
+
+void tst_BluetoothManagement::tst_malformedEvent()
+{
+    QSignalSpy spy(management, SIGNAL(deviceFound(quint16,QBluetoothDeviceInfo,qint64)));
+
+    // EIR length exceeds the event, followed by a valid event
+    send("120000001000" "665544332211" "01" "c5" "00000000" "1600" "0201");
+    send(leDeviceFound);
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(1).value<QBluetoothDeviceInfo>().name(), QStringLiteral("Name"));
+}
+
+void tst_BluetoothManagement::tst_discovering()
+{
+    QSignalSpy spy(management, SIGNAL(discoveringChanged(quint16,bool)));
+
+    send("130000000200" "07" "01");
+    send("130000000200" "07" "00");
+    QTRY_COMPARE(spy.count(), 2);
+
+    QCOMPARE(spy.at(0).at(1).toBool(), true);
+    QCOMPARE(spy.at(1).at(1).toBool(), false);
+}
+
+void tst_BluetoothManagement::tst_commandFailed()
+{
+    QSignalSpy spy(management, SIGNAL(commandFailed(quint16,quint16,quint8)));
+
+    // successful completion is not reported
+    send("010000000400" "2300" "00" "07");
+    // Start Discovery rejected with Not Powered
+    send("020000000300" "2300" "0f");
+    QTRY_COMPARE(spy.count(), 1);
+
+    QCOMPARE(spy.at(0).at(1).value<quint16>(), quint16(0x0023));
+    QCOMPARE(spy.at(0).at(2).value<quint8>(), quint8(0x0f));
+}
+
+QTEST_MAIN(tst_BluetoothManagement)
+
+#include "tst_bluetoothmanagement.moc"
@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_btsnooptracer.cpp
+TARGET = tst_btsnooptracer
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
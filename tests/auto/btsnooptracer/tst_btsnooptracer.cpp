@@ -0,0 +1,195 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtCore/QTemporaryDir>
+#include <QtBluetooth/private/btsnooptracer_p.h>
+
+QT_USE_NAMESPACE
+
+class TracingThread : public QThread
+{
+public:
+    void run() override
+    {
+        const QByteArray payload = QByteArray::fromHex("021700");
+        while (!done.loadAcquire()) {
+            BtSnoopTracer::Reference tracer;
+            if (!tracer.isNull())
+                tracer->trace(BtSnoopTracer::Sent, 1, 4, payload.constData(), payload.size());
+        }
+    }
+
+    QAtomicInt done;
+};
+
+class tst_BtSnoopTracer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void header();
+    void records();
+    void truncatedPayload();
+    void startTwice();
+    void stopWhileTracing();
+
+private:
+    QByteArray readTrace() const;
+
+    QScopedPointer<QTemporaryDir> dir;
+    QString filePath;
+};
+
+void tst_BtSnoopTracer::init()
+{
+    dir.reset(new QTemporaryDir);
+    QVERIFY(dir->isValid());
+    filePath = dir->filePath(QStringLiteral("trace.btsnoop"));
+}
+
+void tst_BtSnoopTracer::cleanup()
+{
+    BtSnoopTracer::stop();
+}
+
+QByteArray tst_BtSnoopTracer::readTrace() const
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+void tst_BtSnoopTracer::header()
+{
+    QVERIFY(BtSnoopTracer::start(filePath));
+    QVERIFY(BtSnoopTracer::active());
+    BtSnoopTracer::stop();
+    QVERIFY(!BtSnoopTracer::active());
+
+    const QByteArray trace = readTrace();
+    QCOMPARE(trace.size(), 16);
+    QCOMPARE(trace.left(8), QByteArray("btsnoop\0", 8));
+    QCOMPARE(qFromBigEndian<quint32>(trace.constData() + 8), quint32(1));
+    QCOMPARE(qFromBigEndian<quint32>(trace.constData() + 12), quint32(1001));
+}
+
+void tst_BtSnoopTracer::records()
+{
+    QVERIFY(BtSnoopTracer::start(filePath));
+    BtSnoopTracer *tracer = BtSnoopTracer::active();
+    QVERIFY(tracer);
+
+    // ATT Exchange MTU Request and Response
+    const QByteArray request = QByteArray::fromHex("021700");
+    const QByteArray response = QByteArray::fromHex("031700");
+    tracer->trace(BtSnoopTracer::Sent, 0x0040, 4, request.constData(), request.size());
+    tracer->trace(BtSnoopTracer::Received, 0x0040, 4, response.constData(), response.size());
+    BtSnoopTracer::stop();
+
+    const QByteArray trace = readTrace();
+    const int recordSize = 24 + 9 + 3;
+    QCOMPARE(trace.size(), 16 + 2 * recordSize);
+
+    qint64 previousTimestamp = 0;
+    for (int i = 0; i < 2; ++i) {
+        const char *record = trace.constData() + 16 + i * recordSize;
+        QCOMPARE(qFromBigEndian<quint32>(record), quint32(12));
+        QCOMPARE(qFromBigEndian<quint32>(record + 4), quint32(12));
+        QCOMPARE(qFromBigEndian<quint32>(record + 8), quint32(i));
+        QCOMPARE(qFromBigEndian<quint32>(record + 12), quint32(0));
+
+        const qint64 timestamp = qFromBigEndian<qint64>(record + 16);
+        QVERIFY(timestamp >= previousTimestamp);
+        previousTimestamp = timestamp;
+
+        QCOMPARE(quint8(record[24]), quint8(0x02));
+        QCOMPARE(qFromLittleEndian<quint16>(record + 25), quint16(0x2040));
+        QCOMPARE(qFromLittleEndian<quint16>(record + 27), quint16(7));
+        QCOMPARE(qFromLittleEndian<quint16>(record + 29), quint16(3));
+        QCOMPARE(qFromLittleEndian<quint16>(record + 31), quint16(4));
+        QCOMPARE(QByteArray(record + 33, 3), i == 0 ? request : response);
+    }
+}
+
+void tst_BtSnoopTracer::truncatedPayload()
+{
+    QVERIFY(BtSnoopTracer::start(filePath));
+    BtSnoopTracer *tracer = BtSnoopTracer::active();
+    QVERIFY(tracer);
+
+    const QByteArray payload(BtSnoopTracer::SnapLength + 100, 'x');
+    tracer->trace(BtSnoopTracer::Sent, 1, BtSnoopTracer::DynamicChannelId,
+                  payload.constData(), payload.size());
+    BtSnoopTracer::stop();
+
+    const QByteArray trace = readTrace();
+    QCOMPARE(trace.size(), 16 + 24 + 9 + BtSnoopTracer::SnapLength);
+    QCOMPARE(qFromBigEndian<quint32>(trace.constData() + 16), quint32(9 + payload.size()));
+    QCOMPARE(qFromBigEndian<quint32>(trace.constData() + 20),
+             quint32(9 + BtSnoopTracer::SnapLength));
+}
+
+void tst_BtSnoopTracer::startTwice()
+{
+    QVERIFY(BtSnoopTracer::start(filePath));
+    QVERIFY(!BtSnoopTracer::start(dir->filePath(QStringLiteral("other.btsnoop"))));
+    QCOMPARE(BtSnoopTracer::active()->fileName(), filePath);
+}
+
+void tst_BtSnoopTracer::stopWhileTracing()
+{
+    TracingThread threads[4];
+    for (TracingThread &thread : threads)
+        thread.start();
+
+    for (int i = 0; i < 50; ++i) {
+        QVERIFY(BtSnoopTracer::start(filePath));
+        QThread::msleep(1);
+        BtSnoopTracer::stop();
+
+        // the writer only ever writes whole records
+        const QByteArray trace = readTrace();
+        QVERIFY(trace.size() >= 16);
+        QCOMPARE((trace.size() - 16) % (24 + 9 + 3), 0);
+    }
+
+    for (TracingThread &thread : threads) {
+        thread.done.storeRelease(1);
+        thread.wait();
+    }
+}
+
+QTEST_MAIN(tst_BtSnoopTracer)
+
+#include "tst_btsnooptracer.moc"
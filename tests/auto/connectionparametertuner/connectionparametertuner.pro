@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_connectionparametertuner.cpp
+TARGET = tst_connectionparametertuner
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
@@ -0,0 +1,300 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/QLowEnergyConnectionParameterPolicy>
+#include <QtBluetooth/private/connectionparametertuner_p.h>
+
+QT_USE_NAMESPACE
+
+class tst_ConnectionParameterTuner : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_ConnectionParameterTuner();
+
+private slots:
+    void inactive();
+    void idleAfterConnect();
+    void burstByQueueDepth();
+    void burstByThroughput();
+    void idleAfterBurst();
+    void stop();
+    void updateApplied();
+    void updateFailed();
+    void retriesLimited();
+    void updateOutsideRange();
+    void applicationUpdate();
+
+private:
+    QLowEnergyConnectionParameterPolicy policy;
+    // never falls back to idle while the retries are tested
+    QLowEnergyConnectionParameterPolicy retryPolicy;
+};
+
+tst_ConnectionParameterTuner::tst_ConnectionParameterTuner()
+{
+    qRegisterMetaType<QLowEnergyConnectionParameters>();
+
+    QLowEnergyConnectionParameters burst;
+    burst.setIntervalRange(7.5, 7.5);
+    policy.setBurstParameters(burst);
+
+    QLowEnergyConnectionParameters idle;
+    idle.setIntervalRange(1000, 1000);
+    policy.setIdleParameters(idle);
+
+    policy.setIdleTimeout(100);
+    policy.setBurstQueueDepth(3);
+    policy.setBurstThroughput(1000);
+
+    retryPolicy = policy;
+    retryPolicy.setIdleTimeout(60000);
+}
+
+void tst_ConnectionParameterTuner::inactive()
+{
+    ConnectionParameterTuner tuner(policy);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+
+    QVERIFY(!tuner.isActive());
+    tuner.observeTraffic(10, 10000);
+    QCOMPARE(tuner.mode(), ConnectionParameterTuner::UnknownMode);
+    QCOMPARE(spy.count(), 0);
+}
+
+void tst_ConnectionParameterTuner::idleAfterConnect()
+{
+    ConnectionParameterTuner tuner(policy);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+
+    tuner.start();
+    QVERIFY(tuner.isActive());
+    QCOMPARE(tuner.mode(), ConnectionParameterTuner::UnknownMode);
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(tuner.mode(), ConnectionParameterTuner::IdleMode);
+    QCOMPARE(spy.at(0).at(0).value<QLowEnergyConnectionParameters>(), policy.idleParameters());
+}
+
+void tst_ConnectionParameterTuner::burstByQueueDepth()
+{
+    ConnectionParameterTuner tuner(policy);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+
+    tuner.observeTraffic(1, 10);
+    tuner.observeTraffic(2, 10);
+    QCOMPARE(spy.count(), 0);
+
+    tuner.observeTraffic(3, 10);
+    QCOMPARE(tuner.mode(), ConnectionParameterTuner::BurstMode);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QLowEnergyConnectionParameters>(), policy.burstParameters());
+
+    // no further requests while the burst lasts
+    tuner.observeTraffic(5, 10);
+    QCOMPARE(spy.count(), 1);
+}
+
+void tst_ConnectionParameterTuner::burstByThroughput()
+{
+    ConnectionParameterTuner tuner(policy);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+
+    for (int i = 0; i < 4; ++i)
+        tuner.observeTraffic(1, 200);
+    QCOMPARE(spy.count(), 0);
+
+    tuner.observeTraffic(1, 200);
+    QCOMPARE(tuner.mode(), ConnectionParameterTuner::BurstMode);
+    QCOMPARE(spy.count(), 1);
+}
+
+void tst_ConnectionParameterTuner::idleAfterBurst()
+{
+    // the gaps between the PDUs stay far below the idle timeout even on a loaded machine
+    QLowEnergyConnectionParameterPolicy slowPolicy = policy;
+    slowPolicy.setIdleTimeout(1000);
+    ConnectionParameterTuner tuner(slowPolicy);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+
+    tuner.observeTraffic(3, 10);
+    QCOMPARE(spy.count(), 1);
+
+    // traffic keeps the burst alive
+    for (int i = 0; i < 4; ++i) {
+        QTest::qWait(100);
+        tuner.observeTraffic(1, 10);
+    }
+    QCOMPARE(tuner.mode(), ConnectionParameterTuner::BurstMode);
+    QCOMPARE(spy.count(), 1);
+
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(tuner.mode(), ConnectionParameterTuner::IdleMode);
+    QCOMPARE(spy.at(1).at(0).value<QLowEnergyConnectionParameters>(), policy.idleParameters());
+
+    // a new burst starts from the idle mode
+    tuner.observeTraffic(3, 10);
+    QCOMPARE(spy.count(), 3);
+}
+
+void tst_ConnectionParameterTuner::stop()
+{
+    ConnectionParameterTuner tuner(policy);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+    tuner.stop();
+
+    QVERIFY(!tuner.isActive());
+    QTest::qWait(200);
+    QCOMPARE(spy.count(), 0);
+}
+
+void tst_ConnectionParameterTuner::updateApplied()
+{
+    ConnectionParameterTuner tuner(retryPolicy);
+    tuner.setRetryInterval(10);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+
+    tuner.observeTraffic(3, 10);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(tuner.isUpdatePending());
+
+    // the reported interval is rounded to units of 1.25ms
+    QLowEnergyConnectionParameters applied;
+    applied.setIntervalRange(7.5, 7.5);
+    tuner.updateApplied(applied);
+    QVERIFY(!tuner.isUpdatePending());
+
+    QTest::qWait(100);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(tuner.mode(), ConnectionParameterTuner::BurstMode);
+}
+
+void tst_ConnectionParameterTuner::updateFailed()
+{
+    ConnectionParameterTuner tuner(retryPolicy);
+    tuner.setRetryInterval(10);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+
+    tuner.observeTraffic(3, 10);
+    QCOMPARE(spy.count(), 1);
+
+    // a rejected request is repeated with the parameters of the current mode
+    tuner.updateFailed();
+    QVERIFY(!tuner.isUpdatePending());
+    QTRY_COMPARE(spy.count(), 2);
+    QVERIFY(tuner.isUpdatePending());
+    QCOMPARE(spy.at(1).at(0).value<QLowEnergyConnectionParameters>(), policy.burstParameters());
+
+    // the outcome of a request is only handled once
+    QLowEnergyConnectionParameters applied;
+    applied.setIntervalRange(7.5, 7.5);
+    tuner.updateApplied(applied);
+    tuner.updateFailed();
+    QTest::qWait(100);
+    QCOMPARE(spy.count(), 2);
+}
+
+void tst_ConnectionParameterTuner::retriesLimited()
+{
+    ConnectionParameterTuner tuner(retryPolicy);
+    tuner.setRetryInterval(10);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+
+    tuner.observeTraffic(3, 10);
+    QCOMPARE(spy.count(), 1);
+
+    for (int retry = 2; retry <= 4; ++retry) {
+        tuner.updateFailed();
+        QTRY_COMPARE(spy.count(), retry);
+    }
+
+    tuner.updateFailed();
+    QTest::qWait(200);
+    QCOMPARE(spy.count(), 4);
+    QVERIFY(!tuner.isUpdatePending());
+
+    // the next change of the mode starts over
+    tuner.stop();
+    tuner.start();
+    tuner.observeTraffic(3, 10);
+    QCOMPARE(spy.count(), 5);
+    tuner.updateFailed();
+    QTRY_COMPARE(spy.count(), 6);
+}
+
+void tst_ConnectionParameterTuner::updateOutsideRange()
+{
+    ConnectionParameterTuner tuner(retryPolicy);
+    tuner.setRetryInterval(10);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+
+    tuner.observeTraffic(3, 10);
+    QCOMPARE(spy.count(), 1);
+
+    // parameters differing from the requested ones count as a failed request
+    QLowEnergyConnectionParameters applied;
+    applied.setIntervalRange(50, 50);
+    tuner.updateApplied(applied);
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).value<QLowEnergyConnectionParameters>(), policy.burstParameters());
+}
+
+void tst_ConnectionParameterTuner::applicationUpdate()
+{
+    ConnectionParameterTuner tuner(retryPolicy);
+    tuner.setRetryInterval(10);
+    QSignalSpy spy(&tuner, SIGNAL(updateRequested(QLowEnergyConnectionParameters)));
+    tuner.start();
+
+    tuner.observeTraffic(3, 10);
+    QLowEnergyConnectionParameters applied;
+    applied.setIntervalRange(7.5, 7.5);
+    tuner.updateApplied(applied);
+
+    // updates the application requested itself are kept until the mode changes
+    applied.setIntervalRange(50, 50);
+    tuner.updateApplied(applied);
+    tuner.updateFailed();
+    QTest::qWait(100);
+    QCOMPARE(spy.count(), 1);
+}
+
+QTEST_MAIN(tst_ConnectionParameterTuner)
+
+#include "tst_connectionparametertuner.moc"
@@ -0,0 +1,18 @@
+SOURCES += tst_declarativebluetoothdiscoverymodel.cpp
+TARGET = tst_declarativebluetoothdiscoverymodel
+CONFIG += testcase
+
+QT = core gui qml bluetooth testlib
+
+INCLUDEPATH += ../../../src/imports/bluetooth
+VPATH += ../../../src/imports/bluetooth
+
+HEADERS += \
+    qdeclarativebluetoothdiscoverymodel_p.h \
+    qdeclarativebluetoothservice_p.h \
+    qdeclarativebluetoothsocket_p.h
+
+SOURCES += \
+    qdeclarativebluetoothdiscoverymodel.cpp \
+    qdeclarativebluetoothservice.cpp \
+    qdeclarativebluetoothsocket.cpp
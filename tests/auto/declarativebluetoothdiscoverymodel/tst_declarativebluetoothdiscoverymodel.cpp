@@ -0,0 +1,277 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/QBluetoothAddress>
+#include <QtBluetooth/QBluetoothDeviceInfo>
+#include <QtBluetooth/QBluetoothServiceInfo>
+
+#include "qdeclarativebluetoothdiscoverymodel_p.h"
+
+QT_USE_NAMESPACE
+
+// normally defined by the QML plugin
+Q_LOGGING_CATEGORY(QT_BT_QML, "qt.bluetooth.qml")
+
+class tst_DeclarativeBluetoothDiscoveryModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_DeclarativeBluetoothDiscoveryModel();
+
+private slots:
+    void deviceDeduplication();
+    void deviceUpdated();
+    void serviceDeduplication();
+    void expiryTimeout();
+    void expiryKeepsSeenRows();
+
+private:
+    static QBluetoothDeviceInfo device(const char *address, const QString &name, qint16 rssi);
+    static QBluetoothServiceInfo service(const char *address, const QBluetoothUuid &uuid,
+                                         const QString &name);
+    static void discover(QDeclarativeBluetoothDiscoveryModel *model,
+                         const QBluetoothDeviceInfo &info);
+    static void discover(QDeclarativeBluetoothDiscoveryModel *model,
+                         const QBluetoothServiceInfo &info);
+    static QStringList addresses(QDeclarativeBluetoothDiscoveryModel *model);
+};
+
+tst_DeclarativeBluetoothDiscoveryModel::tst_DeclarativeBluetoothDiscoveryModel()
+{
+    qRegisterMetaType<QVector<int> >();
+}
+
+QBluetoothDeviceInfo tst_DeclarativeBluetoothDiscoveryModel::device(const char *address,
+                                                                    const QString &name,
+                                                                    qint16 rssi)
+{
+    QBluetoothDeviceInfo info(QBluetoothAddress(QLatin1String(address)), name, 0);
+    info.setRssi(rssi);
+    return info;
+}
+
+QBluetoothServiceInfo tst_DeclarativeBluetoothDiscoveryModel::service(const char *address,
+                                                                      const QBluetoothUuid &uuid,
+                                                                      const QString &name)
+{
+    QBluetoothServiceInfo info;
+    info.setDevice(QBluetoothDeviceInfo(QBluetoothAddress(QLatin1String(address)),
+                                        QString(), 0));
+    info.setServiceUuid(uuid);
+    info.setServiceName(name);
+    return info;
+}
+
+// the agents are not involved, the sightings are fed to the private slots directly
+void tst_DeclarativeBluetoothDiscoveryModel::discover(QDeclarativeBluetoothDiscoveryModel *model,
+                                                      const QBluetoothDeviceInfo &info)
+{
+    QVERIFY(QMetaObject::invokeMethod(model, "deviceDiscovered",
+                                      Q_ARG(QBluetoothDeviceInfo, info)));
+}
+
+void tst_DeclarativeBluetoothDiscoveryModel::discover(QDeclarativeBluetoothDiscoveryModel *model,
+                                                      const QBluetoothServiceInfo &info)
+{
+    QVERIFY(QMetaObject::invokeMethod(model, "serviceDiscovered",
+                                      Q_ARG(QBluetoothServiceInfo, info)));
+}
+
+QStringList tst_DeclarativeBluetoothDiscoveryModel::addresses(QDeclarativeBluetoothDiscoveryModel *model)
+{
+    QStringList result;
+    for (int row = 0; row < model->rowCount(); ++row)
+        result << model->data(model->index(row),
+                              QDeclarativeBluetoothDiscoveryModel::RemoteAddress).toString();
+    return result;
+}
+
+void tst_DeclarativeBluetoothDiscoveryModel::deviceDeduplication()
+{
+    QDeclarativeBluetoothDiscoveryModel model;
+    model.setDiscoveryMode(QDeclarativeBluetoothDiscoveryModel::DeviceDiscovery);
+    QSignalSpy discoveredSpy(&model, SIGNAL(deviceDiscovered(QString)));
+    QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy changedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+    discover(&model, device("00:11:22:33:44:55", QStringLiteral("first"), -60));
+    discover(&model, device("00:11:22:33:44:66", QStringLiteral("second"), -70));
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(discoveredSpy.count(), 2);
+    QCOMPARE(insertedSpy.count(), 2);
+
+    // an unchanged sighting neither adds a row nor changes one
+    discover(&model, device("00:11:22:33:44:55", QStringLiteral("first"), -60));
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(discoveredSpy.count(), 2);
+    QCOMPARE(insertedSpy.count(), 2);
+    QVERIFY(changedSpy.isEmpty());
+
+    // a new rssi updates the row in place
+    discover(&model, device("00:11:22:33:44:55", QStringLiteral("first"), -40));
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(discoveredSpy.count(), 2);
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.at(0).at(0).value<QModelIndex>().row(), 0);
+    QCOMPARE(changedSpy.at(0).at(2).value<QVector<int> >(),
+             QVector<int>() << QDeclarativeBluetoothDiscoveryModel::Rssi);
+    QCOMPARE(model.data(model.index(0), QDeclarativeBluetoothDiscoveryModel::Rssi).toInt(), -40);
+    QCOMPARE(addresses(&model), QStringList() << QStringLiteral("00:11:22:33:44:55")
+                                              << QStringLiteral("00:11:22:33:44:66"));
+}
+
+void tst_DeclarativeBluetoothDiscoveryModel::deviceUpdated()
+{
+    QDeclarativeBluetoothDiscoveryModel model;
+    model.setDiscoveryMode(QDeclarativeBluetoothDiscoveryModel::DeviceDiscovery);
+    QSignalSpy discoveredSpy(&model, SIGNAL(deviceDiscovered(QString)));
+    QSignalSpy changedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+    // an update of an unknown device inserts it
+    QVERIFY(QMetaObject::invokeMethod(&model, "deviceUpdated",
+            Q_ARG(QBluetoothDeviceInfo, device("00:11:22:33:44:55", QStringLiteral("first"), -60))));
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(discoveredSpy.count(), 1);
+
+    // advertisements without a name keep the known one
+    QVERIFY(QMetaObject::invokeMethod(&model, "deviceUpdated",
+            Q_ARG(QBluetoothDeviceInfo, device("00:11:22:33:44:55", QString(), -50))));
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.at(0).at(2).value<QVector<int> >(),
+             QVector<int>() << QDeclarativeBluetoothDiscoveryModel::Rssi);
+    QCOMPARE(model.data(model.index(0), QDeclarativeBluetoothDiscoveryModel::Name).toString(),
+             QStringLiteral("first"));
+
+    QVERIFY(QMetaObject::invokeMethod(&model, "deviceUpdated",
+            Q_ARG(QBluetoothDeviceInfo, device("00:11:22:33:44:55", QStringLiteral("renamed"), -50))));
+    QCOMPARE(changedSpy.count(), 2);
+    QCOMPARE(changedSpy.at(1).at(2).value<QVector<int> >(),
+             QVector<int>() << QDeclarativeBluetoothDiscoveryModel::Name
+                            << QDeclarativeBluetoothDiscoveryModel::DeviceName);
+    QCOMPARE(model.data(model.index(0), QDeclarativeBluetoothDiscoveryModel::Name).toString(),
+             QStringLiteral("renamed"));
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(discoveredSpy.count(), 1);
+}
+
+void tst_DeclarativeBluetoothDiscoveryModel::serviceDeduplication()
+{
+    QDeclarativeBluetoothDiscoveryModel model;
+    QSignalSpy discoveredSpy(&model, SIGNAL(serviceDiscovered(QDeclarativeBluetoothService*)));
+    const QBluetoothUuid serialPort(QBluetoothUuid::SerialPort);
+    const QBluetoothUuid obexPush(QBluetoothUuid::ObexObjectPush);
+
+    discover(&model, service("00:11:22:33:44:55", serialPort, QStringLiteral("serial")));
+    discover(&model, service("00:11:22:33:44:55", serialPort, QStringLiteral("serial")));
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(discoveredSpy.count(), 1);
+
+    // address, UUID and name identify a service
+    discover(&model, service("00:11:22:33:44:66", serialPort, QStringLiteral("serial")));
+    discover(&model, service("00:11:22:33:44:55", obexPush, QStringLiteral("serial")));
+    discover(&model, service("00:11:22:33:44:55", serialPort, QStringLiteral("other")));
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(discoveredSpy.count(), 4);
+
+    discover(&model, service("00:11:22:33:44:66", serialPort, QStringLiteral("serial")));
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(discoveredSpy.count(), 4);
+}
+
+void tst_DeclarativeBluetoothDiscoveryModel::expiryTimeout()
+{
+    QDeclarativeBluetoothDiscoveryModel model;
+    model.setDiscoveryMode(QDeclarativeBluetoothDiscoveryModel::DeviceDiscovery);
+    QCOMPARE(model.expiryTimeout(), 0);
+    model.setExpiryTimeout(-1);
+    QCOMPARE(model.expiryTimeout(), 0);
+
+    QSignalSpy removedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    // without a timeout rows stay
+    discover(&model, device("00:11:22:33:44:55", QStringLiteral("first"), -60));
+    discover(&model, device("00:11:22:33:44:66", QStringLiteral("second"), -60));
+    QTest::qWait(200);
+    QCOMPARE(model.rowCount(), 2);
+
+    // consecutive stale rows are removed in one step
+    QSignalSpy timeoutSpy(&model, SIGNAL(expiryTimeoutChanged()));
+    model.setExpiryTimeout(100);
+    QCOMPARE(timeoutSpy.count(), 1);
+    QTRY_COMPARE(model.rowCount(), 0);
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.at(0).at(1).toInt(), 0);
+    QCOMPARE(removedSpy.at(0).at(2).toInt(), 1);
+
+    // the address index was rebuilt, the device is a new row again
+    QSignalSpy discoveredSpy(&model, SIGNAL(deviceDiscovered(QString)));
+    discover(&model, device("00:11:22:33:44:55", QStringLiteral("first"), -60));
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(discoveredSpy.count(), 1);
+}
+
+void tst_DeclarativeBluetoothDiscoveryModel::expiryKeepsSeenRows()
+{
+    QDeclarativeBluetoothDiscoveryModel model;
+    model.setDiscoveryMode(QDeclarativeBluetoothDiscoveryModel::DeviceDiscovery);
+    // large against the refresh interval below, rows seen again never expire
+    model.setExpiryTimeout(1000);
+    QSignalSpy removedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    discover(&model, device("00:11:22:33:44:01", QStringLiteral("stale"), -60));
+    discover(&model, device("00:11:22:33:44:02", QStringLiteral("seen"), -60));
+    discover(&model, device("00:11:22:33:44:03", QStringLiteral("stale"), -60));
+    discover(&model, device("00:11:22:33:44:04", QStringLiteral("stale"), -60));
+
+    QElapsedTimer timer;
+    timer.start();
+    while (model.rowCount() > 1 && timer.elapsed() < 10000) {
+        discover(&model, device("00:11:22:33:44:02", QStringLiteral("seen"), -60));
+        QTest::qWait(20);
+    }
+
+    QCOMPARE(addresses(&model), QStringList() << QStringLiteral("00:11:22:33:44:02"));
+    int removed = 0;
+    for (const QList<QVariant> &arguments : qAsConst(removedSpy))
+        removed += arguments.at(2).toInt() - arguments.at(1).toInt() + 1;
+    QCOMPARE(removed, 3);
+
+    // the index of the remaining row was rebuilt
+    QSignalSpy changedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    discover(&model, device("00:11:22:33:44:02", QStringLiteral("seen"), -30));
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.at(0).at(0).value<QModelIndex>().row(), 0);
+}
+
+QTEST_MAIN(tst_DeclarativeBluetoothDiscoveryModel)
+
+#include "tst_declarativebluetoothdiscoverymodel.moc"
@@ -0,0 +1,16 @@
+SOURCES += tst_declarativebluetoothsocket.cpp
+TARGET = tst_declarativebluetoothsocket
+CONFIG += testcase
+
+QT = core qml bluetooth testlib
+
+INCLUDEPATH += ../../../src/imports/bluetooth
+VPATH += ../../../src/imports/bluetooth
+
+HEADERS += \
+    qdeclarativebluetoothservice_p.h \
+    qdeclarativebluetoothsocket_p.h
+
+SOURCES += \
+    qdeclarativebluetoothservice.cpp \
+    qdeclarativebluetoothsocket.cpp
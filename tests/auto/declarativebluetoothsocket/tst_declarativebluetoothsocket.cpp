@@ -0,0 +1,192 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/QBluetoothSocket>
+
+#include "qdeclarativebluetoothsocket_p.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+QT_USE_NAMESPACE
+
+// normally defined by the QML plugin
+Q_LOGGING_CATEGORY(QT_BT_QML, "qt.bluetooth.qml")
+
+class tst_DeclarativeBluetoothSocket : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void unbatched();
+    void batchSize();
+    void batchLatency();
+    void batchSizeBeforeLatency();
+    void binaryModeEnabledLater();
+
+private:
+    void send(const QByteArray &data);
+
+    int peer;
+    QBluetoothSocket *socket;
+    QDeclarativeBluetoothSocket *declarativeSocket;
+};
+
+void tst_DeclarativeBluetoothSocket::init()
+{
+    // a socket pair stands in for the RFCOMM connection
+    int fds[2];
+    QVERIFY(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    peer = fds[1];
+
+    socket = new QBluetoothSocket;
+    QVERIFY(socket->setSocketDescriptor(fds[0], QBluetoothServiceInfo::RfcommProtocol));
+    declarativeSocket = new QDeclarativeBluetoothSocket(socket, 0);
+}
+
+void tst_DeclarativeBluetoothSocket::cleanup()
+{
+    // owns and closes the QBluetoothSocket
+    delete declarativeSocket;
+    declarativeSocket = 0;
+    socket = 0;
+    ::close(peer);
+}
+
+void tst_DeclarativeBluetoothSocket::send(const QByteArray &data)
+{
+    QSignalSpy readyReadSpy(socket, SIGNAL(readyRead()));
+    QCOMPARE(::write(peer, data.constData(), data.size()), qint64(data.size()));
+    QTRY_VERIFY(!readyReadSpy.isEmpty());
+}
+
+void tst_DeclarativeBluetoothSocket::unbatched()
+{
+    declarativeSocket->setBinaryMode(true);
+    QSignalSpy dataSpy(declarativeSocket, SIGNAL(dataReceived(QByteArray)));
+
+    send(QByteArray("0123456789"));
+    QCOMPARE(dataSpy.count(), 1);
+    QCOMPARE(dataSpy.at(0).at(0).toByteArray(), QByteArray("0123456789"));
+    QCOMPARE(socket->bytesAvailable(), qint64(0));
+}
+
+void tst_DeclarativeBluetoothSocket::batchSize()
+{
+    declarativeSocket->setBinaryMode(true);
+    declarativeSocket->setMaximumBatchSize(4);
+    QCOMPARE(declarativeSocket->maximumBatchSize(), 4);
+    QSignalSpy dataSpy(declarativeSocket, SIGNAL(dataReceived(QByteArray)));
+
+    // without latency the remainder is delivered right away, never above the size
+    send(QByteArray("0123456789"));
+    QCOMPARE(dataSpy.count(), 3);
+    QCOMPARE(dataSpy.at(0).at(0).toByteArray(), QByteArray("0123"));
+    QCOMPARE(dataSpy.at(1).at(0).toByteArray(), QByteArray("4567"));
+    QCOMPARE(dataSpy.at(2).at(0).toByteArray(), QByteArray("89"));
+
+    declarativeSocket->setMaximumBatchSize(-1);
+    QCOMPARE(declarativeSocket->maximumBatchSize(), 0);
+}
+
+void tst_DeclarativeBluetoothSocket::batchLatency()
+{
+    declarativeSocket->setBinaryMode(true);
+    declarativeSocket->setMaximumBatchLatency(500);
+    QCOMPARE(declarativeSocket->maximumBatchLatency(), 500);
+    QSignalSpy dataSpy(declarativeSocket, SIGNAL(dataReceived(QByteArray)));
+
+    // data arriving within the latency is combined into one delivery
+    send(QByteArray("ab"));
+    QVERIFY(dataSpy.isEmpty());
+    send(QByteArray("cd"));
+    QVERIFY(dataSpy.isEmpty());
+    QCOMPARE(socket->bytesAvailable(), qint64(4));
+
+    QTRY_COMPARE(dataSpy.count(), 1);
+    QCOMPARE(dataSpy.at(0).at(0).toByteArray(), QByteArray("abcd"));
+    QCOMPARE(socket->bytesAvailable(), qint64(0));
+
+    declarativeSocket->setMaximumBatchLatency(-1);
+    QCOMPARE(declarativeSocket->maximumBatchLatency(), 0);
+}
+
+void tst_DeclarativeBluetoothSocket::batchSizeBeforeLatency()
+{
+    declarativeSocket->setBinaryMode(true);
+    declarativeSocket->setMaximumBatchSize(4);
+    // long enough to never expire while the test checks the full batches
+    declarativeSocket->setMaximumBatchLatency(60000);
+    QSignalSpy dataSpy(declarativeSocket, SIGNAL(dataReceived(QByteArray)));
+
+    // full batches do not wait for the latency
+    send(QByteArray("012345"));
+    QCOMPARE(dataSpy.count(), 1);
+    QCOMPARE(dataSpy.at(0).at(0).toByteArray(), QByteArray("0123"));
+    QCOMPARE(socket->bytesAvailable(), qint64(2));
+
+    // the held back remainder completes the next batch
+    send(QByteArray("67"));
+    QCOMPARE(dataSpy.count(), 2);
+    QCOMPARE(dataSpy.at(1).at(0).toByteArray(), QByteArray("4567"));
+    QCOMPARE(socket->bytesAvailable(), qint64(0));
+
+    // without latency the remainder is delivered right away again
+    declarativeSocket->setMaximumBatchLatency(0);
+    send(QByteArray("8"));
+    QCOMPARE(dataSpy.count(), 3);
+    QCOMPARE(dataSpy.at(2).at(0).toByteArray(), QByteArray("8"));
+}
+
+void tst_DeclarativeBluetoothSocket::binaryModeEnabledLater()
+{
+    QSignalSpy dataSpy(declarativeSocket, SIGNAL(dataReceived(QByteArray)));
+    QSignalSpy availableSpy(declarativeSocket, SIGNAL(dataAvailable()));
+
+    // string mode leaves the data in the socket
+    send(QByteArray("0123"));
+    QCOMPARE(availableSpy.count(), 1);
+    QVERIFY(dataSpy.isEmpty());
+    QCOMPARE(socket->bytesAvailable(), qint64(4));
+
+    // buffered data is handed over as soon as binary mode is enabled
+    declarativeSocket->setMaximumBatchSize(3);
+    declarativeSocket->setBinaryMode(true);
+    QCOMPARE(dataSpy.count(), 2);
+    QCOMPARE(dataSpy.at(0).at(0).toByteArray(), QByteArray("012"));
+    QCOMPARE(dataSpy.at(1).at(0).toByteArray(), QByteArray("3"));
+}
+
+QTEST_MAIN(tst_DeclarativeBluetoothSocket)
+
+#include "tst_declarativebluetoothsocket.moc"
@@ -64,6 +64,9 @@ private slots:
     void tst_cached();
 
     void tst_flags();
+
+    void tst_manufacturerData();
+    void tst_serviceData();
 };
 
 tst_QBluetoothDeviceInfo::tst_QBluetoothDeviceInfo()
@@ -440,6 +443,11 @@ void tst_QBluetoothDeviceInfo::tst_assignment()
         QBluetoothDeviceInfo testDeviceInfo;
         QVERIFY(testDeviceInfo == QBluetoothDeviceInfo());
     }
+
+    {
+        QBluetoothDeviceInfo testDeviceInfo;
+        QCOMPARE(testDeviceInfo.lastSeenTimestamp(), qint64(-1));
+    }
 }
 
 void tst_QBluetoothDeviceInfo::tst_serviceUuids()
@@ -515,6 +523,54 @@ void tst_QBluetoothDeviceInfo::tst_flags()
     QVERIFY(serviceResult.testFlag(QBluetoothDeviceInfo::CapturingService));
 }
 
+void tst_QBluetoothDeviceInfo::tst_manufacturerData()
+{
+    QBluetoothDeviceInfo deviceInfo(QBluetoothAddress("AABBCCDDEEFF"),
+        QString("My Bluetooth Device"), quint32(0x002000));
+    QVERIFY(deviceInfo.manufacturerIds().isEmpty());
+    QVERIFY(deviceInfo.manufacturerData().isEmpty());
+    QVERIFY(deviceInfo.manufacturerData(0x004c).isNull());
+
+    QVERIFY(deviceInfo.setManufacturerData(0x004c, QByteArray::fromHex("0215")));
+    QCOMPARE(deviceInfo.manufacturerData(0x004c), QByteArray::fromHex("0215"));
+    QCOMPARE(deviceInfo.manufacturerIds(), QVector<quint16>() << 0x004c);
+
+    // unchanged data is not reported as update
+    QVERIFY(!deviceInfo.setManufacturerData(0x004c, QByteArray::fromHex("0215")));
+
+    QBluetoothDeviceInfo copyInfo = deviceInfo;
+    QVERIFY(copyInfo == deviceInfo);
+    QCOMPARE(copyInfo.manufacturerData(), deviceInfo.manufacturerData());
+
+    QVERIFY(deviceInfo.setManufacturerData(0x004c, QByteArray::fromHex("0216")));
+    QVERIFY(deviceInfo.setManufacturerData(0x0059, QByteArray::fromHex("aa")));
+    QVERIFY(copyInfo != deviceInfo);
+    QCOMPARE(deviceInfo.manufacturerData().count(), 2);
+    QCOMPARE(copyInfo.manufacturerData(0x004c), QByteArray::fromHex("0215"));
+}
+
+void tst_QBluetoothDeviceInfo::tst_serviceData()
+{
+    const QBluetoothUuid eddystone(quint16(0xfeaa));
+
+    QBluetoothDeviceInfo deviceInfo(QBluetoothAddress("AABBCCDDEEFF"),
+        QString("My Bluetooth Device"), quint32(0x002000));
+    QVERIFY(deviceInfo.serviceIds().isEmpty());
+    QVERIFY(deviceInfo.serviceData().isEmpty());
+
+    QVERIFY(deviceInfo.setServiceData(eddystone, QByteArray::fromHex("10ee")));
+    QCOMPARE(deviceInfo.serviceData(eddystone), QByteArray::fromHex("10ee"));
+    QCOMPARE(deviceInfo.serviceIds(), QVector<QBluetoothUuid>() << eddystone);
+    QVERIFY(!deviceInfo.setServiceData(eddystone, QByteArray::fromHex("10ee")));
+
+    QBluetoothDeviceInfo copyInfo = deviceInfo;
+    QVERIFY(copyInfo == deviceInfo);
+
+    QVERIFY(deviceInfo.setServiceData(eddystone, QByteArray::fromHex("20ee")));
+    QVERIFY(copyInfo != deviceInfo);
+    QCOMPARE(copyInfo.serviceData(eddystone), QByteArray::fromHex("10ee"));
+}
+
 QTEST_MAIN(tst_QBluetoothDeviceInfo)
 
 #include "tst_qbluetoothdeviceinfo.moc"
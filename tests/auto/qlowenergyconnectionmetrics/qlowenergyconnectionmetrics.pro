@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_qlowenergyconnectionmetrics.cpp
+TARGET = tst_qlowenergyconnectionmetrics
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
@@ -0,0 +1,129 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/QLowEnergyConnectionMetrics>
+#include <QtBluetooth/private/qlowenergyconnectionmetrics_p.h>
+
+QT_USE_NAMESPACE
+
+class tst_QLowEnergyConnectionMetrics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void defaultConstructed();
+    void bucketLimits();
+    void roundTripTimeBuckets_data();
+    void roundTripTimeBuckets();
+    void pduCounters();
+};
+
+void tst_QLowEnergyConnectionMetrics::defaultConstructed()
+{
+    const QLowEnergyConnectionMetrics metrics;
+    QVERIFY(!metrics.isValid());
+    QCOMPARE(metrics.elapsedTime(), qint64(0));
+    QCOMPARE(metrics.pdusSent(0x0a), quint64(0));
+    QCOMPARE(metrics.bytesReceived(0xff), quint64(0));
+    QCOMPARE(metrics.maximumRequestQueueDepth(), 0);
+    QCOMPARE(metrics.notificationsReceived(), quint64(0));
+
+    const QVector<quint64> histogram = metrics.roundTripTimeHistogram();
+    QCOMPARE(histogram.count(), int(QLowEnergyConnectionMetricsPrivate::RoundTripTimeBuckets));
+    QCOMPARE(histogram, QVector<quint64>(histogram.count(), 0));
+
+    const QLowEnergyConnectionMetrics copy = metrics;
+    QVERIFY(!copy.isValid());
+}
+
+void tst_QLowEnergyConnectionMetrics::bucketLimits()
+{
+    const int buckets = QLowEnergyConnectionMetricsPrivate::RoundTripTimeBuckets;
+    QCOMPARE(QLowEnergyConnectionMetrics::roundTripTimeBucketLimit(0), qint64(1));
+    QCOMPARE(QLowEnergyConnectionMetrics::roundTripTimeBucketLimit(1), qint64(2));
+    QCOMPARE(QLowEnergyConnectionMetrics::roundTripTimeBucketLimit(10), qint64(1024));
+    QCOMPARE(QLowEnergyConnectionMetrics::roundTripTimeBucketLimit(buckets - 1), qint64(-1));
+    QCOMPARE(QLowEnergyConnectionMetrics::roundTripTimeBucketLimit(-1), qint64(-1));
+}
+
+void tst_QLowEnergyConnectionMetrics::roundTripTimeBuckets_data()
+{
+    QTest::addColumn<qint64>("usecs");
+    QTest::addColumn<int>("bucket");
+
+    QTest::newRow("zero") << qint64(0) << 0;
+    QTest::newRow("sub millisecond") << qint64(999) << 0;
+    QTest::newRow("one millisecond") << qint64(1000) << 1;
+    QTest::newRow("just below two") << qint64(1999) << 1;
+    QTest::newRow("two milliseconds") << qint64(2000) << 2;
+    QTest::newRow("one second") << qint64(1000000) << 10;
+    QTest::newRow("request timeout")
+            << qint64(20000000) << int(QLowEnergyConnectionMetricsPrivate::RoundTripTimeBuckets - 1);
+}
+
+void tst_QLowEnergyConnectionMetrics::roundTripTimeBuckets()
+{
+    QFETCH(qint64, usecs);
+    QFETCH(int, bucket);
+
+    QLowEnergyConnectionMetricsPrivate metrics;
+    metrics.addRoundTripTime(usecs);
+
+    for (int i = 0; i < QLowEnergyConnectionMetricsPrivate::RoundTripTimeBuckets; ++i)
+        QCOMPARE(metrics.roundTripTimes[i], quint64(i == bucket ? 1 : 0));
+
+    // the limit of a bucket is exclusive
+    const qint64 limit = QLowEnergyConnectionMetrics::roundTripTimeBucketLimit(bucket);
+    if (limit >= 0)
+        QVERIFY(usecs < limit * 1000);
+}
+
+void tst_QLowEnergyConnectionMetrics::pduCounters()
+{
+    QLowEnergyConnectionMetricsPrivate metrics;
+    metrics.countSentPdu(QByteArray::fromHex("0a0300"));
+    metrics.countSentPdu(QByteArray::fromHex("0a0400"));
+    metrics.countSentPdu(QByteArray());
+    metrics.countReceivedPdu(QByteArray::fromHex("1b030001020304"));
+
+    QCOMPARE(metrics.pdusSent[0x0a], quint64(2));
+    QCOMPARE(metrics.bytesSent[0x0a], quint64(6));
+    QCOMPARE(metrics.pdusSent[0x00], quint64(0));
+    QCOMPARE(metrics.pdusReceived[0x1b], quint64(1));
+    QCOMPARE(metrics.bytesReceived[0x1b], quint64(7));
+
+    metrics.sampleRequestQueueDepth(3);
+    metrics.sampleRequestQueueDepth(1);
+    QCOMPARE(metrics.maximumRequestQueueDepth, 3);
+}
+
+QTEST_MAIN(tst_QLowEnergyConnectionMetrics)
+
+#include "tst_qlowenergyconnectionmetrics.moc"
@@ -71,6 +71,9 @@ private slots:
     // Interaction with actual GATT server goes here. Order is relevant.
     void advertisedData();
     void serverCommunication();
+    void filteredServiceDiscovery();
+    void skipValueDiscovery();
+    void allServiceDetailsDiscovery();
 
 private:
     QBluetoothAddress m_serverAddress;
@@ -491,6 +494,12 @@ void TestQLowEnergyControllerGattServer::serverCommunication()
         QVERIFY(spy->wait(3000));
     QCOMPARE(customChar3.value().constData(), "indicated");
     QCOMPARE(customChar4.value().constData(), "notified");
+#ifdef Q_OS_LINUX
+    // stamped by the kernel when the notification arrived
+    const qint64 notificationTime = customService->lastNotificationTimestamp();
+    QVERIFY(notificationTime > 0);
+    QVERIFY(qAbs(QDateTime::currentMSecsSinceEpoch() - notificationTime / 1000000) < 10000);
+#endif
 
     // signal requires root privileges on Linux
     spy.reset(new QSignalSpy(m_leController.data(), &QLowEnergyController::connectionUpdated));
@@ -556,6 +565,163 @@ void TestQLowEnergyControllerGattServer::serverCommunication()
     }
 }
 
+void TestQLowEnergyControllerGattServer::filteredServiceDiscovery()
+{
+    if (m_serverAddress.isNull())
+        QSKIP("No server address provided");
+    m_leController.reset(QLowEnergyController::createCentral(m_serverInfo));
+    QVERIFY(!m_leController.isNull());
+    m_leController->connectToDevice();
+    QScopedPointer<QSignalSpy> spy(new QSignalSpy(m_leController.data(),
+                                                  &QLowEnergyController::connected));
+    QVERIFY(spy->wait(30000));
+
+    const QBluetoothUuid customUuid(quint16(0x2000));
+    const QBluetoothUuid custom128Uuid(QString("c47774c7-f237-4523-8968-e4ae75431daf"));
+    const QBluetoothUuid missingUuid(quint16(0x1234));
+    spy.reset(new QSignalSpy(m_leController.data(), &QLowEnergyController::discoveryFinished));
+    QSignalSpy serviceSpy(m_leController.data(), &QLowEnergyController::serviceDiscovered);
+    m_leController->discoverServices(QList<QBluetoothUuid>()
+                                     << customUuid << missingUuid << custom128Uuid << customUuid);
+    QVERIFY(spy->wait(30000));
+    QCOMPARE(m_leController->state(), QLowEnergyController::DiscoveredState);
+
+    const QList<QBluetoothUuid> serviceUuids = m_leController->services();
+    QCOMPARE(serviceUuids.count(), 2);
+    QVERIFY(serviceUuids.contains(customUuid));
+    QVERIFY(serviceUuids.contains(custom128Uuid));
+    QCOMPARE(serviceSpy.count(), 2);
+
+    // the handle range found this way must be good enough for the detail discovery
+    const QScopedPointer<QLowEnergyService> customService(
+                m_leController->createServiceObject(customUuid));
+    QVERIFY(!customService.isNull());
+    customService->discoverDetails();
+    while (customService->state() != QLowEnergyService::ServiceDiscovered) {
+        spy.reset(new QSignalSpy(customService.data(), &QLowEnergyService::stateChanged));
+        QVERIFY(spy->wait(5000));
+    }
+    QCOMPARE(customService->characteristics().count(), 5);
+
+    m_leController->disconnectFromDevice();
+    if (m_leController->state() != QLowEnergyController::UnconnectedState) {
+        spy.reset(new QSignalSpy(m_leController.data(), &QLowEnergyController::stateChanged));
+        QVERIFY(spy->wait(3000));
+    }
+}
+
+void TestQLowEnergyControllerGattServer::skipValueDiscovery()
+{
+    if (m_serverAddress.isNull())
+        QSKIP("No server address provided");
+    m_leController.reset(QLowEnergyController::createCentral(m_serverInfo));
+    QVERIFY(!m_leController.isNull());
+    m_leController->connectToDevice();
+    QScopedPointer<QSignalSpy> spy(new QSignalSpy(m_leController.data(),
+                                                  &QLowEnergyController::connected));
+    QVERIFY(spy->wait(30000));
+
+    const QBluetoothUuid customUuid(quint16(0x2000));
+    spy.reset(new QSignalSpy(m_leController.data(), &QLowEnergyController::discoveryFinished));
+    m_leController->discoverServices(QList<QBluetoothUuid>() << customUuid);
+    QVERIFY(spy->wait(30000));
+
+    const QScopedPointer<QLowEnergyService> customService(
+                m_leController->createServiceObject(customUuid));
+    QVERIFY(!customService.isNull());
+    customService->discoverDetails(QLowEnergyService::SkipValueDiscovery);
+    while (customService->state() != QLowEnergyService::ServiceDiscovered) {
+        spy.reset(new QSignalSpy(customService.data(), &QLowEnergyService::stateChanged));
+        QVERIFY(spy->wait(5000));
+    }
+    QCOMPARE(customService->characteristics().count(), 5);
+
+    QLowEnergyCharacteristic customChar
+            = customService->characteristic(QBluetoothUuid(quint16(0x5000)));
+    QVERIFY(customChar.isValid());
+    QCOMPARE(customChar.value(), QByteArray());
+
+    QLowEnergyCharacteristic customChar3
+            = customService->characteristic(QBluetoothUuid(quint16(0x5002)));
+    QVERIFY(customChar3.isValid());
+    QCOMPARE(customChar3.descriptors().count(), 1);
+    QLowEnergyDescriptor cc3ClientConfig
+            = customChar3.descriptor(QBluetoothUuid::ClientCharacteristicConfiguration);
+    QVERIFY(cc3ClientConfig.isValid());
+    QCOMPARE(cc3ClientConfig.value(), QByteArray());
+
+    // values are still available on request
+    spy.reset(new QSignalSpy(customService.data(), &QLowEnergyService::characteristicRead));
+    customService->readCharacteristic(customChar);
+    QVERIFY(spy->wait(3000));
+    QCOMPARE(customChar.value(), QByteArray(1024, 'x'));
+
+    m_leController->disconnectFromDevice();
+    if (m_leController->state() != QLowEnergyController::UnconnectedState) {
+        spy.reset(new QSignalSpy(m_leController.data(), &QLowEnergyController::stateChanged));
+        QVERIFY(spy->wait(3000));
+    }
+}
+
+void TestQLowEnergyControllerGattServer::allServiceDetailsDiscovery()
+{
+    if (m_serverAddress.isNull())
+        QSKIP("No server address provided");
+    m_leController.reset(QLowEnergyController::createCentral(m_serverInfo));
+    QVERIFY(!m_leController.isNull());
+    m_leController->connectToDevice();
+    QScopedPointer<QSignalSpy> spy(new QSignalSpy(m_leController.data(),
+                                                  &QLowEnergyController::connected));
+    QVERIFY(spy->wait(30000));
+
+    spy.reset(new QSignalSpy(m_leController.data(), &QLowEnergyController::discoveryFinished));
+    m_leController->discoverServices();
+    QVERIFY(spy->wait(30000));
+
+    const QBluetoothUuid customUuid(quint16(0x2000));
+    const QBluetoothUuid custom128Uuid(QString("c47774c7-f237-4523-8968-e4ae75431daf"));
+    const QScopedPointer<QLowEnergyService> customService(
+                m_leController->createServiceObject(customUuid));
+    QVERIFY(!customService.isNull());
+    const QScopedPointer<QLowEnergyService> customService128(
+                m_leController->createServiceObject(custom128Uuid));
+    QVERIFY(!customService128.isNull());
+
+    m_leController->discoverAllServiceDetails();
+    QCOMPARE(customService->state(), QLowEnergyService::DiscoveringServices);
+    QCOMPARE(customService128->state(), QLowEnergyService::DiscoveringServices);
+    QTRY_COMPARE_WITH_TIMEOUT(customService->state(), QLowEnergyService::ServiceDiscovered, 10000);
+    QTRY_COMPARE_WITH_TIMEOUT(customService128->state(), QLowEnergyService::ServiceDiscovered,
+                              10000);
+
+    QCOMPARE(customService->includedServices().count(), 0);
+    QCOMPARE(customService->characteristics().count(), 5);
+    const QLowEnergyCharacteristic customChar
+            = customService->characteristic(QBluetoothUuid(quint16(0x5000)));
+    QVERIFY(customChar.isValid());
+    QCOMPARE(customChar.descriptors().count(), 0);
+    QCOMPARE(customChar.value(), QByteArray(1024, 'x'));
+    const QLowEnergyCharacteristic customChar3
+            = customService->characteristic(QBluetoothUuid(quint16(0x5002)));
+    QVERIFY(customChar3.isValid());
+    QCOMPARE(customChar3.descriptors().count(), 1);
+
+    QCOMPARE(customService128->characteristics().count(), 1);
+    const QLowEnergyCharacteristic customChar128 = customService128->characteristics().first();
+    QCOMPARE(customChar128.descriptors().count(), 0);
+    QCOMPARE(customChar128.value(), QByteArray(15, 'a'));
+
+    // services in a later state are left alone
+    m_leController->discoverAllServiceDetails();
+    QCOMPARE(customService->state(), QLowEnergyService::ServiceDiscovered);
+
+    m_leController->disconnectFromDevice();
+    if (m_leController->state() != QLowEnergyController::UnconnectedState) {
+        spy.reset(new QSignalSpy(m_leController.data(), &QLowEnergyController::stateChanged));
+        QVERIFY(spy->wait(3000));
+    }
+}
+
 void TestQLowEnergyControllerGattServer::controllerType()
 {
     const QScopedPointer<QLowEnergyController> controller(QLowEnergyController::createPeripheral());
@@ -47,6 +47,7 @@ public:
 
 private slots:
     void tst_record();
+    void tst_hash();
 
     void tst_textRecord_data();
     void tst_textRecord();
@@ -197,6 +198,51 @@ void tst_QNdefRecord::tst_record()
     }
 }
 
+void tst_QNdefRecord::tst_hash()
+{
+    QNdefRecord record;
+    record.setTypeNameFormat(QNdefRecord::ExternalRtd);
+    record.setType("qt-project.org:test-rtd");
+    record.setId("test id");
+    record.setPayload(QByteArray(4096, 'x'));
+
+    QNdefRecord other;
+    other.setTypeNameFormat(QNdefRecord::ExternalRtd);
+    other.setType("qt-project.org:test-rtd");
+    other.setId("test id");
+    other.setPayload(QByteArray(4096, 'x'));
+
+    // equal records, hashed or not
+    QVERIFY(record == other);
+    QCOMPARE(qHash(record), qHash(other));
+    QVERIFY(record == other);
+
+    // the cached hash is invalidated when the record changes
+    const uint hash = qHash(record);
+    other.setPayload(QByteArray(4096, 'y'));
+    QVERIFY(qHash(other) != hash);
+    QVERIFY(record != other);
+
+    other.setPayload(QByteArray(4096, 'x'));
+    QCOMPARE(qHash(other), hash);
+    QVERIFY(record == other);
+
+    // a modified copy does not change the hash of the original
+    QNdefRecord copy(record);
+    QCOMPARE(qHash(copy), hash);
+    copy.setId("copy id");
+    QVERIFY(qHash(copy) != hash);
+    QCOMPARE(qHash(record), hash);
+    QVERIFY(copy != record);
+
+    // records can be deduplicated in hash based containers
+    QSet<QNdefRecord> records;
+    records.insert(record);
+    records.insert(other);
+    records.insert(copy);
+    QCOMPARE(records.count(), 2);
+}
+
 void tst_QNdefRecord::tst_textRecord_data()
 {
     QTest::addColumn<QString>("locale");
@@ -29,6 +29,7 @@
 #include <QtTest/QtTest>
 
 #include <private/qnearfieldmanager_emulator_p.h>
+#include <private/qnearfieldtarget_emulator_p.h>
 #include <qnearfieldmanager.h>
 #include <qndefmessage.h>
 #include <private/qnearfieldtagtype1_p.h>
@@ -426,6 +427,10 @@ void tst_QNearFieldTagType1::ndefMessages()
         requestCompletedSpy.clear();
         errorSpy.clear();
 
+        TagType1 *emulatedTarget = qobject_cast<TagType1 *>(target);
+        QVERIFY(emulatedTarget);
+        const int requestCount = emulatedTarget->requestCount();
+
         QSignalSpy ndefMessageWriteSpy(target, SIGNAL(ndefMessagesWritten()));
         QNearFieldTarget::RequestId writeId = target->writeNdefMessages(messages);
 
@@ -442,6 +447,9 @@ void tst_QNearFieldTagType1::ndefMessages()
 
         QVERIFY(!ndefMessageWriteSpy.isEmpty());
 
+        // RALL, one RSEG batch for dynamic tags and one batch of write commands
+        QVERIFY(emulatedTarget->requestCount() - requestCount <= 3);
+
         QVERIFY(target->hasNdefMessage());
 
         ndefMessageReadSpy.clear();
@@ -266,8 +266,6 @@ void tst_QNearFieldTagType2::dynamicMemoryModel()
 
 void tst_QNearFieldTagType2::ndefMessages()
 {
-    QSKIP("Not implemented");
-
     QByteArray firstId;
     forever {
         waitForMatchingTarget();
@@ -275,11 +273,8 @@ void tst_QNearFieldTagType2::ndefMessages()
         QNearFieldTarget::RequestId id = target->readBlock(0);
         QVERIFY(target->waitForRequestCompleted(id));
 
-        QByteArray uid = target->requestResponse(id).toByteArray().left(3);
-
-        id = target->readBlock(1);
-        QVERIFY(target->waitForRequestCompleted(id));
-        uid.append(target->requestResponse(id).toByteArray());
+        const QByteArray data = target->requestResponse(id).toByteArray();
+        const QByteArray uid = data.left(3) + data.mid(4, 4);
 
         if (firstId.isEmpty())
             firstId = uid;
@@ -289,10 +284,23 @@ void tst_QNearFieldTagType2::ndefMessages()
         QVERIFY(target->hasNdefMessage());
 
         QSignalSpy ndefMessageReadSpy(target, SIGNAL(ndefMessageRead(QNdefMessage)));
+        QSignalSpy requestCompletedSpy(target,
+                                       SIGNAL(requestCompleted(QNearFieldTarget::RequestId)));
+        QSignalSpy errorSpy(target,
+                            SIGNAL(error(QNearFieldTarget::Error,QNearFieldTarget::RequestId)));
 
-        target->readNdefMessages();
+        QNearFieldTarget::RequestId readId = target->readNdefMessages();
 
-        QTRY_VERIFY(!ndefMessageReadSpy.isEmpty());
+        QVERIFY(readId.isValid());
+
+        QNearFieldTarget::RequestId completedId;
+
+        while (completedId != readId) {
+            QTRY_VERIFY(!requestCompletedSpy.isEmpty() && errorSpy.isEmpty());
+
+            completedId =
+                requestCompletedSpy.takeFirst().first().value<QNearFieldTarget::RequestId>();
+        }
 
         QList<QNdefMessage> ndefMessages;
         for (int i = 0; i < ndefMessageReadSpy.count(); ++i)
@@ -313,20 +321,54 @@ void tst_QNearFieldTagType2::ndefMessages()
             message.append(record);
         }
 
+        // spans the sector boundary
+        if (target->memorySize() > 1024) {
+            QNdefRecord record;
+            record.setTypeNameFormat(QNdefRecord::ExternalRtd);
+            record.setType("org.qt-project:ndefMessagesTest");
+            record.setPayload(QByteArray(1200, quint8(0xaa)));
+            message.append(record);
+        }
+
         messages.append(message);
 
+        requestCompletedSpy.clear();
+        errorSpy.clear();
+
         QSignalSpy ndefMessageWriteSpy(target, SIGNAL(ndefMessagesWritten()));
-        target->writeNdefMessages(messages);
+        QNearFieldTarget::RequestId writeId = target->writeNdefMessages(messages);
+
+        QVERIFY(writeId.isValid());
 
-        QTRY_VERIFY(!ndefMessageWriteSpy.isEmpty());
+        completedId = QNearFieldTarget::RequestId();
+
+        while (completedId != writeId) {
+            QTRY_VERIFY(!requestCompletedSpy.isEmpty() && errorSpy.isEmpty());
+
+            completedId =
+                requestCompletedSpy.takeFirst().first().value<QNearFieldTarget::RequestId>();
+        }
+
+        QVERIFY(!ndefMessageWriteSpy.isEmpty());
 
         QVERIFY(target->hasNdefMessage());
 
         ndefMessageReadSpy.clear();
+        requestCompletedSpy.clear();
+        errorSpy.clear();
 
-        target->readNdefMessages();
+        readId = target->readNdefMessages();
 
-        QTRY_VERIFY(!ndefMessageReadSpy.isEmpty());
+        QVERIFY(readId.isValid());
+
+        completedId = QNearFieldTarget::RequestId();
+
+        while (completedId != readId) {
+            QTRY_VERIFY(!requestCompletedSpy.isEmpty() && errorSpy.isEmpty());
+
+            completedId =
+                requestCompletedSpy.takeFirst().first().value<QNearFieldTarget::RequestId>();
+        }
 
         QList<QNdefMessage> storedMessages;
         for (int i = 0; i < ndefMessageReadSpy.count(); ++i)
@@ -334,7 +376,32 @@ void tst_QNearFieldTagType2::ndefMessages()
 
         QVERIFY(ndefMessages != storedMessages);
 
-        QVERIFY(messages == storedMessages);
+        QCOMPARE(messages, storedMessages);
+
+        // a read turned down while the tag is busy keeps the id of the running one
+        requestCompletedSpy.clear();
+        errorSpy.clear();
+
+        readId = target->readNdefMessages();
+        const QNearFieldTarget::RequestId busyId = target->readNdefMessages();
+        QVERIFY(busyId.isValid());
+        QVERIFY(busyId != readId);
+
+        QTRY_VERIFY(!errorSpy.isEmpty());
+        QCOMPARE(errorSpy.first().at(0).value<QNearFieldTarget::Error>(),
+                 QNearFieldTarget::NdefReadError);
+        QCOMPARE(errorSpy.first().at(1).value<QNearFieldTarget::RequestId>(), busyId);
+
+        completedId = QNearFieldTarget::RequestId();
+
+        while (completedId != readId) {
+            QTRY_VERIFY(!requestCompletedSpy.isEmpty());
+
+            completedId =
+                requestCompletedSpy.takeFirst().first().value<QNearFieldTarget::RequestId>();
+        }
+
+        QCOMPARE(errorSpy.count(), 1);
     }
 }
 
@@ -0,0 +1,299 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtNfc module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+
+#include <private/qnearfieldmanager_emulator_p.h>
+#include <private/qnearfieldtarget_emulator_p.h>
+#include <qnearfieldmanager.h>
+#include <qndefmessage.h>
+#include <private/qnearfieldtagtype4_p.h>
+#include <qndefnfctextrecord.h>
+
+QT_USE_NAMESPACE
+
+Q_DECLARE_METATYPE(QNearFieldTarget*)
+
+class tst_QNearFieldTagType4 : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QNearFieldTagType4();
+
+private slots:
+    void init();
+    void cleanup();
+
+    void fileAccess();
+
+    void ndefMessages();
+
+private:
+    void waitForMatchingTarget();
+    void waitForNdefRequest(const QNearFieldTarget::RequestId &id);
+
+    QNearFieldManagerPrivateImpl *emulatorBackend;
+    QNearFieldManager *manager;
+    QNearFieldTagType4 *target;
+};
+
+tst_QNearFieldTagType4::tst_QNearFieldTagType4()
+:   emulatorBackend(0), manager(0), target(0)
+{
+    QDir::setCurrent(QLatin1String(SRCDIR));
+
+    qRegisterMetaType<QNdefMessage>();
+    qRegisterMetaType<QNearFieldTarget *>();
+}
+
+void tst_QNearFieldTagType4::init()
+{
+    emulatorBackend = new QNearFieldManagerPrivateImpl;
+    manager = new QNearFieldManager(emulatorBackend, 0);
+}
+
+void tst_QNearFieldTagType4::cleanup()
+{
+    emulatorBackend->reset();
+
+    delete manager;
+    manager = 0;
+    emulatorBackend = 0;
+    target = 0;
+}
+
+void tst_QNearFieldTagType4::waitForMatchingTarget()
+{
+    QSignalSpy targetDetectedSpy(manager, SIGNAL(targetDetected(QNearFieldTarget*)));
+
+    manager->startTargetDetection();
+
+    QTRY_VERIFY(!targetDetectedSpy.isEmpty());
+
+    target = qobject_cast<QNearFieldTagType4 *>(targetDetectedSpy.first().at(0).value<QNearFieldTarget *>());
+
+    manager->stopTargetDetection();
+
+    QVERIFY(target);
+
+    QCOMPARE(target->type(), QNearFieldTarget::NfcTagType4);
+}
+
+void tst_QNearFieldTagType4::fileAccess()
+{
+    waitForMatchingTarget();
+
+    QVERIFY(target->accessMethods() & QNearFieldTarget::TagTypeSpecificAccess);
+
+    QCOMPARE(target->version(), quint8(0x20));
+
+    // select()
+    {
+        // unknown application, deselects the NDEF Tag Application
+        QNearFieldTarget::RequestId id = target->select(QByteArray::fromHex("a000000000"));
+        QVERIFY(target->waitForRequestCompleted(id));
+        QVERIFY(!target->requestResponse(id).toBool());
+
+        id = target->select(0xe103);
+        QVERIFY(target->waitForRequestCompleted(id));
+        QVERIFY(!target->requestResponse(id).toBool());
+
+        id = target->select(QByteArray::fromHex("d2760000850101"));
+        QVERIFY(target->waitForRequestCompleted(id));
+        QVERIFY(target->requestResponse(id).toBool());
+
+        id = target->select(0xe103);
+        QVERIFY(target->waitForRequestCompleted(id));
+        QVERIFY(target->requestResponse(id).toBool());
+    }
+
+    // read() capability container
+    {
+        QNearFieldTarget::RequestId id = target->read(15);
+        QVERIFY(target->waitForRequestCompleted(id));
+
+        const QByteArray cc = target->requestResponse(id).toByteArray();
+        QCOMPARE(cc.length(), 15);
+        QCOMPARE(quint8(cc.at(2)), quint8(0x20));
+
+        // MLe, MLc
+        QCOMPARE(cc.mid(3, 4), QByteArray::fromHex("003b0034"));
+    }
+
+    // write() is rejected for the capability container
+    {
+        QNearFieldTarget::RequestId id = target->write(QByteArray(2, 0x55));
+        QVERIFY(target->waitForRequestCompleted(id));
+        QVERIFY(!target->requestResponse(id).toBool());
+    }
+
+    // read(), write() NDEF file
+    {
+        QNearFieldTarget::RequestId id = target->select(0xe104);
+        QVERIFY(target->waitForRequestCompleted(id));
+        QVERIFY(target->requestResponse(id).toBool());
+
+        id = target->write(QByteArray(4, 0x55), 100);
+        QVERIFY(target->waitForRequestCompleted(id));
+        QVERIFY(target->requestResponse(id).toBool());
+
+        id = target->read(4, 100);
+        QVERIFY(target->waitForRequestCompleted(id));
+        QCOMPARE(target->requestResponse(id).toByteArray(), QByteArray(4, 0x55));
+
+        // more than MLe
+        id = target->read(60);
+        QVERIFY(target->waitForRequestCompleted(id));
+        QVERIFY(!target->requestResponse(id).isValid());
+    }
+}
+
+void tst_QNearFieldTagType4::waitForNdefRequest(const QNearFieldTarget::RequestId &id)
+{
+    QSignalSpy requestCompletedSpy(target, SIGNAL(requestCompleted(QNearFieldTarget::RequestId)));
+    QSignalSpy errorSpy(target, SIGNAL(error(QNearFieldTarget::Error,QNearFieldTarget::RequestId)));
+
+    QNearFieldTarget::RequestId completedId;
+
+    while (completedId != id) {
+        QTRY_VERIFY(!requestCompletedSpy.isEmpty() && errorSpy.isEmpty());
+
+        completedId = requestCompletedSpy.takeFirst().first().value<QNearFieldTarget::RequestId>();
+    }
+}
+
+void tst_QNearFieldTagType4::ndefMessages()
+{
+    waitForMatchingTarget();
+
+    TagType4 *emulatedTarget = qobject_cast<TagType4 *>(target);
+    QVERIFY(emulatedTarget);
+
+    QVERIFY(target->hasNdefMessage());
+
+    QSignalSpy ndefMessageReadSpy(target, SIGNAL(ndefMessageRead(QNdefMessage)));
+
+    QNearFieldTarget::RequestId readId = target->readNdefMessages();
+    QVERIFY(readId.isValid());
+    waitForNdefRequest(readId);
+
+    QCOMPARE(ndefMessageReadSpy.count(), 1);
+
+    const QNdefMessage initialMessage = ndefMessageReadSpy.first().first().value<QNdefMessage>();
+    QCOMPARE(initialMessage.count(), 1);
+    QVERIFY(initialMessage.first().isRecordType<QNdefNfcTextRecord>());
+    QCOMPARE(QNdefNfcTextRecord(initialMessage.first()).text(), QStringLiteral("Qt"));
+
+    // a message that needs several READ BINARY and UPDATE BINARY commands
+    QNdefNfcTextRecord textRecord;
+    textRecord.setText(QStringLiteral("tst_QNearFieldTagType4::ndefMessages"));
+
+    QNdefRecord record;
+    record.setTypeNameFormat(QNdefRecord::ExternalRtd);
+    record.setType("org.qt-project:ndefMessagesTest");
+    record.setPayload(QByteArray(1200, quint8(0x55)));
+
+    QNdefMessage message;
+    message.append(textRecord);
+    message.append(record);
+
+    QList<QNdefMessage> messages;
+    messages.append(message);
+
+    QSignalSpy ndefMessageWriteSpy(target, SIGNAL(ndefMessagesWritten()));
+
+    int requestCount = emulatedTarget->requestCount();
+
+    QNearFieldTarget::RequestId writeId = target->writeNdefMessages(messages);
+    QVERIFY(writeId.isValid());
+    waitForNdefRequest(writeId);
+
+    QVERIFY(!ndefMessageWriteSpy.isEmpty());
+
+    // capability container, one batch of UPDATE BINARY commands
+    QCOMPARE(emulatedTarget->requestCount() - requestCount, 2);
+
+    ndefMessageReadSpy.clear();
+    requestCount = emulatedTarget->requestCount();
+
+    readId = target->readNdefMessages();
+    QVERIFY(readId.isValid());
+    waitForNdefRequest(readId);
+
+    // capability container, NLEN and first chunk, one batch for the rest of the message
+    QCOMPARE(emulatedTarget->requestCount() - requestCount, 3);
+
+    QCOMPARE(ndefMessageReadSpy.count(), 1);
+    QCOMPARE(ndefMessageReadSpy.first().first().value<QNdefMessage>(), message);
+
+    // only a single NDEF message fits into the NDEF file
+    QSignalSpy errorSpy(target, SIGNAL(error(QNearFieldTarget::Error,QNearFieldTarget::RequestId)));
+
+    messages.append(message);
+    writeId = target->writeNdefMessages(messages);
+
+    QTRY_VERIFY(!errorSpy.isEmpty());
+    QCOMPARE(errorSpy.first().at(0).value<QNearFieldTarget::Error>(),
+             QNearFieldTarget::NdefWriteError);
+    QCOMPARE(errorSpy.first().at(1).value<QNearFieldTarget::RequestId>(), writeId);
+
+    // a read turned down while the tag is busy keeps the id of the running one
+    QSignalSpy requestCompletedSpy(target, SIGNAL(requestCompleted(QNearFieldTarget::RequestId)));
+    errorSpy.clear();
+
+    readId = target->readNdefMessages();
+    const QNearFieldTarget::RequestId busyId = target->readNdefMessages();
+    QVERIFY(busyId.isValid());
+    QVERIFY(busyId != readId);
+
+    QTRY_VERIFY(!errorSpy.isEmpty());
+    QCOMPARE(errorSpy.first().at(0).value<QNearFieldTarget::Error>(),
+             QNearFieldTarget::NdefReadError);
+    QCOMPARE(errorSpy.first().at(1).value<QNearFieldTarget::RequestId>(), busyId);
+
+    QNearFieldTarget::RequestId completedId;
+    while (completedId != readId) {
+        QTRY_VERIFY(!requestCompletedSpy.isEmpty());
+
+        completedId = requestCompletedSpy.takeFirst().first().value<QNearFieldTarget::RequestId>();
+    }
+
+    QCOMPARE(errorSpy.count(), 1);
+}
+
+QTEST_MAIN(tst_QNearFieldTagType4)
+
+// Unset the moc namespace which is not required for the following include.
+#undef QT_BEGIN_MOC_NAMESPACE
+#define QT_BEGIN_MOC_NAMESPACE
+#undef QT_END_MOC_NAMESPACE
+#define QT_END_MOC_NAMESPACE
+
+#include "tst_qnearfieldtagtype4.moc"
@@ -0,0 +1,8 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_qtbluezobjectmirror.cpp
+HEADERS += ../shared/mockbluez.h
+TARGET = tst_qtbluezobjectmirror
+CONFIG += testcase
+
+QT = core dbus bluetooth-private testlib
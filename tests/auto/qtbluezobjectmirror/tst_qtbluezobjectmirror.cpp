@@ -0,0 +1,311 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "../shared/mockbluez.h"
+
+static const char adapterPath[] = "/org/bluez/hci0";
+static const char devicePath[] = "/org/bluez/hci0/dev_00_11_22_33_44_55";
+static const char newDevicePath[] = "/org/bluez/hci0/dev_66_77_88_99_AA_BB";
+
+class tst_QtBluezObjectMirror : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QtBluezObjectMirror();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void tst_populate();
+    void tst_interfacesAdded();
+    void tst_propertiesChanged();
+    void tst_deviceNameChanged();
+    void tst_interfacesRemoved();
+    void tst_serviceRestart();
+
+private:
+    static InterfaceList deviceInterfaces(const QString &address);
+    void sendInterfacesAdded(const QString &path, const InterfaceList &interfaces);
+
+    MockBluez bluez;
+    QtBluezObjectMirror *mirror;
+};
+
+tst_QtBluezObjectMirror::tst_QtBluezObjectMirror()
+    : mirror(0)
+{
+}
+
+InterfaceList tst_QtBluezObjectMirror::deviceInterfaces(const QString &address)
+{
+    QVariantMap device;
+    device.insert(QStringLiteral("Address"), address);
+    device.insert(QStringLiteral("Alias"), QStringLiteral("Device ") + address);
+    device.insert(QStringLiteral("Adapter"),
+                  QVariant::fromValue(QDBusObjectPath(QLatin1String(adapterPath))));
+    device.insert(QStringLiteral("RSSI"), QVariant::fromValue(qint16(-60)));
+
+    InterfaceList interfaces;
+    interfaces.insert(QStringLiteral("org.bluez.Device1"), device);
+    interfaces.insert(QStringLiteral("org.freedesktop.DBus.Properties"), QVariantMap());
+    return interfaces;
+}
+
+void tst_QtBluezObjectMirror::sendInterfacesAdded(const QString &path,
+                                                  const InterfaceList &interfaces)
+{
+    QDBusMessage message = QDBusMessage::createSignal(
+                QStringLiteral("/"), QStringLiteral("org.freedesktop.DBus.ObjectManager"),
+                QStringLiteral("InterfacesAdded"));
+    message << QVariant::fromValue(QDBusObjectPath(path)) << QVariant::fromValue(interfaces);
+    QVERIFY(QDBusConnection(QStringLiteral("bluez")).send(message));
+}
+
+void tst_QtBluezObjectMirror::initTestCase()
+{
+    const QString dbusDaemon = QStandardPaths::findExecutable(QStringLiteral("dbus-daemon"));
+    if (dbusDaemon.isEmpty())
+        QSKIP("dbus-daemon is required to run a mock BlueZ");
+
+    const QString busAddress = bluez.start(dbusDaemon);
+    QVERIFY(!busAddress.isEmpty());
+
+    QVariantMap adapter;
+    adapter.insert(QStringLiteral("Address"), QStringLiteral("AA:BB:CC:DD:EE:FF"));
+    adapter.insert(QStringLiteral("Name"), QStringLiteral("mock"));
+    InterfaceList adapterInterfaces;
+    adapterInterfaces.insert(QStringLiteral("org.bluez.Adapter1"), adapter);
+    bluez.objects.insert(QDBusObjectPath(QLatin1String(adapterPath)), adapterInterfaces);
+    bluez.objects.insert(QDBusObjectPath(QLatin1String(devicePath)),
+                         deviceInterfaces(QStringLiteral("00:11:22:33:44:55")));
+
+    QDBusConnection mirrorConnection = QDBusConnection::connectToBus(busAddress,
+                                                                     QStringLiteral("mirror"));
+    QVERIFY(mirrorConnection.isConnected());
+    mirror = new QtBluezObjectMirror(mirrorConnection);
+}
+
+void tst_QtBluezObjectMirror::cleanupTestCase()
+{
+    delete mirror;
+    mirror = 0;
+
+    QDBusConnection::disconnectFromBus(QStringLiteral("mirror"));
+    bluez.stop();
+}
+
+void tst_QtBluezObjectMirror::tst_populate()
+{
+    QVERIFY(mirror->isValid());
+    QCOMPARE(bluez.getManagedObjectsCount, 1);
+
+    QCOMPARE(mirror->adapterPaths(), QStringList() << QLatin1String(adapterPath));
+    QCOMPARE(mirror->adapterPath(QBluetoothAddress(QStringLiteral("AA:BB:CC:DD:EE:FF"))),
+             QString::fromLatin1(adapterPath));
+    QVERIFY(mirror->adapterPath(QBluetoothAddress(QStringLiteral("AA:BB:CC:DD:EE:00"))).isEmpty());
+
+    const QBluetoothAddress device(QStringLiteral("00:11:22:33:44:55"));
+    QCOMPARE(mirror->devicePath(QLatin1String(adapterPath), device),
+             QString::fromLatin1(devicePath));
+    QVERIFY(mirror->devicePath(QStringLiteral("/org/bluez/hci1"), device).isEmpty());
+    QCOMPARE(mirror->devicePaths(QLatin1String(adapterPath)),
+             QStringList() << QLatin1String(devicePath));
+
+    const QVariantMap properties = mirror->properties(QLatin1String(devicePath),
+                                                      QStringLiteral("org.bluez.Device1"));
+    QCOMPARE(properties.value(QStringLiteral("Alias")).toString(),
+             QStringLiteral("Device 00:11:22:33:44:55"));
+    QCOMPARE(properties.value(QStringLiteral("RSSI")).toInt(), -60);
+}
+
+void tst_QtBluezObjectMirror::tst_interfacesAdded()
+{
+    QSignalSpy addedSpy(mirror, SIGNAL(interfacesAdded(QDBusObjectPath,InterfaceList)));
+
+    sendInterfacesAdded(QLatin1String(newDevicePath),
+                        deviceInterfaces(QStringLiteral("66:77:88:99:AA:BB")));
+
+    QTRY_COMPARE(addedSpy.count(), 1);
+    QCOMPARE(addedSpy.at(0).at(0).value<QDBusObjectPath>().path(),
+             QString::fromLatin1(newDevicePath));
+
+    // the mirror is updated before the signal is re-emitted
+    QCOMPARE(mirror->devicePath(QLatin1String(adapterPath),
+                                QBluetoothAddress(QStringLiteral("66:77:88:99:AA:BB"))),
+             QString::fromLatin1(newDevicePath));
+    QCOMPARE(mirror->devicePaths(QLatin1String(adapterPath)).count(), 2);
+
+    // no further round trip to BlueZ
+    QCOMPARE(bluez.getManagedObjectsCount, 1);
+}
+
+void tst_QtBluezObjectMirror::tst_propertiesChanged()
+{
+    QSignalSpy changedSpy(mirror,
+                          SIGNAL(propertiesChanged(QString,QString,QVariantMap,QStringList)));
+
+    QVariantMap changed;
+    changed.insert(QStringLiteral("RSSI"), QVariant::fromValue(qint16(-42)));
+    changed.insert(QStringLiteral("Connected"), true);
+
+    QDBusMessage message = QDBusMessage::createSignal(
+                QLatin1String(devicePath), QStringLiteral("org.freedesktop.DBus.Properties"),
+                QStringLiteral("PropertiesChanged"));
+    message << QStringLiteral("org.bluez.Device1") << changed
+            << (QStringList() << QStringLiteral("Alias"));
+    QVERIFY(QDBusConnection(QStringLiteral("bluez")).send(message));
+
+    QTRY_COMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.at(0).at(0).toString(), QString::fromLatin1(devicePath));
+    QCOMPARE(changedSpy.at(0).at(1).toString(), QStringLiteral("org.bluez.Device1"));
+
+    const QVariantMap properties = mirror->properties(QLatin1String(devicePath),
+                                                      QStringLiteral("org.bluez.Device1"));
+    QCOMPARE(properties.value(QStringLiteral("RSSI")).toInt(), -42);
+    QCOMPARE(properties.value(QStringLiteral("Connected")).toBool(), true);
+    QVERIFY(!properties.contains(QStringLiteral("Alias")));
+    QCOMPARE(properties.value(QStringLiteral("Address")).toString(),
+             QStringLiteral("00:11:22:33:44:55"));
+
+    QCOMPARE(bluez.getManagedObjectsCount, 1);
+}
+
+void tst_QtBluezObjectMirror::tst_deviceNameChanged()
+{
+    QSignalSpy changedSpy(mirror,
+                          SIGNAL(propertiesChanged(QString,QString,QVariantMap,QStringList)));
+    QSignalSpy addedSpy(mirror, SIGNAL(interfacesAdded(QDBusObjectPath,InterfaceList)));
+    QSignalSpy nameSpy(mirror, SIGNAL(deviceNameChanged(QString)));
+    QDBusConnection bluezConnection(QStringLiteral("bluez"));
+
+    // other properties are not name changes
+    QVariantMap changed;
+    changed.insert(QStringLiteral("RSSI"), QVariant::fromValue(qint16(-50)));
+    QDBusMessage message = QDBusMessage::createSignal(
+                QLatin1String(devicePath), QStringLiteral("org.freedesktop.DBus.Properties"),
+                QStringLiteral("PropertiesChanged"));
+    message << QStringLiteral("org.bluez.Device1") << changed << QStringList();
+    QVERIFY(bluezConnection.send(message));
+    QTRY_COMPARE(changedSpy.count(), 1);
+    QCOMPARE(nameSpy.count(), 0);
+
+    // neither are other interfaces
+    QVariantMap player;
+    player.insert(QStringLiteral("Name"), QStringLiteral("player"));
+    InterfaceList interfaces;
+    interfaces.insert(QStringLiteral("org.bluez.MediaPlayer1"), player);
+    sendInterfacesAdded(QLatin1String(devicePath), interfaces);
+    QTRY_COMPARE(addedSpy.count(), 1);
+    QCOMPARE(nameSpy.count(), 0);
+
+    changed.clear();
+    changed.insert(QStringLiteral("Alias"), QStringLiteral("Renamed"));
+    message = QDBusMessage::createSignal(
+                QLatin1String(devicePath), QStringLiteral("org.freedesktop.DBus.Properties"),
+                QStringLiteral("PropertiesChanged"));
+    message << QStringLiteral("org.bluez.Device1") << changed << QStringList();
+    QVERIFY(bluezConnection.send(message));
+    QTRY_COMPARE(nameSpy.count(), 1);
+    QCOMPARE(nameSpy.at(0).at(0).toString(), QString::fromLatin1(devicePath));
+
+    // the mirror is updated before the signal is emitted
+    QCOMPARE(mirror->properties(QLatin1String(devicePath), QStringLiteral("org.bluez.Device1"))
+             .value(QStringLiteral("Alias")).toString(), QStringLiteral("Renamed"));
+}
+
+void tst_QtBluezObjectMirror::tst_interfacesRemoved()
+{
+    QSignalSpy removedSpy(mirror, SIGNAL(interfacesRemoved(QDBusObjectPath,QStringList)));
+
+    // removing an unrelated interface keeps the device
+    QDBusMessage message = QDBusMessage::createSignal(
+                QStringLiteral("/"), QStringLiteral("org.freedesktop.DBus.ObjectManager"),
+                QStringLiteral("InterfacesRemoved"));
+    message << QVariant::fromValue(QDBusObjectPath(QLatin1String(newDevicePath)))
+            << (QStringList() << QStringLiteral("org.freedesktop.DBus.Properties"));
+    QVERIFY(QDBusConnection(QStringLiteral("bluez")).send(message));
+
+    QTRY_COMPARE(removedSpy.count(), 1);
+    QCOMPARE(mirror->devicePaths(QLatin1String(adapterPath)).count(), 2);
+
+    message = QDBusMessage::createSignal(
+                QStringLiteral("/"), QStringLiteral("org.freedesktop.DBus.ObjectManager"),
+                QStringLiteral("InterfacesRemoved"));
+    message << QVariant::fromValue(QDBusObjectPath(QLatin1String(newDevicePath)))
+            << (QStringList() << QStringLiteral("org.bluez.Device1"));
+    QVERIFY(QDBusConnection(QStringLiteral("bluez")).send(message));
+
+    QTRY_COMPARE(removedSpy.count(), 2);
+    QVERIFY(mirror->devicePath(QLatin1String(adapterPath),
+                               QBluetoothAddress(QStringLiteral("66:77:88:99:AA:BB"))).isEmpty());
+    QVERIFY(mirror->interfaces(QLatin1String(newDevicePath)).isEmpty());
+    QCOMPARE(mirror->devicePaths(QLatin1String(adapterPath)),
+             QStringList() << QLatin1String(devicePath));
+}
+
+void tst_QtBluezObjectMirror::tst_serviceRestart()
+{
+    QSignalSpy removedSpy(mirror, SIGNAL(interfacesRemoved(QDBusObjectPath,QStringList)));
+    QSignalSpy addedSpy(mirror, SIGNAL(interfacesAdded(QDBusObjectPath,InterfaceList)));
+    QSignalSpy validSpy(mirror, SIGNAL(validChanged(bool)));
+    QSignalSpy nameSpy(mirror, SIGNAL(deviceNameChanged(QString)));
+
+    QDBusConnection bluezConnection(QStringLiteral("bluez"));
+
+    // BlueZ going away drops all objects
+    QVERIFY(bluezConnection.unregisterService(QStringLiteral("org.bluez")));
+    QTRY_COMPARE(removedSpy.count(), 2);
+    QVERIFY(!mirror->isValid());
+    QCOMPARE(validSpy.count(), 1);
+    QCOMPARE(validSpy.at(0).at(0).toBool(), false);
+    QVERIFY(mirror->adapterPaths().isEmpty());
+    QVERIFY(mirror->adapterPath(QBluetoothAddress(QStringLiteral("AA:BB:CC:DD:EE:FF"))).isEmpty());
+
+    // a restarted BlueZ is mirrored again
+    QVERIFY(bluezConnection.registerService(QStringLiteral("org.bluez")));
+    QTRY_COMPARE(addedSpy.count(), 2);
+    QCOMPARE(bluez.getManagedObjectsCount, 2);
+    QVERIFY(mirror->isValid());
+    QCOMPARE(validSpy.count(), 2);
+    QCOMPARE(validSpy.at(1).at(0).toBool(), true);
+    // names of the mirrored devices count as resolved again
+    QCOMPARE(nameSpy.count(), 1);
+    QCOMPARE(nameSpy.at(0).at(0).toString(), QString::fromLatin1(devicePath));
+    QCOMPARE(mirror->adapterPath(QBluetoothAddress(QStringLiteral("AA:BB:CC:DD:EE:FF"))),
+             QString::fromLatin1(adapterPath));
+    QCOMPARE(mirror->devicePaths(QLatin1String(adapterPath)),
+             QStringList() << QLatin1String(devicePath));
+}
+
+QTEST_MAIN(tst_QtBluezObjectMirror)
+
+#include "tst_qtbluezobjectmirror.moc"
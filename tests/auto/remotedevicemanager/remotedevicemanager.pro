@@ -0,0 +1,8 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_remotedevicemanager.cpp
+HEADERS += ../shared/mockbluez.h
+TARGET = tst_remotedevicemanager
+CONFIG += testcase
+
+QT = core dbus bluetooth-private testlib
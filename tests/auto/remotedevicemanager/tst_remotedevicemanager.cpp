@@ -0,0 +1,225 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/private/remotedevicemanager_p.h>
+
+#include "../shared/mockbluez.h"
+
+Q_DECLARE_METATYPE(RemoteDeviceManager::JobType)
+
+static const char adapterPath[] = "/org/bluez/hci0";
+static const int deviceCount = 10;
+
+// Holds back the replies to Disconnect() until release() is called
+class MockDevice : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.bluez.Device1")
+
+public:
+    static QList<QDBusMessage> pendingReplies;
+    static int maximumPending;
+
+    static void release()
+    {
+        foreach (const QDBusMessage &reply, pendingReplies)
+            QDBusConnection(QStringLiteral("bluez")).send(reply);
+        pendingReplies.clear();
+    }
+
+public slots:
+    void Disconnect()
+    {
+        setDelayedReply(true);
+        pendingReplies.append(message().createReply());
+        maximumPending = qMax(maximumPending, pendingReplies.count());
+    }
+};
+
+QList<QDBusMessage> MockDevice::pendingReplies;
+int MockDevice::maximumPending = 0;
+
+class tst_RemoteDeviceManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+
+    void parallelJobs_data();
+    void parallelJobs();
+    void unknownDevice();
+
+private:
+    static QBluetoothAddress deviceAddress(int index);
+    static QString devicePath(int index);
+
+    MockBluez bluez;
+    MockDevice devices[deviceCount];
+    QtBluezObjectMirror *mirror = nullptr;
+};
+
+QBluetoothAddress tst_RemoteDeviceManager::deviceAddress(int index)
+{
+    return QBluetoothAddress(quint64(0x001122334400) + index);
+}
+
+QString tst_RemoteDeviceManager::devicePath(int index)
+{
+    return QLatin1String(adapterPath) + QStringLiteral("/dev_")
+            + deviceAddress(index).toString().replace(QLatin1Char(':'), QLatin1Char('_'));
+}
+
+void tst_RemoteDeviceManager::initTestCase()
+{
+    qRegisterMetaType<RemoteDeviceManager::JobType>();
+
+    const QString dbusDaemon = QStandardPaths::findExecutable(QStringLiteral("dbus-daemon"));
+    if (dbusDaemon.isEmpty())
+        QSKIP("dbus-daemon is required to run a mock BlueZ");
+
+    const QString busAddress = bluez.start(dbusDaemon);
+    QVERIFY(!busAddress.isEmpty());
+    QDBusConnection bluezConnection(QStringLiteral("bluez"));
+
+    QVariantMap adapter;
+    adapter.insert(QStringLiteral("Address"), QStringLiteral("AA:BB:CC:DD:EE:FF"));
+    InterfaceList adapterInterfaces;
+    adapterInterfaces.insert(QStringLiteral("org.bluez.Adapter1"), adapter);
+    bluez.objects.insert(QDBusObjectPath(QLatin1String(adapterPath)), adapterInterfaces);
+
+    for (int i = 0; i < deviceCount; ++i) {
+        QVariantMap device;
+        device.insert(QStringLiteral("Address"), deviceAddress(i).toString());
+        device.insert(QStringLiteral("Adapter"),
+                      QVariant::fromValue(QDBusObjectPath(QLatin1String(adapterPath))));
+        InterfaceList interfaces;
+        interfaces.insert(QStringLiteral("org.bluez.Device1"), device);
+        bluez.objects.insert(QDBusObjectPath(devicePath(i)), interfaces);
+
+        QVERIFY(bluezConnection.registerObject(devicePath(i), &devices[i],
+                                               QDBusConnection::ExportAllSlots));
+    }
+
+    QDBusConnection managerConnection = QDBusConnection::connectToBus(busAddress,
+                                                                      QStringLiteral("manager"));
+    QVERIFY(managerConnection.isConnected());
+    mirror = new QtBluezObjectMirror(managerConnection);
+    QVERIFY(mirror->isValid());
+}
+
+void tst_RemoteDeviceManager::init()
+{
+    MockDevice::pendingReplies.clear();
+    MockDevice::maximumPending = 0;
+}
+
+void tst_RemoteDeviceManager::cleanupTestCase()
+{
+    delete mirror;
+    mirror = nullptr;
+
+    QDBusConnection::disconnectFromBus(QStringLiteral("manager"));
+    bluez.stop();
+}
+
+void tst_RemoteDeviceManager::parallelJobs_data()
+{
+    QTest::addColumn<int>("maximumParallelJobs");
+
+    QTest::newRow("sequential") << 1;
+    QTest::newRow("3 parallel") << 3;
+    QTest::newRow("all parallel") << deviceCount;
+}
+
+void tst_RemoteDeviceManager::parallelJobs()
+{
+    QFETCH(int, maximumParallelJobs);
+
+    RemoteDeviceManager manager(QDBusConnection(QStringLiteral("manager")), mirror,
+                                QLatin1String(adapterPath));
+    manager.setMaximumParallelJobs(maximumParallelJobs);
+    QCOMPARE(manager.maximumParallelJobs(), maximumParallelJobs);
+
+    QSignalSpy jobSpy(&manager, SIGNAL(jobFinished(RemoteDeviceManager::JobType,
+                                                   QBluetoothAddress,bool)));
+    QSignalSpy finishedSpy(&manager, SIGNAL(finished()));
+
+    QVector<QBluetoothAddress> remotes;
+    for (int i = 0; i < deviceCount; ++i)
+        remotes.append(deviceAddress(i));
+    QVERIFY(manager.scheduleJob(RemoteDeviceManager::JobType::JobDisconnectDevice, remotes));
+    QVERIFY(manager.isJobInProgress());
+
+    // release the calls in rounds, never more than the limit may be outstanding
+    int released = 0;
+    while (released < deviceCount) {
+        const int expected = qMin(maximumParallelJobs, deviceCount - released);
+        QTRY_COMPARE(MockDevice::pendingReplies.count(), expected);
+        QCOMPARE(finishedSpy.count(), 0);
+
+        MockDevice::release();
+        released += expected;
+        QTRY_COMPARE(jobSpy.count(), released);
+    }
+
+    QCOMPARE(MockDevice::maximumPending, maximumParallelJobs);
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QVERIFY(!manager.isJobInProgress());
+
+    for (int i = 0; i < jobSpy.count(); ++i)
+        QVERIFY(jobSpy.at(i).at(2).toBool());
+}
+
+void tst_RemoteDeviceManager::unknownDevice()
+{
+    RemoteDeviceManager manager(QDBusConnection(QStringLiteral("manager")), mirror,
+                                QLatin1String(adapterPath));
+
+    QSignalSpy jobSpy(&manager, SIGNAL(jobFinished(RemoteDeviceManager::JobType,
+                                                   QBluetoothAddress,bool)));
+    QSignalSpy finishedSpy(&manager, SIGNAL(finished()));
+
+    const QBluetoothAddress unknown(QStringLiteral("66:77:88:99:AA:BB"));
+    QVERIFY(manager.scheduleJob(RemoteDeviceManager::JobType::JobDisconnectDevice,
+                                QVector<QBluetoothAddress>() << unknown));
+
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QCOMPARE(jobSpy.count(), 1);
+    QCOMPARE(jobSpy.at(0).at(1).value<QBluetoothAddress>(), unknown);
+    QCOMPARE(jobSpy.at(0).at(2).toBool(), false);
+    QVERIFY(MockDevice::pendingReplies.isEmpty());
+}
+
+QTEST_MAIN(tst_RemoteDeviceManager)
+
+#include "tst_remotedevicemanager.moc"
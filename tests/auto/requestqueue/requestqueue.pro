@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_requestqueue.cpp
+TARGET = tst_requestqueue
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
@@ -0,0 +1,284 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/private/qlowenergycontroller_p.h>
+
+QT_USE_NAMESPACE
+
+typedef QLowEnergyControllerPrivate::Request Request;
+typedef QLowEnergyControllerPrivate::RequestQueue RequestQueue;
+
+class tst_RequestQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void wraparound();
+    void prepend();
+    void growth();
+    void growthWhileWrapped();
+    void clear();
+    void payload();
+    void responses();
+    void lateResponse();
+    void lateErrorResponse();
+    void lostResponse();
+
+private:
+    static Request request(quint16 sequence);
+    static Request request(quint8 command, quint16 sequence);
+};
+
+Request tst_RequestQueue::request(quint16 sequence)
+{
+    Request request;
+    request.command = 0x0a;
+    request.charHandle = sequence;
+    return request;
+}
+
+Request tst_RequestQueue::request(quint8 command, quint16 sequence)
+{
+    Request request;
+    request.command = command;
+    request.charHandle = sequence;
+    return request;
+}
+
+void tst_RequestQueue::wraparound()
+{
+    RequestQueue queue;
+    quint16 enqueued = 0;
+    quint16 dequeued = 0;
+
+    // keep a few requests queued while the ring position moves around several times
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 7; ++i)
+            queue.enqueue(request(enqueued++));
+        for (int i = 0; i < 5; ++i) {
+            QCOMPARE(queue.head().charHandle, dequeued);
+            QCOMPARE(queue.dequeue().charHandle, dequeued++);
+        }
+        QCOMPARE(queue.count(), int(enqueued - dequeued));
+    }
+
+    while (!queue.isEmpty())
+        QCOMPARE(queue.dequeue().charHandle, dequeued++);
+    QCOMPARE(dequeued, enqueued);
+}
+
+void tst_RequestQueue::prepend()
+{
+    RequestQueue queue;
+
+    // prepending to a fresh ring wraps to its end
+    queue.enqueue(request(1));
+    queue.enqueue(request(2));
+    queue.prepend(request(0));
+    QCOMPARE(queue.count(), 3);
+    QCOMPARE(queue.head().charHandle, quint16(0));
+
+    queue.enqueue(request(3));
+    for (quint16 i = 0; i < 4; ++i)
+        QCOMPARE(queue.dequeue().charHandle, i);
+    QVERIFY(queue.isEmpty());
+
+    // prepending to an empty queue
+    queue.prepend(request(42));
+    QCOMPARE(queue.count(), 1);
+    QCOMPARE(queue.dequeue().charHandle, quint16(42));
+}
+
+void tst_RequestQueue::growth()
+{
+    RequestQueue queue;
+
+    for (quint16 i = 0; i < 100; ++i)
+        queue.enqueue(request(i));
+    QCOMPARE(queue.count(), 100);
+
+    for (quint16 i = 0; i < 100; ++i)
+        QCOMPARE(queue.dequeue().charHandle, i);
+    QVERIFY(queue.isEmpty());
+}
+
+void tst_RequestQueue::growthWhileWrapped()
+{
+    RequestQueue queue;
+    quint16 enqueued = 0;
+    quint16 dequeued = 0;
+
+    // move the head towards the end of the ring, so that the queue wraps when it grows
+    for (int i = 0; i < 12; ++i)
+        queue.enqueue(request(enqueued++));
+    for (int i = 0; i < 10; ++i)
+        QCOMPARE(queue.dequeue().charHandle, dequeued++);
+
+    for (int i = 0; i < 40; ++i)
+        queue.enqueue(request(enqueued++));
+    queue.prepend(request(1000));
+    QCOMPARE(queue.count(), 43);
+
+    QCOMPARE(queue.dequeue().charHandle, quint16(1000));
+    while (!queue.isEmpty())
+        QCOMPARE(queue.dequeue().charHandle, dequeued++);
+    QCOMPARE(dequeued, enqueued);
+}
+
+void tst_RequestQueue::clear()
+{
+    RequestQueue queue;
+    for (quint16 i = 0; i < 20; ++i)
+        queue.enqueue(request(i));
+
+    queue.clear();
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.count(), 0);
+
+    queue.enqueue(request(7));
+    QCOMPARE(queue.dequeue().charHandle, quint16(7));
+}
+
+void tst_RequestQueue::payload()
+{
+    // the default MTU is stored inline, larger PDUs of a bigger MTU are not
+    const QByteArray shortPdu = QByteArray::fromHex("0a0300");
+    const QByteArray longPdu(QLowEnergyControllerPrivate::Payload::InlineSize + 10, 'x');
+
+    RequestQueue queue;
+    Request shortRequest;
+    shortRequest.payload = shortPdu;
+    queue.enqueue(shortRequest);
+
+    Request longRequest;
+    longRequest.payload = longPdu;
+    queue.enqueue(longRequest);
+
+    Request rawRequest;
+    const char raw[] = { 0x02, 0x17, 0x00 };
+    rawRequest.payload.assign(raw, sizeof(raw));
+    queue.enqueue(rawRequest);
+
+    QCOMPARE(queue.dequeue().payload.toByteArray(), shortPdu);
+    QCOMPARE(queue.dequeue().payload.toByteArray(), longPdu);
+    const Request dequeued = queue.dequeue();
+    QCOMPARE(dequeued.payload.size(), 3);
+    QCOMPARE(QByteArray(dequeued.payload.constData(), 3), QByteArray(raw, 3));
+}
+
+void tst_RequestQueue::responses()
+{
+    RequestQueue queue;
+    queue.enqueue(request(0x0a, 1));    // read
+
+    // nothing was sent yet
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0b00"), false),
+             RequestQueue::UnexpectedResponse);
+
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0b00"), true), RequestQueue::HeadResponse);
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("010a010002"), true),
+             RequestQueue::HeadResponse);
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("13"), true),
+             RequestQueue::UnexpectedResponse);
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0112010002"), true),
+             RequestQueue::UnexpectedResponse);
+
+    queue.dequeue();
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0b00"), true),
+             RequestQueue::UnexpectedResponse);
+}
+
+void tst_RequestQueue::lateResponse()
+{
+    RequestQueue queue;
+    queue.enqueue(request(0x0a, 1));    // read
+    queue.enqueue(request(0x12, 2));    // write
+    queue.enqueue(request(0x0a, 3));    // read
+
+    // the read times out, its response arrives while the write is pending
+    QCOMPARE(queue.dequeueTimedOut().charHandle, quint16(1));
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0b2a"), true), RequestQueue::LateResponse);
+    QCOMPARE(queue.count(), 2);
+
+    // only one late response is expected
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0b2a"), true),
+             RequestQueue::UnexpectedResponse);
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("13"), true), RequestQueue::HeadResponse);
+    QCOMPARE(queue.dequeue().charHandle, quint16(2));
+
+    // the write times out, the next request is a read again
+    queue.enqueue(request(0x12, 4));
+    QCOMPARE(queue.head().charHandle, quint16(3));
+    queue.prepend(request(0x12, 5));
+    QCOMPARE(queue.dequeueTimedOut().charHandle, quint16(5));
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("13"), true), RequestQueue::LateResponse);
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0b2b"), true), RequestQueue::HeadResponse);
+    QCOMPARE(queue.dequeue().charHandle, quint16(3));
+}
+
+void tst_RequestQueue::lateErrorResponse()
+{
+    RequestQueue queue;
+    queue.enqueue(request(0x0a, 1));    // read
+    queue.enqueue(request(0x0a, 2));    // read
+
+    // with the same command on both, the first response is taken as the late one
+    queue.dequeueTimedOut();
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("010a010002"), true),
+             RequestQueue::LateResponse);
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("010a020002"), true),
+             RequestQueue::HeadResponse);
+}
+
+void tst_RequestQueue::lostResponse()
+{
+    RequestQueue queue;
+    queue.enqueue(request(0x0a, 1));    // read
+    queue.enqueue(request(0x12, 2));    // write
+    queue.enqueue(request(0x0a, 3));    // read
+
+    // the read is never answered, the write is
+    queue.dequeueTimedOut();
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("13"), true), RequestQueue::HeadResponse);
+    queue.dequeue();
+
+    // so a read response now belongs to the head request
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0b2a"), true), RequestQueue::HeadResponse);
+
+    // clearing the queue forgets timed out requests
+    queue.dequeueTimedOut();
+    queue.clear();
+    queue.enqueue(request(0x0a, 4));
+    QCOMPARE(queue.matchResponse(QByteArray::fromHex("0b2a"), true), RequestQueue::HeadResponse);
+}
+
+QTEST_MAIN(tst_RequestQueue)
+
+#include "tst_requestqueue.moc"
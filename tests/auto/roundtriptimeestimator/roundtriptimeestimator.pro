@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_roundtriptimeestimator.cpp
+TARGET = tst_roundtriptimeestimator
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
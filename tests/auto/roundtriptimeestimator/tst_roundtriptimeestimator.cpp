@@ -0,0 +1,145 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/private/roundtriptimeestimator_p.h>
+
+QT_USE_NAMESPACE
+
+class tst_RoundTripTimeEstimator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initialTimeout();
+    void firstSample();
+    void steadyLink();
+    void latencySpike();
+    void backOff();
+    void fixedTimeout();
+    void reset();
+};
+
+void tst_RoundTripTimeEstimator::initialTimeout()
+{
+    RoundTripTimeEstimator estimator(500, 20000);
+    QCOMPARE(estimator.timeout(), 20000);
+    QCOMPARE(estimator.minimumTimeout(), 500);
+    QCOMPARE(estimator.maximumTimeout(), 20000);
+    QVERIFY(estimator.smoothedRoundTripTime() < 0);
+}
+
+void tst_RoundTripTimeEstimator::firstSample()
+{
+    RoundTripTimeEstimator estimator(100, 20000);
+
+    // SRTT = R, RTTVAR = R/2, RTO = SRTT + 4 * RTTVAR
+    estimator.addSample(200000);
+    QCOMPARE(estimator.smoothedRoundTripTime(), qint64(200000));
+    QCOMPARE(estimator.roundTripTimeVariation(), qint64(100000));
+    QCOMPARE(estimator.timeout(), 600);
+
+    // bounded by the minimum
+    RoundTripTimeEstimator fast(1000, 20000);
+    fast.addSample(30000);
+    QCOMPARE(fast.timeout(), 1000);
+}
+
+void tst_RoundTripTimeEstimator::steadyLink()
+{
+    RoundTripTimeEstimator estimator(1, 20000);
+
+    for (int i = 0; i < 100; ++i)
+        estimator.addSample(50000);
+
+    QCOMPARE(estimator.smoothedRoundTripTime(), qint64(50000));
+    // the variation decays towards zero, the clock granularity is the lower bound
+    QVERIFY(estimator.timeout() >= 60);
+    QVERIFY(estimator.timeout() < 100);
+}
+
+void tst_RoundTripTimeEstimator::latencySpike()
+{
+    RoundTripTimeEstimator estimator(1, 20000);
+
+    for (int i = 0; i < 100; ++i)
+        estimator.addSample(50000);
+    const int steadyTimeout = estimator.timeout();
+
+    estimator.addSample(1000000);
+    QVERIFY(estimator.timeout() > steadyTimeout);
+    QVERIFY(estimator.timeout() < 20000);
+}
+
+void tst_RoundTripTimeEstimator::backOff()
+{
+    RoundTripTimeEstimator estimator(1000, 20000);
+    estimator.addSample(50000);
+    QCOMPARE(estimator.timeout(), 1000);
+
+    estimator.backOff();
+    QCOMPARE(estimator.timeout(), 2000);
+    estimator.backOff();
+    QCOMPARE(estimator.timeout(), 4000);
+
+    for (int i = 0; i < 10; ++i)
+        estimator.backOff();
+    QCOMPARE(estimator.timeout(), 20000);
+
+    // an answered request recomputes the timeout from the estimate
+    estimator.addSample(50000);
+    QCOMPARE(estimator.timeout(), 1000);
+}
+
+void tst_RoundTripTimeEstimator::fixedTimeout()
+{
+    RoundTripTimeEstimator estimator(20000, 20000);
+    estimator.addSample(50000);
+    QCOMPARE(estimator.timeout(), 20000);
+
+    estimator.setTimeoutRange(30000, 5000);
+    QCOMPARE(estimator.minimumTimeout(), 5000);
+    estimator.addSample(50000);
+    QCOMPARE(estimator.timeout(), 5000);
+}
+
+void tst_RoundTripTimeEstimator::reset()
+{
+    RoundTripTimeEstimator estimator(100, 20000);
+    estimator.addSample(50000);
+    QVERIFY(estimator.timeout() < 20000);
+
+    estimator.reset();
+    QCOMPARE(estimator.timeout(), 20000);
+    QVERIFY(estimator.smoothedRoundTripTime() < 0);
+}
+
+QTEST_MAIN(tst_RoundTripTimeEstimator)
+
+#include "tst_roundtriptimeestimator.moc"
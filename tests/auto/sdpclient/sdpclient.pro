@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_sdpclient.cpp
+TARGET = tst_sdpclient
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
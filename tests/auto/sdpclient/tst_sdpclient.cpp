@@ -0,0 +1,298 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/qbluetoothserviceinfo.h>
+#include <QtBluetooth/private/sdpclient_p.h>
+#include <QtBluetooth/private/sdpdataelement_p.h>
+
+QT_USE_NAMESPACE
+
+// AttributeLists of a Serial Port record on RFCOMM channel 3 as sent by a phone
+static const char serialPortRecord[] =
+        "353b"                                          // attribute lists
+          "3539"                                        // record
+            "090000" "0a00010005"                       // ServiceRecordHandle
+            "090001" "3503" "191101"                    // ServiceClassIDList: SerialPort
+            "090004" "350c" "3503190100"                // ProtocolDescriptorList: L2CAP
+                            "35051900030803"            //   RFCOMM channel 3
+            "090005" "3503" "191002"                    // BrowseGroupList: PublicBrowseGroup
+            "090100" "250b" "53657269616c20506f7274";   // ServiceName "Serial Port"
+
+class tst_SdpClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_SdpClient();
+
+private slots:
+    void tst_request();
+    void tst_response();
+    void tst_continuation();
+    void tst_errorResponse();
+    void tst_malformedResponse_data();
+    void tst_malformedResponse();
+    void tst_decodeRecord();
+    void tst_decodeElement_data();
+    void tst_decodeElement();
+    void tst_decodeTruncated();
+
+private:
+    static QByteArray response(quint16 transactionId, const QByteArray &attributeLists,
+                               const QByteArray &continuationState);
+};
+
+tst_SdpClient::tst_SdpClient()
+{
+}
+
+QByteArray tst_SdpClient::response(quint16 transactionId, const QByteArray &attributeLists,
+                                   const QByteArray &continuationState)
+{
+    const int parameterLength = 2 + attributeLists.size() + 1 + continuationState.size();
+
+    QByteArray pdu;
+    pdu.append(char(0x07));
+    pdu.append(char(transactionId >> 8));
+    pdu.append(char(transactionId & 0xff));
+    pdu.append(char(parameterLength >> 8));
+    pdu.append(char(parameterLength & 0xff));
+    pdu.append(char(attributeLists.size() >> 8));
+    pdu.append(char(attributeLists.size() & 0xff));
+    pdu.append(attributeLists);
+    pdu.append(char(continuationState.size()));
+    pdu.append(continuationState);
+    return pdu;
+}
+
+void tst_SdpClient::tst_request()
+{
+    QByteArray pdu = SdpClient::serviceSearchAttributeRequest(
+                1, QBluetoothUuid(QBluetoothUuid::PublicBrowseGroup), QByteArray());
+    QCOMPARE(pdu.toHex(), QByteArray("060001000f" "3503191002" "ffff" "35050a0000ffff" "00"));
+
+    pdu = SdpClient::serviceSearchAttributeRequest(
+                0x1234, QBluetoothUuid(quint32(0x12345678)), QByteArray::fromHex("0102"));
+    QCOMPARE(pdu.toHex(), QByteArray("0612340013" "35051a12345678" "ffff" "35050a0000ffff" "020102"));
+
+    const QBluetoothUuid custom(QStringLiteral("{6e400001-b5a3-f393-e0a9-e50e24dcca9e}"));
+    pdu = SdpClient::serviceSearchAttributeRequest(2, custom, QByteArray());
+    QCOMPARE(pdu.toHex(), QByteArray("060002001d" "35111c6e400001b5a3f393e0a9e50e24dcca9e"
+                                     "ffff" "35050a0000ffff" "00"));
+}
+
+void tst_SdpClient::tst_response()
+{
+    const QByteArray lists = QByteArray::fromHex(serialPortRecord);
+
+    QByteArray attributeLists;
+    QByteArray continuationState;
+    quint16 errorCode;
+    QVERIFY(SdpClient::parseServiceSearchAttributeResponse(response(5, lists, QByteArray()), 5,
+                                                           &attributeLists, &continuationState,
+                                                           &errorCode));
+    QCOMPARE(attributeLists, lists);
+    QVERIFY(continuationState.isEmpty());
+
+    // response to another transaction
+    QVERIFY(!SdpClient::parseServiceSearchAttributeResponse(response(6, lists, QByteArray()), 5,
+                                                            &attributeLists, &continuationState,
+                                                            &errorCode));
+}
+
+void tst_SdpClient::tst_continuation()
+{
+    const QByteArray lists = QByteArray::fromHex(serialPortRecord);
+
+    QByteArray attributeLists;
+    QByteArray continuationState;
+    quint16 errorCode;
+
+    QVERIFY(SdpClient::parseServiceSearchAttributeResponse(
+                response(1, lists.left(20), QByteArray::fromHex("0014")), 1,
+                &attributeLists, &continuationState, &errorCode));
+    QCOMPARE(continuationState, QByteArray::fromHex("0014"));
+
+    QVERIFY(SdpClient::parseServiceSearchAttributeResponse(
+                response(1, lists.mid(20), QByteArray()), 1,
+                &attributeLists, &continuationState, &errorCode));
+    QVERIFY(continuationState.isEmpty());
+    QCOMPARE(attributeLists, lists);
+
+    QList<QMap<quint16, QVariant> > records;
+    QVERIFY(SdpDataElement::decodeAttributeLists(attributeLists, &records));
+    QCOMPARE(records.count(), 1);
+}
+
+void tst_SdpClient::tst_errorResponse()
+{
+    QByteArray attributeLists;
+    QByteArray continuationState;
+    quint16 errorCode;
+
+    // Invalid Request Syntax
+    QVERIFY(!SdpClient::parseServiceSearchAttributeResponse(
+                QByteArray::fromHex("01000100020003"), 1,
+                &attributeLists, &continuationState, &errorCode));
+    QCOMPARE(errorCode, quint16(0x0003));
+    QVERIFY(attributeLists.isEmpty());
+}
+
+void tst_SdpClient::tst_malformedResponse_data()
+{
+    QTest::addColumn<QByteArray>("pdu");
+
+    QTest::newRow("truncated header") << QByteArray::fromHex("070001");
+    QTest::newRow("parameter length too long") << QByteArray::fromHex("0700010006000135" "00");
+    QTest::newRow("byte count too long") << QByteArray::fromHex("070001000400053500");
+    QTest::newRow("continuation too long") << QByteArray::fromHex("0700010006000235000201");
+    QTest::newRow("unexpected pdu") << QByteArray::fromHex("030001000400000000");
+}
+
+void tst_SdpClient::tst_malformedResponse()
+{
+    QFETCH(QByteArray, pdu);
+
+    QByteArray attributeLists;
+    QByteArray continuationState;
+    quint16 errorCode;
+    QVERIFY(!SdpClient::parseServiceSearchAttributeResponse(pdu, 1, &attributeLists,
+                                                            &continuationState, &errorCode));
+    QCOMPARE(errorCode, quint16(0));
+}
+
+void tst_SdpClient::tst_decodeRecord()
+{
+    QList<QMap<quint16, QVariant> > records;
+    QVERIFY(SdpDataElement::decodeAttributeLists(QByteArray::fromHex(serialPortRecord), &records));
+    QCOMPARE(records.count(), 1);
+
+    QBluetoothServiceInfo info;
+    const QMap<quint16, QVariant> &attributes = records.first();
+    for (QMap<quint16, QVariant>::const_iterator it = attributes.constBegin();
+         it != attributes.constEnd(); ++it) {
+        info.setAttribute(it.key(), it.value());
+    }
+
+    QCOMPARE(info.attributes().count(), 5);
+    QCOMPARE(info.attribute(QBluetoothServiceInfo::ServiceRecordHandle).value<quint32>(),
+             quint32(0x00010005));
+    QCOMPARE(info.serviceName(), QStringLiteral("Serial Port"));
+    QCOMPARE(info.serviceClassUuids(),
+             QList<QBluetoothUuid>() << QBluetoothUuid(QBluetoothUuid::SerialPort));
+    QCOMPARE(info.socketProtocol(), QBluetoothServiceInfo::RfcommProtocol);
+    QCOMPARE(info.serverChannel(), 3);
+    QVERIFY(info.isValid());
+}
+
+void tst_SdpClient::tst_decodeElement_data()
+{
+    QTest::addColumn<QByteArray>("element");
+    QTest::addColumn<QVariant>("value");
+
+    QTest::newRow("nil") << QByteArray("00") << QVariant();
+    QTest::newRow("uint8") << QByteArray("08ff") << QVariant::fromValue(quint8(0xff));
+    QTest::newRow("uint16") << QByteArray("090102") << QVariant::fromValue(quint16(0x0102));
+    QTest::newRow("uint32") << QByteArray("0a01020304")
+                            << QVariant::fromValue(quint32(0x01020304));
+    QTest::newRow("uint64") << QByteArray("0b0102030405060708")
+                            << QVariant::fromValue(quint64(Q_UINT64_C(0x0102030405060708)));
+    QTest::newRow("int8") << QByteArray("10ff") << QVariant::fromValue(qint8(-1));
+    QTest::newRow("int16") << QByteArray("11fffe") << QVariant::fromValue(qint16(-2));
+    QTest::newRow("int32") << QByteArray("12fffffffd") << QVariant::fromValue(qint32(-3));
+    QTest::newRow("int64") << QByteArray("13fffffffffffffffc") << QVariant::fromValue(qint64(-4));
+    QTest::newRow("uuid16") << QByteArray("191101")
+                            << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::SerialPort));
+    QTest::newRow("uuid128") << QByteArray("1c00001101" "00001000800000805f9b34fb")
+                             << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::SerialPort));
+    QTest::newRow("text") << QByteArray("2503616263") << QVariant(QStringLiteral("abc"));
+    QTest::newRow("text with zero") << QByteArray("260004616200ff")
+                                    << QVariant(QStringLiteral("ab"));
+    QTest::newRow("bool") << QByteArray("2801") << QVariant(true);
+    QTest::newRow("url") << QByteArray("4504612e6f72")
+                         << QVariant(QStringLiteral("a.or"));
+
+    QBluetoothServiceInfo::Alternative alternative;
+    alternative << QVariant::fromValue(quint8(1)) << QVariant(false);
+    QTest::newRow("alternative") << QByteArray("3d04" "0801" "2800")
+                                 << QVariant::fromValue(alternative);
+
+    QBluetoothServiceInfo::Sequence sequence;
+    sequence << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::L2cap))
+             << QVariant::fromValue(quint16(0x0019));
+    QTest::newRow("sequence32") << QByteArray("3700000006" "190100" "090019")
+                                << QVariant::fromValue(sequence);
+}
+
+void tst_SdpClient::tst_decodeElement()
+{
+    QFETCH(QByteArray, element);
+    QFETCH(QVariant, value);
+
+    const QByteArray data = QByteArray::fromHex(element);
+    const char *begin = data.constData();
+    bool ok = false;
+    const QVariant decoded = SdpDataElement::decode(begin, data.constData() + data.size(), &ok);
+
+    QVERIFY(ok);
+    QCOMPARE(begin, data.constData() + data.size());
+    QCOMPARE(decoded.userType(), value.userType());
+    if (value.userType() == qMetaTypeId<QBluetoothServiceInfo::Sequence>()) {
+        QCOMPARE(decoded.value<QBluetoothServiceInfo::Sequence>(),
+                 value.value<QBluetoothServiceInfo::Sequence>());
+    } else if (value.userType() == qMetaTypeId<QBluetoothServiceInfo::Alternative>()) {
+        QCOMPARE(decoded.value<QBluetoothServiceInfo::Alternative>(),
+                 value.value<QBluetoothServiceInfo::Alternative>());
+    } else {
+        QCOMPARE(decoded, value);
+    }
+}
+
+void tst_SdpClient::tst_decodeTruncated()
+{
+    const QList<QByteArray> elements = QList<QByteArray>()
+            << "09" << "0a0102" << "2505616263" << "3603" << "350308010a01";
+
+    foreach (const QByteArray &element, elements) {
+        const QByteArray data = QByteArray::fromHex(element);
+        const char *begin = data.constData();
+        bool ok = true;
+        SdpDataElement::decode(begin, data.constData() + data.size(), &ok);
+        QVERIFY2(!ok, element.constData());
+    }
+
+    QList<QMap<quint16, QVariant> > records;
+    QVERIFY(!SdpDataElement::decodeAttributeLists(
+                QByteArray::fromHex(serialPortRecord).left(30), &records));
+}
+
+QTEST_MAIN(tst_SdpClient)
+
+#include "tst_sdpclient.moc"
@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_sdpdataelement.cpp
+TARGET = tst_sdpdataelement
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
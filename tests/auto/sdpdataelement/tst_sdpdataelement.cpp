@@ -0,0 +1,460 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QXmlStreamReader>
+#include <QtBluetooth/qbluetoothserviceinfo.h>
+#include <QtBluetooth/private/sdpdataelement_p.h>
+
+QT_USE_NAMESPACE
+
+typedef QMap<quint16, QVariant> AttributeMap;
+
+class tst_SdpDataElement : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_SdpDataElement();
+
+private slots:
+    void tst_encode_data();
+    void tst_encode();
+    void tst_encodeUnsupported();
+    void tst_encodeLargeSequence();
+    void tst_serviceRecord();
+    void tst_xml();
+    void tst_fuzzRoundTrip();
+    void tst_fuzzDecode();
+    void tst_nestingLimit();
+
+private:
+    static AttributeMap serialPortRecord();
+    static QVariant randomValue(QRandomGenerator *generator, int depth);
+    static bool equal(const QVariant &encoded, const QVariant &decoded);
+    static bool roundTrip(const AttributeMap &attributes, AttributeMap *decoded);
+};
+
+tst_SdpDataElement::tst_SdpDataElement()
+{
+}
+
+AttributeMap tst_SdpDataElement::serialPortRecord()
+{
+    AttributeMap attributes;
+
+    attributes.insert(QBluetoothServiceInfo::ServiceRecordHandle,
+                      QVariant::fromValue(quint32(0x00010005)));
+
+    QBluetoothServiceInfo::Sequence classIds;
+    classIds << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::SerialPort));
+    attributes.insert(QBluetoothServiceInfo::ServiceClassIds, QVariant::fromValue(classIds));
+
+    QBluetoothServiceInfo::Sequence protocolDescriptorList;
+    QBluetoothServiceInfo::Sequence protocol;
+    protocol << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::L2cap));
+    protocolDescriptorList.append(QVariant::fromValue(protocol));
+    protocol.clear();
+    protocol << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::Rfcomm))
+             << QVariant::fromValue(quint8(3));
+    protocolDescriptorList.append(QVariant::fromValue(protocol));
+    attributes.insert(QBluetoothServiceInfo::ProtocolDescriptorList,
+                      QVariant::fromValue(protocolDescriptorList));
+
+    QBluetoothServiceInfo::Sequence browseGroups;
+    browseGroups << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::PublicBrowseGroup));
+    attributes.insert(QBluetoothServiceInfo::BrowseGroupList, QVariant::fromValue(browseGroups));
+
+    attributes.insert(QBluetoothServiceInfo::ServiceName, QStringLiteral("Serial Port"));
+
+    return attributes;
+}
+
+void tst_SdpDataElement::tst_encode_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<QByteArray>("element");
+
+    QTest::newRow("nil") << QVariant() << QByteArray("00");
+    QTest::newRow("uint8") << QVariant::fromValue(quint8(0xff)) << QByteArray("08ff");
+    QTest::newRow("uint16") << QVariant::fromValue(quint16(0x0102)) << QByteArray("090102");
+    QTest::newRow("uint32") << QVariant::fromValue(quint32(0x01020304))
+                            << QByteArray("0a01020304");
+    QTest::newRow("uint64") << QVariant::fromValue(quint64(Q_UINT64_C(0x0102030405060708)))
+                            << QByteArray("0b0102030405060708");
+    QTest::newRow("int8") << QVariant::fromValue(qint8(-1)) << QByteArray("10ff");
+    QTest::newRow("char") << QVariant::fromValue(char(-2)) << QByteArray("10fe");
+    QTest::newRow("int16") << QVariant::fromValue(qint16(-2)) << QByteArray("11fffe");
+    QTest::newRow("int32") << QVariant::fromValue(qint32(-3)) << QByteArray("12fffffffd");
+    QTest::newRow("int64") << QVariant::fromValue(qint64(-4)) << QByteArray("13fffffffffffffffc");
+    QTest::newRow("bool") << QVariant(true) << QByteArray("2801");
+    QTest::newRow("uuid16") << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::SerialPort))
+                            << QByteArray("191101");
+    QTest::newRow("uuid32") << QVariant::fromValue(QBluetoothUuid(quint32(0x12345678)))
+                            << QByteArray("1a12345678");
+    QTest::newRow("uuid128")
+            << QVariant::fromValue(QBluetoothUuid(
+                                       QStringLiteral("{6e400001-b5a3-f393-e0a9-e50e24dcca9e}")))
+            << QByteArray("1c6e400001b5a3f393e0a9e50e24dcca9e");
+    QTest::newRow("text") << QVariant(QString::fromUtf8("ab\xc3\xa4"))
+                          << QByteArray("25046162c3a4");
+    QTest::newRow("url") << QVariant(QUrl(QStringLiteral("http://qt.io")))
+                         << QByteArray("450c687474703a2f2f71742e696f");
+
+    QBluetoothServiceInfo::Alternative alternative;
+    alternative << QVariant::fromValue(quint8(1)) << QVariant(false);
+    QTest::newRow("alternative") << QVariant::fromValue(alternative)
+                                 << QByteArray("3d04" "0801" "2800");
+
+    QBluetoothServiceInfo::Sequence inner;
+    inner << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::Rfcomm))
+          << QVariant::fromValue(quint8(3));
+    QBluetoothServiceInfo::Sequence outer;
+    outer << QVariant::fromValue(inner) << QVariant::fromValue(QBluetoothServiceInfo::Sequence());
+    QTest::newRow("nested sequence") << QVariant::fromValue(outer)
+                                     << QByteArray("3509" "3505" "190003" "0803" "3500");
+}
+
+void tst_SdpDataElement::tst_encode()
+{
+    QFETCH(QVariant, value);
+    QFETCH(QByteArray, element);
+
+    QByteArray data("prefix");
+    QVERIFY(SdpDataElement::encode(value, &data));
+    QVERIFY(data.startsWith("prefix"));
+    QCOMPARE(data.mid(6).toHex(), QByteArray::fromHex(element).toHex());
+
+    const char *begin = data.constData() + 6;
+    bool ok = false;
+    const QVariant decoded = SdpDataElement::decode(begin, data.constData() + data.size(), &ok);
+    QVERIFY(ok);
+    QCOMPARE(begin, data.constData() + data.size());
+    QVERIFY(equal(value, decoded));
+}
+
+void tst_SdpDataElement::tst_encodeUnsupported()
+{
+    QBluetoothServiceInfo::Sequence sequence;
+    sequence << QVariant::fromValue(quint8(1)) << QVariant(QPoint(1, 2));
+
+    QByteArray data("prefix");
+    QTest::ignoreMessage(QtWarningMsg, "Cannot encode SDP attribute of type QPoint");
+    QVERIFY(!SdpDataElement::encode(QVariant::fromValue(sequence), &data));
+    QCOMPARE(data, QByteArray("prefix"));
+
+    AttributeMap attributes;
+    attributes.insert(0x0001, QVariant::fromValue(quint16(2)));
+    attributes.insert(0x0002, QVariant(QPoint(1, 2)));
+    data.clear();
+    QTest::ignoreMessage(QtWarningMsg, "Cannot encode SDP attribute of type QPoint");
+    QTest::ignoreMessage(QtWarningMsg, "Skipping SDP attribute 2");
+    SdpDataElement::encodeAttributeList(attributes, &data);
+    QCOMPARE(data.toHex(), QByteArray("3506" "090001" "090002"));
+}
+
+void tst_SdpDataElement::tst_encodeLargeSequence()
+{
+    // sizes above 255 and 65535 bytes need 16 and 32 bit size fields
+    QBluetoothServiceInfo::Sequence sequence;
+    for (int i = 0; i < 100; ++i)
+        sequence << QVariant::fromValue(quint16(i));
+
+    QByteArray data;
+    QVERIFY(SdpDataElement::encode(QVariant::fromValue(sequence), &data));
+    QCOMPARE(data.size(), 3 + 300);
+    QCOMPARE(data.left(3).toHex(), QByteArray("36012c"));
+
+    const QString text(70000, QLatin1Char('a'));
+    data.clear();
+    QVERIFY(SdpDataElement::encode(text, &data));
+    QCOMPARE(data.size(), 5 + 70000);
+    QCOMPARE(data.left(5).toHex(), QByteArray("2700011170"));
+
+    const char *begin = data.constData();
+    bool ok = false;
+    QCOMPARE(SdpDataElement::decode(begin, begin + data.size(), &ok).toString(), text);
+    QVERIFY(ok);
+}
+
+void tst_SdpDataElement::tst_serviceRecord()
+{
+    QByteArray data;
+    SdpDataElement::encodeAttributeList(serialPortRecord(), &data);
+    QCOMPARE(data.toHex(), QByteArray("3539"
+                                      "090000" "0a00010005"
+                                      "090001" "3503" "191101"
+                                      "090004" "350c" "3503190100" "35051900030803"
+                                      "090005" "3503" "191002"
+                                      "090100" "250b" "53657269616c20506f7274"));
+
+    AttributeMap decoded;
+    QVERIFY(roundTrip(serialPortRecord(), &decoded));
+}
+
+void tst_SdpDataElement::tst_xml()
+{
+    AttributeMap attributes = serialPortRecord();
+    attributes.insert(0x0200, QVariant::fromValue(qint16(-300)));
+    attributes.insert(0x0201, QVariant(QStringLiteral("<&\">")));
+    attributes.insert(0x0202, QVariant::fromValue(
+                          QBluetoothUuid(QStringLiteral("{6e400001-b5a3-f393-e0a9-e50e24dcca9e}"))));
+
+    QBluetoothServiceInfo::Alternative alternative;
+    alternative << QVariant(true) << QVariant();
+    attributes.insert(0x0203, QVariant::fromValue(alternative));
+
+    QByteArray data;
+    SdpDataElement::encodeAttributeList(attributes, &data);
+
+    QString xml;
+    QVERIFY(SdpDataElement::attributeListToXml(data, &xml));
+    QCOMPARE(xml, QStringLiteral(
+                 "<?xml version=\"1.0\" encoding=\"UTF-8\"?><record>"
+                 "<attribute id=\"0x0000\"><uint32 value=\"0x00010005\"/></attribute>"
+                 "<attribute id=\"0x0001\"><sequence><uuid value=\"0x1101\"/></sequence>"
+                 "</attribute>"
+                 "<attribute id=\"0x0004\"><sequence><sequence><uuid value=\"0x0100\"/>"
+                 "</sequence><sequence><uuid value=\"0x0003\"/><uint8 value=\"0x03\"/>"
+                 "</sequence></sequence></attribute>"
+                 "<attribute id=\"0x0005\"><sequence><uuid value=\"0x1002\"/></sequence>"
+                 "</attribute>"
+                 "<attribute id=\"0x0100\"><text value=\"Serial Port\"/></attribute>"
+                 "<attribute id=\"0x0200\"><int16 value=\"-300\"/></attribute>"
+                 "<attribute id=\"0x0201\"><text value=\"&lt;&amp;&quot;&gt;\"/></attribute>"
+                 "<attribute id=\"0x0202\">"
+                 "<uuid value=\"6e400001-b5a3-f393-e0a9-e50e24dcca9e\"/></attribute>"
+                 "<attribute id=\"0x0203\"><alternate><boolean value=\"true\"/><nil/>"
+                 "</alternate></attribute>"
+                 "</record>"));
+
+    QXmlStreamReader reader(xml);
+    while (!reader.atEnd())
+        reader.readNext();
+    QVERIFY2(!reader.hasError(), qPrintable(reader.errorString()));
+
+    QVERIFY(!SdpDataElement::attributeListToXml(data.left(data.size() - 1), &xml));
+}
+
+QVariant tst_SdpDataElement::randomValue(QRandomGenerator *generator, int depth)
+{
+    switch (generator->bounded(depth > 0 ? 16 : 14)) {
+    case 0: return QVariant();
+    case 1: return QVariant::fromValue(quint8(generator->generate()));
+    case 2: return QVariant::fromValue(quint16(generator->generate()));
+    case 3: return QVariant::fromValue(quint32(generator->generate()));
+    case 4: return QVariant::fromValue(quint64(generator->generate64()));
+    case 5: return QVariant::fromValue(qint8(generator->generate()));
+    case 6: return QVariant::fromValue(qint16(generator->generate()));
+    case 7: return QVariant::fromValue(qint32(generator->generate()));
+    case 8: return QVariant::fromValue(qint64(generator->generate64()));
+    case 9: return QVariant(bool(generator->bounded(2)));
+    case 10: return QVariant::fromValue(QBluetoothUuid(quint16(generator->generate())));
+    case 11: {
+        quint128 uuid;
+        for (int i = 0; i < 16; ++i)
+            uuid.data[i] = quint8(generator->generate());
+        return QVariant::fromValue(QBluetoothUuid(uuid));
+    }
+    case 12: {
+        QString text;
+        const int length = generator->bounded(300);
+        for (int i = 0; i < length; ++i)
+            text.append(QChar(ushort(generator->bounded(0x20, 0xd800))));
+        return text;
+    }
+    case 13:
+        return QUrl(QStringLiteral("http://example.com/%1").arg(generator->generate()));
+    default: {
+        QList<QVariant> values;
+        const int count = generator->bounded(8);
+        for (int i = 0; i < count; ++i)
+            values.append(randomValue(generator, depth - 1));
+
+        if (generator->bounded(4) == 0) {
+            QBluetoothServiceInfo::Alternative alternative;
+            alternative.append(values);
+            return QVariant::fromValue(alternative);
+        }
+
+        QBluetoothServiceInfo::Sequence sequence;
+        sequence.append(values);
+        return QVariant::fromValue(sequence);
+    }
+    }
+}
+
+// Compares an encoded value with its decoded form. URLs are decoded as text.
+bool tst_SdpDataElement::equal(const QVariant &encoded, const QVariant &decoded)
+{
+    if (encoded.userType() == QMetaType::QUrl)
+        return decoded.toString() == encoded.toUrl().toString();
+    if (encoded.userType() == QMetaType::Char)
+        return decoded.userType() == QMetaType::SChar && decoded.toInt() == encoded.toInt();
+
+    if (encoded.userType() != decoded.userType())
+        return false;
+
+    QList<QVariant> encodedValues;
+    QList<QVariant> decodedValues;
+    if (encoded.userType() == qMetaTypeId<QBluetoothServiceInfo::Sequence>()) {
+        encodedValues = encoded.value<QBluetoothServiceInfo::Sequence>();
+        decodedValues = decoded.value<QBluetoothServiceInfo::Sequence>();
+    } else if (encoded.userType() == qMetaTypeId<QBluetoothServiceInfo::Alternative>()) {
+        encodedValues = encoded.value<QBluetoothServiceInfo::Alternative>();
+        decodedValues = decoded.value<QBluetoothServiceInfo::Alternative>();
+    } else if (encoded.userType() == qMetaTypeId<QBluetoothUuid>()) {
+        return encoded.value<QBluetoothUuid>() == decoded.value<QBluetoothUuid>();
+    } else {
+        return encoded == decoded;
+    }
+
+    if (encodedValues.count() != decodedValues.count())
+        return false;
+
+    for (int i = 0; i < encodedValues.count(); ++i) {
+        if (!equal(encodedValues.at(i), decodedValues.at(i)))
+            return false;
+    }
+
+    return true;
+}
+
+bool tst_SdpDataElement::roundTrip(const AttributeMap &attributes, AttributeMap *decoded)
+{
+    QByteArray data;
+    SdpDataElement::encodeAttributeList(attributes, &data);
+
+    const char *begin = data.constData();
+    const char *end = begin + data.size();
+    if (!SdpDataElement::decodeAttributeList(begin, end, decoded) || begin != end)
+        return false;
+
+    if (decoded->keys() != attributes.keys())
+        return false;
+
+    for (AttributeMap::const_iterator it = attributes.constBegin(); it != attributes.constEnd();
+         ++it) {
+        if (!equal(it.value(), decoded->value(it.key())))
+            return false;
+    }
+
+    QString xml;
+    return SdpDataElement::attributeListToXml(data, &xml);
+}
+
+void tst_SdpDataElement::tst_fuzzRoundTrip()
+{
+    QRandomGenerator generator(0x5d9);
+
+    for (int i = 0; i < 500; ++i) {
+        AttributeMap attributes;
+        const int count = generator.bounded(12);
+        for (int j = 0; j < count; ++j)
+            attributes.insert(quint16(generator.generate()), randomValue(&generator, 3));
+
+        AttributeMap decoded;
+        QVERIFY2(roundTrip(attributes, &decoded), QByteArray::number(i).constData());
+    }
+}
+
+void tst_SdpDataElement::tst_fuzzDecode()
+{
+    QRandomGenerator generator(0x5d9);
+
+    QByteArray valid;
+    SdpDataElement::encodeAttributeList(serialPortRecord(), &valid);
+
+    // mutated and truncated records must be rejected or decoded without reading out of bounds
+    for (int i = 0; i < 5000; ++i) {
+        QByteArray data = valid.left(generator.bounded(valid.size() + 1));
+        const int mutations = generator.bounded(4);
+        for (int j = 0; j < mutations && !data.isEmpty(); ++j)
+            data[generator.bounded(data.size())] = char(generator.generate());
+
+        const char *begin = data.constData();
+        AttributeMap attributes;
+        SdpDataElement::decodeAttributeList(begin, data.constData() + data.size(), &attributes);
+        QVERIFY(begin <= data.constData() + data.size());
+
+        QString xml;
+        SdpDataElement::attributeListToXml(data, &xml);
+    }
+}
+
+static QByteArray nestedSequences(int depth)
+{
+    QByteArray data("\x08\x01", 2);
+    for (int i = 0; i < depth; ++i) {
+        const quint16 size = data.size();
+        data.prepend(char(size & 0xff));
+        data.prepend(char(size >> 8));
+        data.prepend('\x36');
+    }
+    return data;
+}
+
+void tst_SdpDataElement::tst_nestingLimit()
+{
+    bool ok = false;
+    QByteArray data = nestedSequences(SdpDataElement::MaximumNestingDepth);
+    const char *begin = data.constData();
+    SdpDataElement::decode(begin, data.constData() + data.size(), &ok);
+    QVERIFY(ok);
+
+    // must fail instead of exhausting the stack
+    data = nestedSequences(10000);
+    begin = data.constData();
+    SdpDataElement::decode(begin, data.constData() + data.size(), &ok);
+    QVERIFY(!ok);
+
+    data = nestedSequences(SdpDataElement::MaximumNestingDepth + 1);
+    begin = data.constData();
+    SdpDataElement::decode(begin, data.constData() + data.size(), &ok);
+    QVERIFY(!ok);
+
+    // attribute list with attribute 0x0100 holding the nested value
+    const QByteArray value = nestedSequences(10000);
+    QByteArray list("\x09\x01\x00", 3);
+    list.append(value);
+    const quint32 size = list.size();
+    list.prepend(char(size & 0xff));
+    list.prepend(char((size >> 8) & 0xff));
+    list.prepend(char((size >> 16) & 0xff));
+    list.prepend(char(size >> 24));
+    list.prepend('\x37');
+
+    QString xml;
+    QVERIFY(!SdpDataElement::attributeListToXml(list, &xml));
+}
+
+QTEST_MAIN(tst_SdpDataElement)
+
+#include "tst_sdpdataelement.moc"
@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_servicediscoveryscheduler.cpp
+TARGET = tst_servicediscoveryscheduler
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
@@ -0,0 +1,263 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/qbluetoothdeviceinfo.h>
+#include <QtBluetooth/private/servicediscoveryscheduler_p.h>
+
+QT_USE_NAMESPACE
+
+// Stands in for the service discovery of BlueZ: every device answers after a
+// fixed delay, synchronously if the delay is 0, or once the test calls
+// complete() if the delay is negative.
+class MockServiceDiscovery : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MockServiceDiscovery(ServiceDiscoveryScheduler *scheduler)
+        : scheduler(scheduler)
+    {
+        connect(scheduler, SIGNAL(discoveryStarted(QBluetoothDeviceInfo)),
+                this, SLOT(discoveryStarted(QBluetoothDeviceInfo)));
+        connect(scheduler, SIGNAL(finished()), this, SLOT(finished()));
+    }
+
+    void addDevice(quint64 address, int delay, bool cached)
+    {
+        const QBluetoothDeviceInfo device(QBluetoothAddress(address), QString(), 0);
+        delays.insert(device.address(), delay);
+        scheduler->enqueue(device, cached);
+    }
+
+    QMap<QBluetoothAddress, int> delays;
+    QList<QBluetoothAddress> started;
+    QList<QBluetoothAddress> completed;
+    int running = 0;
+    int maxRunning = 0;
+    int finishedCount = 0;
+
+private slots:
+    void discoveryStarted(const QBluetoothDeviceInfo &device)
+    {
+        const QBluetoothAddress address = device.address();
+        started.append(address);
+        maxRunning = qMax(maxRunning, ++running);
+
+        const int delay = delays.value(address);
+        if (delay < 0)
+            return;
+        if (delay == 0) {
+            complete(address);
+            return;
+        }
+
+        QTimer::singleShot(delay, this, [this, address]() { complete(address); });
+    }
+
+    void finished()
+    {
+        ++finishedCount;
+    }
+
+public:
+    void complete(const QBluetoothAddress &address)
+    {
+        if (!scheduler->isRunning(address))
+            return;
+
+        --running;
+        completed.append(address);
+        scheduler->deviceFinished(address);
+    }
+
+private:
+    ServiceDiscoveryScheduler *scheduler;
+};
+
+class tst_ServiceDiscoveryScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_ServiceDiscoveryScheduler();
+
+private slots:
+    void tst_emptyQueue();
+    void tst_parallelDiscovery();
+    void tst_limit();
+    void tst_cachedDevicesFirst();
+    void tst_synchronousCompletion();
+    void tst_clear();
+};
+
+tst_ServiceDiscoveryScheduler::tst_ServiceDiscoveryScheduler()
+{
+    qRegisterMetaType<QBluetoothDeviceInfo>();
+}
+
+void tst_ServiceDiscoveryScheduler::tst_emptyQueue()
+{
+    ServiceDiscoveryScheduler scheduler;
+    QSignalSpy finishedSpy(&scheduler, SIGNAL(finished()));
+
+    scheduler.start();
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(!scheduler.isActive());
+}
+
+void tst_ServiceDiscoveryScheduler::tst_parallelDiscovery()
+{
+    // 30 devices which only answer when told to. All of them are scanned at
+    // the same time, so slow devices do not add up.
+    ServiceDiscoveryScheduler scheduler;
+    scheduler.setMaximumParallelDiscoveries(30);
+    MockServiceDiscovery bluez(&scheduler);
+
+    for (int i = 0; i < 30; ++i)
+        bluez.addDevice(0x0a0000000000ull + i, -1, false);
+
+    scheduler.start();
+    QCOMPARE(bluez.started.count(), 30);
+    QCOMPARE(bluez.running, 30);
+    QVERIFY(bluez.completed.isEmpty());
+
+    // results of fast devices are not held back by the slow one
+    const QBluetoothAddress slowDevice(0x0a0000000007ull);
+    for (int i = 0; i < 30; ++i) {
+        if (i != 7)
+            bluez.complete(QBluetoothAddress(0x0a0000000000ull + i));
+    }
+    QCOMPARE(bluez.completed.count(), 29);
+    QCOMPARE(bluez.finishedCount, 0);
+    QVERIFY(scheduler.isRunning(slowDevice));
+
+    bluez.complete(slowDevice);
+    QCOMPARE(bluez.finishedCount, 1);
+    QCOMPARE(bluez.completed.last(), slowDevice);
+    QCOMPARE(bluez.maxRunning, 30);
+    QVERIFY(!scheduler.isActive());
+}
+
+void tst_ServiceDiscoveryScheduler::tst_limit()
+{
+    ServiceDiscoveryScheduler scheduler;
+    scheduler.setMaximumParallelDiscoveries(3);
+    MockServiceDiscovery bluez(&scheduler);
+
+    for (int i = 0; i < 10; ++i)
+        bluez.addDevice(0x0b0000000000ull + i, 20 + 10 * (i % 3), false);
+
+    scheduler.start();
+    QTRY_COMPARE(bluez.finishedCount, 1);
+
+    QCOMPARE(bluez.completed.count(), 10);
+    QCOMPARE(bluez.maxRunning, 3);
+    QCOMPARE(bluez.running, 0);
+
+    scheduler.setMaximumParallelDiscoveries(0);
+    QCOMPARE(scheduler.maximumParallelDiscoveries(), 1);
+}
+
+void tst_ServiceDiscoveryScheduler::tst_cachedDevicesFirst()
+{
+    ServiceDiscoveryScheduler scheduler;
+    scheduler.setMaximumParallelDiscoveries(1);
+    MockServiceDiscovery bluez(&scheduler);
+
+    bluez.addDevice(0x01, 10, false);
+    bluez.addDevice(0x02, 10, true);
+    bluez.addDevice(0x03, 10, false);
+    bluez.addDevice(0x04, 10, true);
+
+    scheduler.start();
+    QTRY_COMPARE(bluez.finishedCount, 1);
+
+    const QList<QBluetoothAddress> expected = QList<QBluetoothAddress>()
+            << QBluetoothAddress(0x02) << QBluetoothAddress(0x04)
+            << QBluetoothAddress(0x01) << QBluetoothAddress(0x03);
+    QCOMPARE(bluez.started, expected);
+}
+
+void tst_ServiceDiscoveryScheduler::tst_synchronousCompletion()
+{
+    // devices answered from the cache complete within discoveryStarted()
+    ServiceDiscoveryScheduler scheduler;
+    scheduler.setMaximumParallelDiscoveries(2);
+    MockServiceDiscovery bluez(&scheduler);
+
+    for (int i = 0; i < 5; ++i)
+        bluez.addDevice(0x0c0000000000ull + i, 0, true);
+    bluez.addDevice(0x0c0000000010ull, 20, false);
+
+    scheduler.start();
+    QCOMPARE(bluez.completed.count(), 5);
+    QCOMPARE(bluez.finishedCount, 0);
+    QVERIFY(scheduler.isActive());
+
+    QTRY_COMPARE(bluez.finishedCount, 1);
+    QCOMPARE(bluez.completed.count(), 6);
+    QVERIFY(!scheduler.isActive());
+
+    // all devices synchronous
+    bluez.completed.clear();
+    bluez.addDevice(0x0d0000000000ull, 0, false);
+    bluez.addDevice(0x0d0000000001ull, 0, false);
+    scheduler.start();
+    QCOMPARE(bluez.completed.count(), 2);
+    QCOMPARE(bluez.finishedCount, 2);
+}
+
+void tst_ServiceDiscoveryScheduler::tst_clear()
+{
+    ServiceDiscoveryScheduler scheduler;
+    scheduler.setMaximumParallelDiscoveries(2);
+    MockServiceDiscovery bluez(&scheduler);
+
+    for (int i = 0; i < 4; ++i)
+        bluez.addDevice(0x0e0000000000ull + i, 50, false);
+
+    scheduler.start();
+    QCOMPARE(bluez.started.count(), 2);
+    QVERIFY(scheduler.isRunning(QBluetoothAddress(0x0e0000000000ull)));
+    QCOMPARE(scheduler.runningDevice(QBluetoothAddress(0x0e0000000001ull)).address(),
+             QBluetoothAddress(0x0e0000000001ull));
+
+    scheduler.clear();
+    QVERIFY(!scheduler.isActive());
+    QVERIFY(!scheduler.isRunning(QBluetoothAddress(0x0e0000000000ull)));
+
+    QTest::qWait(100);
+    QCOMPARE(bluez.started.count(), 2);
+    QVERIFY(bluez.completed.isEmpty());
+    QCOMPARE(bluez.finishedCount, 0);
+}
+
+QTEST_MAIN(tst_ServiceDiscoveryScheduler)
+
+#include "tst_servicediscoveryscheduler.moc"
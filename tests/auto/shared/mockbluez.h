@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef MOCKBLUEZ_H
+#define MOCKBLUEZ_H
+
+#include <QtCore/QProcess>
+#include <QtDBus/QtDBus>
+
+#include <QtBluetooth/private/bluez5_helper_p.h>
+
+QT_USE_NAMESPACE
+
+// Minimal BlueZ exporting the object manager interface on a private bus.
+// It is served as org.bluez on the connection named "bluez", which the tests
+// use to export further objects and to send signals.
+class MockBluez : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.DBus.ObjectManager")
+
+public:
+    ~MockBluez()
+    {
+        stop();
+    }
+
+    // Starts a private bus with the dbus-daemon at dbusDaemon and registers
+    // the mock on it. Returns the address of the bus, or an empty string if
+    // anything fails.
+    QString start(const QString &dbusDaemon)
+    {
+        daemon.start(dbusDaemon, QStringList() << QStringLiteral("--session")
+                                               << QStringLiteral("--nofork")
+                                               << QStringLiteral("--print-address"));
+        if (!daemon.waitForStarted() || !daemon.waitForReadyRead())
+            return QString();
+        const QString busAddress = QString::fromLatin1(daemon.readLine().trimmed());
+        if (busAddress.isEmpty())
+            return QString();
+
+        qDBusRegisterMetaType<InterfaceList>();
+        qDBusRegisterMetaType<ManagedObjectList>();
+
+        QDBusConnection connection = QDBusConnection::connectToBus(busAddress,
+                                                                   QStringLiteral("bluez"));
+        if (!connection.isConnected()
+                || !connection.registerObject(QStringLiteral("/"), this,
+                                              QDBusConnection::ExportAllSlots)
+                || !connection.registerService(QStringLiteral("org.bluez"))) {
+            return QString();
+        }
+        return busAddress;
+    }
+
+    void stop()
+    {
+        QDBusConnection::disconnectFromBus(QStringLiteral("bluez"));
+
+        if (daemon.state() != QProcess::NotRunning) {
+            daemon.terminate();
+            daemon.waitForFinished();
+        }
+    }
+
+    ManagedObjectList objects;
+    int getManagedObjectsCount = 0;
+
+public slots:
+    ManagedObjectList GetManagedObjects()
+    {
+        ++getManagedObjectsCount;
+        return objects;
+    }
+
+private:
+    QProcess daemon;
+};
+
+#endif // MOCKBLUEZ_H
@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_signcounterstore.cpp
+TARGET = tst_signcounterstore
+CONFIG += testcase
+
+QT = core bluetooth-private testlib
@@ -0,0 +1,240 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtCore/QSettings>
+#include <QtCore/QTemporaryDir>
+#include <QtBluetooth/private/signcounterstore_p.h>
+
+QT_USE_NAMESPACE
+
+static const char localKey[] = "00112233445566778899AABBCCDDEEFF";
+static const char remoteKey[] = "FFEEDDCCBBAA99887766554433221100";
+
+class tst_SignCounterStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void readKey();
+    void readKeyMissing();
+    void localCounterReservation();
+    void remoteCounterReservation();
+    void releaseOnDestruction();
+    void missingCounterEntry();
+    void resetCounter();
+
+private:
+    void writeGroup(const QString &group, const QByteArray &key, int counter = -1);
+    uint fileCounter(const QString &group) const;
+
+    QScopedPointer<QTemporaryDir> dir;
+    QString filePath;
+};
+
+void tst_SignCounterStore::init()
+{
+    dir.reset(new QTemporaryDir);
+    QVERIFY(dir->isValid());
+    filePath = dir->filePath(QStringLiteral("info"));
+
+    writeGroup(QStringLiteral("LocalSignatureKey"), localKey, 5);
+    writeGroup(QStringLiteral("RemoteSignatureKey"), remoteKey, 10);
+}
+
+void tst_SignCounterStore::writeGroup(const QString &group, const QByteArray &key, int counter)
+{
+    QSettings settings(filePath, QSettings::IniFormat);
+    settings.beginGroup(group);
+    settings.setValue(QStringLiteral("Key"), key);
+    if (counter >= 0)
+        settings.setValue(QStringLiteral("Counter"), counter);
+    else
+        settings.remove(QStringLiteral("Counter"));
+}
+
+uint tst_SignCounterStore::fileCounter(const QString &group) const
+{
+    QSettings settings(filePath, QSettings::IniFormat);
+    settings.beginGroup(group);
+    return settings.value(QStringLiteral("Counter"), 0).toUInt();
+}
+
+void tst_SignCounterStore::readKey()
+{
+    SignCounterStore store(filePath);
+    QCOMPARE(store.settingsFilePath(), filePath);
+
+    quint128 key;
+    quint32 counter = 0;
+    QVERIFY(store.readKey(SignCounterStore::LocalSigningKey, &key, &counter));
+    QCOMPARE(QByteArray(reinterpret_cast<const char *>(key.data), sizeof key),
+             QByteArray::fromHex(localKey));
+    QCOMPARE(counter, 5u);
+
+    QVERIFY(store.readKey(SignCounterStore::RemoteSigningKey, &key, &counter));
+    QCOMPARE(QByteArray(reinterpret_cast<const char *>(key.data), sizeof key),
+             QByteArray::fromHex(remoteKey));
+    QCOMPARE(counter, 10u);
+}
+
+void tst_SignCounterStore::readKeyMissing()
+{
+    quint128 key;
+    quint32 counter = 0;
+
+    SignCounterStore noFile(dir->filePath(QStringLiteral("missing")));
+    QVERIFY(!noFile.readKey(SignCounterStore::LocalSigningKey, &key, &counter));
+
+    writeGroup(QStringLiteral("LocalSignatureKey"), "0011", 5);
+    SignCounterStore shortKey(filePath);
+    QVERIFY(!shortKey.readKey(SignCounterStore::LocalSigningKey, &key, &counter));
+
+    QSettings(filePath, QSettings::IniFormat).remove(QStringLiteral("RemoteSignatureKey"));
+    SignCounterStore noGroup(filePath);
+    QVERIFY(!noGroup.readKey(SignCounterStore::RemoteSigningKey, &key, &counter));
+}
+
+void tst_SignCounterStore::localCounterReservation()
+{
+    const QString group = QStringLiteral("LocalSignatureKey");
+    SignCounterStore store(filePath);
+    store.setReservedCounterCount(16);
+
+    quint128 key;
+    quint32 counter = 0;
+    QVERIFY(store.readKey(SignCounterStore::LocalSigningKey, &key, &counter));
+
+    // the file is only written when the reservation is used up, and before
+    // the counter is used, so a crash can never lead to a counter being reused
+    int writes = 0;
+    uint lastFileCounter = fileCounter(group);
+    for (quint32 used = counter; used < counter + 100; ++used) {
+        store.setCounter(SignCounterStore::LocalSigningKey, used);
+        const uint current = fileCounter(group);
+        QVERIFY2(current > used, qPrintable(QString::number(used)));
+        if (current != lastFileCounter) {
+            QCOMPARE(current, used + 1 + 16);
+            lastFileCounter = current;
+            ++writes;
+        }
+    }
+    QCOMPARE(writes, 6);
+
+    // releases the reservation
+    store.flush();
+    QCOMPARE(fileCounter(group), counter + 100);
+}
+
+void tst_SignCounterStore::remoteCounterReservation()
+{
+    const QString group = QStringLiteral("RemoteSignatureKey");
+    SignCounterStore store(filePath);
+    store.setReservedCounterCount(16);
+
+    quint128 key;
+    quint32 counter = 0;
+    QVERIFY(store.readKey(SignCounterStore::RemoteSigningKey, &key, &counter));
+
+    // the file always holds a high-water mark above the counter of every
+    // accepted write, so a write replayed after a crash is still rejected
+    int writes = 0;
+    uint lastFileCounter = fileCounter(group);
+    for (quint32 used = counter; used < counter + 50; ++used) {
+        store.setCounter(SignCounterStore::RemoteSigningKey, used);
+        const uint current = fileCounter(group);
+        QVERIFY2(current > used, qPrintable(QString::number(used)));
+        if (current != lastFileCounter) {
+            QCOMPARE(current, used + 1 + 16);
+            lastFileCounter = current;
+            ++writes;
+        }
+    }
+    QCOMPARE(writes, 3);
+
+    // the peer may skip counters, even beyond the mark
+    store.setCounter(SignCounterStore::RemoteSigningKey, counter + 60);
+    QCOMPARE(fileCounter(group), counter + 61 + 16);
+
+    // releases the reservation
+    store.flush();
+    QCOMPARE(fileCounter(group), counter + 61);
+}
+
+void tst_SignCounterStore::releaseOnDestruction()
+{
+    const QString localGroup = QStringLiteral("LocalSignatureKey");
+    const QString remoteGroup = QStringLiteral("RemoteSignatureKey");
+    {
+        SignCounterStore store(filePath);
+        store.setReservedCounterCount(16);
+        store.setCounter(SignCounterStore::LocalSigningKey, 41);
+        store.setCounter(SignCounterStore::RemoteSigningKey, 20);
+        QCOMPARE(fileCounter(localGroup), 58u);
+        QCOMPARE(fileCounter(remoteGroup), 37u);
+    }
+    QCOMPARE(fileCounter(localGroup), 42u);
+    QCOMPARE(fileCounter(remoteGroup), 21u);
+}
+
+void tst_SignCounterStore::missingCounterEntry()
+{
+    // BlueZ owns the file, entries which do not exist are not created
+    writeGroup(QStringLiteral("LocalSignatureKey"), localKey);
+
+    SignCounterStore store(filePath);
+    store.setCounter(SignCounterStore::LocalSigningKey, 7);
+    store.flush();
+
+    QSettings settings(filePath, QSettings::IniFormat);
+    settings.beginGroup(QStringLiteral("LocalSignatureKey"));
+    QVERIFY(!settings.contains(QStringLiteral("Counter")));
+}
+
+void tst_SignCounterStore::resetCounter()
+{
+    const QString group = QStringLiteral("LocalSignatureKey");
+    SignCounterStore store(filePath);
+    store.setReservedCounterCount(16);
+
+    store.setCounter(SignCounterStore::LocalSigningKey, 100);
+    QCOMPARE(fileCounter(group), 117u);
+
+    // a new key was distributed and BlueZ starts counting from zero
+    writeGroup(group, remoteKey, 0);
+    store.resetCounter(SignCounterStore::LocalSigningKey);
+    store.setCounter(SignCounterStore::LocalSigningKey, 0);
+    QCOMPARE(fileCounter(group), 17u);
+}
+
+QTEST_MAIN(tst_SignCounterStore)
+
+#include "tst_signcounterstore.moc"
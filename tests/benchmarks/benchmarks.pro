@@ -0,0 +1,10 @@
+TEMPLATE = subdirs
+
+qtHaveModule(bluetooth) {
+    qtConfig(bluez): SUBDIRS += sdpdataelement
+}
+
+qtHaveModule(nfc) {
+    SUBDIRS += \
+        qnearfieldtagaccess
+}
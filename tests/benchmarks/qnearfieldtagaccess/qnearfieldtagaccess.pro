@@ -0,0 +1,24 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_bench_qnearfieldtagaccess.cpp
+TARGET = tst_bench_qnearfieldtagaccess
+CONFIG += benchmark
+
+QT = core nfc-private testlib
+
+INCLUDEPATH += ../../../src/nfc
+VPATH += ../../../src/nfc
+
+HEADERS += \
+    qnearfieldmanagervirtualbase_p.h \
+    qnearfieldtarget_emulator_p.h \
+    qnearfieldmanager_emulator_p.h \
+    targetemulator_p.h
+
+SOURCES += \
+    qnearfieldmanagervirtualbase.cpp \
+    qnearfieldtarget_emulator.cpp \
+    qnearfieldmanager_emulator.cpp \
+    targetemulator.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD\\\"
@@ -0,0 +1,214 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtNfc module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <private/qnearfieldmanager_emulator_p.h>
+#include <private/qnearfieldtarget_emulator_p.h>
+#include <qnearfieldmanager.h>
+#include <qndefmessage.h>
+#include <qndefnfctextrecord.h>
+
+QT_USE_NAMESPACE
+
+Q_DECLARE_METATYPE(QNearFieldTarget*)
+
+// The emulated tags in this directory model a 106 kbit/s link, see the Emulation group of the
+// .nfc files. All of them are kept in proximity at the same time.
+
+class tst_QNearFieldTagAccess : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QNearFieldTagAccess();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void readNdefMessages_data();
+    void readNdefMessages();
+
+    void writeNdefMessages_data();
+    void writeNdefMessages();
+
+private:
+    void addTagRows();
+    bool waitForNdefRequest(const QNearFieldTarget::RequestId &id, QSignalSpy &completedSpy,
+                            QSignalSpy &errorSpy);
+
+    QNearFieldManagerPrivateImpl *emulatorBackend;
+    QNearFieldManager *manager;
+    QMap<QByteArray, QNearFieldTarget *> targets;
+};
+
+tst_QNearFieldTagAccess::tst_QNearFieldTagAccess()
+:   emulatorBackend(0), manager(0)
+{
+    QDir::setCurrent(QLatin1String(SRCDIR));
+
+    qRegisterMetaType<QNdefMessage>();
+    qRegisterMetaType<QNearFieldTarget *>();
+}
+
+void tst_QNearFieldTagAccess::initTestCase()
+{
+    TagActivator::instance()->setMaximumActiveTargets(8);
+
+    emulatorBackend = new QNearFieldManagerPrivateImpl;
+    manager = new QNearFieldManager(emulatorBackend, 0);
+
+    QSignalSpy targetDetectedSpy(manager, SIGNAL(targetDetected(QNearFieldTarget*)));
+
+    manager->startTargetDetection();
+
+    // one tag is activated per second
+    QTRY_COMPARE_WITH_TIMEOUT(targetDetectedSpy.count(), 5, 10000);
+
+    manager->stopTargetDetection();
+
+    for (int i = 0; i < targetDetectedSpy.count(); ++i) {
+        QNearFieldTarget *target = targetDetectedSpy.at(i).at(0).value<QNearFieldTarget *>();
+        targets.insert(target->uid().toHex(), target);
+    }
+}
+
+void tst_QNearFieldTagAccess::cleanupTestCase()
+{
+    emulatorBackend->reset();
+    TagActivator::instance()->setMaximumActiveTargets(1);
+
+    delete manager;
+    manager = 0;
+    emulatorBackend = 0;
+}
+
+void tst_QNearFieldTagAccess::addTagRows()
+{
+    QTest::addColumn<QByteArray>("uid");
+
+    QTest::newRow("Type 1 static") << QByteArray("77665544332211");
+    QTest::newRow("Type 1 dynamic") << QByteArray("11223344556677");
+    QTest::newRow("Type 2 static") << QByteArray("11111111111111");
+    QTest::newRow("Type 2 dynamic") << QByteArray("33333333333333");
+    QTest::newRow("Type 4") << QByteArray("04112233445566");
+}
+
+bool tst_QNearFieldTagAccess::waitForNdefRequest(const QNearFieldTarget::RequestId &id,
+                                                 QSignalSpy &completedSpy, QSignalSpy &errorSpy)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // QTRY_VERIFY polls in 50 ms steps, which would dominate the measured time
+    do {
+        for (int i = 0; i < errorSpy.count(); ++i) {
+            if (errorSpy.at(i).at(1).value<QNearFieldTarget::RequestId>() == id)
+                return false;
+        }
+
+        for (int i = 0; i < completedSpy.count(); ++i) {
+            if (completedSpy.at(i).at(0).value<QNearFieldTarget::RequestId>() == id)
+                return true;
+        }
+
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+    } while (timer.elapsed() < 30000);
+
+    return false;
+}
+
+void tst_QNearFieldTagAccess::readNdefMessages_data()
+{
+    addTagRows();
+}
+
+void tst_QNearFieldTagAccess::readNdefMessages()
+{
+    QFETCH(QByteArray, uid);
+
+    QNearFieldTarget *target = targets.value(uid);
+    QVERIFY(target);
+
+    QSignalSpy completedSpy(target, SIGNAL(requestCompleted(QNearFieldTarget::RequestId)));
+    QSignalSpy errorSpy(target,
+                        SIGNAL(error(QNearFieldTarget::Error,QNearFieldTarget::RequestId)));
+
+    QBENCHMARK {
+        completedSpy.clear();
+        errorSpy.clear();
+
+        QNearFieldTarget::RequestId id = target->readNdefMessages();
+        QVERIFY(waitForNdefRequest(id, completedSpy, errorSpy));
+    }
+}
+
+void tst_QNearFieldTagAccess::writeNdefMessages_data()
+{
+    addTagRows();
+}
+
+void tst_QNearFieldTagAccess::writeNdefMessages()
+{
+    QFETCH(QByteArray, uid);
+
+    QNearFieldTarget *target = targets.value(uid);
+    QVERIFY(target);
+
+    QNdefNfcTextRecord textRecord;
+    textRecord.setText(QStringLiteral("tst_QNearFieldTagAccess"));
+
+    QNdefMessage message;
+    message.append(textRecord);
+
+    QList<QNdefMessage> messages;
+    messages.append(message);
+
+    QSignalSpy completedSpy(target, SIGNAL(requestCompleted(QNearFieldTarget::RequestId)));
+    QSignalSpy errorSpy(target,
+                        SIGNAL(error(QNearFieldTarget::Error,QNearFieldTarget::RequestId)));
+
+    QBENCHMARK {
+        completedSpy.clear();
+        errorSpy.clear();
+
+        QNearFieldTarget::RequestId id = target->writeNdefMessages(messages);
+        QVERIFY(waitForNdefRequest(id, completedSpy, errorSpy));
+    }
+}
+
+QTEST_MAIN(tst_QNearFieldTagAccess)
+
+// Unset the moc namespace which is not required for the following include.
+#undef QT_BEGIN_MOC_NAMESPACE
+#define QT_BEGIN_MOC_NAMESPACE
+#undef QT_END_MOC_NAMESPACE
+#define QT_END_MOC_NAMESPACE
+
+#include "tst_bench_qnearfieldtagaccess.moc"
@@ -0,0 +1,7 @@
+requires(contains(QT_CONFIG, private_tests))
+
+SOURCES += tst_bench_sdpdataelement.cpp
+TARGET = tst_bench_sdpdataelement
+CONFIG += benchmark
+
+QT = core bluetooth-private testlib
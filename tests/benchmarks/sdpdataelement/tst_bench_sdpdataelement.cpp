@@ -0,0 +1,129 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtBluetooth module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/qbluetoothserviceinfo.h>
+#include <QtBluetooth/private/sdpdataelement_p.h>
+
+QT_USE_NAMESPACE
+
+typedef QMap<quint16, QVariant> AttributeMap;
+
+// Attributes of an RFCOMM service as registered by QBluetoothServer::listen()
+static AttributeMap rfcommServiceRecord()
+{
+    AttributeMap attributes;
+
+    QBluetoothServiceInfo::Sequence classIds;
+    classIds << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::SerialPort))
+             << QVariant::fromValue(QBluetoothUuid(
+                                        QStringLiteral("e8e10f95-1a70-4b27-9ccf-02010264e9c8")));
+    attributes.insert(QBluetoothServiceInfo::ServiceClassIds, QVariant::fromValue(classIds));
+
+    QBluetoothServiceInfo::Sequence profileDescriptor;
+    profileDescriptor << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::SerialPort))
+                      << QVariant::fromValue(quint16(0x100));
+    QBluetoothServiceInfo::Sequence profileDescriptorList;
+    profileDescriptorList << QVariant::fromValue(profileDescriptor);
+    attributes.insert(QBluetoothServiceInfo::BluetoothProfileDescriptorList,
+                      QVariant::fromValue(profileDescriptorList));
+
+    attributes.insert(QBluetoothServiceInfo::ServiceName, QStringLiteral("Bt Chat Server"));
+    attributes.insert(QBluetoothServiceInfo::ServiceDescription,
+                      QStringLiteral("Example bluetooth chat server"));
+    attributes.insert(QBluetoothServiceInfo::ServiceProvider, QStringLiteral("qt-project.org"));
+    attributes.insert(QBluetoothServiceInfo::ServiceId, QVariant::fromValue(
+                          QBluetoothUuid(QStringLiteral("e8e10f95-1a70-4b27-9ccf-02010264e9c8"))));
+
+    QBluetoothServiceInfo::Sequence browseGroups;
+    browseGroups << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::PublicBrowseGroup));
+    attributes.insert(QBluetoothServiceInfo::BrowseGroupList, QVariant::fromValue(browseGroups));
+
+    QBluetoothServiceInfo::Sequence protocolDescriptorList;
+    QBluetoothServiceInfo::Sequence protocol;
+    protocol << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::L2cap));
+    protocolDescriptorList.append(QVariant::fromValue(protocol));
+    protocol.clear();
+    protocol << QVariant::fromValue(QBluetoothUuid(QBluetoothUuid::Rfcomm))
+             << QVariant::fromValue(quint8(7));
+    protocolDescriptorList.append(QVariant::fromValue(protocol));
+    attributes.insert(QBluetoothServiceInfo::ProtocolDescriptorList,
+                      QVariant::fromValue(protocolDescriptorList));
+
+    return attributes;
+}
+
+class tst_SdpDataElement : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void encode();
+    void encodeToXml();
+    void decode();
+};
+
+void tst_SdpDataElement::encode()
+{
+    const AttributeMap attributes = rfcommServiceRecord();
+
+    QBENCHMARK {
+        QByteArray data;
+        SdpDataElement::encodeAttributeList(attributes, &data);
+    }
+}
+
+void tst_SdpDataElement::encodeToXml()
+{
+    const AttributeMap attributes = rfcommServiceRecord();
+
+    QBENCHMARK {
+        QByteArray data;
+        SdpDataElement::encodeAttributeList(attributes, &data);
+
+        QString xml;
+        SdpDataElement::attributeListToXml(data, &xml);
+    }
+}
+
+void tst_SdpDataElement::decode()
+{
+    QByteArray data;
+    SdpDataElement::encodeAttributeList(rfcommServiceRecord(), &data);
+
+    QBENCHMARK {
+        const char *begin = data.constData();
+        AttributeMap attributes;
+        SdpDataElement::decodeAttributeList(begin, begin + data.size(), &attributes);
+    }
+}
+
+QTEST_MAIN(tst_SdpDataElement)
+
+#include "tst_bench_sdpdataelement.moc"
@@ -1,4 +1,4 @@
 TEMPLATE = subdirs
-SUBDIRS += auto
+SUBDIRS += auto benchmarks
 
 qtHaveModule(bluetooth):qtHaveModule(quick): SUBDIRS += bttestui